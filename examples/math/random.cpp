@@ -9,6 +9,7 @@ Lance Putnam, 10/2012, putnam.lance@gmail.com
 */
 
 #include "al/math/al_Random.hpp"
+#include "al/math/al_RandomBatch.hpp"
 using namespace al;
 
 int main() {
@@ -120,4 +121,28 @@ int main() {
     rnd::normal();      // Returns standard normal (Gaussian) variate
     rnd::prob(0.2);     // Returns true 20% of the time
   }
+
+  // Lesson 4: Many Random Numbers at Once
+  // =========================================================================
+  /*
+  When thousands of numbers are needed at a time, as for particles or grains,
+  BatchRandom fills whole arrays. It runs several Tausworthe generators side
+  by side using SIMD instructions. Giving each thread its own stream index
+  makes parallel simulations reproducible.
+  */
+  {
+    rnd::BatchRandom rng(1234);  // Seed 1234, stream 0
+    rnd::BatchRandom rng2(1234, 1);  // Same seed, independent stream 1
+
+    float values[1000];
+    rng.uniform(values, 1000);            // Uniform floats in [0, 1)
+    rng.uniform(values, 1000, 10.f, 5.f); // Uniform floats in [5, 10)
+    rng2.normal(values, 1000);            // Standard normal variates
+
+    Vec3f points[1000];
+    rng.sphere(points, 1000);  // Points on the unit sphere
+    rng.ball(points, 1000);    // Points inside the unit sphere
+
+    rng.rng().discard(1000000);  // Skip ahead in the sequence
+  }
 }
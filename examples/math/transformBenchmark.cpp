@@ -0,0 +1,96 @@
+/*
+Allolib Example: Batch transforms
+
+Description:
+Times transforming an array of points one at a time with Mat4f and Quatf
+against the batch functions in al_BatchTransform.hpp. Mat4f products use SSE
+or NEON where available and are compared with the generic Mat<N,T> product.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "al/math/al_BatchTransform.hpp"
+using namespace al;
+
+template <class F> double timeIt(F f, int repeats) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < repeats; ++i) {
+    f();
+  }
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / repeats;
+}
+
+// Same as the generic Mat<N,T>::multiply(), which Mat4f replaces with SIMD
+template <int N, class T>
+void genericMultiply(Mat<N, T> &r, const Mat<N, T> &a, const Mat<N, T> &b) {
+  for (int j = 0; j < N; ++j) {
+    const Vec<N, T> &bcol = b.col(j);
+    for (int i = 0; i < N; ++i) {
+      r(i, j) = a.row(i).dot(bcol);
+    }
+  }
+}
+
+int main() {
+  const int numPoints = 1 << 16;
+  const int repeats = 50;
+
+  Mat4f xfm = Mat4f::translation(1.f, 2.f, 3.f) *
+              Mat4f::rotation(0.5f, 0, 2) * Mat4f::scaling(2.f);
+  std::vector<Vec3f> points(numPoints), out(numPoints);
+  for (int i = 0; i < numPoints; ++i) {
+    points[i].set(i * 0.001f, -i * 0.002f, 1.f);
+  }
+
+  double single = timeIt(
+      [&]() {
+        for (int i = 0; i < numPoints; ++i) {
+          Vec4f p = xfm * Vec4f(points[i], 1.f);
+          out[i].set(p[0], p[1], p[2]);
+        }
+      },
+      repeats);
+  double batch = timeIt(
+      [&]() { transformPoints(xfm, points.data(), out.data(), numPoints); },
+      repeats);
+  printf("Points:   one by one %.3f ms, batch %.3f ms\n", single, batch);
+
+  Mat4f a = xfm, b = xfm, r;
+  b.transpose();
+  double generic = timeIt(
+      [&]() {
+        for (int i = 0; i < numPoints; ++i) {
+          genericMultiply(r, a, b);
+          a[0] = r[1] * 1e-9f;
+        }
+      },
+      repeats);
+  single = timeIt(
+      [&]() {
+        for (int i = 0; i < numPoints; ++i) {
+          r = a * b;
+          a[0] = r[1] * 1e-9f;
+        }
+      },
+      repeats);
+  printf("Mat4f multiply: generic %.3f ns, Mat4f %.3f ns\n",
+         generic * 1e6 / numPoints, single * 1e6 / numPoints);
+
+  Quatf q = Quatf().fromAxisAngle(0.7f, Vec3f(0, 1, 0));
+  single = timeIt(
+      [&]() {
+        for (int i = 0; i < numPoints; ++i) {
+          out[i] = q.rotate(points[i]);
+        }
+      },
+      repeats);
+  batch = timeIt([&]() { rotate(q, points.data(), out.data(), numPoints); },
+                 repeats);
+  printf("Rotation: one by one %.3f ms, batch %.3f ms\n", single, batch);
+
+  return 0;
+}
@@ -11,16 +11,10 @@ class MyServer : public CommandServer {
 public:
   void initiateConversation() {
     std::cout << "Server requesting order" << std::endl;
-    for (auto listener : mServerConnections) {
-      std::cout << "Sending command to " << listener->address() << ":"
-                << listener->port() << std::endl;
-      unsigned char message[8] = {0, 0};
-
-      message[0] = ASK_CLIENT_FOR_ORDER;
-      if (listener->send((const char *)message, 2) == 2) {
-      } else {
-        std::cerr << "ERROR sending command" << std::endl;
-      }
+    uint8_t message = ASK_CLIENT_FOR_ORDER;
+    // Messages are framed, so the client receives them whole
+    if (!sendMessage(&message, 1)) {
+      std::cerr << "ERROR sending command" << std::endl;
     }
   }
 
@@ -44,7 +38,7 @@ public:
 
       uint8_t message[7] = {TELL_SERVER_ORDER, 'w', 'a', 't', 'e', 'r', 0};
 
-      if (!(mSocket.send((const char *)message, 7) == 7)) {
+      if (!sendMessage(message, 7)) {
         std::cerr << "ERROR sending reply" << std::endl;
         return false;
       }
@@ -2,6 +2,7 @@
 #define COMPUTATIONDOMAIN_H
 
 #include <cassert>
+#include <cstdint>
 #include <functional>
 #include <iostream>
 #include <memory>
@@ -156,6 +157,11 @@ protected:
    *
    * You must call this function twice: once for prepended and then for appended
    * domains.
+   *
+   * Subdomains run in list order on the calling thread, except subdomains set
+   * to runConcurrently(), which run on a shared worker pool as soon as the
+   * subdomains they depend on have ticked. All subdomains have ticked when
+   * this function returns.
    */
   bool tickSubdomains(bool pre = false);
 
@@ -209,6 +215,58 @@ public:
    * @return true if execution of the domain succeeded
    */
   virtual bool tick();
+
+  /**
+   * @brief Allow this domain to tick concurrently with its sibling domains
+   *
+   * By default a subdomain ticks on its parent's thread after all the
+   * subdomains before it in the parent's list. A concurrent subdomain only
+   * waits for the domains set with dependsOn() and may tick on a worker
+   * thread, so it must not depend on thread local state like a graphics
+   * context. Subdomains that are not concurrent still wait for all concurrent
+   * subdomains before them in the list.
+   */
+  void runConcurrently(bool concurrent) { mConcurrent = concurrent; }
+  bool runsConcurrently() { return mConcurrent; }
+
+  /**
+   * @brief Declare that this domain must tick after domain
+   *
+   * Only applies between subdomains of the same parent that are both
+   * prepended or both appended, and only to domains that run concurrently.
+   * Other domains tick after all subdomains before them in the list, so a
+   * dependency on a subdomain after them is ignored with a warning.
+   */
+  void dependsOn(std::shared_ptr<SynchronousDomain> domain) {
+    mDependencies.push_back(domain.get());
+  }
+
+  /// Timing of the tick() calls made by the parent domain
+  struct TickStats {
+    uint64_t ticks{0};
+    double lastSeconds{0.0};
+    double averageSeconds{0.0}; ///< Exponential moving average
+    double maxSeconds{0.0};
+  };
+
+  TickStats tickStats() {
+    std::lock_guard<std::mutex> lk(mStatsLock);
+    return mTickStats;
+  }
+
+  void resetTickStats() {
+    std::lock_guard<std::mutex> lk(mStatsLock);
+    mTickStats = TickStats();
+  }
+
+private:
+  bool timedTick();
+
+  bool mConcurrent{false};
+  std::vector<SynchronousDomain *> mDependencies;
+  bool mWarnedDependencies{false};
+  std::mutex mStatsLock;
+  TickStats mTickStats;
 };
 
 class AsynchronousDomain : public ComputationDomain {
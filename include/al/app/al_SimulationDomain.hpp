@@ -1,15 +1,20 @@
 #ifndef SIMULATIONDOMAIN_H
 #define SIMULATIONDOMAIN_H
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <functional>
 #include <iostream>
 #include <memory>
 #include <mutex>
 #include <stack>
+#include <thread>
 #include <vector>
 
 #include "al/app/al_ComputationDomain.hpp"
+#include "al/types/al_TripleBuffer.hpp"
 
 namespace al {
 
@@ -46,6 +51,176 @@ protected:
   std::shared_ptr<TSharedState> mState{new TSharedState};
 };
 
+// -------------
+
+/**
+ * @brief Simulation domain that steps at a fixed rate on its own thread
+ * @ingroup App
+ *
+ * simulationFunction is called with a constant time step from a separate
+ * thread, independently of the rate at which the parent domain ticks. After
+ * every step, the state is copied into a lock-free triple buffer.
+ *
+ * When inserted as a subdomain of the graphics domain, each tick() takes the
+ * latest snapshot. Rendering then runs one step behind the simulation, and
+ * alpha() gives the position between previous() and current() for the
+ * current frame. If interpolationFunction is set, interpolated() holds the
+ * state interpolated by it.
+ *
+ * TState must be copyable. The simulation thread starts in init() and stops
+ * in cleanup(). Set the initial values through state() before init().
+ */
+template <class TState>
+class FixedStepSimulationDomain : public SynchronousDomain {
+public:
+  /// Simulation time and state after a step
+  struct Snapshot {
+    TState state;
+    double time{0.0};
+    uint64_t step{0};
+  };
+
+  ~FixedStepSimulationDomain() { stopSimulation(); }
+
+  bool init(ComputationDomain *parent = nullptr) override {
+    bool ret = SynchronousDomain::init(parent);
+    startSimulation();
+    return ret;
+  }
+
+  bool cleanup(ComputationDomain *parent = nullptr) override {
+    stopSimulation();
+    return SynchronousDomain::cleanup(parent);
+  }
+
+  bool tick() override {
+    bool ret = tickSubdomains(true);
+    if (mSnapshots.update()) {
+      mPrevious = mCurrent;
+      mCurrent = mSnapshots.front();
+      mHasSnapshot = true;
+    }
+    double now = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - mStartTime)
+                     .count();
+    // Snapshots are published one step ahead of their time, so now lies
+    // between previous and current while the simulation keeps up
+    double span = mCurrent.time - mPrevious.time;
+    mAlpha = span > 0 ? (now - mPrevious.time) / span : 1.0;
+    mAlpha = std::min(1.0, std::max(0.0, mAlpha));
+    if (interpolationFunction && mHasSnapshot) {
+      interpolationFunction(mPrevious.state, mCurrent.state, mAlpha,
+                            mInterpolated);
+    }
+    ret &= tickSubdomains(false);
+    return ret;
+  }
+
+  /// Called from the simulation thread with the fixed time step
+  std::function<void(double dt, TState &state)> simulationFunction =
+      [](double, TState &) {};
+
+  /// Optional. Called in tick() to interpolate between two snapshots
+  std::function<void(const TState &previous, const TState &current,
+                     double alpha, TState &out)>
+      interpolationFunction;
+
+  /// Simulation state. Only access before init() or from simulationFunction
+  TState &state() { return mState; }
+
+  /// Set the simulation rate in steps per second. Applies on next start
+  void stepRate(double stepsPerSecond) { mStepRate = stepsPerSecond; }
+  double stepRate() { return mStepRate; }
+
+  /**
+   * @brief Limit the steps run to catch up after a slow step
+   *
+   * If the simulation falls further behind, the missed time is dropped instead
+   * of running more steps.
+   */
+  void maxCatchUpSteps(int steps) { mMaxCatchUpSteps = steps; }
+
+  /// Snapshot before current(). Only use from the thread calling tick()
+  const Snapshot &previous() { return mPrevious; }
+  /// Latest snapshot taken by tick()
+  const Snapshot &current() { return mCurrent; }
+  /// Position between previous() and current() for this tick, from 0 to 1
+  double alpha() { return mAlpha; }
+  /// Result of interpolationFunction for this tick
+  const TState &interpolated() { return mInterpolated; }
+
+  /// Number of steps skipped because the simulation could not keep up
+  uint64_t droppedSteps() { return mDroppedSteps; }
+
+private:
+  void startSimulation() {
+    if (mSimulationThread) {
+      return;
+    }
+    mRunning = true;
+    mStartTime = std::chrono::steady_clock::now();
+    mSimulationThread = std::make_unique<std::thread>([this]() {
+      const double dt = 1.0 / mStepRate;
+      const auto stepDuration = std::chrono::duration<double>(dt);
+      uint64_t step = 0;
+      auto nextStep = mStartTime;
+      while (mRunning) {
+        int stepsRun = 0;
+        while (std::chrono::steady_clock::now() >= nextStep && mRunning) {
+          if (stepsRun == mMaxCatchUpSteps) {
+            // Drop missed steps, keeping the time grid
+            auto behind = std::chrono::steady_clock::now() - nextStep;
+            uint64_t missed = uint64_t(
+                std::chrono::duration<double>(behind).count() / dt) + 1;
+            mDroppedSteps += missed;
+            step += missed;
+            nextStep = mStartTime + std::chrono::duration_cast<
+                                        std::chrono::steady_clock::duration>(
+                                        stepDuration * double(step));
+            break;
+          }
+          simulationFunction(dt, mState);
+          step++;
+          stepsRun++;
+          Snapshot &snapshot = mSnapshots.back();
+          snapshot.state = mState;
+          snapshot.time = step * dt;
+          snapshot.step = step;
+          mSnapshots.publish();
+          nextStep = mStartTime +
+                     std::chrono::duration_cast<
+                         std::chrono::steady_clock::duration>(
+                         stepDuration * double(step));
+        }
+        std::this_thread::sleep_until(nextStep);
+      }
+    });
+  }
+
+  void stopSimulation() {
+    if (mSimulationThread) {
+      mRunning = false;
+      mSimulationThread->join();
+      mSimulationThread = nullptr;
+    }
+  }
+
+  TState mState;
+  TripleBuffer<Snapshot> mSnapshots;
+  Snapshot mPrevious;
+  Snapshot mCurrent;
+  TState mInterpolated;
+  double mAlpha{1.0};
+  bool mHasSnapshot{false};
+
+  double mStepRate{120.0};
+  int mMaxCatchUpSteps{8};
+  std::atomic<uint64_t> mDroppedSteps{0};
+  std::chrono::steady_clock::time_point mStartTime;
+  std::atomic<bool> mRunning{false};
+  std::unique_ptr<std::thread> mSimulationThread;
+};
+
 } // namespace al
 
 #endif // SIMULATIONDOMAIN
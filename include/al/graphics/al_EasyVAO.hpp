@@ -12,6 +12,7 @@
 */
 
 #include "al/graphics/al_BufferObject.hpp"
+#include "al/graphics/al_MeshPacker.hpp"
 #include "al/graphics/al_VAO.hpp"
 
 namespace al {
@@ -79,6 +80,12 @@ struct EasyVAO : VAO {
   // indices must be unsigned int
   void updateIndices(const unsigned int* data, size_t size);
 
+  // upload interleaved data from a MeshPacker into a single buffer.
+  // only the packer's dirty ranges are uploaded unless its layout changed.
+  // marks the packer clean. do not mix with the per attribute update
+  // functions above on the same EasyVAO
+  void updateInterleaved(MeshPacker& packer);
+
   // GL_TRIANGLES, GL_TRIANGLE_STRIP, ...
   void primitive(unsigned int prim);
 
@@ -97,6 +104,7 @@ struct EasyVAO : VAO {
       mNormalAtt{LAYOUT_NORMAL, DIMENSION_NORMAL};
 
   BufferObject mIndexBuffer;
+  BufferObject mInterleavedBuffer;
 };
 
 }  // namespace al
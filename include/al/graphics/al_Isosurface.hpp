@@ -71,6 +71,8 @@
 
 namespace al {
 
+class Voxels;
+
 /**
  * @brief Isosurface generated using marching cubes
  * @ingroup Graphics
@@ -216,13 +218,16 @@ public:
     generate(scalarField, n, n, n, cellLength, cellLength, cellLength);
   }
 
-  /*
-  // support for building isosurface from al::Voxels class
-  void generate(const MRC& mrc, float glUnitLength) {
-          generate((float*)mrc.dataPtr(), mrc.array().dim(0),
-  mrc.array().dim(1), mrc.array().dim(2), mrc.header().cella[0]/glUnitLength,
-  mrc.header().cella[1]/glUnitLength, mrc.header().cella[2]/glUnitLength);
-  }*/
+  /// Generate isosurface from a mip level of a volume
+
+  /// Voxels are located at the corners of the cells and cell lengths are the
+  /// voxel widths of the level. Bricks whose value range does not contain the
+  /// isolevel are skipped. Each brick is decoded once to find its range, and
+  /// the range is kept when the brick is evicted, so later calls skip it
+  /// without decoding. Since edge IDs are 32-bit, large volumes may need to
+  /// be generated from a coarser level.
+  /// \returns false if the level is too large
+  bool generate(const Voxels &voxels, int mipLevel = 0);
 
   void vertexAction(VertexAction &a) { mVertexAction = &a; }
 
@@ -54,6 +54,7 @@
 #include "al/math/al_Vec.hpp"
 #include "al/types/al_Color.hpp"
 
+#include <cstdint>
 #include <functional>
 #include <vector>
 
@@ -114,11 +115,58 @@ public:
   // destructive edits to internal vertices:
 
   /// Generates indices for a set of vertices
+
+  /// Vertices with identical positions are merged. Equivalent to weld(0, false).
   Mesh &compress();
 
   /// Convert indices (if any) to flat vertex buffers
   Mesh &decompress();
 
+  /// Merge vertices closer than a tolerance
+
+  /// Vertices are bucketed on a spatial hash grid with a cell size of
+  /// the tolerance, so welding runs in linear time. Existing indices are
+  /// remapped; non-indexed meshes become indexed.
+  ///
+  /// @param[in] tolerance        maximum distance between merged vertices
+  /// @param[in] matchAttributes  if true, only merge vertices whose normals,
+  ///                             colors and texture coordinates are equal
+  Mesh &weld(float tolerance = 0, bool matchAttributes = true);
+
+  /// Reorder triangles for post-transform vertex cache efficiency
+
+  /// Uses Forsyth's linear-speed vertex cache optimization. Only applies to
+  /// indexed triangle meshes.
+  ///
+  /// @param[in] cacheSize  number of entries of the simulated vertex cache
+  Mesh &optimizeVertexCache(unsigned cacheSize = 32);
+
+  /// Reorder triangle clusters to reduce overdraw
+
+  /// Triangles are split into clusters at vertex cache boundaries, then
+  /// clusters facing away from the mesh center are drawn first. Should be
+  /// called after optimizeVertexCache().
+  ///
+  /// @param[in] threshold  allowed increase of the vertex cache miss ratio
+  ///                       from splitting clusters
+  /// @param[in] cacheSize  number of entries of the simulated vertex cache
+  Mesh &optimizeOverdraw(float threshold = 1.05f, unsigned cacheSize = 32);
+
+  /// Reorder vertex buffers in order of first use by the indices
+
+  /// Improves memory locality of vertex fetches. Unreferenced vertices are
+  /// removed. Only applies to indexed meshes.
+  Mesh &optimizeVertexFetch();
+
+  /// Run vertex cache, overdraw and vertex fetch optimizations in order
+  Mesh &optimize(unsigned cacheSize = 32);
+
+  /// Average number of vertex cache misses per triangle
+
+  /// Simulates a FIFO vertex cache. Values range from 0.5 (best case for
+  /// large grids) to 3 (no vertex reuse).
+  float vertexCacheMissRatio(unsigned cacheSize = 32) const;
+
   /// Extend buffers to match number of vertices
 
   /// This will resize all populated buffers to match the size of the vertex
@@ -177,6 +225,9 @@ public:
   template <class T>
   Mesh &transform(const Mat<4, T> &m, int begin = 0, int end = -1);
 
+  /// Transform vertices by a float matrix using batch SIMD transforms
+  Mesh &transform(const Mat<4, float> &m, int begin = 0, int end = -1);
+
   /// Generates normals for a set of vertices
 
   /// This method will generate a normal for each vertex in the buffer
@@ -191,6 +242,40 @@ public:
   ///                  based on face areas
   Mesh &generateNormals(bool normalize = true, bool equalWeightPerFace = false);
 
+  /// Generates normals using multiple threads
+
+  /// This produces the same normals as generateNormals(). Face normals are
+  /// computed in parallel and then gathered for each vertex through a
+  /// vertex-face adjacency list, so no two threads write the same normal.
+  /// Meshes too small to benefit are processed on the calling thread.
+  ///
+  /// @param[in] normalize      whether to normalize normals
+  /// @param[in] equalWeightPerFace  whether to use an equal weighting of
+  ///                  face normals rather than a weighting
+  ///                  based on face areas
+  /// @param[in] numThreads    number of threads, 0 uses one per hardware
+  ///                  thread
+  Mesh &generateNormalsParallel(bool normalize = true,
+                                bool equalWeightPerFace = false,
+                                unsigned numThreads = 0);
+
+  /// Regenerates normals affected by moving a range of vertices
+
+  /// Only the normals of vertices that share a face with a vertex in the
+  /// range are recomputed. All normals are regenerated instead if the
+  /// primitive, the vertex count or the indices changed since normals were
+  /// last generated, or if they were generated with other arguments.
+  ///
+  /// @param[in] begin    beginning index of moved vertices; negative value
+  ///            specifies distance from last element
+  /// @param[in] end      ending index of moved vertices, negative value
+  ///            specifies distance from one past last element
+  /// @param[in] normalize      whether to normalize normals
+  /// @param[in] equalWeightPerFace  whether to use an equal weighting of
+  ///                  face normals
+  Mesh &updateNormals(int begin, int end = -1, bool normalize = true,
+                      bool equalWeightPerFace = false);
+
   /// Invert direction of normals
   Mesh &invertNormals();
 
@@ -539,6 +624,8 @@ protected:
 
   Primitive mPrimitive;
   float mStroke = -1.f;
+  // Topology the normals were last generated for, 0 if unknown
+  uint64_t mNormalsTopology = 0;
 };
 
 template <class T>
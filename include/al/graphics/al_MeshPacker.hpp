@@ -0,0 +1,167 @@
+#ifndef INCLUDE_AL_GRAPHICS_MESHPACKER_HPP
+#define INCLUDE_AL_GRAPHICS_MESHPACKER_HPP
+
+/*  Allocore --
+  Multimedia / virtual environment application class library
+
+  Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+  Copyright (C) 2012. The Regents of the University of California.
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    Neither the name of the University of California nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  File description:
+  Packs Mesh attributes into a single interleaved vertex buffer, tracking
+  which byte ranges changed since the previous pack. Does not use OpenGL, so
+  it can be used and tested without a context.
+
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "al/graphics/al_Mesh.hpp"
+
+namespace al {
+
+/**
+@brief Interleaved, optionally quantized vertex data for a Mesh
+@ingroup Graphics
+
+Each vertex is stored as position (3 floats), then if present color, texture
+coordinate (2 floats) and normal. When quantized, colors are stored as four
+normalized unsigned bytes and normals as four half floats (the fourth is
+padding), which roughly halves the size of a vertex.
+
+Repeated calls to pack() compare against the previous contents and record
+the byte ranges that changed, so only those need to be uploaded. A packer
+should feed a single GPU buffer.
+*/
+class MeshPacker {
+public:
+  enum AttribIndex : unsigned int {
+    POSITION = 0,
+    COLOR = 1,
+    TEXCOORD = 2,
+    NORMAL = 3,
+    NUM_ATTRIBS
+  };
+
+  /// Location of one attribute inside the interleaved vertex
+  struct Attrib {
+    bool enabled = false;
+    int components = 0;           ///< Number of components read by the shader
+    unsigned int type = GL_FLOAT; ///< GL_FLOAT, GL_HALF_FLOAT, ...
+    bool normalized = false;      ///< Integer types mapped to [0, 1]
+    size_t offset = 0;            ///< Byte offset inside the vertex
+
+    bool operator==(const Attrib &other) const {
+      return enabled == other.enabled && components == other.components &&
+             type == other.type && normalized == other.normalized &&
+             offset == other.offset;
+    }
+    bool operator!=(const Attrib &other) const { return !(*this == other); }
+  };
+
+  /// Byte range [first, second) of the vertex data
+  typedef std::pair<size_t, size_t> Range;
+
+  MeshPacker(bool quantize = false) : mQuantize(quantize) {}
+
+  /// Store colors as unorm8 and normals as half floats
+  void quantize(bool enable) { mQuantize = enable; }
+  bool quantize() const { return mQuantize; }
+
+  /// Set number of unchanged vertices allowed inside a single dirty range
+
+  /// Larger values produce fewer, larger uploads.
+  void mergeGap(size_t vertices) { mMergeGap = vertices; }
+
+  /// Pack the mesh, updating dirty ranges and the layout
+  void pack(const Mesh &mesh);
+
+  /// Interleaved vertex data
+  const uint8_t *data() const { return mData.data(); }
+  /// Size of the vertex data in bytes
+  size_t size() const { return mData.size(); }
+  /// Size of a single vertex in bytes
+  size_t stride() const { return mStride; }
+  size_t numVertices() const { return mNumVertices; }
+  unsigned int primitive() const { return mPrimitive; }
+  const Attrib &attrib(AttribIndex index) const { return mAttribs[index]; }
+
+  const std::vector<Mesh::Index> &indices() const { return mIndices; }
+
+  /// True if stride, attributes or vertex count changed in the last pack()
+
+  /// In that case the whole buffer must be uploaded and attribute pointers
+  /// set again.
+  bool layoutChanged() const { return mLayoutChanged; }
+
+  /// Byte ranges modified by the last pack()
+  const std::vector<Range> &dirtyRanges() const { return mDirtyRanges; }
+
+  /// True if the indices changed in the last pack()
+  bool indicesChanged() const { return mIndicesChanged; }
+
+  /// Number of bytes that need to be uploaded after the last pack()
+  size_t dirtyBytes() const;
+
+  /// Mark everything as uploaded
+  void clearDirty();
+
+  /// Forget previous contents so the next pack() reports everything dirty
+  void reset();
+
+  /// Read back a packed attribute as floats, mostly useful for testing
+
+  /// @param[in] index  attribute to read
+  /// @param[in] vertex vertex index
+  /// @param[out] out   at least 4 floats
+  /// @return false if attribute is not present
+  bool unpack(AttribIndex index, size_t vertex, float *out) const;
+
+private:
+  bool mQuantize;
+  size_t mMergeGap{16};
+  unsigned int mPrimitive{GL_TRIANGLES};
+  size_t mStride{0};
+  size_t mNumVertices{0};
+  Attrib mAttribs[NUM_ATTRIBS];
+  std::vector<uint8_t> mData;
+  std::vector<Mesh::Index> mIndices;
+  std::vector<Range> mDirtyRanges;
+  bool mLayoutChanged{true};
+  bool mIndicesChanged{true};
+};
+
+} // namespace al
+
+#endif
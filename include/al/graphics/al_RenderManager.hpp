@@ -287,6 +287,15 @@ public:
   void draw(const Mesh &mesh);
   void draw(Mesh &&mesh);
 
+  /// Store colors as unorm8 and normals as half floats when drawing a Mesh
+
+  /// Reduces upload size for meshes passed to draw(const Mesh&). Colors are
+  /// clamped to [0, 1].
+  void quantizeMeshes(bool enable) {
+    mMeshPacker.quantize(enable);
+    mMeshPacker.reset();
+  }
+
 protected:
   ShaderProgram *mShaderPtr = nullptr;
   std::unordered_map<unsigned int, int> modelviewLocs;
@@ -301,6 +310,10 @@ protected:
 
   ViewportStack mViewportStack;
   EasyVAO mInternalVAO;
+  MeshPacker mMeshPacker;
+  // Mesh last packed into mMeshPacker. Dirty ranges are only computed when
+  // the same mesh is drawn again.
+  const Mesh *mLastPackedMesh = nullptr;
   // unsigned int mFBOID = 0;
   FBOStack mFBOStack;
 };
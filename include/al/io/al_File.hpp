@@ -386,6 +386,52 @@ protected:
   friend class Dir;
 };
 
+/// Read-only memory mapped file
+
+/// The contents of the file are mapped into the address space of the process
+/// and can be accessed in place through data() without copying.
+///
+/// @ingroup IO
+class MappedFile {
+public:
+  MappedFile() {}
+  MappedFile(const std::string &path) { open(path); }
+  ~MappedFile() { close(); }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  /// Map file at path. Any previously mapped file is released.
+
+  /// \returns true on success, false otherwise. Empty files can not be
+  /// mapped.
+  bool open(const std::string &path);
+
+  /// Release mapping
+  void close();
+
+  /// Returns whether file is mapped
+  bool opened() const { return mData != nullptr; }
+
+  /// Returns pointer to the mapped contents or nullptr if not mapped
+  const char *data() const { return mData; }
+
+  /// Returns size, in bytes, of mapped contents
+  size_t size() const { return mSize; }
+
+  /// Returns path of mapped file
+  const std::string &path() const { return mPath; }
+
+private:
+  std::string mPath;
+  const char *mData{nullptr};
+  size_t mSize{0};
+#ifdef AL_WINDOWS
+  void *mFileHandle{nullptr};
+  void *mMappingHandle{nullptr};
+#endif
+};
+
 class PushDirectory {
 public:
   PushDirectory(std::string directory, bool verbose = false);
@@ -46,6 +46,7 @@
 */
 
 #include <string>
+#include <vector>
 #include <cstdint>
 
 #include "al/system/al_Time.hpp"
@@ -168,6 +169,22 @@ public:
   /// socket address pair of this connection.
   bool accept(Socket &sock);
 
+  /// Readiness of a socket reported by poll()
+  struct PollEvent {
+    Socket *socket{nullptr};
+    bool wantWrite{false}; ///< Also wait for the socket to be writable
+    bool readable{false};  ///< Data, or the connection closing, can be read
+    bool writable{false};
+    bool error{false}; ///< Error or connection closed
+  };
+
+  /// Wait until any of a set of sockets is ready
+
+  /// @param[in,out] events	Sockets to wait for. Their readiness is set
+  /// @param[in] timeout	Maximum wait in seconds. < 0 waits forever
+  /// \returns number of ready sockets, 0 on timeout or -1 on error
+  static int poll(std::vector<PollEvent> &events, al_sec timeout);
+
   ValueSource *valueSource();
 
 protected:
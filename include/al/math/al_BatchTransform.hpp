@@ -0,0 +1,83 @@
+#ifndef INCLUDE_AL_BATCHTRANSFORM_HPP
+#define INCLUDE_AL_BATCHTRANSFORM_HPP
+
+/*  Allolib --
+  Multimedia / virtual environment application class library
+
+  Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+  Copyright (C) 2012-2018. The Regents of the University of California.
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    Neither the name of the University of California nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  File description:
+  Transformation of arrays of vectors by matrices and quaternions
+
+  File author(s):
+  AlloSphere Research Group
+*/
+
+#include <cstddef>
+
+#include "al/math/al_Mat.hpp"
+#include "al/math/al_Quat.hpp"
+#include "al/math/al_Vec.hpp"
+
+namespace al {
+
+/// @addtogroup Math
+/// @{
+///
+/// Batch transforms apply one transformation to a whole array with SIMD
+/// instructions where available. Source and destination may be the same
+/// array, but must not partially overlap.
+
+/// Transform positions, dst[i] = (m * Vec4f(src[i], 1)).xyz
+void transformPoints(const Mat4f &m, const Vec3f *src, Vec3f *dst,
+                     size_t count);
+
+/// Transform directions, ignoring translation, dst[i] = (m * Vec4f(src[i],
+/// 0)).xyz
+void transformVectors(const Mat4f &m, const Vec3f *src, Vec3f *dst,
+                      size_t count);
+
+/// Transform 4-vectors, dst[i] = m * src[i]
+void transform(const Mat4f &m, const Vec4f *src, Vec4f *dst, size_t count);
+
+/// Transform normals by a normal matrix and normalize them, dst[i] =
+/// normalize(m * src[i])
+void transformNormals(const Mat3f &m, const Vec3f *src, Vec3f *dst,
+                      size_t count);
+
+/// Rotate vectors, dst[i] = q.rotate(src[i]). q should be normalized
+void rotate(const Quatf &q, const Vec3f *src, Vec3f *dst, size_t count);
+
+/// @}
+
+} // namespace al
+
+#endif // INCLUDE_AL_BATCHTRANSFORM_HPP
@@ -42,6 +42,7 @@
   Lance Putnam, 2011, putnam.lance@gmail.com
 */
 
+#include "al/math/al_Mat.hpp"
 #include "al/math/al_Plane.hpp"
 #include "al/math/al_Vec.hpp"
 
@@ -120,6 +121,13 @@ class Frustum {
   ///
   void computePlanes();
 
+  /// Compute corners and planes from a view-projection matrix
+
+  /// The frustum is in the space the matrix transforms from, e.g. world space
+  /// for projection * view. Returns false if the matrix can't be inverted.
+  template <class U>
+  bool fromMatrix(const Mat<4, U>& viewProj);
+
  private:
   template <class Tf, class Tv>
   static Tv lerp(Tf f, const Tv& x, const Tv& y) {
@@ -153,6 +161,22 @@ void Frustum<T>::computePlanes() {
   pl[FARP].from3Points(ftr, ftl, fbl);
 }
 
+template <class T>
+template <class U>
+bool Frustum<T>::fromMatrix(const Mat<4, U>& viewProj) {
+  Mat<4, T> inv(viewProj);
+  if (!invert(inv)) return false;
+
+  // Unproject the corners of the normalized device coordinate cube
+  for (int i = 0; i < 8; ++i) {
+    Vec<4, T> ndc((i & 1) ? 1 : -1, (i & 2) ? -1 : 1, (i & 4) ? 1 : -1, 1);
+    Vec<4, T> v = inv * ndc;
+    (&ntl)[i] = Vec<3, T>(v[0], v[1], v[2]) / v[3];
+  }
+  computePlanes();
+  return true;
+}
+
 template <class T>
 int Frustum<T>::testPoint(const Vec<3, T>& p) const {
   for (int i = 0; i < 6; ++i) {
@@ -43,6 +43,7 @@
   Graham Wakefield, 2010, grrrwaaa@gmail.com
 */
 
+#include "al/math/al_SIMD.hpp"
 #include "al/math/al_Vec.hpp"
 #include <cmath>
 #include <stdio.h>
@@ -536,6 +537,73 @@ public:
   void print(std::ostream &stream) const;
 };
 
+#if defined(AL_SIMD_SSE) || defined(AL_SIMD_NEON)
+// SIMD versions of the 4x4 float products. Each result column is a sum of the
+// columns of the left matrix, added in the same order as the generic versions.
+// Results are kept in registers until the end, so the result may alias an
+// operand.
+
+template <>
+inline Mat<4, float> &Mat<4, float>::multiply(Mat<4, float> &r,
+                                              const Mat<4, float> &a,
+                                              const Mat<4, float> &b) {
+  const float *A = a.elems();
+  const float *B = b.elems();
+#ifdef AL_SIMD_SSE
+  const __m128 a0 = _mm_loadu_ps(A), a1 = _mm_loadu_ps(A + 4);
+  const __m128 a2 = _mm_loadu_ps(A + 8), a3 = _mm_loadu_ps(A + 12);
+  __m128 c[4];
+  for (int j = 0; j < 4; ++j) {
+    const float *bcol = B + 4 * j;
+    c[j] = _mm_mul_ps(a0, _mm_set1_ps(bcol[0]));
+    c[j] = _mm_add_ps(c[j], _mm_mul_ps(a1, _mm_set1_ps(bcol[1])));
+    c[j] = _mm_add_ps(c[j], _mm_mul_ps(a2, _mm_set1_ps(bcol[2])));
+    c[j] = _mm_add_ps(c[j], _mm_mul_ps(a3, _mm_set1_ps(bcol[3])));
+  }
+  for (int j = 0; j < 4; ++j) {
+    _mm_storeu_ps(r.elems() + 4 * j, c[j]);
+  }
+#else
+  const float32x4_t a0 = vld1q_f32(A), a1 = vld1q_f32(A + 4);
+  const float32x4_t a2 = vld1q_f32(A + 8), a3 = vld1q_f32(A + 12);
+  float32x4_t c[4];
+  for (int j = 0; j < 4; ++j) {
+    const float *bcol = B + 4 * j;
+    c[j] = vmulq_n_f32(a0, bcol[0]);
+    c[j] = vaddq_f32(c[j], vmulq_n_f32(a1, bcol[1]));
+    c[j] = vaddq_f32(c[j], vmulq_n_f32(a2, bcol[2]));
+    c[j] = vaddq_f32(c[j], vmulq_n_f32(a3, bcol[3]));
+  }
+  for (int j = 0; j < 4; ++j) {
+    vst1q_f32(r.elems() + 4 * j, c[j]);
+  }
+#endif
+  return r;
+}
+
+template <>
+template <>
+inline Vec<4, float> &Mat<4, float>::multiply(Vec<4, float> &r,
+                                              const Mat<4, float> &m,
+                                              const Vec<4, float> &vCol) {
+  const float *M = m.elems();
+#ifdef AL_SIMD_SSE
+  __m128 c = _mm_mul_ps(_mm_loadu_ps(M), _mm_set1_ps(vCol[0]));
+  c = _mm_add_ps(c, _mm_mul_ps(_mm_loadu_ps(M + 4), _mm_set1_ps(vCol[1])));
+  c = _mm_add_ps(c, _mm_mul_ps(_mm_loadu_ps(M + 8), _mm_set1_ps(vCol[2])));
+  c = _mm_add_ps(c, _mm_mul_ps(_mm_loadu_ps(M + 12), _mm_set1_ps(vCol[3])));
+  _mm_storeu_ps(r.elems(), c);
+#else
+  float32x4_t c = vmulq_n_f32(vld1q_f32(M), vCol[0]);
+  c = vaddq_f32(c, vmulq_n_f32(vld1q_f32(M + 4), vCol[1]));
+  c = vaddq_f32(c, vmulq_n_f32(vld1q_f32(M + 8), vCol[2]));
+  c = vaddq_f32(c, vmulq_n_f32(vld1q_f32(M + 12), vCol[3]));
+  vst1q_f32(r.elems(), c);
+#endif
+  return r;
+}
+#endif
+
 // -----------------------------------------------------------------------------
 // The following are functions that either cannot be defined as class methods
 // (due to syntax rules or specialization) or simply are not object oriented.
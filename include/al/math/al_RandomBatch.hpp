@@ -0,0 +1,158 @@
+#ifndef INCLUDE_AL_RANDOMBATCH_HPP
+#define INCLUDE_AL_RANDOMBATCH_HPP
+
+/*  Allolib --
+  Multimedia / virtual environment application class library
+
+  Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+  Copyright (C) 2012-2018. The Regents of the University of California.
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    Neither the name of the University of California nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  File description:
+  Multi-lane random number generator and bulk distribution fills
+
+  File author(s):
+  AlloSphere Research Group
+*/
+
+
+#include <cstddef>
+#include <cstdint>
+
+#include "al/math/al_Random.hpp"
+#include "al/math/al_Vec.hpp"
+
+namespace al {
+
+namespace rnd {
+
+/// Combined Tausworthe generator running several independent lanes at once
+
+/// Each lane is a Tausworthe generator. The lanes are stepped together with
+/// SIMD integer instructions where available, and their outputs are
+/// interleaved into a single stream. The stream does not depend on how it is
+/// split into calls, so fill(a, 3) followed by fill(b, 5) produces the same
+/// values as fill(c, 8).
+///
+/// For reproducible parallel simulation, give each thread its own stream
+/// index with the same seed, or give each thread the same seed and stream and
+/// skip ahead to its own part of the sequence with discard().
+///
+/// The class can also be used as the RNG of Random<>.
+///
+/// @ingroup Math
+class TauswortheLanes {
+ public:
+  static const int kLanes = 4;
+
+  /// Default constructor uses a randomly generated seed
+  TauswortheLanes();
+
+  /// @param[in] seed    Initial seed value
+  /// @param[in] stream  Index of the stream for this seed
+  TauswortheLanes(uint32_t seed, uint32_t stream = 0);
+
+  /// Set seed and stream index
+  void seed(uint32_t v, uint32_t stream = 0);
+
+  /// Generate next uniform random integer in [0, 2^32)
+  uint32_t operator()();
+
+  /// Fill array with uniform random integers in [0, 2^32)
+  void fill(uint32_t *dst, size_t count);
+
+  /// Advance every lane by a number of steps
+
+  /// This skips kLanes * steps values of the stream, plus any values already
+  /// generated but not yet returned. Cost is logarithmic in steps.
+  void discard(uint64_t steps);
+
+ private:
+  // Component major, mState[c][lane]
+  alignas(16) uint32_t mState[4][kLanes];
+  uint32_t mCache[kLanes];
+  int mCacheIndex = kLanes;
+
+  // Step all lanes, writing kLanes values per group
+  void iterate(uint32_t *out, size_t groups);
+};
+
+/// Bulk random distribution generator
+
+/// Fills arrays with variates, generating the uniform numbers they are made
+/// from several at a time. Unlike Random<>, the methods do not use rejection
+/// sampling, so every call consumes a fixed number of values from the stream.
+///
+/// @ingroup Math
+class BatchRandom {
+ public:
+  /// Default constructor uses a randomly generated seed
+  BatchRandom() {}
+
+  /// @param[in] seed    Initial seed value
+  /// @param[in] stream  Index of the stream for this seed
+  BatchRandom(uint32_t seed, uint32_t stream = 0) : mRNG(seed, stream) {}
+
+  /// Set seed and stream index
+  BatchRandom &seed(uint32_t v, uint32_t stream = 0) {
+    mRNG.seed(v, stream);
+    return *this;
+  }
+
+  /// Get underlying random number generator
+  TauswortheLanes &rng() { return mRNG; }
+
+  /// Fill with uniform randoms in [0, 1)
+  void uniform(float *dst, size_t count);
+
+  /// Fill with uniform randoms in [lo, hi)
+  void uniform(float *dst, size_t count, float hi, float lo = 0.f);
+
+  /// Fill with uniform randoms in [-1, 1)
+  void uniformS(float *dst, size_t count);
+
+  /// Fill with normal variates
+  void normal(float *dst, size_t count, float mean = 0.f,
+              float stddev = 1.f);
+
+  /// Fill with points on the unit sphere
+  void sphere(Vec3f *dst, size_t count);
+
+  /// Fill with points within the unit ball
+  void ball(Vec3f *dst, size_t count);
+
+ private:
+  TauswortheLanes mRNG;
+};
+
+}  // namespace rnd
+
+}  // namespace al
+
+#endif  // INCLUDE_AL_RANDOMBATCH_HPP
@@ -51,6 +51,7 @@
 #include <cstring>
 #include <cinttypes>
 #include <condition_variable>
+#include <deque>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -140,6 +141,29 @@ private:
   size_t mReadIndex{0};
 };
 
+/**
+ * @brief The CommandConnection class is the base for TCP command servers and
+ * clients
+ *
+ * Messages passed to sendMessage() are delivered whole to
+ * processIncomingMessage() on the other end, whatever their size. Each
+ * message is sent as one or more frames with a 4 byte little endian header
+ * holding the frame length in the lower 31 bits and, in the top bit, whether
+ * more frames of the same message follow. Messages longer than kChunkSize are
+ * split into several frames, so meshes, textures or state snapshots of many
+ * megabytes can be sent.
+ *
+ * The handshake carries kProtocolVersion after the subclass version and
+ * revision. Peers using a different protocol version, including those from
+ * before framing, which send no protocol version, are rejected when
+ * connecting, as their messages can't be parsed.
+ *
+ * sendMessage() does not block. Messages are queued for each connection and
+ * sent by a single event loop thread that waits on all connections with
+ * Socket::poll(), which also receives and dispatches incoming messages. If a
+ * connection can't keep up and its queue would grow beyond sendQueueLimit(),
+ * sendMessage() fails instead.
+ */
 class CommandConnection {
 public:
   typedef enum {
@@ -150,9 +174,18 @@ public:
     PING,
     PONG,
     COMMAND_QUIT,
+    HANDSHAKE_REJECT,
     COMMAND_LAST_INTERNAL = 32,
   } InternalCommands;
 
+  /// Messages longer than this are split in several frames
+  static const uint32_t kChunkSize = 65536;
+  /// Version of the message framing. Connections between peers with
+  /// different versions are refused
+  static const uint8_t kProtocolVersion = 2;
+
+  virtual ~CommandConnection() {}
+
   virtual bool start(uint16_t port, const char *addr) = 0;
   virtual void stop();
 
@@ -160,7 +193,7 @@ public:
    * @brief sendMessage
    * @param message
    * @param dst
-   * @return
+   * @return false if the message could not be queued for all destinations
    *
    * if dst is nullptr, the message is sent to all connected sockets
    * If src is not nullptr, the message will not be sent to it
@@ -174,6 +207,21 @@ public:
 
   void setVerbose(bool verbose) { mVerbose = verbose; }
 
+  /// Maximum bytes waiting to be sent on each connection. Default 64MB
+  void sendQueueLimit(size_t bytes) { mSendQueueLimit = bytes; }
+  size_t sendQueueLimit() { return mSendQueueLimit; }
+
+  /// Larger incoming messages are discarded. Default 256MB
+  void maxMessageSize(size_t bytes) { mMaxMessageSize = bytes; }
+  size_t maxMessageSize() { return mMaxMessageSize; }
+
+  /// Bytes waiting to be sent on all connections
+  size_t queuedBytes();
+
+  /// Block until all queued messages have been sent
+  /// \returns false if the timeout expired first
+  bool flush(double timeoutSecs = 10.0);
+
 protected:
   virtual bool processIncomingMessage(Message &message, Socket *src) {
     auto command = message.getByte();
@@ -192,6 +240,31 @@ protected:
 
   virtual void onConnection(Socket *newConnection){};
 
+  // Send and receive state of a connection handled by the event loop
+  struct Connection {
+    std::shared_ptr<Socket> socket;
+    std::mutex sendLock;
+    std::deque<std::vector<uint8_t>> sendQueue; // Frames with headers
+    size_t sendOffset{0}; // Bytes of the first frame already sent
+    std::atomic<size_t> queuedBytes{0};
+    std::vector<uint8_t> receiveBuffer;
+    size_t receivedBytes{0};
+    std::vector<uint8_t> message; // Frames of the message being received
+    bool discardMessage{false};
+  };
+
+  /// Make socket non-blocking and hand it over to the event loop
+  void addConnection(std::shared_ptr<Socket> socket);
+  std::shared_ptr<Connection> findConnection(Socket *socket);
+  virtual void removeConnection(Socket *socket);
+
+  /// Frame message and queue it on connection
+  bool queueMessage(Connection &connection, const uint8_t *message,
+                    size_t length);
+
+  /// Serve all connections until mRunning is false
+  void runEventLoop();
+
   uint16_t mVersion = 0,
            mRevision = 0; // Subclasses must set these to ensure compatibility
 
@@ -199,7 +272,7 @@ protected:
   BarrierState mState{BarrierState::NONE};
   std::mutex mConnectionsLock;
 
-  bool mRunning{false};
+  std::atomic<bool> mRunning{false};
   std::vector<std::unique_ptr<std::thread>> mConnectionThreads;
   std::vector<std::unique_ptr<std::thread>> mDataThreads;
   std::vector<std::shared_ptr<al::Socket>>
@@ -207,6 +280,17 @@ protected:
   std::vector<std::pair<uint16_t, uint16_t>> mConnectionVersions;
   al::Socket mSocket; // Bootstrap socket for server, main socket for client.
   bool mVerbose{false};
+
+private:
+  // Send queued frames until the socket would block. sendLock must be held
+  void sendQueued(Connection &connection);
+  // Returns false if the connection was closed
+  bool receive(Connection &connection, bool error);
+  void dispatchMessage(Connection &connection);
+
+  std::vector<std::shared_ptr<Connection>> mConnections;
+  size_t mSendQueueLimit{64 * 1024 * 1024};
+  size_t mMaxMessageSize{256 * 1024 * 1024};
 };
 
 class CommandServer : public CommandConnection {
@@ -246,6 +330,8 @@ public:
                    ValueSource *src = nullptr) override;
 
 protected:
+  void removeConnection(Socket *socket) override;
+
 private:
   std::unique_ptr<std::thread> mBootstrapServerThread;
 
@@ -267,7 +353,6 @@ protected:
 
 private:
   uint16_t mPortOffset = 12000;
-  std::atomic<bool> mBusy{false};
 };
 
 } // namespace al
@@ -329,6 +329,9 @@ public:
   /// Send a packet
   size_t send(const Packet &p);
 
+  /// Send raw, already serialized OSC message or bundle bytes
+  size_t sendRaw(const char *data, size_t size);
+
   /// Send zero argument message immediately
   size_t send(const std::string &addr) {
     addMessage(addr);
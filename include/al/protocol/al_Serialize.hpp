@@ -42,10 +42,12 @@
   Lance Putnam, 2010, putnam.lance@gmail.com
 */
 
-#include <string>
 #include <cstdint>
+#include <string>
+#include <type_traits>
 #include <vector>
-#include "al_Serialize.h"
+
+#include "al/protocol/al_Serialize.h"
 
 namespace al {
 
@@ -116,6 +118,10 @@ inline uint8_t getType<double>() {
   return 'd';
 }
 template <>
+inline uint8_t getType<char>() {
+  return 'h';
+}
+template <>
 inline uint8_t getType<bool>() {
   return 't';
 }
@@ -152,13 +158,93 @@ inline uint8_t getType<int64_t>() {
   return 'I';
 }
 
+// Copy n elements of T from serialized data in b
+template <class T>
+inline uint32_t decode(T* v, const char* b, uint32_t n) {
+  switch (sizeof(T)) {
+    case 1:
+      return serCopy1(v, b, n);
+    case 2:
+      return serCopy2(v, b, n);
+    case 4:
+      return serCopy4(v, b, n);
+    case 8:
+      return serCopy8(v, b, n);
+    default:
+      return 0;
+  }
+}
+
+/// Number of bytes of the LEB128 variable length encoding of v
+inline uint32_t varintSize(uint64_t v) {
+  uint32_t n = 1;
+  while (v >= 0x80) {
+    v >>= 7;
+    n++;
+  }
+  return n;
+}
+
+inline uint32_t encodeVarint(char* b, uint64_t v) {
+  uint32_t n = 0;
+  while (v >= 0x80) {
+    b[n++] = char((v & 0x7F) | 0x80);
+    v >>= 7;
+  }
+  b[n++] = char(v);
+  return n;
+}
+
+/// Returns bytes read or 0 if the value does not end before size
+inline uint32_t decodeVarint(const char* b, uint32_t size, uint64_t& v) {
+  v = 0;
+  for (uint32_t n = 0; n < size && n < 10; n++) {
+    v |= uint64_t((unsigned char)b[n] & 0x7F) << (7 * n);
+    if (((unsigned char)b[n] & 0x80) == 0) {
+      return n + 1;
+    }
+  }
+  return 0;
+}
+
+// Zigzag mapping of signed values so small magnitudes use few varint bytes
+inline uint64_t zigzag(int64_t v) {
+  return (uint64_t(v) << 1) ^ uint64_t(v >> 63);
+}
+inline int64_t unzigzag(uint64_t v) {
+  return int64_t(v >> 1) ^ -int64_t(v & 1);
+}
+
 }  // namespace ser
 
+/// Header type of arrays of unsigned integers in LEB128 varint encoding
+const uint8_t SER_VARINT = 'v';
+/// Header type of arrays of signed integers in zigzag varint encoding
+const uint8_t SER_ZIGZAG = 'z';
+
 ///
 /// \brief The Serializer struct
 ///
+/// By default data is written to an internal buffer that grows as needed and
+/// keeps its capacity across reset(), so a Serializer kept around to build
+/// each packet does not allocate once it has reached the packet size. Data
+/// can also be written directly into a caller provided buffer, for example a
+/// network send buffer. In that case writes that do not fit are dropped and
+/// overflowed() returns true.
+///
+/// Besides the fixed size encoding, integer arrays can be written as
+/// variable length integers with addVarint(), or as the difference to a
+/// reference array with addDelta(). Both produce few bytes for small values,
+/// e.g. state that changed little since the last packet.
+///
 /// @ingroup allocore
 struct Serializer {
+  Serializer() {}
+
+  /// Serialize into buffer, which must hold capacity bytes
+  Serializer(char* buffer, uint32_t capacity)
+      : mExternal(buffer), mCapacity(capacity) {}
+
   template <class T>
   Serializer& operator<<(T v);
 
@@ -168,35 +254,102 @@ struct Serializer {
   template <class T>
   Serializer& add(const T* v, uint32_t num);
 
+  /// Add integer array as variable length integers
+  template <class T>
+  Serializer& addVarint(const T* v, uint32_t num);
+
+  /// Add integer array as varint differences to the values in reference
+  template <class T>
+  Serializer& addDelta(const T* v, const T* reference, uint32_t num);
+
+  /// Start a new message. The internal buffer keeps its capacity
+  void reset();
+
+  const char* data() const { return mExternal ? mExternal : mBuf.data(); }
+  uint32_t size() const { return mSize; }
+
+  /// Returns true if a write did not fit in the caller provided buffer
+  bool overflowed() const { return mOverflow; }
+
+  /// Internal buffer. Empty when writing to a caller provided buffer
   const std::vector<char>& buf() const;
 
  private:
-  std::vector<char> mBuf, mTemp;
+  std::vector<char> mBuf;
+  char* mExternal{nullptr};
+  uint32_t mCapacity{0};
+  uint32_t mSize{0};
+  bool mOverflow{false};
 
+  // Returns where n bytes can be written or nullptr if they don't fit
+  char* reserve(uint32_t n);
   template <class T>
-  void checkSize(uint32_t n = 1);
+  Serializer& addVarints(const T* v, const T* reference, uint32_t num,
+                         std::true_type isSigned);
+  template <class T>
+  Serializer& addVarints(const T* v, const T* reference, uint32_t num,
+                         std::false_type isSigned);
 };
 
 ///
 /// \brief The Deserializer struct
 ///
+/// The Deserializer reads in place from the buffer it is given without
+/// copying it, so the buffer must outlive the Deserializer, and strings read
+/// as const char* point into it. Temporary vectors are not accepted for this
+/// reason. Reads are bounds checked. A read that runs past the end of the
+/// data or finds a different type than requested leaves the value untouched
+/// and makes ok() return false.
+///
 /// @ingroup allocore
 struct Deserializer {
   Deserializer(const std::vector<char>& b);
+  Deserializer(std::vector<char>&& b) = delete;
 
   Deserializer(const char* b, uint32_t n);
 
+  /// Start reading from a new buffer
+  void reset(const char* b, uint32_t n);
+
   template <class T>
   Deserializer& operator>>(T& v);
   Deserializer& operator>>(char* v);
   Deserializer& operator>>(std::string& v);
 
-  const std::vector<char>& buf() const;
+  /// Point v to the string within the buffer, without copying
+  Deserializer& operator>>(const char*& v);
+
+  /// Read up to maxNum elements of an array. Returns elements read
+  template <class T>
+  uint32_t read(T* v, uint32_t maxNum);
+
+  /// Read up to maxNum elements written with Serializer::addVarint()
+  template <class T>
+  uint32_t readVarint(T* v, uint32_t maxNum);
+
+  /// Read up to maxNum elements written with Serializer::addDelta()
+  template <class T>
+  uint32_t readDelta(T* v, const T* reference, uint32_t maxNum);
+
+  /// Returns false if any read failed
+  bool ok() const { return !mFailed; }
+
+  const char* data() const { return mData; }
+  uint32_t size() const { return mSize; }
+  uint32_t position() const { return mStart; }
+  uint32_t remaining() const { return mSize - mStart; }
 
  private:
-  int mStart;
-  std::vector<char> mBuf;
-  char* bufDec();
+  const char* mData;
+  uint32_t mSize;
+  uint32_t mStart;
+  bool mFailed;
+
+  // Reads the next header without moving past it. Returns a pointer to the
+  // elements or nullptr if there is no header of the type
+  const char* header(uint8_t type, SerHeader& h);
+  template <class T>
+  uint32_t readVarints(T* v, const T* reference, uint32_t maxNum);
 };
 
 // =============================================================================
@@ -210,30 +363,122 @@ Serializer& Serializer::operator<<(T v) {
 
 template <class T>
 Serializer& Serializer::add(const T* v, uint32_t num) {
-  checkSize<T>(num);
-  uint32_t n = ser::encode(&mTemp[0], v, num);
-  mBuf.insert(mBuf.end(), mTemp.begin(), mTemp.begin() + n);
+  char* b = reserve(num * sizeof(T) + serHeaderSize());
+  if (b) ser::encode(b, v, num);
+  return *this;
+}
+
+template <class T>
+Serializer& Serializer::addVarint(const T* v, uint32_t num) {
+  return addVarints(v, (const T*)nullptr, num, std::is_signed<T>());
+}
+
+template <class T>
+Serializer& Serializer::addDelta(const T* v, const T* reference,
+                                 uint32_t num) {
+  // Differences can be negative, so always use zigzag encoding
+  return addVarints(v, reference, num, std::true_type());
+}
+
+template <class T>
+Serializer& Serializer::addVarints(const T* v, const T* reference,
+                                   uint32_t num, std::true_type) {
+  uint32_t need = serHeaderSize();
+  for (uint32_t i = 0; i < num; i++) {
+    int64_t d = int64_t(v[i]) - (reference ? int64_t(reference[i]) : 0);
+    need += ser::varintSize(ser::zigzag(d));
+  }
+  char* b = reserve(need);
+  if (b) {
+    serHeaderWrite(b, SER_ZIGZAG, num);
+    b += serHeaderSize();
+    for (uint32_t i = 0; i < num; i++) {
+      int64_t d = int64_t(v[i]) - (reference ? int64_t(reference[i]) : 0);
+      b += ser::encodeVarint(b, ser::zigzag(d));
+    }
+  }
   return *this;
 }
 
 template <class T>
-void Serializer::checkSize(uint32_t n) {
-  uint32_t need = n * sizeof(T) + serHeaderSize();
-  if (mTemp.size() < need) mTemp.resize(need);
+Serializer& Serializer::addVarints(const T* v, const T* /*reference*/,
+                                   uint32_t num, std::false_type) {
+  uint32_t need = serHeaderSize();
+  for (uint32_t i = 0; i < num; i++) need += ser::varintSize(uint64_t(v[i]));
+  char* b = reserve(need);
+  if (b) {
+    serHeaderWrite(b, SER_VARINT, num);
+    b += serHeaderSize();
+    for (uint32_t i = 0; i < num; i++) {
+      b += ser::encodeVarint(b, uint64_t(v[i]));
+    }
+  }
+  return *this;
 }
 
 template <class T>
 Deserializer& Deserializer::operator>>(T& v) {
-  uint32_t n = serDecode(bufDec(), &v);
-  mStart += n;
+  read(&v, 1);
   return *this;
 }
 
-// template <class T>
-// Deserializer& decode(const T * v, uint32_t num){
-//  uint32_t n = decode(bufDec(), v);
-//  return *this;
-//}
+template <class T>
+uint32_t Deserializer::read(T* v, uint32_t maxNum) {
+  SerHeader h;
+  const char* b = header(ser::getType<T>(), h);
+  if (!b) return 0;
+  uint32_t available = remaining() - serHeaderSize();
+  if (h.num > available / sizeof(T)) {
+    mFailed = true;
+    return 0;
+  }
+  uint32_t n = h.num < maxNum ? h.num : maxNum;
+  ser::decode(v, b, n);
+  // Elements that did not fit in v are skipped
+  mStart += serHeaderSize() + h.num * sizeof(T);
+  return n;
+}
+
+template <class T>
+uint32_t Deserializer::readVarint(T* v, uint32_t maxNum) {
+  return readVarints(v, (const T*)nullptr, maxNum);
+}
+
+template <class T>
+uint32_t Deserializer::readDelta(T* v, const T* reference, uint32_t maxNum) {
+  return readVarints(v, reference, maxNum);
+}
+
+template <class T>
+uint32_t Deserializer::readVarints(T* v, const T* reference,
+                                   uint32_t maxNum) {
+  bool zigzag = reference || std::is_signed<T>::value;
+  SerHeader h;
+  const char* b = header(zigzag ? SER_ZIGZAG : SER_VARINT, h);
+  if (!b) return 0;
+  const char* end = mData + mSize;
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < h.num; i++) {
+    uint64_t value;
+    uint32_t bytes = ser::decodeVarint(b, uint32_t(end - b), value);
+    if (bytes == 0) {
+      mFailed = true;
+      return 0;
+    }
+    b += bytes;
+    if (n < maxNum) {
+      if (zigzag) {
+        int64_t offset = reference ? int64_t(reference[n]) : 0;
+        v[n] = T(ser::unzigzag(value) + offset);
+      } else {
+        v[n] = T(value);
+      }
+      n++;
+    }
+  }
+  mStart = uint32_t(b - mData);
+  return n;
+}
 
 }  // namespace al
 
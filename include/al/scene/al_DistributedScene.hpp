@@ -1,6 +1,14 @@
 #ifndef AL_DISTRIBUTEDSCENE_HPP
 #define AL_DISTRIBUTEDSCENE_HPP
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 #include "al/protocol/al_OSC.hpp"
 #include "al/scene/al_DynamicScene.hpp"
 #include "al/ui/al_ParameterServer.hpp"
@@ -22,6 +30,8 @@ public:
   DistributedScene(TimeMasterMode masterMode)
       : DistributedScene("scene", 0, masterMode) {}
 
+  ~DistributedScene();
+
   std::string name() { return mName; }
 
   void registerNotifier(OSCNotifier &notifier);
@@ -42,12 +52,98 @@ public:
    */
   void registerVoiceParameters(SynthVoice *voice);
 
+  /**
+   * @brief Send triggers as packed binary batches instead of one OSC message
+   * per event
+   *
+   * Trigger on, trigger off and free events are packed into an OSC blob sent
+   * to the "/events" address of the scene. Voice classes are sent as integer
+   * ids, with the id to name mapping included once in each batch that uses
+   * the class. Batches carry a sequence number so replicas can detect lost
+   * batches. Replicas accept both protocols, so this only needs to be set on
+   * the sender.
+   *
+   * Trigger fields are captured with SynthVoice::writeTriggerParams().
+   * Enabling allocates a pool of triggerBatchPoolSize batches and starts the
+   * thread that sends them, so queuing an event does not allocate memory
+   * once a voice class has been sent. If all batches are waiting to be sent,
+   * events are dropped and counted in droppedTriggerEvents().
+   */
+  void binaryTriggers(bool enable);
+  bool binaryTriggers() { return mBinaryTriggers; }
+
+  /**
+   * @brief Set the time between sending binary trigger batches
+   *
+   * Defaults to one audio block of 64 frames at 48000Hz. Batches are also
+   * sent whenever flushTriggers() is called.
+   */
+  void triggerBatchInterval(double seconds) { mBatchInterval = seconds; }
+
+  /**
+   * @brief Send pending binary trigger batches
+   *
+   * You can call this at the end of the audio callback to send one batch per
+   * audio block.
+   */
+  void flushTriggers();
+
+  /**
+   * @brief Number of binary trigger batches detected as lost on this replica
+   */
+  uint64_t lostTriggerBatches() { return mLostBatches; }
+
+  /// Binary trigger events dropped because no batch was free
+  uint64_t droppedTriggerEvents() { return mDroppedEvents; }
+
+  /// Maximum bytes of events in a single batch
+  static const size_t maxBatchBytes = 1200;
+  /// Batches allocated when binary triggers are enabled
+  static const size_t triggerBatchPoolSize = 64;
+
 protected:
   void registerCallbackForParameter(SynthVoice *voice, ParameterMeta *param);
 
 private:
+  struct TriggerBatch {
+    std::vector<char> data;
+    uint16_t eventCount{0};
+    std::vector<uint16_t> definedClasses;
+  };
+
+  // Starts a new batch if the event does not fit the current one. Returns
+  // nullptr if a new batch is needed and none is free
+  TriggerBatch *batchForEvent(size_t eventSize);
+  void appendTriggerOn(SynthVoice *voice, int id);
+  void appendTriggerEvent(char type, int id);
+  void batchSenderLoop();
+  // Stop the batch sender thread after it sends what is queued
+  void stopBatchSender();
+  bool consumeEvents(const char *data, size_t size);
+
   OSCNotifier *mNotifier{nullptr};
   std::string mName;
+
+  std::atomic<bool> mBinaryTriggers{false};
+  double mBatchInterval{64.0 / 48000.0};
+  std::vector<TriggerBatch> mBatches;
+  std::vector<TriggerBatch> mFreeBatches;
+  std::vector<TriggerBatch> mSendingBatches;
+  std::vector<std::string> mClassNames;
+  std::mutex mBatchLock;
+  std::mutex mFlushLock;
+  uint32_t mSendSequence{0};
+  std::unique_ptr<std::thread> mBatchSenderThread;
+  std::atomic<bool> mRunBatchSender{false};
+  std::mutex mBatchSenderLock;
+  std::condition_variable mBatchSenderCondition;
+  std::atomic<uint64_t> mDroppedEvents{0};
+
+  // Replica side
+  bool mReceivedBatch{false};
+  uint32_t mExpectedSequence{0};
+  std::atomic<uint64_t> mLostBatches{0};
+  std::unordered_map<uint16_t, int> mRemoteClassIds;
 };
 
 } // namespace al
@@ -205,9 +205,24 @@ public:
 
   /**
    * @brief Enables/disables sorting by distance to listener on graphics render
+   *
+   * Voices are drawn far to near within each PositionedVoice::drawGroup().
+   * Voices that are not a PositionedVoice are drawn before draw group 0.
    */
   void sortDrawingByDistance(bool sort = true);
 
+  /**
+   * @brief Skip drawing voices whose bounds are outside the view
+   *
+   * The view frustum is computed from the projection, view and model matrices
+   * of the Graphics passed to render(). Only voices with a
+   * PositionedVoice::boundingRadius() are culled.
+   */
+  void cullDrawing(bool cull = true) { mCullDrawing = cull; }
+
+  /// Number of voices culled in the last graphics render
+  size_t culledVoices() { return mCulledVoices; }
+
   /**
    * @brief Stop all audio threads. No processing is possible after calling this
    * function
@@ -227,6 +242,20 @@ private:
   DistAtten<> mDistAtten;
 
   bool mSortDrawingByDistance{false};
+  bool mCullDrawing{false};
+  size_t mCulledVoices{0};
+
+  // Voices to draw with their sort key: draw group in bits 32-47 and, when
+  // sorting by distance, the inverted bits of the squared distance in 0-31.
+  // positioned is null for voices that are not a PositionedVoice. Kept
+  // between frames to avoid allocations.
+  struct DrawItem {
+    uint64_t key;
+    SynthVoice *voice;
+    PositionedVoice *positioned;
+  };
+  std::vector<DrawItem> mDrawItems;
+  std::vector<DrawItem> mDrawItemsScratch;
   // For threaded simulation
   std::unique_ptr<ThreadPool> mWorkerThreads; // Update worker threads
   bool mThreadedUpdate{true};
@@ -41,12 +41,16 @@
     Andrés Cabrera mantaraya36@gmail.com
 */
 
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <cstring>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <typeindex>
+#include <unordered_map>
 #include <vector>
 
 #include "al/graphics/al_Graphics.hpp"
@@ -121,6 +125,48 @@ public:
   /*[[nodiscard]]*/ SynthVoice *getVoice(std::string name,
                                          bool forceAlloc = false);
 
+  /**
+   * @brief Get a free voice by voice class id
+   * @param classId id returned by voiceClassId()
+   * @param forceAlloc force allocation of voice even if free voices exist
+   *
+   * Avoids the name lookup in getVoice(std::string) when voices are
+   * requested often. Does not take the class table lock. Taking a voice from
+   * the free list only waits for other threads getting a voice of the same
+   * class, and allocates if allocation is allowed and no voice is free.
+   */
+  /*[[nodiscard]]*/ SynthVoice *getVoice(int classId, bool forceAlloc = false);
+
+  /**
+   * @brief Get the id of a voice class by name
+   * @return the class id or -1 if the name is not known
+   *
+   * Names are those passed to registerSynthClass() or the demangled class
+   * name.
+   */
+  int voiceClassId(std::string name);
+
+  /**
+   * @brief Get the id of a voice class, registering the class if needed
+   * @return the class id or -1 if maxVoiceClasses are registered
+   *
+   * Looks up the type under the class table lock. Cache the id and use
+   * getVoice(int) where that matters.
+   */
+  template <class TSynthVoice> int voiceClassId() {
+    return typeClassId(typeid(TSynthVoice));
+  }
+
+  /**
+   * @brief Get the id of the class of a voice, registering the class if needed
+   */
+  int voiceClassId(SynthVoice *voice);
+
+  /**
+   * @brief Get the registered name for a voice class id
+   */
+  std::string voiceClassName(int classId);
+
   /**
    * @brief Get the first available voice with minimal checks
    * @return
@@ -328,22 +374,27 @@ public:
     if (name.size() == 0) {
       name = demangle(typeid(TSynthVoice).name());
     }
-    if (mCreators.find(name) != mCreators.end()) {
+    int classId = voiceClassId<TSynthVoice>();
+    if (classId < 0) {
+      return;
+    }
+    std::unique_lock<std::mutex> lk(mVoiceClassLock);
+    VoiceClass &voiceClass = *mVoiceClasses[classId];
+    if (voiceClass.creator) {
       if (mVerbose) {
         std::cout << "Warning: Overriding registration of SynthVoice: " << name
                   << std::endl;
       }
     }
     if (!allowAutoAllocation) {
-      if (std::find(mNoAllocationList.begin(), mNoAllocationList.end(), name) ==
-          mNoAllocationList.end()) {
-        mNoAllocationList.push_back(name);
-      }
+      voiceClass.allowAutoAllocation = false;
     }
-    mCreators[name] = [&]() {
+    voiceClass.name = name;
+    voiceClass.creator = [this]() {
       TSynthVoice *voice = allocateVoice<TSynthVoice>();
       return voice;
     };
+    mVoiceClassIds[name] = classId;
   }
 
   SynthVoice *allocateVoice(std::string name);
@@ -351,6 +402,8 @@ public:
   template <class TSynthVoice> TSynthVoice *allocateVoice() {
     TSynthVoice *voice = new TSynthVoice;
     voice->next = nullptr;
+    int classId = voiceClassId<TSynthVoice>();
+    voice->mFreeList = classId >= 0 ? &freeVoices(classId) : nullptr;
     if (mDefaultUserData) {
       voice->userData(mDefaultUserData);
     }
@@ -364,6 +417,24 @@ public:
   bool verbose() { return mVerbose; }
   void verbose(bool verbose) { mVerbose = verbose; }
 
+  /**
+   * @brief Number of audio frames rendered by render(AudioIOData &io)
+   *
+   * Can be read from any thread. Trigger events at offsetFrames within the
+   * current block happen at sampleTime() + offsetFrames.
+   */
+  uint64_t sampleTime() const {
+    return mSampleTime.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Sample rate of the last rendered audio block, 0 if no audio has
+   * been rendered yet
+   */
+  double sampleRate() const {
+    return mSampleRate.load(std::memory_order_relaxed);
+  }
+
   /**
    * @brief getActiveVoices
    * @return
@@ -379,13 +450,13 @@ public:
 
   /**
    * @brief getFreeVoices
-   * @return
+   * @return a snapshot of the voices in the free pools of all voice classes
    *
-   * This function is unsafe and should be used with extreme care. Ensure that
-   * no allocation, voice insertion or removal takes place while working with
-   * these voices.
+   * The voices can be taken from the pools at any time after this call.
+   * Ensure that no allocation, voice insertion or removal takes place while
+   * working with these voices.
    */
-  SynthVoice *getFreeVoices() { return mFreeVoices; }
+  std::vector<SynthVoice *> getFreeVoices();
 
   /**
    * @brief Determines the number of output channels allocated for the internal
@@ -471,23 +542,14 @@ public:
       mVoiceToInsertLock.unlock();
     }
     if (mAllNotesOff) {
-      if (mFreeVoiceLock.try_lock()) {
-        mAllNotesOff = false;
-        if (mActiveVoices) {
-          auto voice = mActiveVoices->next;
-          SynthVoice *previousVoice = mActiveVoices;
-          previousVoice->id(-1);
-          while (voice) {
-            voice->id(-1);
-            previousVoice = voice;
-            voice = voice->next;
-          }
-          previousVoice->next =
-              mFreeVoices; // Connect last active voice to first free voice
-          mFreeVoices = mActiveVoices; // Move all voices to free voices
-          mActiveVoices = nullptr;     // No active voices left
-        }
-        mFreeVoiceLock.unlock();
+      mAllNotesOff = false;
+      auto voice = mActiveVoices;
+      mActiveVoices = nullptr; // No active voices left
+      while (voice) {
+        auto *nextVoice = voice->next;
+        voice->id(-1);
+        releaseVoice(voice); // Move to the free voices of its class
+        voice = nextVoice;
       }
     }
   }
@@ -542,42 +604,29 @@ public:
    * In other modes it is called in the render() function for the domain.
    */
   inline void processInactiveVoices() {
-    // Move inactive voices to free queue
-    if (mFreeVoiceLock.try_lock()) { // Attempt to remove inactive voices
-      // without waiting.
-      auto *voice = mActiveVoices;
-      SynthVoice *previousVoice = nullptr;
-      while (voice) {
-        if (!voice->active()) {
-          int id = voice->id();
-          //          std::cout << " ****((((())))) **** Remove inactive voice:
-          //          " << voice << std::endl;
-          if (previousVoice) {
-            previousVoice->next = voice->next; // Remove from active list
-            voice->next = mFreeVoices;
-            mFreeVoices = voice; // Insert as head in free voices
-            voice->id(-1);       // Reset voice id
-            voice->onFree();
-            voice = previousVoice; // prepare next iteration
-          } else {                 // Inactive is head of the list
-            auto *nextVoice = voice->next;
-            mActiveVoices = nextVoice; // Remove voice from list
-            voice->next = mFreeVoices;
-            mFreeVoices = voice; // Insert as head in free voices
-            voice->id(-1);       // Reset voice id
-            voice->onFree();
-            voice = voice->next; // prepare next iteration
-          }
-          for (const auto &cbNode : mFreeCallbacks) {
-            cbNode.first(id, cbNode.second);
-          }
+    // Move inactive voices to the free voices of their class. Free lists
+    // accept voices without locking, so this never waits.
+    auto *voice = mActiveVoices;
+    SynthVoice *previousVoice = nullptr;
+    while (voice) {
+      auto *nextVoice = voice->next;
+      if (!voice->active()) {
+        int id = voice->id();
+        if (previousVoice) {
+          previousVoice->next = nextVoice; // Remove from active list
+        } else {                           // Inactive is head of the list
+          mActiveVoices = nextVoice;
         }
-        previousVoice = voice;
-        if (voice) {
-          voice = voice->next;
+        voice->id(-1); // Reset voice id
+        voice->onFree();
+        releaseVoice(voice);
+        for (const auto &cbNode : mFreeCallbacks) {
+          cbNode.first(id, cbNode.second);
         }
+      } else {
+        previousVoice = voice;
       }
-      mFreeVoiceLock.unlock();
+      voice = nextVoice;
     }
   }
 
@@ -599,16 +648,53 @@ protected:
 
   virtual void prepare(AudioIOData &io);
 
+  inline void advanceSampleTime(AudioIOData &io) {
+    mSampleRate.store(io.framesPerSecond(), std::memory_order_relaxed);
+    mSampleTime.fetch_add(io.framesPerBuffer(), std::memory_order_release);
+  }
+
+  typedef std::function<SynthVoice *()> VoiceCreatorFunc;
+
+  /// Voice classes are interned on registration or first use. The class id is
+  /// the index in mVoiceClasses.
+  struct VoiceClass {
+    std::string name;
+    VoiceCreatorFunc creator;
+    std::atomic<bool> allowAutoAllocation{true};
+    /// Allocated voices of this class available for reuse
+    SynthVoiceFreeList freeVoices;
+  };
+
+  /// mVoiceClasses is reserved for this many classes so entries never move
+  static const int maxVoiceClasses = 256;
+
+  int typeClassId(const std::type_info &type);
+
+  /// Free voices of a class. Ids come from voiceClassId(), so the entry
+  /// exists and can be read without the class table lock.
+  SynthVoiceFreeList &freeVoices(int classId) {
+    return mVoiceClasses[classId]->freeVoices;
+  }
+
+  /// Return voice to the free list of its class
+  void releaseVoice(SynthVoice *voice) {
+    if (!voice->mFreeList) { // Voice allocated outside PolySynth
+      int classId = voiceClassId(voice);
+      if (classId < 0) { // Not reused
+        return;
+      }
+      voice->mFreeList = &freeVoices(classId);
+    }
+    voice->mFreeList->push(voice);
+  }
+
   /// Voices to be inserted in the realtime context. Internal voices are
   /// allocated in PolySynth and shared with the outside.
   SynthVoice *mVoicesToInsert{nullptr};
-  /// Allocated voices available for reuse
-  SynthVoice *mFreeVoices{nullptr};
   /// Dynamic voices that are currently active. Only modified
   /// within the master domain (set by mMasterMode)
   SynthVoice *mActiveVoices{nullptr};
   std::mutex mVoiceToInsertLock;
-  std::mutex mFreeVoiceLock;
   std::mutex mGraphicsLock; // TODO: remove this lock?
 
   bool m_useInternalAudioIO = true;
@@ -647,17 +733,21 @@ protected:
 
   int mIdCounter{1000};
 
+  std::atomic<uint64_t> mSampleTime{0};
+  std::atomic<double> mSampleRate{0.0};
+
   // Flag used to notify processing to turn off all voices
   bool mAllNotesOff{false};
 
-  typedef std::function<SynthVoice *()> VoiceCreatorFunc;
-  typedef std::map<std::string, VoiceCreatorFunc> Creators;
-
   void *mDefaultUserData{nullptr};
 
-  Creators mCreators;
-  // Disallow auto allocation for class name. Set in allocateVoice()
-  std::vector<std::string> mNoAllocationList;
+  std::vector<std::unique_ptr<VoiceClass>> mVoiceClasses;
+  std::atomic<int> mVoiceClassCount{0};
+  std::unordered_map<std::string, int> mVoiceClassIds;
+  std::unordered_map<std::type_index, int> mVoiceTypeIds;
+  // Protects the class tables when adding or looking up classes. Not taken
+  // when getting or freeing voices by class id.
+  std::mutex mVoiceClassLock;
   std::vector<size_t> mChannelMap; // Maps synth output to audio channels
 
   bool mRunCPUClock{true};
@@ -668,39 +758,24 @@ protected:
 };
 
 template <class TSynthVoice> void PolySynth::disableAllocation() {
-  std::string name = demangle(typeid(TSynthVoice).name());
-  disableAllocation(name);
+  int classId = voiceClassId<TSynthVoice>();
+  if (classId >= 0) {
+    mVoiceClasses[classId]->allowAutoAllocation = false;
+  }
 }
 
 template <class TSynthVoice> TSynthVoice *PolySynth::getVoice(bool forceAlloc) {
-  std::unique_lock<std::mutex> lk(
-      mFreeVoiceLock); // Only one getVoice() call at a time
-  SynthVoice *freeVoice = mFreeVoices;
-  SynthVoice *previousVoice = nullptr;
-  if (forceAlloc) {
-    freeVoice = nullptr;
-  } else {
-    while (freeVoice) {
-      if (std::type_index(typeid(*freeVoice)) ==
-          std::type_index(typeid(TSynthVoice))) {
-        if (previousVoice) {
-          previousVoice->next = freeVoice->next;
-        } else {
-          mFreeVoices = freeVoice->next;
-        }
-        break;
-      }
-      previousVoice = freeVoice;
-      freeVoice = freeVoice->next;
-    }
+  int classId = voiceClassId<TSynthVoice>();
+  if (classId < 0) {
+    return nullptr;
+  }
+  SynthVoice *freeVoice = nullptr;
+  if (!forceAlloc) {
+    freeVoice = freeVoices(classId).pop();
   }
   if (!freeVoice) { // No free voice in list, so we need to allocate it
-    // TODO report current polyphony for more informed allocation of polyphony
-    // TODO check if allocation allowed
     //  But only allocate if allocation has not been disabled
-    std::string name = demangle(typeid(TSynthVoice).name());
-    if (std::find(mNoAllocationList.begin(), mNoAllocationList.end(), name) ==
-        mNoAllocationList.end()) {
+    if (mVoiceClasses[classId]->allowAutoAllocation) {
       // TODO report current polyphony for more informed allocation of polyphony
       freeVoice = allocateVoice<TSynthVoice>();
       if (mVerbose) {
@@ -708,27 +783,17 @@ template <class TSynthVoice> TSynthVoice *PolySynth::getVoice(bool forceAlloc) {
                   << "." << std::endl;
       }
     } else {
-      std::cout << "Automatic allocation disabled for voice:" << name
-                << std::endl;
+      std::cout << "Automatic allocation disabled for voice:"
+                << voiceClassName(classId) << std::endl;
     }
   }
   return static_cast<TSynthVoice *>(freeVoice);
 }
 
 template <class TSynthVoice> void PolySynth::allocatePolyphony(int number) {
-  std::unique_lock<std::mutex> lk(mFreeVoiceLock);
-  SynthVoice *lastVoice = mFreeVoices;
-  if (lastVoice) {
-    while (lastVoice->next) {
-      lastVoice = lastVoice->next;
-    }
-  } else {
-    lastVoice = mFreeVoices = allocateVoice<TSynthVoice>();
-    number--;
-  }
   for (int i = 0; i < number; i++) {
-    lastVoice->next = allocateVoice<TSynthVoice>();
-    lastVoice = lastVoice->next;
+    auto *voice = allocateVoice<TSynthVoice>();
+    voice->mFreeList->push(voice);
   }
 }
 
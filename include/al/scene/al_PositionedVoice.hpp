@@ -75,6 +75,25 @@ public:
 
   Parameter &parameterSize() { return mSize; }
 
+  /**
+   * @brief Set the radius of a sphere around the voice position that contains
+   * everything the voice draws, before scaling by size()
+   *
+   * DynamicScene uses it to skip drawing voices outside the view when culling
+   * is enabled. Voices with a radius of 0 (the default) are always drawn.
+   */
+  void boundingRadius(float radius) { mBoundingRadius = radius; }
+  float boundingRadius() { return mBoundingRadius; }
+
+  /**
+   * @brief Set the group used to order drawing
+   *
+   * DynamicScene draws voices in ascending group order, so voices that share
+   * a shader or material can be drawn together.
+   */
+  void drawGroup(uint16_t group) { mDrawGroup = group; }
+  uint16_t drawGroup() { return mDrawGroup; }
+
   bool useDistanceAttenuation() { return mUseDistAtten; }
   void useDistanceAttenuation(bool atten) { mUseDistAtten = atten; }
 
@@ -148,6 +167,12 @@ public:
     return pFields;
   }
 
+  /**
+   * @brief For PositionedVoice, the pose (7 floats) and the size are appended
+   * to the pfields
+   */
+  virtual void writeTriggerParams(TriggerParamWriter &writer) override;
+
   /**
    * @brief Apply translation, rotation and scaling for this PositionedVoice
    * @param g
@@ -165,6 +190,9 @@ protected:
                                 // audio out
 
   bool mUseDistAtten{true};
+
+  float mBoundingRadius{0};
+  uint16_t mDrawGroup{0};
 };
 
 } // namespace al
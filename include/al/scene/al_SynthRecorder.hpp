@@ -43,8 +43,12 @@
         Andrés Cabrera mantaraya36@gmail.com
 */
 
+#include <atomic>
 #include <chrono>
 #include <fstream>
+#include <thread>
+#include <typeindex>
+#include <unordered_map>
 
 #include "al/io/al_File.hpp"
 #include "al/scene/al_SynthSequencer.hpp"
@@ -73,7 +77,18 @@ namespace al {
  * connect the 'trigger off' to a previous 'trigger on'.
  *
  * Alternatively, the sequence can be recorded in CPP_FORMAT that produces C++
- * code that can be pasted to deliver the sequence.
+ * code that can be pasted to deliver the sequence, or in BINARY_FORMAT that
+ * stores event times as exact frame counts. SynthSequencer can load both text
+ * and binary sequence files.
+ *
+ * Events are timestamped with the audio sample clock of the PolySynth
+ * (PolySynth::sampleTime()) if audio is running when recording starts, or with
+ * a microsecond wall clock otherwise. The trigger callbacks copy the event
+ * and its SynthVoice::writeTriggerParams() fields, including the pose and
+ * size of a PositionedVoice, into a preallocated lock-free queue without
+ * allocating. A writer thread collects them, so recording does not block the
+ * threads that trigger voices. Events are dropped and counted in
+ * droppedEvents() if the queue is full.
  *
  * The sequences stored in the text file can be played back using SynthSequencer
  * You must make sre that the synthesizers referenced in the sequence have
@@ -97,11 +112,14 @@ class SynthRecorder {
                          // trigger off can be separate entries (uses '+' and
                          // '-' text commands)
     CPP_FORMAT,          // Saves code that can be copy-pasted into C++
+    BINARY_FORMAT,       // Binary triggers with exact frame times
     NONE
   } TextFormat;
 
   SynthRecorder(TextFormat format = SEQUENCER_EVENT) { mFormat = format; }
 
+  ~SynthRecorder();
+
   void setDirectory(std::string path) {
     if (!File::exists(path)) {
       if (!Dir::make(path)) {
@@ -118,9 +136,12 @@ class SynthRecorder {
 
   void setMaxRecordTime(al_sec maxTime) { mMaxRecordTime = maxTime; }
 
-  void verbose(bool verbose) { mVerbose = true; }
+  void verbose(bool verbose) { mVerbose = verbose; }
   bool verbose() { return mVerbose; }
 
+  /// Events dropped because the event queue was full in the last recording
+  uint64_t droppedEvents() { return mDroppedEvents; }
+
   //	std::string lastSequenceName();
   //	std::string lastSequenceSubDir();
 
@@ -142,87 +163,76 @@ class SynthRecorder {
    * @param userData
    */
   static bool onTriggerOn(SynthVoice *voice, int offsetFrames, int id,
-                          void *userData) {
-    std::chrono::high_resolution_clock::time_point now =
-        std::chrono::high_resolution_clock::now();
-    SynthRecorder *rec = static_cast<SynthRecorder *>(userData);
-    if (rec->mRecording) {
-      std::unique_lock<std::mutex> lk(rec->mSequenceLock);
-      if (rec->mStartOnEvent) {
-        rec->mSequenceStart = now;
-        rec->mStartOnEvent = false;
-      }
-      std::chrono::duration<double> diff = now - rec->mSequenceStart;
-      std::vector<VariantValue> pFields = voice->getTriggerParams();
-
-      SynthEvent event;
-      event.type = SynthEventType::TRIGGER_ON;
-      event.id = voice->id();
-      event.time = diff.count();
-      event.synthName = demangle(typeid(*voice).name());
-      event.duration = -1;
-      event.pFields = pFields;
-      rec->mSequence.push_back(event);
-      if (rec->verbose()) {
-        std::cout << "trigger at " << event.time << ":" << event.synthName
-                  << ":" << voice->id() << std::endl;
-      }
-    }
-    return true;
-  }
+                          void *userData);
 
   /**
    * @brief onTriggerOff callback for trigger off events
    * @param id
    * @param userData
    */
-  static bool onTriggerOff(int id, void *userData) {
-    std::chrono::high_resolution_clock::time_point now =
-        std::chrono::high_resolution_clock::now();
-    SynthRecorder *rec = static_cast<SynthRecorder *>(userData);
-    if (rec->mRecording) {
-      std::unique_lock<std::mutex> lk(rec->mSequenceLock);
-      //            if (rec->mStartOnEvent) {
-      //                rec->mSequenceStart = now;
-      //                rec->mStartOnEvent = false;
-      //            }
-      std::chrono::duration<double> diff = now - rec->mSequenceStart;
-
-      SynthEvent event;
-      event.type = SynthEventType::TRIGGER_OFF;
-      event.id = id;
-      event.time = diff.count();
-      //            event.synthName = demangle(typeid (*voice).name() );
-      event.duration = -1;
-      //            for (int i = 0; i < numFields; i++) {
-      //                event.pFields.push_back(pFields[i]);
-      //            }
-      rec->mSequence.push_back(event);
-      if (rec->verbose()) {
-        std::cout << "trigger OFF at " << event.time << ":" << event.synthName
-                  << ":" << id << std::endl;
-      }
-    }
-    return true;
-  }
+  static bool onTriggerOff(int id, void *userData);
+
+  /// Maximum number of pfields captured per event
+  static const int kMaxFields = 32;
+  /// Maximum bytes for the string pfields of an event
+  static const int kMaxStringBytes = 128;
+  /// Events that can be queued before the writer thread collects them
+  static const size_t kQueueSize = 4096;
 
  private:
+  // Fixed size event copied from the trigger callbacks. Strings are stored
+  // zero separated in strings, and stringMask marks which fields are strings
+  struct CapturedEvent {
+    std::atomic<size_t> sequence;
+    SynthEventType type;
+    int id;
+    const std::type_info *voiceType;
+    uint64_t time;
+    int numFields;
+    uint32_t stringMask;
+    float fields[kMaxFields];
+    char strings[kMaxStringBytes];
+  };
+
+  // Bounded multiple producer, single consumer queue
+  bool pushEvent(SynthEventType type, int id, SynthVoice *voice,
+                 int offsetFrames);
+  void collectEvents();
+  void writerLoop();
+
+  uint64_t now() const;
+
   std::string mDirectory;
   PolySynth *mPolySynth{nullptr};
   TextFormat mFormat;
-  bool mVerbose;
+  bool mVerbose{false};
 
   bool mOverwrite;
   std::string mSequenceName;
 
-  std::mutex mSequenceLock;
-
-  bool mRecording{false};
+  std::atomic<bool> mRecording{false};
   bool mStartOnEvent{true};
 
   al_sec mMaxRecordTime;
-  std::chrono::high_resolution_clock::time_point mSequenceStart;
+  // Timestamps are frames if mTickRate is the audio sample rate or
+  // microseconds otherwise
+  double mTickRate{1.0e6};
+  bool mUseSampleClock{false};
+  uint64_t mStartTime{0};
+  std::chrono::steady_clock::time_point mClockStart;
+
+  std::unique_ptr<CapturedEvent[]> mQueue;
+  std::atomic<size_t> mEnqueuePos{0};
+  size_t mDequeuePos{0};
+  std::atomic<uint64_t> mDroppedEvents{0};
+
+  std::unique_ptr<std::thread> mWriterThread;
+  std::atomic<bool> mRunWriter{false};
+
+  // Only accessed by the writer thread while recording
   std::vector<SynthEvent> mSequence;
+  std::vector<uint64_t> mSequenceTimes;
+  std::unordered_map<std::type_index, std::string> mVoiceNames;
 };
 
 // Implementation
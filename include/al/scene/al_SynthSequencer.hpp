@@ -173,6 +173,21 @@ struct SynthEvent {
  *
  * When SynthSequencer controls a DynamicScene, 8 additional values are appended
  * corresponding to position(x,y,z), quaternion (w, x,y,z) and size.
+ *
+ * Sequence files written by SynthRecorder in BINARY_FORMAT are detected by
+ * their header and loaded as timed events. All numbers are little endian:
+ *
+ * "ALSQ" version(u32) tickRate(f64) nameCount(u32) {length(u16) name}...
+ *
+ * followed by events until the end of the file:
+ *
+ * type(u8, 0 on, 1 off) ticks(u64) eventId(i32)
+ *
+ * and for trigger on events:
+ *
+ * nameIndex(u32) fieldCount(u8) {'f' value(f32) | 's' length(u16) string}...
+ *
+ * Event times in seconds are ticks / tickRate.
  */
 
 class SynthSequencer {
@@ -268,6 +283,10 @@ public:
                                               double timeOffset = 0,
                                               double timeScale = 1.0);
 
+  /// Header identifying binary sequence files
+  static constexpr const char *binaryMagic = "ALSQ";
+  static const uint32_t binaryVersion = 1;
+
   /**
    * @brief play the event list provided all other events in list are discarded
    */
@@ -302,6 +321,10 @@ public:
   void operator<<(PolySynth &synth) { return registerSynth(synth); }
 
 private:
+  std::list<SynthSequencerEvent> loadBinarySequence(std::string fullName,
+                                                    double timeOffset,
+                                                    double timeScale);
+
   PolySynth *mPolySynth;
   std::unique_ptr<PolySynth> mInternalSynth;
 
@@ -41,8 +41,10 @@
     Andrés Cabrera mantaraya36@gmail.com
 */
 
+#include <atomic>
 #include <chrono>
 #include <cstring>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <typeindex>
@@ -57,6 +59,23 @@
 
 namespace al {
 
+class SynthVoiceFreeList;
+
+/**
+ * @brief Receives trigger parameter fields from
+ * SynthVoice::writeTriggerParams()
+ * @ingroup Scene
+ */
+class TriggerParamWriter {
+public:
+  virtual ~TriggerParamWriter() {}
+
+  virtual void writeFloat(float value) = 0;
+
+  /// value is zero terminated and only valid during the call
+  virtual void writeString(const char *value, size_t length) = 0;
+};
+
 /**
  * @brief The SynthVoice class
  * @ingroup Scene
@@ -157,6 +176,20 @@ the other
    */
   virtual std::vector<VariantValue> getTriggerParams();
 
+  /**
+   * @brief Pass this instance's parameter fields to writer without allocating
+   * memory
+   *
+   * Writes the same fields as getTriggerParams(). This is used to capture
+   * fields in trigger callbacks, which can run on the audio thread. If you
+   * override getTriggerParams(), override this function too. String fields
+   * are truncated to maxTriggerStringLength characters.
+   */
+  virtual void writeTriggerParams(TriggerParamWriter &writer);
+
+  /// Maximum length of string fields passed by writeTriggerParams()
+  static const size_t maxTriggerStringLength = 255;
+
   /**
    * @brief Override this function to define audio processing.
    * @param io
@@ -437,6 +470,78 @@ private:
   int mOffOffsetFrames{0};
   void *mUserData;
   unsigned int mNumOutChannels{1};
+  // Pool this voice returns to when freed. Set by PolySynth
+  SynthVoiceFreeList *mFreeList{nullptr};
+};
+
+/**
+ * @brief Stack of free voices of a single voice class
+ * @ingroup Scene
+ *
+ * push() is lock-free and can be called from the audio thread, so voices are
+ * freed in the rendering context without waiting. pop() and the other
+ * functions are not lock-free. They are serialized by a mutex, which makes the
+ * stack safe from the ABA problem as only one thread removes voices at a time.
+ * The mutex is only contended by threads getting voices of the same class.
+ */
+class SynthVoiceFreeList {
+public:
+  void push(SynthVoice *voice) {
+    SynthVoice *head = mHead.load(std::memory_order_relaxed);
+    do {
+      voice->next = head;
+    } while (!mHead.compare_exchange_weak(head, voice, std::memory_order_release,
+                                          std::memory_order_relaxed));
+  }
+
+  /// Remove and return a voice, or nullptr if empty
+  SynthVoice *pop() {
+    std::unique_lock<std::mutex> lk(mPopLock);
+    SynthVoice *head = mHead.load(std::memory_order_acquire);
+    while (head &&
+           !mHead.compare_exchange_weak(head, head->next,
+                                        std::memory_order_acquire,
+                                        std::memory_order_acquire)) {
+    }
+    if (head) {
+      head->next = nullptr;
+    }
+    return head;
+  }
+
+  /// Remove a specific voice. Returns false if not found
+  bool remove(SynthVoice *voice) {
+    std::unique_lock<std::mutex> lk(mPopLock);
+    SynthVoice *list = mHead.exchange(nullptr, std::memory_order_acquire);
+    bool found = false;
+    while (list) {
+      SynthVoice *next = list->next;
+      if (list == voice) {
+        voice->next = nullptr;
+        found = true;
+      } else {
+        push(list);
+      }
+      list = next;
+    }
+    return found;
+  }
+
+  /// Append current free voices to voices
+  void collect(std::vector<SynthVoice *> &voices) {
+    std::unique_lock<std::mutex> lk(mPopLock);
+    SynthVoice *voice = mHead.load(std::memory_order_acquire);
+    while (voice) {
+      voices.push_back(voice);
+      voice = voice->next;
+    }
+  }
+
+  bool empty() const { return mHead.load(std::memory_order_acquire) == nullptr; }
+
+private:
+  std::atomic<SynthVoice *> mHead{nullptr};
+  std::mutex mPopLock;
 };
 
 } // namespace al
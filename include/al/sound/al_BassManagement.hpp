@@ -0,0 +1,108 @@
+#ifndef AL_BASSMANAGEMENT
+#define AL_BASSMANAGEMENT
+
+#include <atomic>
+#include <vector>
+
+#include "al/io/al_AudioIOData.hpp"
+#include "al/sound/al_BiquadBank.hpp"
+#include "al/sound/al_Speaker.hpp"
+
+namespace al {
+
+/**
+ * @brief Route the low frequencies of a speaker layout to subwoofers
+ * @ingroup Sound
+ *
+ * Every main speaker is split with a 4th order Linkwitz-Riley crossover. The
+ * highs replace the speaker's output and the lows are summed into the
+ * subwoofer channels, after a per speaker delay and gain. The lows and highs
+ * of a speaker sum back to an allpass response, so the crossover is
+ * inaudible when the subwoofers are aligned with the mains.
+ *
+ * The crossovers of all speakers run in a BiQuadBank, so channels are
+ * filtered in SIMD lanes. Audio is processed in fixed size blocks and
+ * process() does not allocate. Speaker gains, delays and the crossover
+ * frequency can be changed while audio is running.
+ *
+ * The sum of the lows is split evenly among the subwoofers, so adding
+ * subwoofers does not change the overall bass level. Any signal already in
+ * the subwoofer channels (e.g. an LFE feed) is kept.
+ */
+class BassManagement {
+ public:
+  /**
+   * @brief Allocate buffers and filters for a layout
+   * @param mains speakers to bass manage
+   * @param subwoofers device channels of the subwoofers
+   * @param crossoverFrequency crossover frequency in Hz
+   * @param sampleRate sample rate of the audio stream
+   * @param maxDelay maximum speaker delay in samples
+   */
+  void configure(const Speakers &mains, const std::vector<unsigned> &subwoofers,
+                 float crossoverFrequency = 80.0f, double sampleRate = 44100,
+                 unsigned maxDelay = 4096);
+
+  /// Set the crossover frequency of all speakers in Hz
+  void crossoverFrequency(float frequency);
+  float crossoverFrequency() const { return mCrossoverFrequency; }
+
+  /// Set the gain applied to a main speaker's lows before summing
+  void speakerGain(size_t speaker, float gain);
+  float speakerGain(size_t speaker) const { return mGains[speaker]; }
+
+  /// Set the delay in samples applied to a main speaker's lows before summing.
+  /// It is clamped to the maximum passed to configure()
+  void speakerDelay(size_t speaker, unsigned samples);
+  unsigned speakerDelay(size_t speaker) const { return mDelays[speaker]; }
+
+  /// Filter the output buffers of io in place
+  void processBass(AudioIOData &io);
+
+ private:
+  static const int kBlockFrames = 256;
+
+  Speakers mMains;
+  std::vector<unsigned> mSubwoofers;
+  float mCrossoverFrequency{80.0f};
+  double mSampleRate{44100};
+
+  BiQuadBank mHighPass;  // Filters the main outputs in place
+  BiQuadBank mLowPass;   // Filters mLows
+  std::vector<std::atomic<float>> mGains;
+  std::vector<std::atomic<unsigned>> mDelays;
+  unsigned mMaxDelay{0};
+
+  std::vector<float *> mMainBuffers;
+  std::vector<float *> mLowBuffers;
+  std::vector<float> mLows;  // kBlockFrames per speaker
+  std::vector<float> mSum;   // kBlockFrames
+  // Delay lines of the lows, one per speaker, mDelayMask + 1 long
+  std::vector<float> mDelayLines;
+  unsigned mDelayMask{0};
+  unsigned mDelayWrite{0};
+};
+
+/**
+ * @brief This class is added for convenience to append bass management to
+ * AudioIO processing
+ *
+ * @code
+ * BassManagementProcessor bassManagement;
+ * bassManagement.configure(speakerLayout, {60, 61}, 80.0f,
+ *                          audioIO().framesPerSecond());
+ * audioIO().append(bassManagement);
+ * @endcode
+ */
+class BassManagementProcessor : public AudioCallback, public BassManagement {
+ public:
+  virtual void onAudioCB(AudioIOData &io) { this->processBass(io); }
+
+ private:
+  // Hide this function to users of this class
+  using BassManagement::processBass;
+};
+
+}  // namespace al
+
+#endif  // AL_BASSMANAGEMENT
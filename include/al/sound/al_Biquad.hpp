@@ -40,6 +40,10 @@ class BiQuad {
 
   void enable(bool on) { enabled = on; }
 
+  /// Normalized coefficients computed by set(). a0-a2 are the feedforward and
+  /// a3-a4 the feedback coefficients
+  const BiquadData &coefficients() const { return mBD; }
+
  private:
   BIQUADTYPE mType;
   BiquadData mBD;
@@ -0,0 +1,141 @@
+#ifndef AL_BIQUADBANK
+#define AL_BIQUADBANK
+
+#include <atomic>
+#include <vector>
+
+#include "al/io/al_AudioIOData.hpp"
+#include "al/sound/al_Biquad.hpp"
+
+namespace al {
+
+/**
+ * @brief Bank of cascaded biquad filters applied to many channels at once
+ * @ingroup Sound
+ *
+ * Each channel has its own chain of biquad sections, e.g. for per speaker room
+ * correction. Channels are grouped in sets of kLanes and each group is
+ * filtered together, one channel per SIMD lane, using the transposed direct
+ * form II.
+ *
+ * Coefficients are staged with setSection() from any single thread and become
+ * active all at once on the audio thread after commit(), so the audio thread
+ * never sees a half updated chain. configure() allocates and must not be
+ * called while process() can run.
+ *
+ * All sections pass audio through unchanged until they are set.
+ */
+class BiQuadBank {
+ public:
+  /// Number of channels filtered together
+  static const int kLanes = 4;
+
+  /// Normalized coefficients of a single section
+  struct Coefficients {
+    float b0{1.0f}, b1{0.0f}, b2{0.0f};  // Feedforward
+    float a1{0.0f}, a2{0.0f};            // Feedback
+  };
+
+  /**
+   * @brief Allocate the bank and reset all sections to pass through
+   * @param numChannels number of channels to filter
+   * @param numSections number of cascaded biquads per channel
+   * @param sampleRate sample rate used to compute coefficients in setSection()
+   */
+  void configure(unsigned numChannels, unsigned numSections,
+                 double sampleRate = 44100);
+
+  unsigned channels() const { return mNumChannels; }
+  unsigned sections() const { return mNumSections; }
+  double sampleRate() const { return mSampleRate; }
+
+  /// Stage a section computed with the same formulas as BiQuad::set()
+  void setSection(unsigned channel, unsigned section, BIQUADTYPE type,
+                  double freq, double bandwidth = 1.9, double dbGain = 0);
+
+  /// Stage a section from normalized coefficients
+  void setSection(unsigned channel, unsigned section,
+                  const Coefficients &coefficients);
+
+  /// Staged coefficients of a section
+  Coefficients section(unsigned channel, unsigned section) const;
+
+  /// Make all the sections staged so far active on the next processed block
+  void commit();
+
+  /// Clear the filter state on the next processed block
+  void reset() { mResetPending = true; }
+
+  /**
+   * @brief Filter non interleaved buffers in place
+   * @param buffers one buffer per channel. Null buffers are skipped
+   * @param count number of frames in each buffer
+   */
+  void process(float *const *buffers, int count);
+
+  /// Filter the output buffers of io in place
+  void processOutputs(AudioIOData &io);
+
+ private:
+  static const int kBlockFrames = 256;
+
+  // Coefficients of one section for a group of channels, one per lane
+  struct LaneCoefficients {
+    float b0[kLanes], b1[kLanes], b2[kLanes], a1[kLanes], a2[kLanes];
+  };
+
+  struct LaneState {
+    float z1[kLanes], z2[kLanes];
+  };
+
+  static void processSection(float *frames, int count,
+                             const LaneCoefficients &c, LaneState &state);
+
+  unsigned mNumChannels{0};
+  unsigned mNumSections{0};
+  unsigned mNumGroups{0};
+  double mSampleRate{44100};
+
+  // Coefficients indexed by group * sections + section. mStaged belongs to
+  // the writer, the other three sets form a triple buffer between commit()
+  // and the audio thread
+  std::vector<LaneCoefficients> mStaged;
+  std::vector<LaneCoefficients> mSets[3];
+  int mWriteSet{1};
+  int mReadSet{0};
+  std::atomic<int> mPendingSet{2};  // Set index, plus kNewSet if unread
+  static const int kNewSet = 4;
+
+  std::vector<LaneState> mState;
+  std::atomic<bool> mResetPending{false};
+  std::vector<float *> mBuffers;
+  float mFrames[kBlockFrames * kLanes];
+};
+
+/**
+ * @brief This class is added for convenience to append a BiQuadBank to
+ * AudioIO processing
+ *
+ * @code
+ * BiQuadBankProcessor roomCorrection;
+ * roomCorrection.configure(60, 4, audioIO().framesPerSecond());
+ * roomCorrection.setSection(0, 0, BIQUAD_PEQ, 120, 1.0, -6.0);
+ * roomCorrection.commit();
+ * audioIO().append(roomCorrection);
+ * @endcode
+ *
+ * The filters are applied to the output buffers after the AudioIO main
+ * callback function has been processed.
+ */
+class BiQuadBankProcessor : public AudioCallback, public BiQuadBank {
+ public:
+  virtual void onAudioCB(AudioIOData &io) { this->processOutputs(io); }
+
+ private:
+  // Hide this function to users of this class
+  using BiQuadBank::processOutputs;
+};
+
+}  // namespace al
+
+#endif  // AL_BIQUADBANK
@@ -47,6 +47,7 @@
 
 #include <float.h>
 #include <stdio.h>
+#include <cmath>
 
 #include "al/math/al_Constants.hpp"
 
@@ -82,11 +83,11 @@ protected:
   T mC0, mC1, mZ0, mZ1, mZ2;
 };
 
-template <> void Crossover<double>::freq(double f, double fs) {
+template <> inline void Crossover<double>::freq(double f, double fs) {
   double rad = M_PI * 2. * f / fs;
   double cosine = cos(rad);
   double sine = sin(rad);
-  if (abs(c) > 0.0001) {
+  if (fabs(cosine) > 0.0001) {
     mC0 = (sine - 1.) / cosine;
   } else {
     mC0 = cosine * 0.5;
@@ -115,7 +116,7 @@ inline void Crossover<double>::next(const double in, double *lo, double *hi) {
   *hi = x0 - x2;
 }
 
-template <> void Crossover<float>::freq(float f, float fs) {
+template <> inline void Crossover<float>::freq(float f, float fs) {
   float rad = M_PI * 2.f * f / fs;
   float cosine = cosf(rad);
   float sine = sinf(rad);
@@ -0,0 +1,103 @@
+#ifndef AL_FDNREVERB
+#define AL_FDNREVERB
+
+#include <vector>
+
+namespace al {
+
+/**
+ * @brief Feedback delay network reverb with many decorrelated outputs
+ * @ingroup Sound
+ *
+ * A set of delay lines of mutually prime lengths feed back into each other
+ * through an orthogonal mixing matrix. Each output is taken from a different
+ * delay line, so the outputs are decorrelated and can feed one speaker each to
+ * render a diffuse field. Adding outputs only adds delay lines, and mixing N
+ * lines with the Hadamard matrix costs N log N, so the cost per output grows
+ * with log N.
+ *
+ * Audio is processed in blocks no longer than the shortest delay, so the
+ * mixing runs on whole blocks of each line at once. All delay lines share one
+ * contiguous allocation with each line starting on a cache line.
+ *
+ * @code
+ * FDNReverb reverb;
+ * reverb.configure(64, audioIO().framesPerSecond());
+ * reverb.decayTime(2.5f).damping(0.3f);
+ * // In the audio callback, mix the reverb of bus 0 into outputs 0-63
+ * reverb.process(io.busBuffer(0), outputs, io.framesPerBuffer());
+ * @endcode
+ */
+class FDNReverb {
+ public:
+  /// Feedback matrix
+  enum Mixing {
+    HADAMARD,    ///< Dense mixing, N log N operations
+    HOUSEHOLDER  ///< Reflection, N operations but slower diffusion
+  };
+
+  /**
+   * @brief Allocate the delay network
+   * @param numOutputs number of decorrelated outputs
+   * @param sampleRate sample rate of the audio stream
+   * @param numDelays number of delay lines, rounded up to a power of two. If 0
+   * it is the number of outputs, but at least 8
+   * @param minDelay shortest delay line in seconds
+   * @param maxDelay longest delay line in seconds
+   */
+  void configure(unsigned numOutputs, double sampleRate, unsigned numDelays = 0,
+                 float minDelay = 0.02f, float maxDelay = 0.1f);
+
+  unsigned outputs() const { return mNumOutputs; }
+  unsigned delays() const { return mNumDelays; }
+
+  /// Set the time for the reverb to decay by 60 dB, in seconds
+  FDNReverb &decayTime(float seconds);
+  float decayTime() const { return mDecayTime; }
+
+  /// Set high-frequency damping amount, in [0, 1)
+  FDNReverb &damping(float v);
+
+  /// Set the feedback matrix
+  FDNReverb &mixing(Mixing m);
+
+  /// Set gain of outputs
+  FDNReverb &gain(float v);
+
+  /// Zero the delay lines
+  void zero();
+
+  /**
+   * @brief Compute the reverb of a mono input
+   * @param in dry input
+   * @param outs one buffer per output, the wet signal is added to them
+   * @param frames number of frames in the buffers
+   */
+  void process(const float *in, float *const *outs, int frames);
+
+ private:
+  void updateGains();
+  void mixBlock(int frames);
+
+  unsigned mNumOutputs{0};
+  unsigned mNumDelays{0};
+  int mBlockFrames{0};  // Largest block, no longer than the shortest delay
+  double mSampleRate{44100};
+  float mDecayTime{1.5f};
+  float mDamping{0.2f};
+  float mGain{1.0f};
+  Mixing mMixing{HADAMARD};
+
+  std::vector<float> mMemory;  // Delay lines and block buffer
+  std::vector<float *> mLines;
+  std::vector<unsigned> mLengths;
+  std::vector<unsigned> mPositions;
+  std::vector<float> mFeedback;    // Per line gain for the decay time
+  std::vector<float> mInputGains;  // Signs spreading the input
+  std::vector<float> mFilterState;
+  float *mBlock{nullptr};  // mBlockFrames per line
+};
+
+}  // namespace al
+
+#endif  // AL_FDNREVERB
@@ -0,0 +1,151 @@
+#ifndef AL_LEVELMETER
+#define AL_LEVELMETER
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "al/io/al_AudioIOData.hpp"
+#include "al/protocol/al_OSC.hpp"
+#include "al/sound/al_BiquadBank.hpp"
+#include "al/types/al_TripleBuffer.hpp"
+
+namespace al {
+
+/**
+ * @brief Levels measured by a LevelMeter
+ * @ingroup Sound
+ *
+ * Levels are linear amplitudes, loudness is in LUFS.
+ */
+struct LevelMeterSnapshot {
+  std::vector<float> peak;      ///< Sample peak with release
+  std::vector<float> rms;       ///< Smoothed RMS level
+  std::vector<float> truePeak;  ///< 4x oversampled peak with release
+  float loudness{-70.0f};       ///< Momentary loudness of all channels
+  uint64_t frames{0};           ///< Frames measured so far
+};
+
+/**
+ * @brief Multichannel peak, RMS, true peak and loudness meter
+ * @ingroup Sound
+ *
+ * process() runs on the audio thread and publishes a LevelMeterSnapshot after
+ * every buffer through a lock-free triple buffer, so it never waits for the
+ * reader. One other thread, typically the graphics thread, calls update() and
+ * reads snapshot(), and can forward the snapshot to monitoring clients over
+ * OSC with send().
+ *
+ * Peaks hold their maximum and fall at a fixed rate in dB per second and RMS
+ * is smoothed over a time constant, so snapshots skipped by a slow reader do
+ * not hide short peaks. True peak follows ITU-R BS.1770 with a 4x polyphase
+ * interpolator. Loudness is the momentary (400 ms) K-weighted loudness of all
+ * channels with equal weights, and can be turned off to save processing.
+ *
+ * configure() allocates, process() does not. configure() must not be called
+ * while process() or update() may run on another thread.
+ */
+class LevelMeter {
+ public:
+  /**
+   * @brief Allocate the meter
+   * @param numChannels number of channels measured
+   * @param sampleRate sample rate of the audio stream
+   */
+  void configure(unsigned numChannels, double sampleRate);
+
+  unsigned channels() const { return mNumChannels; }
+  double sampleRate() const { return mSampleRate; }
+
+  /// Set how fast peaks fall, in dB per second
+  void peakRelease(float dbPerSecond) { mPeakRelease = dbPerSecond; }
+
+  /// Set the RMS smoothing time constant, in seconds
+  void rmsTime(float seconds) { mRmsTime = seconds; }
+
+  /// Enable loudness measurement
+  void loudness(bool enable) { mLoudnessEnabled = enable; }
+
+  /// Measure non interleaved buffers, one per channel
+  void process(const float *const *buffers, int frames);
+
+  /// Measure the output buffers of io
+  void processOutputs(AudioIOData &io);
+
+  /**
+   * @brief Take the latest snapshot published by the audio thread
+   * @return true if there is a new snapshot
+   */
+  bool update() { return mSnapshots.update(); }
+
+  /// Snapshot taken by the last call to update()
+  const LevelMeterSnapshot &snapshot() { return mSnapshots.front(); }
+
+  /**
+   * @brief Send the current snapshot as OSC messages
+   * @param sender OSC sender
+   * @param prefix address prefix
+   * @return number of bytes sent
+   *
+   * Sends <prefix>/peak, <prefix>/rms and <prefix>/truePeak with one float
+   * per channel, and <prefix>/loudness, in one bundle. Call from the same
+   * thread as update().
+   */
+  size_t send(osc::Send &sender, const std::string &prefix = "/meter");
+
+ private:
+  static const int kBlockFrames = 256;
+  static const int kTruePeakTaps = 12;
+
+  void measureTruePeak(unsigned channel, const float *buffer, int frames,
+                       float &peak);
+
+  unsigned mNumChannels{0};
+  double mSampleRate{44100};
+  float mPeakRelease{20.0f};
+  float mRmsTime{0.3f};
+  bool mLoudnessEnabled{true};
+
+  std::vector<float> mPeak, mMeanSquare, mTruePeak;
+  std::vector<float> mHistory;  // Last inputs of each channel for true peak
+  std::vector<float> mInterpolated;
+  std::vector<float> mExtended;
+
+  BiQuadBank mKWeighting;
+  std::vector<float> mWeighted;  // kBlockFrames per channel
+  std::vector<float *> mWeightedBuffers;
+  std::vector<float> mFrameEnergy;
+  // Energy of the last four 100 ms blocks make the 400 ms window
+  double mLoudnessBlocks[4]{0, 0, 0, 0};
+  int mLoudnessIndex{0};
+  int mLoudnessFrames{0};
+  int mLoudnessBlockLength{0};
+  double mLoudnessEnergy{0};
+  uint64_t mFrames{0};
+
+  std::vector<const float *> mBuffers;
+  TripleBuffer<LevelMeterSnapshot> mSnapshots;
+};
+
+/**
+ * @brief This class is added for convenience to append a LevelMeter to
+ * AudioIO processing
+ *
+ * @code
+ * LevelMeterProcessor meter;
+ * meter.configure(audioIO().channelsOut(), audioIO().framesPerSecond());
+ * audioIO().append(meter);
+ * @endcode
+ */
+class LevelMeterProcessor : public AudioCallback, public LevelMeter {
+ public:
+  virtual void onAudioCB(AudioIOData &io) { this->processOutputs(io); }
+
+ private:
+  // Hide this function to users of this class
+  using LevelMeter::processOutputs;
+};
+
+}  // namespace al
+
+#endif  // AL_LEVELMETER
@@ -0,0 +1,183 @@
+#ifndef INCLUDE_AL_BVH_HPP
+#define INCLUDE_AL_BVH_HPP
+
+/*  Allolib --
+  Multimedia / virtual environment application class library
+
+  Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+  Copyright (C) 2012-2018. The Regents of the University of California.
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    Neither the name of the University of California nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  File description:
+  Bounding volume hierarchy of axis aligned boxes for ray queries
+
+  File author(s):
+  AlloSphere Research Group
+*/
+
+#include <cstdint>
+#include <vector>
+
+#include "al/math/al_Ray.hpp"
+#include "al/math/al_Vec.hpp"
+
+namespace al {
+
+/**
+ * @brief The BVH class is a bounding volume hierarchy over items with axis
+ * aligned bounds.
+ * @ingroup Spatial
+ *
+ * Items are identified by their index in the bounds passed to build(). Ray
+ * queries only test the items whose boxes the ray crosses, visiting nearer
+ * boxes first so the search stops early once a close hit is found.
+ *
+ * When items move, refit() updates the boxes of their ancestors without
+ * rebuilding the tree. The tree gets looser as items move far from where
+ * they were built, so rebuild after large changes.
+ *
+ * @code
+ * BVH bvh;
+ * bvh.build(mins, maxs);
+ * size_t item;
+ * double t = bvh.nearest(ray, [&](size_t i) { return intersectItem(i, ray); },
+ *                        item);
+ * @endcode
+ */
+class BVH {
+public:
+  /// Maximum number of items in a leaf
+  static const int kLeafSize = 4;
+
+  /**
+   * @brief Build the tree
+   * @param mins minimum corner of each item's bounds
+   * @param maxs maximum corner of each item's bounds
+   */
+  void build(const std::vector<Vec3d> &mins, const std::vector<Vec3d> &maxs);
+
+  void clear();
+
+  /// Number of items in the tree
+  size_t size() const { return mItemLeaf.size(); }
+
+  /// Set new bounds for an item and update the bounds of its ancestors
+  void refit(size_t item, const Vec3d &min, const Vec3d &max);
+
+  /// Bounds of all items
+  bool bounds(Vec3d &min, Vec3d &max) const;
+
+  /**
+   * @brief Find the nearest item hit by a ray
+   * @param ray ray to test
+   * @param testItem function taking an item index and returning the ray
+   * parameter of the hit, or a value <= 0 if the item is missed
+   * @param item set to the index of the nearest item hit
+   * @return the ray parameter of the nearest hit or -1 if nothing was hit
+   */
+  template <class TestFunction>
+  double nearest(const Rayd &ray, TestFunction testItem, size_t &item) const;
+
+  /// Collect all the items whose bounds are crossed by a ray
+  void query(const Rayd &ray, std::vector<size_t> &items) const;
+
+private:
+  struct Node {
+    Vec3d min, max;
+    int32_t parent;
+    // Children for internal nodes, range in mItems for leaves
+    int32_t left, right;
+    uint32_t first, count;
+
+    bool leaf() const { return count > 0; }
+  };
+
+  int32_t buildNode(uint32_t first, uint32_t count, int32_t parent);
+  void updateLeafBounds(int32_t node);
+
+  // Entry parameter of the ray into a box or a negative value if missed
+  static double intersectBox(const Vec3d &origin, const Vec3d &invDir,
+                             const Vec3d &min, const Vec3d &max);
+
+  std::vector<Node> mNodes;
+  std::vector<size_t> mItems; // Item indices ordered by leaf
+  std::vector<int32_t> mItemLeaf;
+  std::vector<Vec3d> mItemMin, mItemMax;
+  std::vector<Vec3d> mCentroids; // Only used while building
+};
+
+template <class TestFunction>
+double BVH::nearest(const Rayd &ray, TestFunction testItem,
+                    size_t &item) const {
+  double best = -1.0;
+  if (mNodes.empty()) {
+    return best;
+  }
+  Vec3d invDir(1.0 / ray.d.x, 1.0 / ray.d.y, 1.0 / ray.d.z);
+  int32_t stack[64];
+  int stackSize = 0;
+  if (intersectBox(ray.o, invDir, mNodes[0].min, mNodes[0].max) >= 0) {
+    stack[stackSize++] = 0;
+  }
+  while (stackSize > 0) {
+    const Node &node = mNodes[stack[--stackSize]];
+    if (best > 0 && intersectBox(ray.o, invDir, node.min, node.max) > best) {
+      continue; // Box is behind the nearest hit found so far
+    }
+    if (node.leaf()) {
+      for (uint32_t i = node.first; i < node.first + node.count; i++) {
+        double t = testItem(mItems[i]);
+        if (t > 0 && (best < 0 || t < best)) {
+          best = t;
+          item = mItems[i];
+        }
+      }
+      continue;
+    }
+    double tLeft = intersectBox(ray.o, invDir, mNodes[node.left].min,
+                                mNodes[node.left].max);
+    double tRight = intersectBox(ray.o, invDir, mNodes[node.right].min,
+                                 mNodes[node.right].max);
+    // Push the farther child first so the nearer one is visited first
+    if (tLeft >= 0 && tRight >= 0) {
+      bool leftFirst = tLeft <= tRight;
+      stack[stackSize++] = leftFirst ? node.right : node.left;
+      stack[stackSize++] = leftFirst ? node.left : node.right;
+    } else if (tLeft >= 0) {
+      stack[stackSize++] = node.left;
+    } else if (tRight >= 0) {
+      stack[stackSize++] = node.right;
+    }
+  }
+  return best;
+}
+
+} // namespace al
+
+#endif // INCLUDE_AL_BVH_HPP
@@ -42,10 +42,12 @@
 */
 
 #include "al/graphics/al_Graphics.hpp"
+#include <atomic>
 #include <cstring>
 #include "al/graphics/al_Mesh.hpp"
 #include "al/graphics/al_Shapes.hpp"
 #include "al/io/al_AudioIOData.hpp"
+#include "al/sound/al_LevelMeter.hpp"
 #include "al/sound/al_Speaker.hpp"
 
 using namespace al;
@@ -56,6 +58,15 @@ using namespace al;
  * You can use this in a distributed system by calculating audio levels on
  * the audio renderer, and then sending the values to renderer nodes.
  *
+ * Levels are measured by a LevelMeter on the audio thread and published
+ * without locking. draw(), getMeterValues() and levels() read them and must
+ * be called from the same thread, usually the graphics thread.
+ *
+ * If the audio stream has a different number of channels or sample rate
+ * than given to init(), processSound() stops metering and the next call to
+ * one of these functions reconfigures the meter, so the audio thread never
+ * allocates.
+ *
  * @code
 
 struct SharedState {
@@ -92,6 +103,18 @@ public:
    * @param sl The speaker layout
    */
   void init(const Speakers &sl);
+
+  /**
+   * @brief Initialize and allocate the level meter
+   * @param sl The speaker layout
+   * @param numChannels number of output channels metered
+   * @param sampleRate sample rate of the audio stream
+   *
+   * Metering starts on the first processSound() call. With init(sl), or if
+   * the number of channels or the sample rate differ from these, metering
+   * starts after the meter is reconfigured from the reader thread.
+   */
+  void init(const Speakers &sl, unsigned numChannels, double sampleRate);
   /**
    * @brief Call this function on every audio callback
    * @param io the audio IO data
@@ -109,7 +132,21 @@ public:
    *
    * Useful to share the values measured to render nodes
    */
-  const std::vector<float> &getMeterValues() { return values; }
+  const std::vector<float> &getMeterValues() {
+    updateValues();
+    return values;
+  }
+
+  /**
+   * @brief Access the level meter
+   *
+   * Use it to read peak, RMS, true peak and loudness or to send them over
+   * OSC, e.g. levels().send(sender) to feed a monitoring client.
+   */
+  LevelMeter &levels() {
+    applyConfiguration();
+    return mLevels;
+  }
 
   /**
    * @brief set meter values to display
@@ -121,9 +158,17 @@ public:
   void setMeterValues(float *newValues, size_t count);
 
 private:
+  void updateValues();
+  // Configure the level meter if processSound() requested it
+  void applyConfiguration();
+
   Mesh mMesh;
+  LevelMeter mLevels;
+  // Set by the audio thread, cleared by the reader thread once configured
+  std::atomic<bool> mConfigureRequested{false};
+  unsigned mRequestedChannels{0};
+  double mRequestedSampleRate{0};
   std::vector<float> values;
-  std::vector<float> tempValues;
   Speakers mSl;
 };
 
@@ -88,13 +88,33 @@ public:
   // std::vector<Vec3f> warp_data;
   // std::vector<float> blend_data;
   std::vector<Vec4f> warp_and_blend_data;
+  // half float bits, 4 per pixel. filled instead of warp_and_blend_data
+  // when WarpBlendData::keep_half_float is set
+  std::vector<uint16_t> warp_and_blend_data_half;
+
+  // warp and blend value for pixel from whichever data is loaded
+  Vec4f warp_and_blend(size_t i) const;
 };
 
 class WarpBlendData {
 public:
   std::vector<ProjectionViewport> viewports;
+  // if not empty, a binary cache of the calibration for each host is kept in
+  // this directory and used while the calibration files are unchanged
+  std::string cache_directory;
+  // keep warp and blend data as half floats to halve memory use
+  bool keep_half_float = false;
+
   void load_allosphere_calibration(const char *path, const char *hostname);
   void load_desktop_mode_calibration();
+
+  // read viewports from cache file written by write_calibration_cache().
+  // fails if the cache is from another version, corrupt or older than the
+  // calibration files it was made from.
+  bool read_calibration_cache(const std::string &cache_path,
+                              const std::string &config_path);
+  bool write_calibration_cache(const std::string &cache_path,
+                               const std::string &config_path);
 };
 
 class PerProjectionRender {
@@ -120,6 +140,7 @@ public:
   Graphics *g;
   VAOMesh texquad;
   bool calibration_loaded = false;
+  bool desktop_config_initialized = false;
   bool did_begin = false;
   int current_eye = 0;
   int current_projection = 0;
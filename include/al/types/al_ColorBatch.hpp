@@ -0,0 +1,103 @@
+#ifndef INCLUDE_AL_COLORBATCH_HPP
+#define INCLUDE_AL_COLORBATCH_HPP
+
+/*  Allolib --
+  Multimedia / virtual environment application class library
+
+  Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+  Copyright (C) 2012-2018. The Regents of the University of California.
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    Neither the name of the University of California nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  File description:
+  Conversion of arrays of colors between RGB and perceptual color spaces
+
+  File author(s):
+  AlloSphere Research Group
+*/
+
+
+#include <cstddef>
+
+#include "al/types/al_Color.hpp"
+
+namespace al {
+
+/// @addtogroup allocore
+/// @{
+///
+/// Batch color conversions work on whole arrays with SIMD instructions where
+/// available. They follow the same formulas (sRGB, reference white D65) as the
+/// single color classes, with pow, atan2, sin and cos replaced by polynomial
+/// approximations. Results stay within 1e-5 of the single color conversions
+/// for RGB and normalized HCLab components, and within 1e-3 for Lab
+/// components.
+///
+/// The planar (SoA) kernels take one array per component. Destination arrays
+/// may be the same as source arrays.
+
+/// Decode sRGB components to linear intensity
+void srgbToLinear(const float *src, float *dst, size_t count);
+
+/// Encode linear intensity to sRGB components, clamped to [0, 1]
+void linearToSrgb(const float *src, float *dst, size_t count);
+
+/// Convert planar sRGB to Lab
+void rgbToLab(const float *r, const float *g, const float *b, float *L,
+              float *A, float *B, size_t count);
+
+/// Convert planar Lab to sRGB, clamped to [0, 1]
+void labToRgb(const float *L, const float *A, const float *B, float *r,
+              float *g, float *b, size_t count);
+
+/// Convert planar Lab to HCLab
+void labToHCLab(const float *L, const float *A, const float *B, float *h,
+                float *c, float *l, size_t count);
+
+/// Convert planar HCLab to Lab
+void hcLabToLab(const float *h, const float *c, const float *l, float *L,
+                float *A, float *B, size_t count);
+
+/// Convert array of colors to Lab
+void convertColors(const Color *src, Lab *dst, size_t count);
+
+/// Convert array of Lab colors to RGBA with given alpha
+void convertColors(const Lab *src, Color *dst, size_t count, float alpha = 1.f);
+
+/// Convert array of colors to HCLab
+void convertColors(const Color *src, HCLab *dst, size_t count);
+
+/// Convert array of HCLab colors to RGBA with given alpha
+void convertColors(const HCLab *src, Color *dst, size_t count,
+                   float alpha = 1.f);
+
+/// @}
+
+} // namespace al
+
+#endif // INCLUDE_AL_COLORBATCH_HPP
@@ -0,0 +1,106 @@
+#ifndef INCLUDE_AL_COLORMAP_HPP
+#define INCLUDE_AL_COLORMAP_HPP
+
+/*  Allolib --
+  Multimedia / virtual environment application class library
+
+  Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+  Copyright (C) 2012-2018. The Regents of the University of California.
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    Neither the name of the University of California nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  File description:
+  Lookup tables mapping scalar values to colors
+
+  File author(s):
+  AlloSphere Research Group
+*/
+
+
+#include <cstddef>
+#include <vector>
+
+#include "al/types/al_Color.hpp"
+
+namespace al {
+
+/// Precomputed table mapping scalar values to colors
+///
+/// The table is built by interpolating a list of color stops in Lab space,
+/// so steps in value give even steps in perceived color. Mapping arrays of
+/// values only computes table indices, so it can fill Mesh::colors() for
+/// large meshes every frame:
+///
+/// @code
+///   ColorMap colormap(ColorMap::VIRIDIS);
+///   colormap.map(values.data(), values.size(), mesh.colors(), minValue,
+///                maxValue);
+/// @endcode
+///
+/// @ingroup allocore
+class ColorMap {
+public:
+  /// Perceptually uniform maps from matplotlib, sampled at 10 stops
+  enum Preset { VIRIDIS, MAGMA, INFERNO, PLASMA, GRAY };
+
+  /// @param[in] preset  color stops to use
+  /// @param[in] size    number of table entries
+  ColorMap(Preset preset = VIRIDIS, unsigned size = 256);
+
+  /// @param[in] stops  colors evenly spaced from the lowest to the highest value
+  /// @param[in] size   number of table entries
+  ColorMap(const std::vector<Color> &stops, unsigned size = 256);
+
+  /// Rebuild table from preset color stops
+  void set(Preset preset, unsigned size = 256);
+
+  /// Rebuild table from color stops
+  void set(const std::vector<Color> &stops, unsigned size = 256);
+
+  /// Get the table entries
+  const std::vector<Color> &table() const { return mTable; }
+
+  /// Get color for a value in [0, 1]. Values outside are clamped
+  const Color &operator()(float t) const;
+
+  /// Map values in [lo, hi] to colors. Values outside are clamped, NaN maps
+  /// to the lowest color.
+  void map(const float *values, Color *dst, size_t count, float lo = 0.f,
+           float hi = 1.f) const;
+
+  /// Map values in [lo, hi] to colors, resizing dst to count
+  void map(const float *values, size_t count, std::vector<Color> &dst,
+           float lo = 0.f, float hi = 1.f) const;
+
+private:
+  std::vector<Color> mTable;
+};
+
+} // namespace al
+
+#endif // INCLUDE_AL_COLORMAP_HPP
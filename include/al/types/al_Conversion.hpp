@@ -150,12 +150,21 @@ uint32_t floatExponent(float v);
 /// Returns mantissa field as float between [0, 1).
 float floatMantissa(float v);
 
+/// Convert 32-bit float to 16-bit IEEE 754 half float bits
+
+/// Rounds to nearest even. Values too large for half precision become
+/// infinity and values too small become zero.
+uint16_t floatToHalf(float v);
+
 /// Converts linear integer phase to fraction
 
 ///  2^bits is the effective size of the lookup table. \n
 ///  Note: the fraction only has 24-bits of precision.
 float fraction(uint32_t bits, uint32_t phase);
 
+/// Convert 16-bit IEEE 754 half float bits to 32-bit float
+float halfToFloat(uint16_t v);
+
 /// Convert 16-bit signed integer to floating point in [-1, 1)
 float intToUnit(int16_t v);
 
@@ -316,6 +325,45 @@ inline float floatMantissa(float v) {
   return punUF(frac) - 1.f;
 }
 
+inline uint16_t floatToHalf(float v) {
+  const uint32_t i = punFU(v);
+  const uint32_t sign = (i >> 16) & 0x8000;
+  const uint32_t expo = (i >> 23) & 0xff;
+  uint32_t frac = i & MaskFrac<float>();
+  if (expo == 0xff) {  // infinity or NaN
+    return uint16_t(sign | 0x7c00 | (frac ? 0x200 : 0));
+  }
+  const int32_t halfExpo = int32_t(expo) - 127 + 15;
+  if (halfExpo >= 0x1f) return uint16_t(sign | 0x7c00);  // overflow
+  uint32_t shift = 13;
+  uint32_t h;
+  if (halfExpo <= 0) {  // subnormal half
+    if (halfExpo < -10) return uint16_t(sign);
+    frac |= 0x800000;
+    shift = uint32_t(14 - halfExpo);
+    h = frac >> shift;
+  } else {
+    h = (uint32_t(halfExpo) << 10) | (frac >> shift);
+  }
+  // Round to nearest even. A carry into the exponent is still correct.
+  const uint32_t rem = frac & ((1u << shift) - 1);
+  const uint32_t mid = 1u << (shift - 1);
+  if (rem > mid || (rem == mid && (h & 1))) ++h;
+  return uint16_t(sign | h);
+}
+
+inline float halfToFloat(uint16_t v) {
+  const uint32_t sign = uint32_t(v & 0x8000) << 16;
+  const uint32_t expo = (v >> 10) & 0x1f;
+  const uint32_t frac = v & 0x3ff;
+  if (expo == 0x1f) return punUF(sign | 0x7f800000 | (frac << 13));
+  if (expo == 0) {  // zero or subnormal
+    const float f = float(frac) * (1.f / 16777216.f);  // 2^-24
+    return sign ? -f : f;
+  }
+  return punUF(sign | ((expo + 112) << 23) | (frac << 13));
+}
+
 inline float fraction(uint32_t bits, uint32_t phase) {
   phase = phase << bits >> 9 | Expo1<float>();
   return punUF(phase) - 1.f;
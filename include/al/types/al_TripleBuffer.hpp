@@ -0,0 +1,111 @@
+#ifndef AL_TRIPLEBUFFER_HPP
+#define AL_TRIPLEBUFFER_HPP
+
+/*	Allolib --
+   Multimedia / virtual environment application class library
+
+   Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology,
+   UCSB. Copyright (C) 2012-2018. The Regents of the University of California.
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   Neither the name of the University of California nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+   IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+   PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+   OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+   OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+   ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+   File description:
+   Lock-free triple buffer to pass the latest value between two threads
+   File author(s):
+   AlloSphere Research Group
+*/
+
+#include <atomic>
+#include <cstdint>
+
+namespace al {
+
+/**
+ * @brief Lock-free triple buffer for a single writer and a single reader
+ * @ingroup Types
+ *
+ * The writer fills back() and calls publish(). The reader calls update() and
+ * then reads front(). Neither side ever waits, and the reader always gets the
+ * most recently published value. Values published between two update() calls
+ * are skipped.
+ */
+template <class T> class TripleBuffer {
+public:
+  /// Slot the writer can fill. Only use from the writer thread
+  T &back() { return mSlots[mBack]; }
+
+  /// Make the contents of back() available to the reader
+  void publish() {
+    uint8_t previous =
+        mMiddle.exchange(uint8_t(mBack | freshBit), std::memory_order_acq_rel);
+    mBack = previous & indexMask;
+  }
+
+  /**
+   * @brief Take the latest published value
+   * @return true if a new value was published since the last call
+   *
+   * Only use from the reader thread.
+   */
+  bool update() {
+    if (!(mMiddle.load(std::memory_order_relaxed) & freshBit)) {
+      return false;
+    }
+    uint8_t previous = mMiddle.exchange(mFront, std::memory_order_acq_rel);
+    mFront = previous & indexMask;
+    return true;
+  }
+
+  /// Latest value taken by update(). Only use from the reader thread
+  T &front() { return mSlots[mFront]; }
+
+  /**
+   * @brief Call f on each of the three slots
+   *
+   * Use to allocate or reset all slots. Only call while neither the writer
+   * nor the reader are using the buffer.
+   */
+  template <class F> void forEachSlot(F f) {
+    for (auto &slot : mSlots) {
+      f(slot);
+    }
+  }
+
+private:
+  static const uint8_t indexMask = 0x3;
+  static const uint8_t freshBit = 0x4;
+
+  T mSlots[3];
+  uint8_t mFront{0};
+  uint8_t mBack{1};
+  std::atomic<uint8_t> mMiddle{2};
+};
+
+} // namespace al
+
+#endif // AL_TRIPLEBUFFER_HPP
@@ -33,11 +33,11 @@
 
 
         File description:
-        Voxel Array Class for scientific volumetric data, containing
+        Voxel class for scientific volumetric data, containing
         physical metadata
 
-        Base structure utilizes 3D AlloArray class, with support for
-        MRC file format
+        Volumes are stored as cubic bricks that are decoded on demand,
+        with support for MRC file format and mip levels
 
         File author(s):
         Matt Wright, 2015, matt@create.ucsb.edu
@@ -47,15 +47,12 @@
 #ifndef INCLUDE_ALLO_VOXELS_HPP
 #define INCLUDE_ALLO_VOXELS_HPP
 
-#include <cmath>
 #include <cstdint>
-#include <fstream>
-#include <iostream>
-#include <sstream>
+#include <cstdio>
+#include <list>
+#include <memory>
 #include <string>
 #include <vector>
-#include "al/core/types/al_Conversion.hpp"
-#include "al/util/al_Array.hpp"
 
 namespace al {
 
@@ -149,42 +146,54 @@ struct MRCHeader {
   char labels[10][80];
 };
 
-/// OBJECT-oriented interface to AlloArray
+/// How MRC volume data is read
+enum MRCAccess {
+  MRC_MAP,   // map the file into memory, the OS pages data in and out
+  MRC_STREAM // read bricks from the file as they are needed
+};
+
+struct MRCSource;
+
+/// Volume of scalar values stored in cubic bricks
+///
+/// Bricks are allocated when first written to or decoded from a file when
+/// first read. A brick whose values are all equal is stored as a single value,
+/// so empty regions of a sparse volume use almost no memory. Bricks loaded from
+/// a file and bricks of mip levels are kept in a least recently used cache
+/// whose size can be limited, so volumes larger than memory can be traversed.
+///
+/// Mip level 0 is the full resolution volume. Each following level halves the
+/// resolution, averaging 2x2x2 voxels, down to a level that fits in one brick.
+///
+/// Accessors are const but update the brick cache, so a Voxels object must not
+/// be read from several threads at once.
 ///
 /// @ingroup allocore
-class Voxels : public Array {
+class Voxels {
  public:
-  Voxels() : Array() { init(1, 1, 1, VOX_METERS); }
+  Voxels();
 
   /// Construct dimx x dimy x dimz voxel grid giving 3D size of each voxel
   /// cuboid with units
-  Voxels(AlloTy ty, uint32_t dimx, uint32_t dimy, uint32_t dimz, float sizex,
-         float sizey, float sizez, UnitsTy units)
-      : Array(1, ty, dimx, dimy, dimz) {
-    init(sizex, sizey, sizez, units);
-  }
-
-  /// Construct dimx x dimy x dimz voxel grid giving 3D size of each voxel
-  /// cuboid in meters
-  Voxels(AlloTy ty, uint32_t dimx, uint32_t dimy, uint32_t dimz, float sizex,
-         float sizey, float sizez)
-      : Array(1, ty, dimx, dimy, dimz) {
-    init(sizex, sizey, sizez, VOX_METERS);
-  }
+  Voxels(uint32_t dimx, uint32_t dimy, uint32_t dimz, float sizex, float sizey,
+         float sizez, UnitsTy units);
 
   /// Construct dimx x dimy x dimz voxel grid giving dimension of each voxel
   /// cube with units
-  Voxels(AlloTy ty, uint32_t dimx, uint32_t dimy, uint32_t dimz,
-         float voxelsize, UnitsTy units)
-      : Array(1, ty, dimx, dimy, dimz) {
-    init(voxelsize, voxelsize, voxelsize, units);
-  }
+  Voxels(uint32_t dimx, uint32_t dimy, uint32_t dimz, float voxelsize,
+         UnitsTy units);
 
   /// Construct dimx x dimy x dimz voxel grid with every voxel 1m x 1m x 1m
-  Voxels(AlloTy ty, uint32_t dimx, uint32_t dimy, uint32_t dimz)
-      : Array(1, ty, dimx, dimy, dimz) {
-    init(1, 1, 1, VOX_METERS);
-  }
+  Voxels(uint32_t dimx, uint32_t dimy, uint32_t dimz);
+
+  Voxels(const Voxels &) = delete;
+  Voxels &operator=(const Voxels &) = delete;
+
+  ~Voxels();
+
+  /// Set dimensions, releasing all data. Voxels read as background()
+  void format(uint32_t dimx, uint32_t dimy, uint32_t dimz,
+              uint32_t brickSize = 32);
 
   void init(float voxWidthX, float voxWidthY, float voxWidthZ, UnitsTy units) {
     m_voxWidth[0] = voxWidthX;
@@ -198,77 +207,96 @@ class Voxels : public Array {
     m_voxWidth[axis] = voxWidth;
   }
 
-  std::string printVoxWidth(unsigned int axis) {
-    std::ostringstream ss;
-    ss << m_voxWidth[axis] << " " << printUnits(m_units);
-
-    return ss.str();
-  }
+  std::string printVoxWidth(unsigned int axis);
 
   UnitsTy getUnits() const { return m_units; }
   void setUnits(UnitsTy units) { m_units = units; }
 
   std::string printUnits() { return printUnits(m_units); }
 
-  const std::string printUnits(UnitsTy t) {
-    if (t == VOX_ANGSTROMS) {
-      return "angstroms";
-    } else if (t == VOX_NANOMETERS) {
-      return "nm";
-    } else if (t == VOX_MICROMETERS) {
-      return "µm";
-    } else if (t == VOX_MILLIMETERS) {
-      return "mm";
-    } else if (t == VOX_CENTIMETERS) {
-      return "cm";
-    } else {
-      std::ostringstream ss;
-      ss << "(m*10^" << t << ")";
-      return ss.str();
-    }
+  const std::string printUnits(UnitsTy t);
+
+  /// Number of voxels along an axis at a mip level
+  uint32_t dim(int axis, int level = 0) const {
+    return level < int(mLevels.size()) ? mLevels[level].dims[axis] : 0;
+  }
+  uint32_t width(int level = 0) const { return dim(0, level); }
+  uint32_t height(int level = 0) const { return dim(1, level); }
+  uint32_t depth(int level = 0) const { return dim(2, level); }
+
+  /// Number of mip levels
+  int levels() const { return int(mLevels.size()); }
+
+  /// Number of voxels along each side of a brick
+  uint32_t brickSize() const { return mBrickSize; }
+
+  /// Number of bricks along an axis at a mip level
+  uint32_t bricks(int axis, int level = 0) const {
+    return level < int(mLevels.size()) ? mLevels[level].bricks[axis] : 0;
   }
 
-  // functions to support MRC
-  MRCHeader &parseMRC(const char *data);
+  /// Value of voxels that have not been written
+  float background() const { return mBackground; }
+  void background(float v) { mBackground = v; }
 
-  bool loadFromMRC(std::string filename, bool update = false);
+  /// Get voxel value. Coordinates must be within the level dimensions
+  float value(uint32_t x, uint32_t y, uint32_t z, int level = 0) const;
 
-  bool loadFromMRC(std::string filename, UnitsTy ty, float voxWidth);
+  /// Set voxel value at level 0
+  void setValue(uint32_t x, uint32_t y, uint32_t z, float v);
 
-  bool loadFromMRC(std::string filename, UnitsTy ty, float voxWidthX,
-                   float voxWidthY, float voxWidthZ);
+  /// Read a region of a level into dst, x varying fastest
 
-  // functions for loading from images
-  bool getdir(std::string dir, std::vector<std::string> &files);
+  /// Coordinates outside the level are clamped to its edges.
+  void read(float *dst, int x0, int y0, int z0, uint32_t nx, uint32_t ny,
+            uint32_t nz, int level = 0) const;
 
-  bool parseInfo(std::string dir, std::vector<std::string> &data);
+  /// Get brick data, brickSize()^3 values with x varying fastest
 
-  bool loadFromDirectory(std::string dir);
+  /// Returns nullptr if all values of the brick are equal to min. The pointer
+  /// is valid until the next access of the volume. Voxels of bricks on the
+  /// far edges that lie outside the volume repeat the last voxel.
+  const float *brick(uint32_t bx, uint32_t by, uint32_t bz, int level,
+                     float &min, float &max) const;
 
-  // functions for slicing
-  bool linePlaneIntersection(const Vec3f &P0, const Vec3f &P1,
-                             const Vec3f &planeCenter, const Vec3f &planeNormal,
-                             Vec3f *intersection);
+  /// Get the value range of a brick
 
-  std::vector<Vec3f> linspace(Vec3f a, Vec3f b, int n);
+  /// The range of a brick is kept when its data is evicted from the cache,
+  /// so only the first query decodes the brick.
+  void brickRange(uint32_t bx, uint32_t by, uint32_t bz, int level,
+                  float &min, float &max) const;
 
-  Vec3f point2Dto3D(Vec3f Q, Vec3f H, Vec3f K, float u, float v);
+  /// Limit memory used by cached bricks, 0 for no limit
 
-  bool parallelLinespace(Vec3f p0, Vec3f p1, Vec3f p2, Vec3f p3,
-                         std::vector<Vec3f> &list, std::vector<Vec3f> &list2,
-                         float aDirection, float oDirection,
-                         std::vector<Vec3f> &points);
+  /// Bricks that were written with setValue() are never evicted.
+  void cacheLimit(size_t bytes);
+  size_t cacheLimit() const { return mCacheLimit; }
 
-  Array slice(Vec3f planeCenter, Vec3f planeNormal,
-              std::vector<Vec3f> &finalPointList);
+  /// Memory used by brick data
+  size_t residentBytes() const { return mResidentBytes; }
 
-  // mostly for saving partial changes into mrc header.
-  bool writeToMRC(std::string filename, MRCHeader &header);
+  /// Parse MRC header, swapping byte order if needed
 
-  // write/read files for voxel class
-  bool writeToFile(std::string filename);
+  /// \returns false if the header is not valid. swapped is set to whether
+  /// the file byte order differs from the machine
+  static bool parseMRC(const char *data, MRCHeader &header, bool &swapped);
 
-  bool loadFromFile(std::string filename);
+  /// Open MRC file. Bricks are decoded from the file when first accessed
+
+  /// Voxel widths are taken from the header, in nanometers.
+  bool loadFromMRC(std::string filename, MRCAccess access = MRC_MAP);
+
+  /// Open MRC file, overriding voxel widths
+  bool loadFromMRC(std::string filename, UnitsTy ty, float voxWidth,
+                   MRCAccess access = MRC_MAP);
+
+  /// Open MRC file, overriding voxel widths
+  bool loadFromMRC(std::string filename, UnitsTy ty, float voxWidthX,
+                   float voxWidthY, float voxWidthZ,
+                   MRCAccess access = MRC_MAP);
+
+  /// Write level 0 as a 32-bit float MRC file
+  bool writeToMRC(std::string filename);
 
   void print(FILE *fp = stdout);
 
@@ -280,12 +308,43 @@ class Voxels : public Array {
 
   float rms() const { return m_rms; }
 
-  ~Voxels() {}
-
  protected:
+  struct Brick {
+    std::unique_ptr<float[]> data; // null if uniform or not loaded
+    float min = 0, max = 0;
+    bool loaded = false;
+    bool rangeKnown = false; // min and max are kept when data is released
+    bool pinned = false; // written by setValue(), never evicted
+    std::list<Brick *>::iterator lru;
+  };
+
+  struct Level {
+    uint32_t dims[3];
+    uint32_t bricks[3];
+    std::vector<Brick> grid; // x varying fastest
+  };
+
   UnitsTy m_units;
   float m_voxWidth[3];
-  float m_min, m_max, m_mean, m_rms;
+  float m_min{0}, m_max{0}, m_mean{0}, m_rms{0};
+
+  uint32_t mBrickSize{32};
+  float mBackground{0};
+  mutable std::vector<Level> mLevels;
+  std::unique_ptr<MRCSource> mSource;
+  size_t mCacheLimit{0};
+  mutable size_t mResidentBytes{0};
+  mutable std::list<Brick *> mLRU; // most recently used first
+
+  Brick &brickAt(int level, uint32_t bx, uint32_t by, uint32_t bz) const;
+  Brick &load(int level, uint32_t bx, uint32_t by, uint32_t bz) const;
+  void decode(int level, uint32_t bx, uint32_t by, uint32_t bz,
+              float *dst) const;
+  void store(Brick &b, std::unique_ptr<float[]> data) const;
+  void touch(Brick &b) const;
+  void evict() const;
+  void release(Brick &b) const;
+  void invalidateMips(uint32_t x, uint32_t y, uint32_t z);
 };
 
 }  // namespace al
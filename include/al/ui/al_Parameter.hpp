@@ -48,6 +48,7 @@
 #include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <cstring>
 #include <functional>
 #include <iostream>
 #include <map>
@@ -55,6 +56,8 @@
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 #include "al/math/al_Vec.hpp"
@@ -204,6 +207,19 @@ protected:
   std::map<std::string, float> mHints; // Provide hints for behavior
 };
 
+/**
+ * @brief Determines whether a parameter type can be read without locking
+ *
+ * Types that can be copied as plain memory are read through a sequence lock,
+ * so readers never block. Other types (e.g. std::string) fall back to the
+ * last cached value while a writer holds the lock.
+ */
+template <class ParameterType>
+struct ParameterLockFreeRead : std::is_trivially_copyable<ParameterType> {};
+
+// Pose only holds doubles but declares its own copy constructor
+template <> struct ParameterLockFreeRead<al::Pose> : std::true_type {};
+
 /**
  * @brief The ParameterWrapper class provides a generic thread safe Parameter
  * class from the ParameterType template parameter
@@ -222,10 +238,11 @@ public:
    * @param min Minimum value for the parameter
    * @param max Maximum value for the parameter
    *
-   * The mechanism used to protect data is locking a mutex within the set()
-   * function and doing try_lock() on the mutex to update a cached value in the
-   * get() function. In the worst case this might incur some jitter when reading
-   * the value.
+   * Writers are serialized by a mutex within the set() function. For types
+   * that can be copied as plain memory (see ParameterLockFreeRead), get()
+   * reads the value through a sequence counter and never locks, so it is
+   * safe to call from the audio thread. For other types get() does try_lock()
+   * on the mutex and returns a cached value if it is held.
    */
   ParameterWrapper(std::string parameterName, std::string group = "",
                    ParameterType defaultValue = ParameterType());
@@ -295,11 +312,17 @@ public:
   /**
    * @brief set the parameter's value forcing a lock
    *
-   * No callbacks are called.
+   * No callbacks are called. Lock-free readers retry if they overlap with the
+   * write.
    */
   inline void setLocking(ParameterType value) {
     mMutex->lock();
+    uint32_t sequence = mSequence->load(std::memory_order_relaxed);
+    // An odd sequence number marks a write in progress
+    mSequence->store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
     mValue = value;
+    mSequence->store(sequence + 2, std::memory_order_release);
     mMutex->unlock();
   }
 
@@ -486,6 +509,20 @@ protected:
 
   void runChangeCallbacksSynchronous(ParameterType &value, ValueSource *src);
 
+  ParameterType readValue(std::true_type lockFree);
+  ParameterType readValue(std::false_type lockFree);
+
+  // Calls f with the value without copying it. Uses the cached value if a
+  // writer holds the lock, as get() does for types that are not lock-free
+  template <class F> void readInPlace(F f) {
+    if (mMutex->try_lock()) {
+      f(mValue);
+      mMutex->unlock();
+    } else {
+      f(mValueCache);
+    }
+  }
+
   std::shared_ptr<ParameterProcessCallback> mProcessCallback;
   // void * mProcessUdata;
   // std::vector<void *> mCallbackUdata;
@@ -495,6 +532,7 @@ protected:
 private:
   // pointer to avoid having to explicitly declare copy/move
   std::unique_ptr<std::mutex> mMutex;
+  std::unique_ptr<std::atomic<uint32_t>> mSequence;
 
 private:
   std::vector<std::shared_ptr<ParameterChangeCallback>> mCallbacks;
@@ -1639,6 +1677,25 @@ public:
     sender.send(prefix + getFullAddress(), get());
   }
 
+  /**
+   * @brief Copy the value to dst without allocating memory
+   * @param dst buffer receiving the zero terminated value
+   * @param capacity size of dst. Longer values are truncated
+   * @return number of characters copied, not counting the terminator
+   */
+  size_t copyTo(char *dst, size_t capacity) {
+    size_t length = 0;
+    if (capacity == 0) {
+      return 0;
+    }
+    readInPlace([&](const std::string &value) {
+      length = std::min(value.size(), capacity - 1);
+      memcpy(dst, value.data(), length);
+    });
+    dst[length] = '\0';
+    return length;
+  }
+
   virtual void getFields(std::vector<VariantValue> &fields) override {
     fields.emplace_back(VariantValue(get()));
   }
@@ -1930,6 +1987,27 @@ public:
     }
   }
 
+  /**
+   * @brief Copy the current element to dst without allocating memory
+   * @param dst buffer receiving the zero terminated element
+   * @param capacity size of dst. Longer elements are truncated
+   * @return number of characters copied, not counting the terminator
+   */
+  size_t copyCurrent(char *dst, size_t capacity) {
+    if (capacity == 0) {
+      return 0;
+    }
+    int current = get();
+    size_t length = 0;
+    std::lock_guard<std::mutex> lk(mElementsLock);
+    if (current >= 0 && current < int32_t(mElements.size())) {
+      length = std::min(mElements[current].size(), capacity - 1);
+      memcpy(dst, mElements[current].data(), length);
+    }
+    dst[length] = '\0';
+    return length;
+  }
+
   void setCurrent(std::string element, bool noCalls = false) {
     mElementsLock.lock();
     auto position = std::find(mElements.begin(), mElements.end(), element);
@@ -2196,6 +2274,7 @@ ParameterWrapper<ParameterType>::ParameterWrapper(std::string parameterName,
   mValue = defaultValue;
   mValueCache = defaultValue;
   mMutex = std::make_unique<std::mutex>();
+  mSequence = std::make_unique<std::atomic<uint32_t>>(0);
   setDefault(defaultValue);
   std::shared_ptr<ParameterChangeCallback> mAsyncCallback =
       std::make_shared<ParameterChangeCallback>(
@@ -2212,7 +2291,6 @@ ParameterWrapper<ParameterType>::ParameterWrapper(std::string parameterName,
                                                         defaultValue) {
   mMin = min;
   mMax = max;
-  mMutex = std::make_unique<std::mutex>();
   setDefault(defaultValue);
 }
 
@@ -2226,12 +2304,38 @@ ParameterWrapper<ParameterType>::ParameterWrapper(
   // mProcessUdata = param.mProcessUdata;
   mCallbacks = param.mCallbacks;
   mMutex = std::make_unique<std::mutex>();
+  mSequence = std::make_unique<std::atomic<uint32_t>>(0);
   setDefault(param.getDefault());
   // mCallbackUdata = param.mCallbackUdata;
 }
 
 template <class ParameterType>
 ParameterType ParameterWrapper<ParameterType>::get() {
+  return readValue(ParameterLockFreeRead<ParameterType>());
+}
+
+template <class ParameterType>
+ParameterType ParameterWrapper<ParameterType>::readValue(std::true_type) {
+  ParameterType current;
+  unsigned int attempts = 0;
+  while (true) {
+    uint32_t sequence = mSequence->load(std::memory_order_acquire);
+    if ((sequence & 1) == 0) {
+      current = mValue;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (mSequence->load(std::memory_order_relaxed) == sequence) {
+        return current;
+      }
+    }
+    // Writer was preempted halfway through. Let it finish.
+    if (++attempts % 64 == 0) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+template <class ParameterType>
+ParameterType ParameterWrapper<ParameterType>::readValue(std::false_type) {
   ParameterType current = mValueCache;
   if (mMutex->try_lock()) {
     current = mValue;
@@ -0,0 +1,350 @@
+#ifndef AL_PARAMETERJOURNAL_H
+#define AL_PARAMETERJOURNAL_H
+
+/*	Allolib --
+   Multimedia / virtual environment application class library
+
+   Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology,
+   UCSB. Copyright (C) 2012-2018. The Regents of the University of California.
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   Neither the name of the University of California nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+   IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+   PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+   OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+   OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+   ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+   File description:
+   Continuous recording and playback of parameter changes
+   File author(s):
+   AlloSphere Research Group
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "al/io/al_File.hpp"
+#include "al/ui/al_Parameter.hpp"
+
+namespace al {
+
+/**
+ * @ingroup UI
+ * @brief The ParameterJournal class records every change of a set of
+ * parameters to a binary journal file.
+ *
+ * Changes are copied from the parameter callbacks into a lock-free queue
+ * together with their timestamp and the network source of the change, if
+ * any. A writer thread appends them to the journal file, and turns menu
+ * indices into element text and sources into "address:port". Every
+ * snapshotInterval() seconds writes a snapshot of all parameter values, so a
+ * ParameterJournalPlayer can seek without replaying the whole file.
+ *
+ * Timestamps come from a steady clock in microseconds by default. Set a
+ * sampleClock() to timestamp changes in audio frames, for example from
+ * PolySynth::sampleTime().
+ *
+ * The file starts with a 16 byte header: the characters "ALPJ", the format
+ * version (uint32) and the tick rate in ticks per second (float64). Records
+ * follow, each starting with a type byte:
+ *
+ * - 'p': parameter definition. Id (uint16), address length (uint16) and
+ *   address. All parameters are defined before any other record.
+ * - 's': source definition. Id (uint16), length (uint16) and "address:port"
+ *   of the sender. Source 0 is local changes and is not defined.
+ * - 'k': snapshot. Time (uint64), number of parameters (uint16) and for each
+ *   the parameter id (uint16) and its fields.
+ * - 'c': change. Time (uint64), parameter id (uint16), source id (uint16) and
+ *   the fields.
+ *
+ * Fields are stored as their count (uint8) followed by each field as its
+ * VariantType (uint8) and value. Strings are stored as length (uint16) and
+ * characters, all other types as 8 bytes: int64 for integer types and
+ * float64 for float types. All numbers are little endian and times are in
+ * ticks from the start of the recording, never decreasing along the file.
+ *
+ * @code
+ * Parameter x{"x"};
+ * ParameterJournal journal;
+ * journal << x;
+ * journal.startRecord("performance.journal");
+ * ...
+ * journal.stopRecord();
+ * @endcode
+ */
+class ParameterJournal {
+public:
+  ParameterJournal() {}
+  ~ParameterJournal();
+
+  ParameterJournal(const ParameterJournal &) = delete;
+  ParameterJournal &operator=(const ParameterJournal &) = delete;
+
+  /**
+   * @brief Register a parameter to be recorded
+   *
+   * Parameters can't be registered while recording.
+   */
+  void registerParameter(ParameterMeta &p);
+
+  ParameterJournal &operator<<(ParameterMeta &p) {
+    registerParameter(p);
+    return *this;
+  }
+
+  /**
+   * @brief Use a sample counter to timestamp changes
+   * @param clock function returning the current sample count
+   * @param sampleRate rate at which the counter advances
+   *
+   * Pass nullptr to go back to the steady clock. Takes effect on the next
+   * call to startRecord().
+   */
+  void sampleClock(std::function<uint64_t()> clock, double sampleRate);
+
+  /// Seconds between snapshots of all parameter values. Default 1.0
+  void snapshotInterval(double seconds) { mSnapshotInterval = seconds; }
+  double snapshotInterval() { return mSnapshotInterval; }
+
+  /**
+   * @brief Stop recording changes after this many seconds
+   *
+   * Changes later than this from the start of the recording are not
+   * written and recording() becomes false. stopRecord() must still be
+   * called to close the file. 0, the default, records until stopRecord().
+   * Takes effect on the next call to startRecord().
+   */
+  void maxRecordTime(double seconds) { mMaxRecordTime = seconds; }
+  double maxRecordTime() { return mMaxRecordTime; }
+
+  /**
+   * @brief Start recording to a journal file
+   * @param path file to write. It is overwritten if it exists
+   * @return false if the file could not be opened
+   */
+  bool startRecord(std::string path);
+
+  /// Stop recording and close the journal file
+  void stopRecord();
+
+  bool recording() { return mRecording; }
+
+  /// Number of changes lost in the current recording because the queue was
+  /// full
+  uint64_t droppedChanges() { return mDroppedChanges; }
+
+  /// Maximum number of fields captured per change
+  static const int kMaxFields = 8;
+  /// Maximum bytes for the string fields of a change
+  static const int kMaxStringBytes = 64;
+  /// Maximum bytes for the address of the source of a change
+  static const int kMaxSourceBytes = 48;
+  /// Changes that can be queued before the writer thread collects them
+  static const size_t kQueueSize = 8192;
+
+  static constexpr const char *magic = "ALPJ";
+  static const uint32_t formatVersion = 1;
+
+private:
+  // Fixed size change copied from the parameter callbacks. String fields
+  // store the offset of their zero terminated characters in strings. Menus
+  // store their index, which the writer thread turns into the element text.
+  struct CapturedChange {
+    std::atomic<size_t> sequence;
+    uint64_t time;
+    uint16_t parameterId;
+    uint8_t numFields;
+    uint8_t types[kMaxFields];
+    uint64_t values[kMaxFields];
+    char strings[kMaxStringBytes];
+    bool hasSource;
+    uint16_t sourcePort;
+    char source[kMaxSourceBytes];
+  };
+
+  template <class ParameterType>
+  bool registerWrapper(ParameterMeta &p, uint16_t id);
+
+  // Returns a slot for a new change or nullptr if the queue is full. The slot
+  // must be passed to commitChange() once filled.
+  CapturedChange *reserveChange(uint16_t id, ValueSource *src);
+  void commitChange(CapturedChange *change);
+  // Write queued changes to mBuffer if write is true, else discard them
+  void collectChanges(bool write);
+  void writerLoop();
+
+  uint64_t now() const;
+
+  std::vector<ParameterMeta *> mParameters;
+  // Same indices as mParameters, nullptr for parameters that are not menus
+  std::vector<ParameterMenu *> mMenus;
+
+  // Set by sampleClock() and used from the next startRecord()
+  std::function<uint64_t()> mPendingSampleClock;
+  double mPendingSampleRate{0};
+  std::function<uint64_t()> mSampleClock;
+  double mTickRate{1.0e6};
+  uint64_t mStartTime{0};
+  std::chrono::steady_clock::time_point mClockStart;
+  double mSnapshotInterval{1.0};
+  double mMaxRecordTime{0.0};
+  uint64_t mMaxTicks{0};
+
+  std::atomic<bool> mRecording{false};
+
+  std::unique_ptr<CapturedChange[]> mQueue;
+  std::atomic<size_t> mEnqueuePos{0};
+  size_t mDequeuePos{0};
+  std::atomic<uint64_t> mDroppedChanges{0};
+
+  std::unique_ptr<std::thread> mWriterThread;
+  std::atomic<bool> mRunWriter{false};
+
+  // Only accessed by the writer thread while recording
+  std::ofstream mFile;
+  std::vector<char> mBuffer;
+  // Encoded fields for each parameter, as written in snapshots
+  std::vector<std::vector<char>> mCurrentValues;
+  std::map<std::string, uint16_t> mSources;
+  uint64_t mLastTime{0};
+  uint64_t mLastSnapshot{0};
+};
+
+/**
+ * @ingroup UI
+ * @brief The ParameterJournalPlayer class replays journals written by
+ * ParameterJournal.
+ *
+ * The journal is memory mapped and indexed by its snapshots when opened.
+ * seek() finds the closest snapshot before the requested time with a binary
+ * search and then applies only the changes recorded after it, so scrubbing
+ * costs the same anywhere in a long recording. Changes are applied to the
+ * registered parameters that have the same address as the recorded ones.
+ *
+ * @code
+ * ParameterJournalPlayer player;
+ * player << x;
+ * player.open("performance.journal");
+ * player.seek(12.5);
+ * // For playback, call regularly, e.g. from onAnimate()
+ * player.advance(player.position() + dt);
+ * @endcode
+ */
+class ParameterJournalPlayer {
+public:
+  typedef std::map<std::string, std::vector<VariantValue>> ParameterStates;
+
+  typedef std::function<void(const std::string &address,
+                             std::vector<VariantValue> &fields,
+                             const std::string &source, double time)>
+      ChangeCallback;
+
+  ParameterJournalPlayer() {}
+
+  ParameterJournalPlayer(const ParameterJournalPlayer &) = delete;
+  ParameterJournalPlayer &operator=(const ParameterJournalPlayer &) = delete;
+
+  /// Map and index a journal file. Returns false if it is not a valid journal
+  bool open(std::string path);
+  void close();
+  bool opened() { return mFile.opened(); }
+
+  void registerParameter(ParameterMeta &p);
+
+  ParameterJournalPlayer &operator<<(ParameterMeta &p) {
+    registerParameter(p);
+    return *this;
+  }
+
+  /**
+   * @brief Register a function called for every change applied by advance()
+   *
+   * The source is "address:port" of the sender of the change or empty for
+   * local changes.
+   */
+  void registerChangeCallback(ChangeCallback cb) { mChangeCallback = cb; }
+
+  /// Time in seconds of the last change in the journal
+  double duration() { return mDuration; }
+
+  /// Current playback position in seconds
+  double position() { return mPosition; }
+
+  /// Addresses of the parameters recorded in the journal
+  std::vector<std::string> parameterAddresses() { return mAddresses; }
+
+  /**
+   * @brief Compute the values of all recorded parameters at a time
+   * @param time in seconds from the start of the journal
+   * @param values filled with the values of parameters that have a value
+   */
+  bool stateAt(double time, ParameterStates &values);
+
+  /// Set the registered parameters to their values at time and move the
+  /// playback position there
+  bool seek(double time);
+
+  /**
+   * @brief Apply the changes recorded up to time
+   *
+   * Changes between the current position and time are applied in order and
+   * passed to the change callback. Seeks if time is before the position.
+   */
+  bool advance(double time);
+
+private:
+  struct Snapshot {
+    uint64_t time;
+    size_t offset;
+  };
+
+  bool findState(uint64_t ticks, std::vector<std::vector<VariantValue>> &state,
+                 std::vector<bool> &valid, size_t &nextRecord);
+  void applyFields(uint16_t id, std::vector<VariantValue> &fields);
+
+  MappedFile mFile;
+  double mTickRate{1.0};
+  std::vector<std::string> mAddresses;
+  std::vector<std::string> mSourceNames;
+  std::vector<Snapshot> mSnapshots;
+  // Bytes up to the end of the last complete record
+  size_t mValidSize{0};
+  double mDuration{0};
+
+  std::map<std::string, ParameterMeta *> mParameters;
+  ChangeCallback mChangeCallback;
+  double mPosition{0};
+  size_t mReadOffset{0};
+};
+
+} // namespace al
+
+#endif // AL_PARAMETERJOURNAL_H
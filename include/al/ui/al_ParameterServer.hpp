@@ -42,8 +42,11 @@
         Andrés Cabrera mantaraya36@gmail.com
 */
 
+#include <condition_variable>
 #include <mutex>
 #include <cstdint>
+#include <thread>
+#include <unordered_map>
 
 #include "al/protocol/al_OSC.hpp"
 #include "al/ui/al_Parameter.hpp"
@@ -95,6 +98,8 @@ public:
     auto newListenerSocket = new osc::Send;
 
     if (newListenerSocket->open(oscPort, IPaddress.c_str())) {
+      // Resolve once here instead of on every notification
+      auto ip = resolveListenerAddress(IPaddress);
       mListenerLock.lock();
       for (const auto &sender : mOSCSenders) {
         if (sender->address() == IPaddress && sender->port() == oscPort) {
@@ -105,10 +110,12 @@ public:
                     << oscPort << std::endl;
           mListenerLock.unlock();
           delete newListenerSocket;
+          return;
         }
       }
 
       mOSCSenders.push_back(newListenerSocket);
+      mListenerIps.push_back(ip);
       mListenerLock.unlock();
       std::cout << "Registered listener " << IPaddress << ":" << oscPort
                 << std::endl;
@@ -130,6 +137,9 @@ public:
    * register to be notified when the data changes to only do notifications
    * then.
    *
+   * Notifications are sent immediately unless a coalesceInterval() is set.
+   * Each notification serializes an osc::Packet, so these functions allocate
+   * and should not be called from the audio thread.
    */
   void notifyListeners(std::string OSCaddress, float value,
                        ValueSource *src = nullptr);
@@ -151,16 +161,50 @@ public:
   void notifyListeners(std::string OSCaddress, ParameterMeta *param,
                        ValueSource *src);
 
+  /**
+   * @brief Send a packet to all listeners immediately
+   *
+   * Queued notifications are sent first to preserve ordering.
+   */
   void send(osc::Packet &p) {
-    mListenerLock.lock();
+    std::unique_lock<std::mutex> lk(mListenerLock);
+    sendQueued();
     for (osc::Send *sender : mOSCSenders) {
       sender->send(p);
-      //      std::cout << "Notifying " << sender->address() << ":" <<
-      //      sender->port()
-      //                << std::endl;
     }
-    mListenerLock.unlock();
   }
+
+  /**
+   * @brief Send queued notifications now
+   */
+  void flush() {
+    std::unique_lock<std::mutex> lk(mListenerLock);
+    sendQueued();
+  }
+
+  /**
+   * @brief Set time to gather notifications before sending them
+   * @param seconds Defaults to 0, sending every notification immediately.
+   *
+   * When greater than 0, notifications are queued and sent from a separate
+   * thread once per interval, packed into OSC bundles. If an address is
+   * notified more than once within an interval only the last value is sent,
+   * except for Trigger parameters. This reduces traffic for continuously
+   * changing parameters, but adds up to one interval of latency and drops
+   * intermediate values, e.g. the steps of a preset morph.
+   */
+  void coalesceInterval(double seconds) { mCoalesceInterval = seconds; }
+  double coalesceInterval() const { return mCoalesceInterval; }
+
+  /**
+   * @brief Set maximum size in bytes of the bundles sent to listeners
+   *
+   * Defaults to 1024, the receive buffer size of osc::Recv in previous
+   * versions. Values above the network MTU (usually 1472 bytes for UDP
+   * payloads) will cause fragmentation.
+   */
+  void maxBundleSize(size_t bytes) { mMaxBundleSize = bytes; }
+
   void startHandshakeServer(std::string address = "0.0.0.0");
 
   void appendCommandHandler(osc::PacketHandler &handler) {
@@ -168,8 +212,27 @@ public:
   }
 
 protected:
+  /// A serialized notification waiting to be sent
+  struct QueuedMessage {
+    std::vector<char> data;
+    bool hasSource{false};
+    ValueSource source;
+  };
+
+  template <class... Args>
+  void queueMessage(const std::string &OSCaddress, ValueSource *src,
+                    bool coalesce, const Args &...args);
+
+  // Must be called with mListenerLock held
+  void sendQueued();
+
+  void senderLoop();
+
+  static std::string resolveListenerAddress(const std::string &address);
+
   std::mutex mListenerLock;
   std::vector<osc::Send *> mOSCSenders;
+  std::vector<std::string> mListenerIps; // Resolved addresses of mOSCSenders
   std::vector<std::pair<std::string, int>> mConnectedNodes;
 
   class HandshakeHandler : public osc::PacketHandler {
@@ -185,6 +248,14 @@ protected:
   std::mutex mNodeLock;
 
 private:
+  std::mutex mQueueLock;
+  std::condition_variable mQueueCondition;
+  std::vector<QueuedMessage> mQueue;
+  std::unordered_map<std::string, size_t> mQueueIndex; // address -> mQueue
+  std::unique_ptr<std::thread> mSenderThread;
+  bool mSenderRunning{false};
+  double mCoalesceInterval{0.0};
+  size_t mMaxBundleSize{1024};
 };
 
 /**
@@ -0,0 +1,165 @@
+#ifndef AL_PARAMETERSMOOTHER_H
+#define AL_PARAMETERSMOOTHER_H
+
+/*	Allolib --
+   Multimedia / virtual environment application class library
+
+   Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology,
+   UCSB. Copyright (C) 2012-2018. The Regents of the University of California.
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   Neither the name of the University of California nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+   IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+   PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+   OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+   OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+   ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+   File description:
+   Per-sample smoothing of parameter values for the audio thread
+   File author(s):
+   AlloSphere Research Group
+*/
+
+#include <cmath>
+
+#include "al/ui/al_Parameter.hpp"
+
+namespace al {
+
+/**
+ * @brief Smooths changes of a parameter's value for use in audio callbacks
+ * @ingroup UI
+ *
+ * Reads the target value from a parameter once per block and interpolates
+ * towards it per sample, either linearly over a fixed time or through a one
+ * pole lowpass. Does not lock or allocate, so it can be used in the audio
+ * thread. ParameterType must support addition, subtraction and
+ * multiplication by a float (e.g. float, double, Vec3f, Color).
+ *
+ * @code
+ * Parameter gain{"gain", "", 0.5f};
+ * ParameterSmoother<float> gainSmooth{gain, 0.05f};
+ *
+ * void onSound(AudioIOData &io) {
+ *   gainSmooth.update(io.framesPerSecond());
+ *   while (io()) {
+ *     io.out(0) = io.in(0) * gainSmooth.next();
+ *   }
+ * }
+ * @endcode
+ */
+template <class ParameterType> class ParameterSmoother {
+public:
+  enum SmoothingMode { LINEAR, ONE_POLE };
+
+  /**
+   * @param parameter parameter to read target values from
+   * @param time  ramp time for LINEAR, time constant for ONE_POLE (seconds)
+   * @param mode  interpolation used
+   */
+  ParameterSmoother(ParameterWrapper<ParameterType> &parameter,
+                    float time = 0.02f, SmoothingMode mode = LINEAR)
+      : mParameter(parameter), mTime(time), mMode(mode),
+        mCurrent(parameter.get()), mTarget(mCurrent) {}
+
+  /// Set smoothing time in seconds. Takes effect on the next target change.
+  void time(float seconds) {
+    mTime = seconds;
+    mSampleRate = 0; // recompute coefficients in update()
+  }
+  float time() const { return mTime; }
+
+  void mode(SmoothingMode mode) { mMode = mode; }
+  SmoothingMode mode() const { return mMode; }
+
+  /**
+   * @brief Read the parameter's current value as the new target
+   *
+   * Call once at the start of every audio block.
+   */
+  void update(double sampleRate) {
+    if (sampleRate != mSampleRate) {
+      mSampleRate = sampleRate;
+      mRampSamples = std::max(1, int(std::lround(mTime * sampleRate)));
+      mCoefficient =
+          mTime > 0 ? float(std::exp(-1.0 / (mTime * sampleRate))) : 0.f;
+    }
+    ParameterType target = mParameter.get();
+    if (!(target == mTarget)) {
+      mTarget = target;
+      mStep = (mTarget - mCurrent) * (1.f / mRampSamples);
+      mRemaining = mRampSamples;
+    }
+  }
+
+  /// Get the next smoothed sample
+  ParameterType next() {
+    if (mMode == LINEAR) {
+      if (mRemaining > 0) {
+        if (--mRemaining == 0) {
+          mCurrent = mTarget; // avoid accumulated rounding error
+        } else {
+          mCurrent = mCurrent + mStep;
+        }
+      }
+    } else {
+      mCurrent = mTarget + (mCurrent - mTarget) * mCoefficient;
+    }
+    return mCurrent;
+  }
+
+  /// Write the next numSamples smoothed values to out
+  void nextBlock(ParameterType *out, int numSamples) {
+    for (int i = 0; i < numSamples; i++) {
+      out[i] = next();
+    }
+  }
+
+  /// Jump to the parameter's current value without smoothing
+  void reset() {
+    mTarget = mCurrent = mParameter.get();
+    mRemaining = 0;
+  }
+
+  ParameterType current() const { return mCurrent; }
+  ParameterType target() const { return mTarget; }
+
+  /// True while a LINEAR ramp is in progress
+  bool isSmoothing() const { return mRemaining > 0; }
+
+private:
+  ParameterWrapper<ParameterType> &mParameter;
+  float mTime;
+  SmoothingMode mMode;
+  double mSampleRate{0};
+  int mRampSamples{1};
+  float mCoefficient{0};
+  int mRemaining{0};
+  ParameterType mCurrent;
+  ParameterType mTarget;
+  ParameterType mStep{};
+};
+
+} // namespace al
+
+#endif // AL_PARAMETERSMOOTHER_H
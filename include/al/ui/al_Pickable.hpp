@@ -1,10 +1,12 @@
 #ifndef __PICKABLE_HPP__
 #define __PICKABLE_HPP__
 
+#include <atomic>
 #include <vector>
 
 #include "al/graphics/al_Graphics.hpp"
 #include "al/math/al_Ray.hpp"
+#include "al/spatial/al_BVH.hpp"
 #include "al/ui/al_BoundingBox.hpp"
 #include "al/ui/al_Parameter.hpp"
 #include "al/ui/al_ParameterBundle.hpp"
@@ -77,6 +79,10 @@ struct Pickable {
   Pose pose0, prevPose;
   Vec3f scale0, prevScale;
 
+  /// set when the pose, scale or shape change, so PickableManager can update
+  /// its bounding volume hierarchy
+  std::atomic<bool> boundsChanged{true};
+
   Pickable();
 
   virtual ~Pickable() {}
@@ -85,6 +91,11 @@ struct Pickable {
   virtual Hit intersect(Rayd r) = 0;
   virtual Hit intersect(Vec3d v) { return intersect(Rayd(v, Vec3d())); }
 
+  /// axis aligned bounds of the pickable (not its children) after pose and
+  /// scale transforms. Return false if bounds are unknown, the pickable is
+  /// then always tested.
+  virtual bool bounds(Vec3d & /*min*/, Vec3d & /*max*/) { return false; }
+
   /// override callback
   virtual bool onEvent(PickEvent e, Hit hit) { return false; }
 
@@ -129,6 +140,8 @@ struct Pickable {
   Vec3f transformVecWorld(const Vec3f &v, float w = 1);
   /// transfrom a vector in world space to local space
   Vec3f transformVecLocal(const Vec3f &v, float w = 1);
+  /// distance along ray to the point at localT along transformRayLocal(ray)
+  double worldDistance(const Rayd &ray, const Rayd &localRay, double localT);
 };
 
 /// Bounding Box PickableMesh
@@ -155,6 +168,7 @@ struct PickableBB : Pickable {
 
   /// override base methods
   Hit intersect(Rayd r);
+  bool bounds(Vec3d &min, Vec3d &max);
   // bool contains(Vec3d v){ auto p = transformVecLocal(v); return
   // bb.contains(p); }
 
@@ -184,6 +198,41 @@ struct PickableBB : Pickable {
   void updateAABB();
 };
 
+/// PickableBB that is hit on the triangles of its mesh
+///
+/// Triangles are tested through a bounding volume hierarchy, so dense meshes
+/// can be picked interactively. Call updateTriangles() after changing the
+/// mesh vertices. Meshes that are not made of triangles are hit on their
+/// bounding box.
+/// @ingroup UI
+struct PickableMesh : PickableBB {
+  /// test triangles through the BVH. Otherwise all triangles are tested
+  bool useBVH{true};
+
+  PickableMesh(std::string name_ = "") : PickableBB(name_) {}
+  PickableMesh(Mesh &m) { set(m); }
+
+  /// initialize bounding box and triangles
+  void set(Mesh &m);
+
+  /// rebuild bounding box and triangles from the mesh
+  void updateTriangles();
+
+  Hit intersect(Rayd r);
+
+  /// intersect ray in local space with the mesh triangles
+  double intersectTriangles(Rayd localRay);
+
+  size_t triangleCount() { return mTriangles.size() / 3; }
+
+protected:
+  // Ray parameter of the hit with a triangle or -1
+  double intersectTriangle(const Rayd &ray, size_t triangle);
+
+  std::vector<Mesh::Index> mTriangles; // 3 vertex indices per triangle
+  BVH mTriangleBVH;
+};
+
 } // namespace al
 
 #endif
@@ -8,11 +8,17 @@
 #include "al/graphics/al_Graphics.hpp"
 #include "al/io/al_Window.hpp"
 #include "al/math/al_Ray.hpp"
+#include "al/spatial/al_BVH.hpp"
 #include "al/ui/al_Pickable.hpp"
 
 namespace al {
 
 /// PickableManager
+///
+/// Pickables that provide bounds() are kept in a bounding volume hierarchy,
+/// so a ray only tests the pickables whose bounds it crosses. The hierarchy
+/// is refit for pickables whose pose or scale changed before each query and
+/// rebuilt when pickables are added or removed, or after many refits.
 /// @ingroup UI
 class PickableManager {
 public:
@@ -24,7 +30,10 @@ public:
 
   std::vector<Pickable *>& pickables() { return mPickables; }
 
-  void clear() { mPickables.clear(); }
+  void clear() {
+    mPickables.clear();
+    mTreeDirty = true;
+  }
 
   Hit intersect(Rayd r);
 
@@ -45,6 +54,17 @@ public:
 
 protected:
   std::vector<Pickable *> mPickables;
+
+  // Bring the hierarchy up to date with the pickables
+  void updateTree();
+
+  BVH mTree;
+  bool mTreeDirty{true};
+  size_t mRefitCount{0};
+  std::vector<size_t> mTreeItems; // Index in mPickables of each tree item
+  std::vector<size_t> mUnbounded; // Pickables without bounds, always tested
+  std::vector<size_t> mQueryItems;
+  std::vector<char> mDispatch;
   // std::map<int, Hit> mHover;
   // std::map<int, Hit> mSelect;
 
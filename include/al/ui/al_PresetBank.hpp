@@ -0,0 +1,142 @@
+#ifndef AL_PRESETBANK_H
+#define AL_PRESETBANK_H
+
+/*	Allolib --
+   Multimedia / virtual environment application class library
+
+   Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology,
+   UCSB. Copyright (C) 2012-2018. The Regents of the University of California.
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   Neither the name of the University of California nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+   IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+   PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+   OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+   OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+   ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+   File description:
+   Binary storage of all presets in a preset map in a single indexed file
+   File author(s):
+   AlloSphere Research Group
+*/
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "al/io/al_File.hpp"
+#include "al/types/al_VariantValue.hpp"
+
+namespace al {
+
+/**
+ * @ingroup UI
+ * @brief The PresetBank class stores a set of presets in one binary file.
+ *
+ * A preset bank holds the same information as the text ".preset" files, but
+ * for all the presets in a preset map at once. The file is memory mapped and
+ * contains an index, so any preset can be decoded without reading the others.
+ *
+ * The file starts with a 16 byte header: the characters "ALPB", the format
+ * version, the number of presets and the size in bytes of the index. The
+ * index has an entry per preset: name length (uint16), name, offset and size
+ * in bytes (uint64) of the preset data within the file. Preset data holds the
+ * number of parameters (uint32) followed for each parameter by address length
+ * (uint16), address, number of fields (uint16) and the fields, each as a type
+ * tag ('f', 'i' or 's' like the text format) and the value. Strings are
+ * stored as length (uint32) and characters. All numbers are little endian.
+ *
+ * See PresetHandler::exportPresetBank() and PresetHandler::usePresetBank()
+ */
+class PresetBank {
+public:
+  typedef std::map<std::string, std::vector<VariantValue>> ParameterStates;
+
+  PresetBank() {}
+  PresetBank(std::string path) { open(path); }
+
+  /**
+   * @brief Map a bank file and read its index
+   * @param path path to the bank file
+   * @return true if the file was mapped and the index is valid
+   */
+  bool open(std::string path);
+
+  void close();
+
+  bool opened() { return mFile.opened(); }
+
+  std::string path() { return mFile.path(); }
+
+  /// Modification time of the bank file when it was opened
+  al_sec modified() { return mModified; }
+
+  std::vector<std::string> presetNames();
+
+  bool hasPreset(std::string name) { return mIndex.find(name) != mIndex.end(); }
+
+  /**
+   * @brief Decode preset values from the bank
+   * @param name name of the preset
+   * @param values the states are written here
+   * @return false if the preset is not in the bank or data is corrupt
+   */
+  bool getPresetValues(std::string name, ParameterStates &values);
+
+  /**
+   * @brief Remove a preset from the index of the opened bank
+   *
+   * The file is not modified, the preset will be reported as not available
+   * until the bank is opened again.
+   */
+  void invalidate(std::string name) { mIndex.erase(name); }
+
+  /**
+   * @brief Write presets to a bank file
+   * @param path path of the bank file to write
+   * @param presets map of preset name to preset states
+   * @return true if no errors
+   *
+   * Only float, int32 and string fields are stored, as in the text format.
+   * Fails if a parameter has more than 65535 fields.
+   */
+  static bool write(std::string path,
+                    const std::map<std::string, ParameterStates> &presets);
+
+  static const uint32_t formatVersion = 2;
+
+private:
+  struct IndexEntry {
+    uint64_t offset;
+    uint64_t size;
+  };
+
+  MappedFile mFile;
+  std::map<std::string, IndexEntry> mIndex;
+  al_sec mModified{0};
+};
+
+} // namespace al
+
+#endif // AL_PRESETBANK_H
@@ -55,6 +55,7 @@
 #include "al/system/al_Time.hpp"
 #include "al/ui/al_Parameter.hpp"
 #include "al/ui/al_ParameterServer.hpp"
+#include "al/ui/al_PresetBank.hpp"
 
 namespace al {
 
@@ -368,6 +369,44 @@ public:
   bool savePresetValues(const ParameterStates &values, std::string presetName,
                         bool overwrite = true);
 
+  /**
+   * @brief Write all presets in a preset map to a binary preset bank
+   * @param mapName name of the preset map. If empty, current map is used
+   * @return true if no errors.
+   *
+   * The bank is written to the current path with the ".presetBank" extension
+   * and is read instead of the text preset files when usePresetBank() is
+   * enabled. See PresetBank.
+   */
+  bool exportPresetBank(std::string mapName = "");
+
+  /**
+   * @brief Write text preset files for all presets in a binary preset bank
+   * @param mapName name of the preset map. If empty, current map is used
+   * @param overwrite true overwrites otherwise append unique number
+   * @return true if no errors.
+   */
+  bool importPresetBank(std::string mapName = "", bool overwrite = true);
+
+  /**
+   * @brief Load preset values from the preset bank of the current map
+   * @param use
+   *
+   * When enabled, the ".presetBank" file for the current preset map is
+   * memory mapped and presets are decoded from it instead of parsing the
+   * text preset files. A text preset file that is newer than the bank takes
+   * precedence.
+   */
+  void usePresetBank(bool use = true);
+
+  /**
+   * @brief Discard preset values cached by loadPresetValues()
+   *
+   * Preset values are cached after being loaded and are reloaded only when
+   * the preset is stored or its file changes on disk.
+   */
+  void clearPresetCache();
+
   void setTimeMaster(TimeMasterMode masterMode);
 
   void startCpuThread();
@@ -382,6 +421,12 @@ private:
 
   ParameterStates getBundleStates(ParameterBundle *bundle, std::string id);
 
+  // Parse text preset file in the current path
+  ParameterStates readPresetFile(std::string name);
+
+  std::string buildBankPath(std::string mapName);
+  void openPresetBank();
+
   bool mVerbose{false};
   bool mUseCallbacks{true};
   std::string mRootDir;
@@ -400,6 +445,17 @@ private:
   // a time.
   std::mutex mFileLock;
 
+  struct CachedPreset {
+    ParameterStates values;
+    al_sec modified; // Modification time of the preset file when loaded
+    size_t size;     // Size of the preset file when loaded
+  };
+  // Protects preset cache and preset bank. Acquire after mFileLock
+  std::mutex mPresetCacheLock;
+  std::map<std::string, CachedPreset> mPresetCache; // Keyed by file path
+  bool mUsePresetBank{false};
+  PresetBank mPresetBank;
+
   std::mutex mTargetLock;
   ParameterStates mDeltaValues;
   ParameterStates mStartValues;
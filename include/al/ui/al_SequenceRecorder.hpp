@@ -51,6 +51,7 @@
 #include <thread>
 #include <utility>
 
+#include "al/ui/al_ParameterJournal.hpp"
 #include "al/ui/al_PresetHandler.hpp"
 #include "al/ui/al_PresetSequencer.hpp"
 
@@ -78,6 +79,12 @@ namespace al {
  * recorder.stopRecord();
  *
  * @endcode
+ *
+ * Sequence files only hold the preset changes and changes to the parameters
+ * registered directly. To capture every change of all these parameters with
+ * its time and source, enable recordJournal(). A ".journal" file is then
+ * written next to the sequence that can be replayed and scrubbed with
+ * ParameterJournalPlayer.
  */
 class SequenceRecorder : public osc::MessageConsumer {
  public:
@@ -100,6 +107,20 @@ class SequenceRecorder : public osc::MessageConsumer {
 
   void setMaxRecordTime(al_sec maxTime) { mMaxRecordTime = maxTime; }
 
+  /**
+   * @brief Also record all parameter changes to a ParameterJournal
+   *
+   * Changes to registered parameters and to the parameters of the
+   * registered PresetHandler are journaled from startRecord() to
+   * stopRecord(), or for at most the setMaxRecordTime(), in a file with the
+   * sequence name and ".journal" extension.
+   */
+  void recordJournal(bool record) { mRecordJournal = record; }
+  bool recordJournal() { return mRecordJournal; }
+
+  /// Access the journal e.g. to set its sample clock or snapshot interval
+  ParameterJournal &journal() { return mJournal; }
+
   std::string lastSequenceName();
   std::string lastSequenceSubDir();
 
@@ -133,6 +154,9 @@ class SequenceRecorder : public osc::MessageConsumer {
       }
       mPresetHandler->registerPresetCallback(SequenceRecorder::presetChanged,
                                              (void *)this);
+      for (auto *presetParam : mPresetHandler->parameters()) {
+        mJournal.registerParameter(*presetParam);
+      }
     }
   }
 
@@ -176,6 +200,9 @@ class SequenceRecorder : public osc::MessageConsumer {
   PresetSequencer::Step mStepToInsert;
 
   al_sec mMaxRecordTime;
+
+  bool mRecordJournal{false};
+  ParameterJournal mJournal;
 };
 
 }  // namespace al
@@ -1,10 +1,108 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
 #include <iostream>
+#include <thread>
 
 #include "al/app/al_ComputationDomain.hpp"
 
 using namespace al;
 
+namespace {
+
+// Worker threads shared by all domains to tick concurrent subdomains
+class SubdomainWorkerPool {
+public:
+  static SubdomainWorkerPool &get() {
+    static SubdomainWorkerPool pool;
+    return pool;
+  }
+
+  size_t size() { return mWorkers.size(); }
+
+  void post(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lk(mLock);
+      mTasks.push_back(std::move(task));
+    }
+    mCondition.notify_one();
+  }
+
+private:
+  SubdomainWorkerPool() {
+    unsigned int numThreads = std::thread::hardware_concurrency();
+    numThreads = numThreads > 1 ? numThreads - 1 : 1;
+    for (unsigned int i = 0; i < numThreads; i++) {
+      mWorkers.emplace_back([this]() {
+        while (true) {
+          std::function<void()> task;
+          {
+            std::unique_lock<std::mutex> lk(mLock);
+            mCondition.wait(lk, [this]() { return !mRunning || !mTasks.empty(); });
+            if (mTasks.empty()) {
+              return;
+            }
+            task = std::move(mTasks.front());
+            mTasks.pop_front();
+          }
+          task();
+        }
+      });
+    }
+  }
+
+  ~SubdomainWorkerPool() {
+    {
+      std::lock_guard<std::mutex> lk(mLock);
+      mRunning = false;
+    }
+    mCondition.notify_all();
+    for (auto &worker : mWorkers) {
+      worker.join();
+    }
+  }
+
+  std::vector<std::thread> mWorkers;
+  std::deque<std::function<void()>> mTasks;
+  std::mutex mLock;
+  std::condition_variable mCondition;
+  bool mRunning{true};
+};
+
+// Dependency state for one call to tickSubdomains(). Shared with the pool
+// tasks, which may still hold it after the tick has completed.
+struct SubdomainSchedule {
+  std::vector<SynchronousDomain *> domains;
+  std::vector<bool> concurrent;
+  std::vector<int> remaining; // Number of dependencies not yet ticked
+  std::vector<bool> started;
+  std::vector<std::vector<size_t>> dependents;
+  std::deque<size_t> readyConcurrent;
+  size_t nextSerial{0};
+  size_t done{0};
+  size_t running{0};
+  bool ret{true};
+  std::mutex lock;
+  std::condition_variable condition;
+
+  // Call with lock held
+  void complete(size_t index, bool result) {
+    ret &= result;
+    done++;
+    running--;
+    for (size_t dependent : dependents[index]) {
+      if (--remaining[dependent] == 0 && concurrent[dependent]) {
+        readyConcurrent.push_back(dependent);
+      }
+    }
+    condition.notify_all();
+  }
+};
+
+} // namespace
+
 bool ComputationDomain::initializeSubdomains(bool pre) {
   bool ret = true;
   for (auto subDomain : mSubDomainList) {
@@ -22,17 +120,137 @@ bool ComputationDomain::initializeSubdomains(bool pre) {
 bool ComputationDomain::tickSubdomains(bool pre) {
   bool ret = true;
   std::unique_lock<std::mutex> lk(mSubdomainLock);
-  for (auto subDomain : mSubDomainList) {
+  for (auto it = mSubDomainList.begin(); it != mSubDomainList.end(); it++) {
+    auto &domain = *it->first;
+    if (it->second != pre || domain.mConcurrent ||
+        domain.mWarnedDependencies) {
+      continue;
+    }
+    for (auto *dependency : domain.mDependencies) {
+      auto before = std::find_if(
+          mSubDomainList.begin(), it,
+          [&](const std::pair<std::shared_ptr<SynchronousDomain>, bool> &d) {
+            return d.first.get() == dependency && d.second == pre;
+          });
+      if (before == it) {
+        std::cout << "WARNING: Ignoring dependsOn() for a subdomain that does "
+                     "not run concurrently. It ticks after the subdomains "
+                     "before it."
+                  << std::endl;
+        domain.mWarnedDependencies = true;
+        break;
+      }
+    }
+  }
+  bool anyConcurrent = false;
+  for (auto &subDomain : mSubDomainList) {
+    if (subDomain.second == pre && subDomain.first->mConcurrent) {
+      anyConcurrent = true;
+      break;
+    }
+  }
+  if (!anyConcurrent) {
+    for (auto subDomain : mSubDomainList) {
+      if (subDomain.second == pre) {
+        subDomain.first->mTimeDrift = mTimeDrift;
+        ret &= subDomain.first->timedTick();
+      }
+    }
+    return ret;
+  }
+
+  auto schedule = std::make_shared<SubdomainSchedule>();
+  for (auto &subDomain : mSubDomainList) {
     if (subDomain.second == pre) {
-      auto syncSubDomain =
-          std::dynamic_pointer_cast<SynchronousDomain>(subDomain.first);
-      if (syncSubDomain) {
-        syncSubDomain->mTimeDrift = mTimeDrift;
-        ret &= syncSubDomain->tick();
+      subDomain.first->mTimeDrift = mTimeDrift;
+      schedule->domains.push_back(subDomain.first.get());
+      schedule->concurrent.push_back(subDomain.first->mConcurrent);
+    }
+  }
+  auto &domains = schedule->domains;
+  schedule->remaining.resize(domains.size(), 0);
+  schedule->started.resize(domains.size(), false);
+  schedule->dependents.resize(domains.size());
+  size_t numConcurrent = 0;
+  for (size_t i = 0; i < domains.size(); i++) {
+    if (schedule->concurrent[i]) {
+      numConcurrent++;
+      for (auto *dependency : domains[i]->mDependencies) {
+        auto position = std::find(domains.begin(), domains.end(), dependency);
+        if (position != domains.end() && *position != domains[i]) {
+          schedule->dependents[position - domains.begin()].push_back(i);
+          schedule->remaining[i]++;
+        }
+      }
+      if (schedule->remaining[i] == 0) {
+        schedule->readyConcurrent.push_back(i);
+      }
+    } else { // Serial domains wait for everything before them
+      for (size_t j = 0; j < i; j++) {
+        schedule->dependents[j].push_back(i);
+        schedule->remaining[i]++;
       }
     }
   }
-  return ret;
+
+  // Pool tasks and this thread take ready concurrent domains from the same
+  // queue, so ticking completes even if all workers are busy.
+  auto runConcurrent = [](std::shared_ptr<SubdomainSchedule> schedule) {
+    std::unique_lock<std::mutex> lk(schedule->lock);
+    while (!schedule->readyConcurrent.empty()) {
+      size_t index = schedule->readyConcurrent.front();
+      schedule->readyConcurrent.pop_front();
+      schedule->started[index] = true;
+      schedule->running++;
+      lk.unlock();
+      bool result = schedule->domains[index]->timedTick();
+      lk.lock();
+      schedule->complete(index, result);
+    }
+  };
+  auto &pool = SubdomainWorkerPool::get();
+  size_t numTasks = std::min(numConcurrent - 1, pool.size());
+  for (size_t i = 0; i < numTasks; i++) {
+    pool.post([schedule, runConcurrent]() { runConcurrent(schedule); });
+  }
+
+  std::unique_lock<std::mutex> scheduleLock(schedule->lock);
+  while (schedule->done < domains.size()) {
+    while (schedule->nextSerial < domains.size() &&
+           schedule->concurrent[schedule->nextSerial]) {
+      schedule->nextSerial++;
+    }
+    size_t serial = schedule->nextSerial;
+    if (serial < domains.size() && schedule->remaining[serial] == 0) {
+      // Serial domains always tick on this thread
+      schedule->nextSerial++;
+      schedule->started[serial] = true;
+      schedule->running++;
+      scheduleLock.unlock();
+      bool result = domains[serial]->timedTick();
+      scheduleLock.lock();
+      schedule->complete(serial, result);
+    } else if (!schedule->readyConcurrent.empty()) {
+      scheduleLock.unlock();
+      runConcurrent(schedule);
+      scheduleLock.lock();
+    } else if (schedule->running > 0) {
+      schedule->condition.wait(scheduleLock);
+    } else {
+      std::cerr << "ERROR: Circular subdomain dependencies. Ticking remaining "
+                   "subdomains in order."
+                << std::endl;
+      schedule->readyConcurrent.clear();
+      for (size_t i = 0; i < domains.size(); i++) {
+        if (!schedule->started[i]) {
+          schedule->started[i] = true;
+          schedule->ret &= domains[i]->timedTick();
+        }
+      }
+      break;
+    }
+  }
+  return schedule->ret;
 }
 
 bool ComputationDomain::cleanupSubdomains(bool pre) {
@@ -104,6 +322,23 @@ void ComputationDomain::registerCleanupCallback(
   mCleanupCallbacks.push_back(callback);
 }
 
+bool SynchronousDomain::timedTick() {
+  auto start = std::chrono::steady_clock::now();
+  bool ret = tick();
+  double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+  std::lock_guard<std::mutex> lk(mStatsLock);
+  mTickStats.lastSeconds = seconds;
+  mTickStats.averageSeconds = mTickStats.ticks == 0
+                                  ? seconds
+                                  : 0.95 * mTickStats.averageSeconds +
+                                        0.05 * seconds;
+  mTickStats.maxSeconds = std::max(mTickStats.maxSeconds, seconds);
+  mTickStats.ticks++;
+  return ret;
+}
+
 bool SynchronousDomain::tick() {
   bool ret = tickSubdomains(true);
   ret &= tickSubdomains(false);
@@ -69,6 +69,46 @@ void EasyVAO::updateWithoutBinding(const void* data, size_t typeSize,
   // attrib.buffer.unbind();
 }
 
+void EasyVAO::updateInterleaved(MeshPacker& packer) {
+  validate();
+  bind();
+  primitive(packer.primitive());
+  mNumVertices = static_cast<int>(packer.numVertices());
+
+  if (!mInterleavedBuffer.created()) {
+    mInterleavedBuffer.create();
+  }
+  mInterleavedBuffer.bind();
+
+  if (packer.layoutChanged()) {
+    mInterleavedBuffer.data(packer.size(), packer.data());
+    // packer attribute indices match the default shader layout
+    for (unsigned int i = 0; i < MeshPacker::NUM_ATTRIBS; i++) {
+      auto& att = packer.attrib(static_cast<MeshPacker::AttribIndex>(i));
+      if (att.enabled) {
+        enableAttrib(i);
+        attribPointer(i, mInterleavedBuffer, att.components, att.type,
+                      att.normalized ? GL_TRUE : GL_FALSE,
+                      static_cast<int>(packer.stride()),
+                      reinterpret_cast<void const*>(att.offset));
+      } else {
+        disableAttrib(i);
+      }
+    }
+  } else {
+    for (auto& range : packer.dirtyRanges()) {
+      mInterleavedBuffer.subdata(static_cast<int>(range.first),
+                                 static_cast<int>(range.second - range.first),
+                                 packer.data() + range.first);
+    }
+  }
+
+  if (packer.indicesChanged()) {
+    updateIndices(packer.indices().data(), packer.indices().size());
+  }
+  packer.clearDirty();
+}
+
 void EasyVAO::primitive(unsigned int prim) { mGLPrimMode = prim; }
 
 void EasyVAO::draw() {
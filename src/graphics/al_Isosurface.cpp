@@ -1,6 +1,11 @@
 #include "al/graphics/al_Isosurface.hpp"
 #include <math.h>
 #include "al/graphics/al_Graphics.hpp"
+#include "al/types/al_Voxels.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <iostream>
 
 namespace al {
 
@@ -624,6 +629,81 @@ bool Isosurface::volumeLengths(double& volLengthX, double& volLengthY,
   return false;
 }
 
+bool Isosurface::generate(const Voxels& voxels, int mipLevel) {
+  int nx = int(voxels.width(mipLevel));
+  int ny = int(voxels.height(mipLevel));
+  int nz = int(voxels.depth(mipLevel));
+  double numEdges = 3. * (nx + 1.) * (ny + 1.) * (nz + 1.);
+  if (nx < 2 || ny < 2 || nz < 2 || numEdges > INT_MAX) {
+    std::cerr << "Isosurface: cannot generate from " << nx << "x" << ny << "x"
+              << nz << " voxels" << std::endl;
+    return false;
+  }
+
+  double scale = double(1 << mipLevel);
+  fieldDims(nx, ny, nz);
+  cellLengths(voxels.getVoxWidth(0) * scale, voxels.getVoxWidth(1) * scale,
+              voxels.getVoxWidth(2) * scale);
+  inBox(false);
+  begin();
+
+  const int B = int(voxels.brickSize());
+  const int nb[3] = {int(voxels.bricks(0, mipLevel)),
+                     int(voxels.bricks(1, mipLevel)),
+                     int(voxels.bricks(2, mipLevel))};
+  std::vector<float> block;
+
+  // Bricks in the same order as cells of the dense field
+  for (int bz = nb[2] - 1; bz >= 0; --bz) {
+    for (int by = 0; by < nb[1]; ++by) {
+      for (int bx = 0; bx < nb[0]; ++bx) {
+        // Cells of a brick reach the first voxels of the following bricks
+        float lo = level(), hi = level();
+        bool first = true;
+        for (int k = bz; k <= std::min(bz + 1, nb[2] - 1); ++k) {
+          for (int j = by; j <= std::min(by + 1, nb[1] - 1); ++j) {
+            for (int i = bx; i <= std::min(bx + 1, nb[0] - 1); ++i) {
+              float bmin, bmax;
+              voxels.brickRange(i, j, k, mipLevel, bmin, bmax);
+              lo = first ? bmin : std::min(lo, bmin);
+              hi = first ? bmax : std::max(hi, bmax);
+              first = false;
+            }
+          }
+        }
+        if (hi < level() || lo >= level()) continue;
+
+        int x0 = bx * B, y0 = by * B, z0 = bz * B;
+        int cx = std::min(B, nx - 1 - x0);
+        int cy = std::min(B, ny - 1 - y0);
+        int cz = std::min(B, nz - 1 - z0);
+        if (cx <= 0 || cy <= 0 || cz <= 0) continue;
+
+        int sx = cx + 1, sxy = sx * (cy + 1);
+        block.resize(size_t(sxy) * (cz + 1));
+        voxels.read(block.data(), x0, y0, z0, sx, cy + 1, cz + 1, mipLevel);
+
+        for (int z = cz - 1; z >= 0; --z) {
+          for (int y = 0; y < cy; ++y) {
+            const float* v0 = &block[z * sxy + y * sx];
+            const float* v1 = v0 + sxy;
+            for (int x = 0; x < cx; ++x) {
+              float v8[] = {v0[x],      v0[x + 1],      v0[x + sx],
+                            v0[x + sx + 1], v1[x],          v1[x + 1],
+                            v1[x + sx],     v1[x + sx + 1]};
+              int i3[] = {x0 + x, y0 + y, z0 + z};
+              addCell(i3, v8);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  end();
+  return true;
+}
+
 }  // namespace al
 
 /*
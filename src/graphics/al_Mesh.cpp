@@ -1,8 +1,12 @@
-// #include <algorithm> // transform
+#include <algorithm>
 #include <cctype> // tolower
 #include <cstdio>
+#include <functional>
 #include <map>
+#include <cmath>
 #include <set>
+#include <thread>
+#include <unordered_map>
 // #include <string>
 #include <fstream>
 #include <sstream> // stringstream
@@ -12,6 +16,7 @@
 #include <stdio.h>
 
 #include "al/graphics/al_Mesh.hpp"
+#include "al/math/al_BatchTransform.hpp"
 #include "al/system/al_Printing.hpp"
 
 namespace al {
@@ -24,7 +29,7 @@ Mesh::Mesh(const Mesh &cpy)
     : mVertices(cpy.mVertices), mNormals(cpy.mNormals), mColors(cpy.mColors),
       mTexCoord1s(cpy.mTexCoord1s), mTexCoord2s(cpy.mTexCoord2s),
       mTexCoord3s(cpy.mTexCoord3s), mIndices(cpy.mIndices),
-      mPrimitive(cpy.mPrimitive) {}
+      mPrimitive(cpy.mPrimitive), mNormalsTopology(cpy.mNormalsTopology) {}
 
 void Mesh::copy(Mesh const &m) {
   mVertices = m.mVertices;
@@ -35,6 +40,7 @@ void Mesh::copy(Mesh const &m) {
   mTexCoord3s = m.mTexCoord3s;
   mIndices = m.mIndices;
   mPrimitive = m.mPrimitive;
+  mNormalsTopology = m.mNormalsTopology;
 }
 
 Mesh &Mesh::reset() {
@@ -189,78 +195,492 @@ Mesh &Mesh::invertNormals() {
   return *this;
 }
 
-Mesh &Mesh::compress() {
-  int Ni = (int)indices().size();
-  int Nv = (int)vertices().size();
-  if (Ni) {
-    AL_WARN_ONCE("cannot compress Mesh with indices");
-    return *this;
+Mesh &Mesh::compress() { return weld(0, false); }
+
+namespace {
+
+// Reorders the per-vertex buffers of a mesh. newToOld gives the source vertex
+// of each new vertex. Buffers not matching the vertex count are left alone.
+template <class T>
+void gatherBuffer(std::vector<T> &buf, size_t Nv,
+                  const std::vector<unsigned> &newToOld) {
+  if (buf.size() != Nv)
+    return;
+  std::vector<T> old;
+  old.swap(buf);
+  buf.resize(newToOld.size());
+  for (size_t i = 0; i < newToOld.size(); ++i)
+    buf[i] = old[newToOld[i]];
+}
+
+void gatherVertices(Mesh &m, const std::vector<unsigned> &newToOld) {
+  size_t Nv = m.vertices().size();
+  gatherBuffer(m.normals(), Nv, newToOld);
+  gatherBuffer(m.colors(), Nv, newToOld);
+  gatherBuffer(m.texCoord1s(), Nv, newToOld);
+  gatherBuffer(m.texCoord2s(), Nv, newToOld);
+  gatherBuffer(m.texCoord3s(), Nv, newToOld);
+  gatherBuffer(m.vertices(), Nv, newToOld);
+}
+
+template <class T>
+bool sameAttribute(const std::vector<T> &buf, size_t Nv, unsigned i,
+                   unsigned j) {
+  return buf.size() != Nv || buf[i] == buf[j];
+}
+
+// FIFO cache used to estimate post-transform vertex cache misses
+struct FifoCache {
+  std::vector<unsigned> timestamps; // per vertex, time of insertion
+  unsigned time;
+
+  FifoCache(size_t numVertices, unsigned cacheSize)
+      : timestamps(numVertices, 0), time(cacheSize + 1) {}
+
+  // Returns true on a cache miss
+  bool access(unsigned v, unsigned cacheSize) {
+    if (time - timestamps[v] > cacheSize) {
+      timestamps[v] = time++;
+      return true;
+    }
+    return false;
   }
+};
+
+} // namespace
+
+Mesh &Mesh::weld(float tolerance, bool matchAttributes) {
+  size_t Nv = vertices().size();
   if (Nv == 0) {
-    AL_WARN_ONCE("cannot compress Mesh with no vertices");
+    AL_WARN_ONCE("cannot weld Mesh with no vertices");
     return *this;
   }
 
-  int Nc = (int)colors().size();
-  int Nn = (int)normals().size();
-  int Nt1 = (int)texCoord1s().size();
-  int Nt2 = (int)texCoord2s().size();
-  int Nt3 = (int)texCoord3s().size();
+  const float cellSize = tolerance > 0 ? tolerance : 1.f;
+  auto cellOf = [&](float x) -> int64_t {
+    if (tolerance > 0)
+      return int64_t(std::floor(x / cellSize));
+    // Exact matching: hash the float value itself. Adding zero turns -0 to +0.
+    x += 0.f;
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    return bits;
+  };
+  auto cellKey = [](int64_t x, int64_t y, int64_t z) {
+    uint64_t h = uint64_t(x) * 73856093ULL;
+    h ^= uint64_t(y) * 19349663ULL;
+    h ^= uint64_t(z) * 83492791ULL;
+    return h;
+  };
 
-  // map tree to uniquely ID vertices with same values:
-  typedef std::map<float, int> Zmap;
-  typedef std::map<float, Zmap> Ymap;
-  typedef std::map<float, Ymap> Xmap;
-  Xmap xmap;
+  auto equalAttributes = [&](unsigned i, unsigned j) {
+    return sameAttribute(normals(), Nv, i, j) &&
+           sameAttribute(colors(), Nv, i, j) &&
+           sameAttribute(texCoord1s(), Nv, i, j) &&
+           sameAttribute(texCoord2s(), Nv, i, j) &&
+           sameAttribute(texCoord3s(), Nv, i, j);
+  };
 
-  // copy current values:
-  Mesh old(*this);
+  // Cells hold the original index of each unique vertex
+  std::unordered_multimap<uint64_t, unsigned> grid;
+  grid.reserve(Nv);
+  std::vector<unsigned> remap(Nv);
+  std::vector<unsigned> newToOld;
+  const float tol2 = tolerance * tolerance;
+  const int reach = tolerance > 0 ? 1 : 0;
+
+  for (unsigned i = 0; i < Nv; ++i) {
+    const Vertex &v = vertices()[i];
+    int64_t cx = cellOf(v.x), cy = cellOf(v.y), cz = cellOf(v.z);
+    bool found = false;
+    for (int dx = -reach; dx <= reach && !found; ++dx) {
+      for (int dy = -reach; dy <= reach && !found; ++dy) {
+        for (int dz = -reach; dz <= reach && !found; ++dz) {
+          auto range = grid.equal_range(cellKey(cx + dx, cy + dy, cz + dz));
+          for (auto it = range.first; it != range.second; ++it) {
+            unsigned j = it->second;
+            const Vertex &u = vertices()[j];
+            bool close = tolerance > 0 ? (u - v).magSqr() <= tol2 : u == v;
+            if (close && (!matchAttributes || equalAttributes(i, j))) {
+              remap[i] = remap[j];
+              found = true;
+              break;
+            }
+          }
+        }
+      }
+    }
+    if (!found) {
+      remap[i] = unsigned(newToOld.size());
+      newToOld.push_back(i);
+      grid.emplace(cellKey(cx, cy, cz), i);
+    }
+  }
 
-  // walk backward through the vertex list
-  // create a ID for each one
-  for (int i = (int)vertices().size() - 1; i >= 0; i--) {
-    Vertex &v = vertices()[i];
-    xmap[v.x][v.y][v.z] = i;
+  if (indices().size()) {
+    for (auto &idx : indices())
+      idx = remap[idx];
+  } else {
+    indices().assign(remap.begin(), remap.end());
   }
+  gatherVertices(*this, newToOld);
+  return *this;
+}
 
-  // map of old vertex index to new vertex index:
-  typedef std::map<int, int> Imap;
-  Imap imap;
+Mesh &Mesh::optimizeVertexCache(unsigned cacheSize) {
+  if (!isTriangles() || indices().size() < 3) {
+    AL_WARN_ONCE("vertex cache optimization needs indexed triangles");
+    return *this;
+  }
+  const size_t Nt = indices().size() / 3;
+  const size_t Nv = vertices().size();
+  const Index *tris = indices().data();
+  cacheSize = std::max(cacheSize, 4u);
+
+  // Vertex-triangle adjacency
+  std::vector<unsigned> offsets(Nv + 1, 0);
+  for (size_t i = 0; i < Nt * 3; ++i)
+    ++offsets[tris[i] + 1];
+  for (size_t v = 0; v < Nv; ++v)
+    offsets[v + 1] += offsets[v];
+  std::vector<unsigned> adjacency(offsets[Nv]);
+  std::vector<unsigned> liveTriangles(Nv);
+  {
+    std::vector<unsigned> cursor(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < Nt * 3; ++i)
+      adjacency[cursor[tris[i]]++] = unsigned(i / 3);
+    for (size_t v = 0; v < Nv; ++v)
+      liveTriangles[v] = offsets[v + 1] - offsets[v];
+  }
 
-  // reset current mesh:
-  reset();
+  // Scoring from Tom Forsyth, "Linear-Speed Vertex Cache Optimisation"
+  auto vertexScore = [&](int cachePosition, unsigned live) -> float {
+    if (live == 0)
+      return -1;
+    float score = 0;
+    if (cachePosition >= 0) {
+      if (cachePosition < 3) {
+        score = 0.75f;
+      } else {
+        float s = 1.f - float(cachePosition - 3) / float(cacheSize - 3);
+        score = std::pow(s, 1.5f);
+      }
+    }
+    return score + 2.f / std::sqrt(float(live));
+  };
 
-  // walk forward, inserting if
-  for (size_t i = 0; i < old.vertices().size(); i++) {
-    Vertex &v = old.vertices()[i];
-    int idx = xmap[v.x][v.y][v.z];
-    Imap::iterator it = imap.find(idx);
-    if (it != imap.end()) {
-      // use existing
-      index(it->second);
-    } else {
-      // create new
-      int newidx = (int)vertices().size();
-      vertex(v);
-      if (Nc)
-        color(old.colors()[i]);
-      if (Nn)
-        normal(old.normals()[i]);
-      if (Nt1)
-        texCoord(old.texCoord1s()[i]);
-      if (Nt2)
-        texCoord(old.texCoord2s()[i]);
-      if (Nt3)
-        texCoord(old.texCoord3s()[i]);
-      // store new index:
-      imap[idx] = newidx;
-      // use new index:
-      index(newidx);
+  std::vector<float> vScore(Nv);
+  for (size_t v = 0; v < Nv; ++v)
+    vScore[v] = vertexScore(-1, liveTriangles[v]);
+  std::vector<float> tScore(Nt);
+  for (size_t t = 0; t < Nt; ++t)
+    tScore[t] = vScore[tris[3 * t]] + vScore[tris[3 * t + 1]] +
+                vScore[tris[3 * t + 2]];
+  std::vector<char> emitted(Nt, 0);
+
+  Indices result;
+  result.reserve(Nt * 3);
+  std::vector<unsigned> cache, newCache;
+  cache.reserve(cacheSize + 3);
+  newCache.reserve(cacheSize + 3);
+  size_t deadEndCursor = 0;
+  unsigned best = unsigned(-1);
+
+  for (size_t n = 0; n < Nt; ++n) {
+    if (best == unsigned(-1)) {
+      // Dead end: continue with the next triangle in input order
+      while (emitted[deadEndCursor])
+        ++deadEndCursor;
+      best = unsigned(deadEndCursor);
+    }
+    emitted[best] = 1;
+    const Index *tri = tris + 3 * best;
+    result.insert(result.end(), tri, tri + 3);
+
+    // Move the triangle's vertices to the front of the LRU cache
+    newCache.clear();
+    for (int k = 0; k < 3; ++k) {
+      if (std::find(newCache.begin(), newCache.end(), tri[k]) == newCache.end())
+        newCache.push_back(tri[k]);
+    }
+    for (auto v : cache) {
+      if (v != tri[0] && v != tri[1] && v != tri[2])
+        newCache.push_back(v);
+    }
+    for (int k = 0; k < 3; ++k) {
+      // Remove the triangle from its vertices' live lists
+      unsigned v = tri[k];
+      unsigned *first = adjacency.data() + offsets[v];
+      unsigned *last = first + liveTriangles[v];
+      *std::find(first, last, best) = *(last - 1);
+      --liveTriangles[v];
+    }
+    auto updateScore = [&](unsigned v, int position) {
+      float score = vertexScore(position, liveTriangles[v]);
+      float delta = score - vScore[v];
+      vScore[v] = score;
+      for (unsigned a = 0; a < liveTriangles[v]; ++a)
+        tScore[adjacency[offsets[v] + a]] += delta;
+    };
+    for (size_t c = cacheSize; c < newCache.size(); ++c)
+      updateScore(newCache[c], -1);
+    if (newCache.size() > cacheSize)
+      newCache.resize(cacheSize);
+    cache.swap(newCache);
+
+    // Update scores and pick the best triangle touching the cache
+    for (size_t c = 0; c < cache.size(); ++c)
+      updateScore(cache[c], int(c));
+    best = unsigned(-1);
+    float bestScore = -1;
+    for (auto v : cache) {
+      for (unsigned a = 0; a < liveTriangles[v]; ++a) {
+        unsigned t = adjacency[offsets[v] + a];
+        if (tScore[t] > bestScore) {
+          bestScore = tScore[t];
+          best = t;
+        }
+      }
+    }
+  }
+
+  indices().swap(result);
+  return *this;
+}
+
+Mesh &Mesh::optimizeOverdraw(float threshold, unsigned cacheSize) {
+  if (!isTriangles() || indices().size() < 3) {
+    AL_WARN_ONCE("overdraw optimization needs indexed triangles");
+    return *this;
+  }
+  const size_t Nt = indices().size() / 3;
+  const Index *tris = indices().data();
+  const auto &verts = vertices();
+
+  // Hard cluster boundaries are triangles that miss the cache on all three
+  // vertices. Inside those, split again wherever the miss ratio so far stays
+  // within threshold of the whole cluster's ratio.
+  std::vector<unsigned> misses(Nt);
+  FifoCache cache(verts.size(), cacheSize);
+  std::vector<size_t> hard;
+  for (size_t t = 0; t < Nt; ++t) {
+    unsigned m = 0;
+    for (int k = 0; k < 3; ++k)
+      m += cache.access(tris[3 * t + k], cacheSize);
+    misses[t] = m;
+    if (m == 3)
+      hard.push_back(t);
+  }
+  if (hard.empty() || hard[0] != 0)
+    hard.insert(hard.begin(), 0);
+  hard.push_back(Nt);
+
+  std::vector<size_t> clusters;
+  for (size_t h = 0; h + 1 < hard.size(); ++h) {
+    size_t begin = hard[h], end = hard[h + 1];
+    unsigned total = 0;
+    for (size_t t = begin; t < end; ++t)
+      total += misses[t];
+    float clusterRatio = float(total) / float(end - begin);
+    clusters.push_back(begin);
+    unsigned pieceMisses = 0;
+    size_t pieceBegin = begin;
+    for (size_t t = begin; t < end; ++t) {
+      pieceMisses += misses[t];
+      float ratio = float(pieceMisses) / float(t + 1 - pieceBegin);
+      if (t + 1 < end && ratio <= clusterRatio * threshold &&
+          misses[t + 1] > 0) {
+        clusters.push_back(t + 1);
+        pieceBegin = t + 1;
+        pieceMisses = 0;
+      }
+    }
+  }
+  clusters.push_back(Nt);
+  size_t Nc = clusters.size() - 1;
+
+  // Mesh centroid weighted by triangle area
+  Vec3f meshCenter(0, 0, 0);
+  float meshArea = 0;
+  for (size_t t = 0; t < Nt; ++t) {
+    const Vertex &v1 = verts[tris[3 * t]], &v2 = verts[tris[3 * t + 1]],
+                 &v3 = verts[tris[3 * t + 2]];
+    float area = cross(v2 - v1, v3 - v1).mag();
+    meshCenter += (v1 + v2 + v3) * (area / 3.f);
+    meshArea += area;
+  }
+  if (meshArea > 0)
+    meshCenter /= meshArea;
+
+  // Clusters facing outward from the center are likely to occlude others
+  std::vector<float> sortKey(Nc);
+  for (size_t c = 0; c < Nc; ++c) {
+    Vec3f center(0, 0, 0), normal(0, 0, 0);
+    float area = 0;
+    for (size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+      const Vertex &v1 = verts[tris[3 * t]], &v2 = verts[tris[3 * t + 1]],
+                   &v3 = verts[tris[3 * t + 2]];
+      Vec3f n = cross(v2 - v1, v3 - v1);
+      float triArea = n.mag();
+      center += (v1 + v2 + v3) * (triArea / 3.f);
+      normal += n;
+      area += triArea;
+    }
+    if (area > 0)
+      center /= area;
+    float nmag = normal.mag();
+    sortKey[c] = nmag > 0 ? (center - meshCenter).dot(normal / nmag) : 0;
+  }
+  std::vector<unsigned> order(Nc);
+  for (size_t c = 0; c < Nc; ++c)
+    order[c] = unsigned(c);
+  std::stable_sort(order.begin(), order.end(), [&](unsigned a, unsigned b) {
+    return sortKey[a] > sortKey[b];
+  });
+
+  Indices result;
+  result.reserve(indices().size());
+  for (auto c : order) {
+    result.insert(result.end(), tris + 3 * clusters[c],
+                  tris + 3 * clusters[c + 1]);
+  }
+  indices().swap(result);
+  return *this;
+}
+
+Mesh &Mesh::optimizeVertexFetch() {
+  if (indices().empty()) {
+    AL_WARN_ONCE("vertex fetch optimization needs an indexed mesh");
+    return *this;
+  }
+  const size_t Nv = vertices().size();
+  std::vector<unsigned> remap(Nv, unsigned(-1));
+  std::vector<unsigned> newToOld;
+  newToOld.reserve(Nv);
+  for (auto &idx : indices()) {
+    if (remap[idx] == unsigned(-1)) {
+      remap[idx] = unsigned(newToOld.size());
+      newToOld.push_back(idx);
     }
+    idx = remap[idx];
   }
+  gatherVertices(*this, newToOld);
   return *this;
 }
 
+Mesh &Mesh::optimize(unsigned cacheSize) {
+  optimizeVertexCache(cacheSize);
+  optimizeOverdraw(1.05f, cacheSize);
+  return optimizeVertexFetch();
+}
+
+float Mesh::vertexCacheMissRatio(unsigned cacheSize) const {
+  if (!isTriangles())
+    return 0;
+  const size_t Ni = indices().size();
+  if (Ni == 0)
+    return vertices().size() >= 3 ? 3.f : 0.f;
+  FifoCache cache(vertices().size(), cacheSize);
+  unsigned misses = 0;
+  for (size_t i = 0; i < Ni - Ni % 3; ++i)
+    misses += cache.access(indices()[i], cacheSize);
+  return Ni >= 3 ? float(misses) / float(Ni / 3) : 0.f;
+}
+
+namespace {
+
+// Vertex indices of each face of a triangle or triangle strip mesh
+struct FaceList {
+  const Mesh::Index *indices; // nullptr if mesh is not indexed
+  size_t size;
+  bool strip;
+
+  FaceList(const Mesh &m) {
+    size_t N = m.indices().size() ? m.indices().size() : m.vertices().size();
+    indices = m.indices().size() ? m.indices().data() : nullptr;
+    strip = m.isTriangleStrip();
+    if (strip) {
+      size = N > 2 ? N - 2 : 0;
+    } else if (m.isTriangles()) {
+      size = N / 3;
+    } else {
+      size = 0;
+    }
+  }
+
+  void get(size_t f, unsigned &i1, unsigned &i2, unsigned &i3) const {
+    if (strip) {
+      // Flip every other face due to change in winding direction
+      unsigned odd = f & 1;
+      i1 = unsigned(f);
+      i2 = unsigned(f + 1 + odd);
+      i3 = unsigned(f + 2 - odd);
+    } else {
+      i1 = unsigned(3 * f);
+      i2 = i1 + 1;
+      i3 = i1 + 2;
+    }
+    if (indices) {
+      i1 = indices[i1];
+      i2 = indices[i2];
+      i3 = indices[i3];
+    }
+  }
+};
+
+// Hash of what normals depend on besides vertex positions, never 0
+uint64_t normalsTopology(const Mesh &m, bool normalize,
+                         bool equalWeightPerFace) {
+  uint64_t hash = 14695981039346656037ull;
+  auto add = [&hash](uint64_t value) {
+    hash ^= value;
+    hash *= 1099511628211ull;
+  };
+  add(m.primitive());
+  add(normalize);
+  add(equalWeightPerFace);
+  add(m.vertices().size());
+  add(m.indices().size());
+  for (auto i : m.indices())
+    add(i);
+  return hash | 1;
+}
+
+Mesh::Normal faceNormal(const Mesh::Vertices &v, unsigned i1, unsigned i2,
+                        unsigned i3, bool equalWeight) {
+  // MWAAT (mean weighted by areas of adjacent triangles)
+  auto vn = cross(v[i2] - v[i1], v[i3] - v[i1]);
+  // MWE (mean weighted equally)
+  if (equalWeight)
+    vn.normalize();
+  return vn;
+}
+
+// Splits [0, n) into contiguous ranges processed by separate threads.
+// Small workloads are run on the calling thread.
+void parallelFor(size_t n, unsigned numThreads,
+                 const std::function<void(size_t begin, size_t end)> &func) {
+  const size_t minPerThread = 16384;
+  if (numThreads == 0) {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  numThreads = unsigned(std::min<size_t>(numThreads, n / minPerThread));
+  if (numThreads <= 1) {
+    func(0, n);
+    return;
+  }
+  std::vector<std::thread> threads;
+  for (unsigned t = 1; t < numThreads; t++) {
+    threads.emplace_back(func, n * t / numThreads, n * (t + 1) / numThreads);
+  }
+  func(0, n / numThreads);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+} // namespace
+
 Mesh &Mesh::generateNormals(bool normalize, bool equalWeightPerFace) {
   auto calcNormal = [](const Vertex &v1, const Vertex &v2, const Vertex &v3,
                        bool MWE) {
@@ -387,6 +807,177 @@ Mesh &Mesh::generateNormals(bool normalize, bool equalWeightPerFace) {
       }
     }
   }
+  mNormalsTopology = normalsTopology(*this, normalize, equalWeightPerFace);
+  return *this;
+}
+
+Mesh &Mesh::generateNormalsParallel(bool normalize, bool equalWeightPerFace,
+                                    unsigned numThreads) {
+  size_t Nv = vertices().size();
+
+  // need at least one triangle
+  if (Nv < 3)
+    return *this;
+
+  normals().resize(Nv);
+  mNormalsTopology = normalsTopology(*this, normalize, equalWeightPerFace);
+  FaceList faces(*this);
+  const auto &verts = vertices();
+  auto &norms = normals();
+
+  // non-indexed triangles have one normal per face
+  if (!faces.indices && !faces.strip) {
+    parallelFor(faces.size, numThreads, [&](size_t begin, size_t end) {
+      for (size_t f = begin; f < end; ++f) {
+        unsigned i1, i2, i3;
+        faces.get(f, i1, i2, i3);
+        auto vn = cross(verts[i2] - verts[i1], verts[i3] - verts[i1]);
+        if (normalize)
+          vn.normalize();
+        norms[i1] = vn;
+        norms[i2] = vn;
+        norms[i3] = vn;
+      }
+    });
+    return *this;
+  }
+
+  // indexed meshes without faces have no normals, as in generateNormals()
+  if (faces.size == 0) {
+    for (auto &n : norms)
+      n.set(0, 0, 0);
+    return *this;
+  }
+
+  std::vector<Normal> faceNormals(faces.size);
+  parallelFor(faces.size, numThreads, [&](size_t begin, size_t end) {
+    for (size_t f = begin; f < end; ++f) {
+      unsigned i1, i2, i3;
+      faces.get(f, i1, i2, i3);
+      faceNormals[f] = faceNormal(verts, i1, i2, i3, equalWeightPerFace);
+    }
+  });
+
+  // Vertex-face adjacency in compressed rows. Faces are listed in ascending
+  // order, so sums match the serial version exactly.
+  std::vector<unsigned> offsets(Nv + 1, 0);
+  for (size_t f = 0; f < faces.size; ++f) {
+    unsigned i[3];
+    faces.get(f, i[0], i[1], i[2]);
+    for (auto vi : i)
+      ++offsets[vi + 1];
+  }
+  for (size_t v = 0; v < Nv; ++v)
+    offsets[v + 1] += offsets[v];
+  std::vector<unsigned> adjacentFaces(offsets[Nv]);
+  {
+    std::vector<unsigned> cursor(offsets.begin(), offsets.end() - 1);
+    for (size_t f = 0; f < faces.size; ++f) {
+      unsigned i[3];
+      faces.get(f, i[0], i[1], i[2]);
+      for (auto vi : i)
+        adjacentFaces[cursor[vi]++] = unsigned(f);
+    }
+  }
+
+  parallelFor(Nv, numThreads, [&](size_t begin, size_t end) {
+    for (size_t v = begin; v < end; ++v) {
+      Normal n(0, 0, 0);
+      for (unsigned a = offsets[v]; a < offsets[v + 1]; ++a)
+        n += faceNormals[adjacentFaces[a]];
+      if (normalize)
+        n.normalize();
+      norms[v] = n;
+    }
+  });
+  return *this;
+}
+
+Mesh &Mesh::updateNormals(int begin, int end, bool normalize,
+                          bool equalWeightPerFace) {
+  int Nv = (int)vertices().size();
+  if (begin < 0)
+    begin += Nv;
+  if (end < 0)
+    end += Nv + 1; // negative index wraps to end of array
+  begin = std::max(begin, 0);
+  end = std::min(end, Nv);
+  if (begin >= end)
+    return *this;
+
+  if ((int)normals().size() != Nv ||
+      mNormalsTopology != normalsTopology(*this, normalize, equalWeightPerFace))
+    return generateNormals(normalize, equalWeightPerFace);
+
+  FaceList faces(*this);
+  const auto &verts = vertices();
+  auto &norms = normals();
+  auto inRange = [&](unsigned i) { return int(i) >= begin && int(i) < end; };
+
+  // Without indices, only faces next to the range need to be visited
+  size_t fBegin = 0, fEnd = faces.size;
+  if (!faces.indices) {
+    if (faces.strip) {
+      fBegin = size_t(std::max(begin - 4, 0));
+      fEnd = std::min(size_t(end + 2), faces.size);
+    } else {
+      fBegin = size_t(begin / 3);
+      fEnd = std::min(size_t((end + 2) / 3), faces.size);
+    }
+  }
+
+  if (!faces.indices && !faces.strip) {
+    for (size_t f = fBegin; f < fEnd; ++f) {
+      unsigned i1, i2, i3;
+      faces.get(f, i1, i2, i3);
+      auto vn = cross(verts[i2] - verts[i1], verts[i3] - verts[i1]);
+      if (normalize)
+        vn.normalize();
+      norms[i1] = vn;
+      norms[i2] = vn;
+      norms[i3] = vn;
+    }
+    return *this;
+  }
+
+  // Vertices sharing a face with a moved vertex
+  std::vector<char> affected(Nv, 0);
+  std::vector<unsigned> affectedList;
+  for (size_t f = fBegin; f < fEnd; ++f) {
+    unsigned i[3];
+    faces.get(f, i[0], i[1], i[2]);
+    if (inRange(i[0]) || inRange(i[1]) || inRange(i[2])) {
+      for (auto vi : i) {
+        if (!affected[vi]) {
+          affected[vi] = 1;
+          affectedList.push_back(vi);
+        }
+      }
+    }
+  }
+  for (auto vi : affectedList)
+    norms[vi].set(0, 0, 0);
+
+  if (!faces.indices) {
+    fBegin = size_t(std::max(begin - 4, 0));
+    fEnd = std::min(size_t(end + 4), faces.size);
+  }
+  for (size_t f = fBegin; f < fEnd; ++f) {
+    unsigned i[3];
+    faces.get(f, i[0], i[1], i[2]);
+    if (affected[i[0]] || affected[i[1]] || affected[i[2]]) {
+      auto vn = faceNormal(verts, i[0], i[1], i[2], equalWeightPerFace);
+      for (auto vi : i) {
+        if (affected[vi])
+          norms[vi] += vn;
+      }
+    }
+  }
+
+  if (normalize) {
+    for (auto vi : affectedList)
+      norms[vi].normalize();
+  }
   return *this;
 }
 
@@ -556,6 +1147,22 @@ Mesh &Mesh::flipWinding() {
   return *this;
 }
 
+Mesh &Mesh::transform(const Mat<4, float> &m, int begin, int end) {
+  if (begin < 0)
+    begin += vertices().size();
+  if (end < 0)
+    end += vertices().size() + 1; // negative index wraps to end of array
+  if (end <= begin)
+    return *this;
+  transformPoints(m, vertices().data() + begin, vertices().data() + begin,
+                  end - begin);
+  if (normals().size() >= vertices().size()) {
+    transformNormals(normalMatrix(m), normals().data() + begin,
+                     normals().data() + begin, end - begin);
+  }
+  return *this;
+}
+
 Mesh &Mesh::merge(const Mesh &src) {
   // TODO: only do merge if source and dest are well-formed
   // TODO: what to do when mixing float and integer colors? promote or demote?
@@ -0,0 +1,176 @@
+#include "al/graphics/al_MeshPacker.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "al/types/al_Conversion.hpp"
+
+using namespace al;
+
+namespace {
+
+// Arrays shorter than the vertex array repeat their last element, as in
+// Mesh::equalizeBuffers()
+template <class T>
+const T &element(const std::vector<T> &buf, size_t i) {
+  return i < buf.size() ? buf[i] : buf.back();
+}
+
+uint8_t toUnorm8(float v) {
+  v = std::min(std::max(v, 0.f), 1.f);
+  return uint8_t(v * 255.f + 0.5f);
+}
+
+void packVertex(const Mesh &m, size_t i, const MeshPacker::Attrib *attribs,
+                bool quantize, uint8_t *dst) {
+  std::memcpy(dst + attribs[MeshPacker::POSITION].offset,
+              m.vertices()[i].elems(), sizeof(Mesh::Vertex));
+  if (attribs[MeshPacker::COLOR].enabled) {
+    const Color &c = element(m.colors(), i);
+    uint8_t *out = dst + attribs[MeshPacker::COLOR].offset;
+    if (quantize) {
+      for (int k = 0; k < 4; ++k)
+        out[k] = toUnorm8(c.components[k]);
+    } else {
+      std::memcpy(out, c.components, sizeof(Color));
+    }
+  }
+  if (attribs[MeshPacker::TEXCOORD].enabled) {
+    std::memcpy(dst + attribs[MeshPacker::TEXCOORD].offset,
+                element(m.texCoord2s(), i).elems(), sizeof(Mesh::TexCoord2));
+  }
+  if (attribs[MeshPacker::NORMAL].enabled) {
+    const Mesh::Normal &n = element(m.normals(), i);
+    uint8_t *out = dst + attribs[MeshPacker::NORMAL].offset;
+    if (quantize) {
+      uint16_t h[4] = {floatToHalf(n.x), floatToHalf(n.y), floatToHalf(n.z),
+                       0};
+      std::memcpy(out, h, sizeof(h));
+    } else {
+      std::memcpy(out, n.elems(), sizeof(Mesh::Normal));
+    }
+  }
+}
+
+} // namespace
+
+void MeshPacker::pack(const Mesh &mesh) {
+  const size_t Nv = mesh.vertices().size();
+  mPrimitive = mesh.primitive();
+
+  // Work out the layout
+  Attrib attribs[NUM_ATTRIBS];
+  size_t stride = 0;
+  auto add = [&](AttribIndex index, bool present, int components,
+                 unsigned int type, bool normalized, size_t bytes) {
+    if (!present)
+      return;
+    attribs[index].enabled = true;
+    attribs[index].components = components;
+    attribs[index].type = type;
+    attribs[index].normalized = normalized;
+    attribs[index].offset = stride;
+    stride += bytes;
+  };
+  add(POSITION, true, 3, GL_FLOAT, false, sizeof(Mesh::Vertex));
+  add(COLOR, !mesh.colors().empty(), 4,
+      mQuantize ? GL_UNSIGNED_BYTE : GL_FLOAT, mQuantize,
+      mQuantize ? 4 : sizeof(Color));
+  add(TEXCOORD, !mesh.texCoord2s().empty(), 2, GL_FLOAT, false,
+      sizeof(Mesh::TexCoord2));
+  add(NORMAL, !mesh.normals().empty(), 3,
+      mQuantize ? GL_HALF_FLOAT : GL_FLOAT, false,
+      mQuantize ? 4 * sizeof(uint16_t) : sizeof(Mesh::Normal));
+
+  bool layoutChanged = mLayoutChanged || stride != mStride || Nv != mNumVertices;
+  for (unsigned int a = 0; a < NUM_ATTRIBS; ++a) {
+    if (attribs[a] != mAttribs[a]) {
+      layoutChanged = true;
+    }
+    mAttribs[a] = attribs[a];
+  }
+  mStride = stride;
+  mNumVertices = Nv;
+  mLayoutChanged = layoutChanged;
+  mDirtyRanges.clear();
+
+  if (layoutChanged) {
+    mData.resize(Nv * stride);
+    for (size_t i = 0; i < Nv; ++i) {
+      packVertex(mesh, i, mAttribs, mQuantize, mData.data() + i * stride);
+    }
+    if (Nv > 0) {
+      mDirtyRanges.emplace_back(0, mData.size());
+    }
+  } else {
+    // Compare against the previous contents and collect changed runs
+    std::vector<uint8_t> vertex(stride);
+    size_t lastDirty = 0;
+    bool inRange = false;
+    for (size_t i = 0; i < Nv; ++i) {
+      uint8_t *dst = mData.data() + i * stride;
+      packVertex(mesh, i, mAttribs, mQuantize, vertex.data());
+      if (std::memcmp(vertex.data(), dst, stride) == 0) {
+        continue;
+      }
+      std::memcpy(dst, vertex.data(), stride);
+      if (inRange && i - lastDirty <= mMergeGap + 1) {
+        mDirtyRanges.back().second = (i + 1) * stride;
+      } else {
+        mDirtyRanges.emplace_back(i * stride, (i + 1) * stride);
+        inRange = true;
+      }
+      lastDirty = i;
+    }
+  }
+
+  const auto &indices = mesh.indices();
+  mIndicesChanged = mIndicesChanged || indices.size() != mIndices.size() ||
+                    !std::equal(indices.begin(), indices.end(),
+                                mIndices.begin());
+  if (mIndicesChanged) {
+    mIndices = indices;
+  }
+}
+
+size_t MeshPacker::dirtyBytes() const {
+  size_t bytes = 0;
+  for (const auto &range : mDirtyRanges) {
+    bytes += range.second - range.first;
+  }
+  return bytes;
+}
+
+void MeshPacker::clearDirty() {
+  mDirtyRanges.clear();
+  mLayoutChanged = false;
+  mIndicesChanged = false;
+}
+
+void MeshPacker::reset() {
+  mData.clear();
+  mIndices.clear();
+  mDirtyRanges.clear();
+  mLayoutChanged = true;
+  mIndicesChanged = true;
+}
+
+bool MeshPacker::unpack(AttribIndex index, size_t vertex, float *out) const {
+  const Attrib &attrib = mAttribs[index];
+  if (!attrib.enabled || vertex >= mNumVertices) {
+    return false;
+  }
+  const uint8_t *src = mData.data() + vertex * mStride + attrib.offset;
+  for (int k = 0; k < attrib.components; ++k) {
+    if (attrib.type == GL_UNSIGNED_BYTE) {
+      out[k] = src[k] / 255.f;
+    } else if (attrib.type == GL_HALF_FLOAT) {
+      uint16_t h;
+      std::memcpy(&h, src + k * sizeof(uint16_t), sizeof(h));
+      out[k] = halfToFloat(h);
+    } else {
+      std::memcpy(out + k, src + k * sizeof(float), sizeof(float));
+    }
+  }
+  return true;
+}
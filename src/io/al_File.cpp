@@ -16,6 +16,8 @@
 #endif
 #undef NOMINMAX
 #else
+#include <fcntl.h>    // open (POSIX)
+#include <sys/mman.h> // mmap (POSIX)
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h> // getcwd (POSIX)
@@ -442,6 +444,75 @@ FilePath::FilePath(const std::string &fullpath) {
   }
 }
 
+bool MappedFile::open(const std::string &path) {
+  close();
+#ifdef AL_WINDOWS
+  HANDLE fileHandle =
+      CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (fileHandle == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+    CloseHandle(fileHandle);
+    return false;
+  }
+  HANDLE mappingHandle =
+      CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (mappingHandle == NULL) {
+    CloseHandle(fileHandle);
+    return false;
+  }
+  void *data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+  if (data == NULL) {
+    CloseHandle(mappingHandle);
+    CloseHandle(fileHandle);
+    return false;
+  }
+  mFileHandle = fileHandle;
+  mMappingHandle = mappingHandle;
+  mSize = (size_t)fileSize.QuadPart;
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat s;
+  if (fstat(fd, &s) != 0 || s.st_size == 0) {
+    ::close(fd);
+    return false;
+  }
+  void *data = mmap(nullptr, s.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping stays valid after the descriptor is closed
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+  mSize = s.st_size;
+#endif
+  mData = static_cast<const char *>(data);
+  mPath = path;
+  return true;
+}
+
+void MappedFile::close() {
+  if (mData) {
+#ifdef AL_WINDOWS
+    UnmapViewOfFile(mData);
+    CloseHandle(mMappingHandle);
+    CloseHandle(mFileHandle);
+    mMappingHandle = nullptr;
+    mFileHandle = nullptr;
+#else
+    munmap(const_cast<char *>(mData), mSize);
+#endif
+  }
+  mData = nullptr;
+  mSize = 0;
+  mPath.clear();
+}
+
 std::mutex PushDirectory::mDirectoryLock;
 
 PushDirectory::PushDirectory(std::string directory, bool verbose)
@@ -74,6 +74,9 @@ public:
 
 /*static*/ std::string Socket::hostIP() { return "0.0.0.0"; }
 /*static*/ std::string Socket::hostName() { return "dummy_invalid"; }
+/*static*/ int Socket::poll(std::vector<PollEvent> &events, al_sec timeout) {
+  return -1;
+}
 
 // Native socket code
 #else
@@ -113,6 +116,8 @@ const char *errorString() {
 
 #define INIT_SOCKET WsInit::get()
 typedef SOCKET SocketHandle;
+typedef WSAPOLLFD PollHandle;
+#define pollSockets WSAPoll
 #define SHUT_RDWR SD_BOTH
 DWORD secToTimeout(float t) {
   return t >= 0. ? DWORD(t * 1000. + 0.5) : 4294967295; // msec
@@ -123,6 +128,7 @@ DWORD secToTimeout(float t) {
 #include <arpa/inet.h> // inet_ntoa
 #include <errno.h>
 #include <netdb.h> // gethostbyname
+#include <poll.h>
 #include <string.h> // memset, strerror
 #include <sys/socket.h>
 #include <sys/time.h> // timeval
@@ -134,6 +140,8 @@ const char *errorString() { return strerror(errno); }
 
 #define INIT_SOCKET
 typedef int SocketHandle;
+typedef pollfd PollHandle;
+#define pollSockets ::poll
 timeval secToTimeout(float t) {
   if (t < 0)
     t = 2147483520.; // largest representable 32-bit int
@@ -435,15 +443,17 @@ public:
   void timeout(float v) {
     mTimeout = v;
     auto to = secToTimeout(v);
-    for (auto opt : {SO_SNDTIMEO, SO_RCVTIMEO}) {
-      if (mTimeout < 0) { // necessary?
+    // A timeout of 0 makes the socket non-blocking
 #ifdef AL_WINDOWS
-        decltype(WSABUF::len) nb = 0;
-        ::ioctlsocket(mSocketHandle, FIONBIO, &nb);
+    decltype(WSABUF::len) nb = mTimeout == 0 ? 1 : 0;
+    ::ioctlsocket(mSocketHandle, FIONBIO, &nb);
 #else
-        int nb = 0;
-        ::ioctl(mSocketHandle, FIONBIO, &nb);
+    int nb = mTimeout == 0 ? 1 : 0;
+    ::ioctl(mSocketHandle, FIONBIO, &nb);
 #endif
+    for (auto opt : {SO_SNDTIMEO, SO_RCVTIMEO}) {
+      if (mTimeout <= 0) {
+        continue;
       } else if (SOCKET_ERROR == ::setsockopt(mSocketHandle, SOL_SOCKET, opt,
                                               (char *)&to, sizeof(to))) {
         AL_WARN("unable to set timeout on socket at %s:%i: %s",
@@ -519,9 +529,16 @@ public:
   }
 
   int send(const char *buffer, int len) {
+#ifdef MSG_NOSIGNAL
+    // Report closed connections as errors instead of raising SIGPIPE
+    return (int)::send(mSocketHandle, buffer, len, MSG_NOSIGNAL);
+#else
     return (int)::send(mSocketHandle, buffer, len, 0);
+#endif
   }
 
+  SocketHandle handle() const { return mSocketHandle; }
+
 private:
   int mType = 0;
   float mTimeout = -1;
@@ -569,6 +586,24 @@ std::string Socket::nameToIp(std::string name) {
   return buf;
 }
 
+/*static*/ int Socket::poll(std::vector<PollEvent> &events, al_sec timeout) {
+  std::vector<PollHandle> handles(events.size());
+  for (size_t i = 0; i < events.size(); i++) {
+    handles[i].fd = events[i].socket->mImpl->handle();
+    handles[i].events = POLLIN | (events[i].wantWrite ? POLLOUT : 0);
+    handles[i].revents = 0;
+  }
+  int timeoutMs = timeout < 0 ? -1 : int(timeout * 1000. + 0.5);
+  int ready = pollSockets(handles.data(), handles.size(), timeoutMs);
+  for (size_t i = 0; i < events.size(); i++) {
+    auto revents = handles[i].revents;
+    events[i].error = (revents & (POLLERR | POLLHUP | POLLNVAL)) != 0;
+    events[i].readable = (revents & (POLLIN | POLLHUP)) != 0;
+    events[i].writable = (revents & POLLOUT) != 0;
+  }
+  return ready < 0 ? -1 : ready;
+}
+
 #endif // native socket
 
 // Everything below is common across all platforms
@@ -0,0 +1,106 @@
+#include "al/math/al_BatchTransform.hpp"
+
+#include "al/math/al_SIMD.hpp"
+
+using namespace al;
+
+namespace {
+
+// dst[i] = c0 * x + c1 * y + c2 * z + t, for 3 element results. Columns hold 4
+// floats, the last one is ignored
+void affine(const float *c0, const float *c1, const float *c2, const float *t,
+            const Vec3f *src, Vec3f *dst, size_t count) {
+#if defined(AL_SIMD_SSE)
+  const __m128 C0 = _mm_loadu_ps(c0), C1 = _mm_loadu_ps(c1);
+  const __m128 C2 = _mm_loadu_ps(c2), T = _mm_loadu_ps(t);
+  for (size_t i = 0; i < count; ++i) {
+    const float *s = src[i].elems();
+    __m128 r = _mm_mul_ps(C0, _mm_set1_ps(s[0]));
+    r = _mm_add_ps(r, _mm_mul_ps(C1, _mm_set1_ps(s[1])));
+    r = _mm_add_ps(r, _mm_mul_ps(C2, _mm_set1_ps(s[2])));
+    r = _mm_add_ps(r, T);
+    // Store only 3 floats, the next element may not have been read yet
+    float *d = dst[i].elems();
+    _mm_storel_pi(reinterpret_cast<__m64 *>(d), r);
+    _mm_store_ss(d + 2, _mm_movehl_ps(r, r));
+  }
+#elif defined(AL_SIMD_NEON)
+  const float32x4_t C0 = vld1q_f32(c0), C1 = vld1q_f32(c1);
+  const float32x4_t C2 = vld1q_f32(c2), T = vld1q_f32(t);
+  for (size_t i = 0; i < count; ++i) {
+    const float *s = src[i].elems();
+    float32x4_t r = vmulq_n_f32(C0, s[0]);
+    r = vaddq_f32(r, vmulq_n_f32(C1, s[1]));
+    r = vaddq_f32(r, vmulq_n_f32(C2, s[2]));
+    r = vaddq_f32(r, T);
+    float *d = dst[i].elems();
+    vst1_f32(d, vget_low_f32(r));
+    vst1q_lane_f32(d + 2, r, 2);
+  }
+#else
+  for (size_t i = 0; i < count; ++i) {
+    const Vec3f s = src[i];
+    for (int k = 0; k < 3; ++k) {
+      dst[i][k] = c0[k] * s[0] + c1[k] * s[1] + c2[k] * s[2] + t[k];
+    }
+  }
+#endif
+}
+
+const float kZero[4] = {0, 0, 0, 0};
+
+} // namespace
+
+namespace al {
+
+void transformPoints(const Mat4f &m, const Vec3f *src, Vec3f *dst,
+                     size_t count) {
+  const float *M = m.elems();
+  affine(M, M + 4, M + 8, M + 12, src, dst, count);
+}
+
+void transformVectors(const Mat4f &m, const Vec3f *src, Vec3f *dst,
+                      size_t count) {
+  const float *M = m.elems();
+  affine(M, M + 4, M + 8, kZero, src, dst, count);
+}
+
+void transform(const Mat4f &m, const Vec4f *src, Vec4f *dst, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    // Uses the SIMD specialization of Mat4f * Vec4f
+    Mat4f::multiply(dst[i], m, src[i]);
+  }
+}
+
+void transformNormals(const Mat3f &m, const Vec3f *src, Vec3f *dst,
+                      size_t count) {
+  // Pad the 3 element columns
+  float c[3][4];
+  for (int j = 0; j < 3; ++j) {
+    for (int i = 0; i < 3; ++i) {
+      c[j][i] = m(i, j);
+    }
+    c[j][3] = 0;
+  }
+  affine(c[0], c[1], c[2], kZero, src, dst, count);
+  for (size_t i = 0; i < count; ++i) {
+    dst[i].normalize();
+  }
+}
+
+void rotate(const Quatf &q, const Vec3f *src, Vec3f *dst, size_t count) {
+  // A rotation matrix costs fewer operations per vector than the quaternion
+  float c[3][4];
+  for (int j = 0; j < 3; ++j) {
+    Vec3f axis(0, 0, 0);
+    axis[j] = 1;
+    Vec3f column = q.rotate(axis);
+    for (int i = 0; i < 3; ++i) {
+      c[j][i] = column[i];
+    }
+    c[j][3] = 0;
+  }
+  affine(c[0], c[1], c[2], kZero, src, dst, count);
+}
+
+} // namespace al
@@ -0,0 +1,302 @@
+#include "al/math/al_RandomBatch.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "al/math/al_SIMD.hpp"
+
+using namespace al;
+using namespace al::rnd;
+
+namespace {
+
+const int kBlock = 256;
+
+// Integer hash (lowbias32) to decorrelate nearby seeds and stream indices
+uint32_t mix(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352d;
+  x ^= x >> 15;
+  x *= 0x846ca68b;
+  x ^= x >> 16;
+  return x;
+}
+
+// One step of a Tausworthe component, same as Tausworthe::iterate()
+uint32_t step(int component, uint32_t s) {
+  switch (component) {
+    case 0:
+      return ((s & 0xfffffffe) << 18) ^ (((s << 6) ^ s) >> 13);
+    case 1:
+      return ((s & 0xfffffff8) << 2) ^ (((s << 2) ^ s) >> 27);
+    case 2:
+      return ((s & 0xfffffff0) << 7) ^ (((s << 13) ^ s) >> 21);
+    default:
+      return ((s & 0xffffff80) << 13) ^ (((s << 3) ^ s) >> 12);
+  }
+}
+
+// Linear map over GF(2)^32, column j is the image of bit j
+struct BitMatrix {
+  uint32_t col[32];
+
+  uint32_t apply(uint32_t x) const {
+    uint32_t r = 0;
+    for (int j = 0; x; ++j, x >>= 1) {
+      if (x & 1) {
+        r ^= col[j];
+      }
+    }
+    return r;
+  }
+
+  // this * b
+  BitMatrix operator*(const BitMatrix &b) const {
+    BitMatrix r;
+    for (int j = 0; j < 32; ++j) {
+      r.col[j] = apply(b.col[j]);
+    }
+    return r;
+  }
+};
+
+// [0, 1) * scale + offset
+void toFloat(const uint32_t *src, float *dst, int count, float scale,
+             float offset) {
+  int i = 0;
+#if defined(AL_SIMD_SSE2)
+  const __m128i one = _mm_set1_epi32(0x3F800000);
+  const __m128 S = _mm_set1_ps(scale), O = _mm_set1_ps(offset);
+  const __m128 onef = _mm_set1_ps(1.f);
+  for (; i + 4 <= count; i += 4) {
+    __m128i u = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    // Float in [1, 2), then (f - 1) * scale + offset
+    __m128 f = _mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(u, 9), one));
+    f = _mm_sub_ps(f, onef);
+    _mm_storeu_ps(dst + i, _mm_add_ps(_mm_mul_ps(f, S), O));
+  }
+#elif defined(AL_SIMD_NEON)
+  const uint32x4_t one = vdupq_n_u32(0x3F800000);
+  const float32x4_t O = vdupq_n_f32(offset), onef = vdupq_n_f32(1.f);
+  for (; i + 4 <= count; i += 4) {
+    uint32x4_t u = vld1q_u32(src + i);
+    float32x4_t f = vreinterpretq_f32_u32(vorrq_u32(vshrq_n_u32(u, 9), one));
+    f = vsubq_f32(f, onef);
+    vst1q_f32(dst + i, vaddq_f32(vmulq_n_f32(f, scale), O));
+  }
+#endif
+  for (; i < count; ++i) {
+    dst[i] = al::uintToUnit<float>(src[i]) * scale + offset;
+  }
+}
+
+} // namespace
+
+TauswortheLanes::TauswortheLanes() { seed(al::rnd::seed()); }
+
+TauswortheLanes::TauswortheLanes(uint32_t v, uint32_t stream) {
+  seed(v, stream);
+}
+
+void TauswortheLanes::seed(uint32_t v, uint32_t stream) {
+  for (int lane = 0; lane < kLanes; ++lane) {
+    // Seed each lane like Tausworthe::seed(uint32_t)
+    uint32_t index = stream * uint32_t(kLanes) + uint32_t(lane) + 1;
+    al::rnd::LinCon g(mix(v ^ mix(index)));
+    g();
+    uint32_t s[4] = {g(), g(), g(), g()};
+    // Each component needs a bit set above those that are shifted out
+    const uint32_t masks[4] = {0xffffffe, 0xffffff8, 0xffffff0, 0xfffff80};
+    for (int c = 0; c < 4; ++c) {
+      mState[c][lane] = s[c] & masks[c] ? s[c] : ~s[c];
+    }
+  }
+  mCacheIndex = kLanes;
+}
+
+uint32_t TauswortheLanes::operator()() {
+  if (mCacheIndex == kLanes) {
+    iterate(mCache, 1);
+    mCacheIndex = 0;
+  }
+  return mCache[mCacheIndex++];
+}
+
+void TauswortheLanes::fill(uint32_t *dst, size_t count) {
+  while (count && mCacheIndex < kLanes) {
+    *dst++ = mCache[mCacheIndex++];
+    --count;
+  }
+  size_t groups = count / kLanes;
+  iterate(dst, groups);
+  dst += groups * kLanes;
+  count -= groups * kLanes;
+  if (count) {
+    iterate(mCache, 1);
+    mCacheIndex = 0;
+    while (count--) {
+      *dst++ = mCache[mCacheIndex++];
+    }
+  }
+}
+
+void TauswortheLanes::discard(uint64_t steps) {
+  mCacheIndex = kLanes;
+  for (int c = 0; c < 4; ++c) {
+    BitMatrix power, result;
+    for (int j = 0; j < 32; ++j) {
+      power.col[j] = step(c, 1u << j);
+      result.col[j] = 1u << j;
+    }
+    for (uint64_t n = steps; n; n >>= 1) {
+      if (n & 1) {
+        result = power * result;
+      }
+      if (n > 1) {
+        power = power * power;
+      }
+    }
+    for (int lane = 0; lane < kLanes; ++lane) {
+      mState[c][lane] = result.apply(mState[c][lane]);
+    }
+  }
+}
+
+void TauswortheLanes::iterate(uint32_t *out, size_t groups) {
+#if defined(AL_SIMD_SSE2)
+  static_assert(kLanes == 4, "SSE2 path runs 4 lanes");
+  __m128i *state = reinterpret_cast<__m128i *>(mState);
+  __m128i s1 = _mm_load_si128(state), s2 = _mm_load_si128(state + 1);
+  __m128i s3 = _mm_load_si128(state + 2), s4 = _mm_load_si128(state + 3);
+  const __m128i m1 = _mm_set1_epi32(int(0xfffffffe));
+  const __m128i m2 = _mm_set1_epi32(int(0xfffffff8));
+  const __m128i m3 = _mm_set1_epi32(int(0xfffffff0));
+  const __m128i m4 = _mm_set1_epi32(int(0xffffff80));
+  for (size_t g = 0; g < groups; ++g) {
+    s1 = _mm_xor_si128(
+        _mm_slli_epi32(_mm_and_si128(s1, m1), 18),
+        _mm_srli_epi32(_mm_xor_si128(_mm_slli_epi32(s1, 6), s1), 13));
+    s2 = _mm_xor_si128(
+        _mm_slli_epi32(_mm_and_si128(s2, m2), 2),
+        _mm_srli_epi32(_mm_xor_si128(_mm_slli_epi32(s2, 2), s2), 27));
+    s3 = _mm_xor_si128(
+        _mm_slli_epi32(_mm_and_si128(s3, m3), 7),
+        _mm_srli_epi32(_mm_xor_si128(_mm_slli_epi32(s3, 13), s3), 21));
+    s4 = _mm_xor_si128(
+        _mm_slli_epi32(_mm_and_si128(s4, m4), 13),
+        _mm_srli_epi32(_mm_xor_si128(_mm_slli_epi32(s4, 3), s4), 12));
+    __m128i r = _mm_xor_si128(_mm_xor_si128(s1, s2), _mm_xor_si128(s3, s4));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + g * kLanes), r);
+  }
+  _mm_store_si128(state, s1);
+  _mm_store_si128(state + 1, s2);
+  _mm_store_si128(state + 2, s3);
+  _mm_store_si128(state + 3, s4);
+#elif defined(AL_SIMD_NEON)
+  static_assert(kLanes == 4, "NEON path runs 4 lanes");
+  uint32x4_t s1 = vld1q_u32(mState[0]), s2 = vld1q_u32(mState[1]);
+  uint32x4_t s3 = vld1q_u32(mState[2]), s4 = vld1q_u32(mState[3]);
+  const uint32x4_t m1 = vdupq_n_u32(0xfffffffe);
+  const uint32x4_t m2 = vdupq_n_u32(0xfffffff8);
+  const uint32x4_t m3 = vdupq_n_u32(0xfffffff0);
+  const uint32x4_t m4 = vdupq_n_u32(0xffffff80);
+  for (size_t g = 0; g < groups; ++g) {
+    s1 = veorq_u32(vshlq_n_u32(vandq_u32(s1, m1), 18),
+                   vshrq_n_u32(veorq_u32(vshlq_n_u32(s1, 6), s1), 13));
+    s2 = veorq_u32(vshlq_n_u32(vandq_u32(s2, m2), 2),
+                   vshrq_n_u32(veorq_u32(vshlq_n_u32(s2, 2), s2), 27));
+    s3 = veorq_u32(vshlq_n_u32(vandq_u32(s3, m3), 7),
+                   vshrq_n_u32(veorq_u32(vshlq_n_u32(s3, 13), s3), 21));
+    s4 = veorq_u32(vshlq_n_u32(vandq_u32(s4, m4), 13),
+                   vshrq_n_u32(veorq_u32(vshlq_n_u32(s4, 3), s4), 12));
+    uint32x4_t r = veorq_u32(veorq_u32(s1, s2), veorq_u32(s3, s4));
+    vst1q_u32(out + g * kLanes, r);
+  }
+  vst1q_u32(mState[0], s1);
+  vst1q_u32(mState[1], s2);
+  vst1q_u32(mState[2], s3);
+  vst1q_u32(mState[3], s4);
+#else
+  for (size_t g = 0; g < groups; ++g) {
+    for (int lane = 0; lane < kLanes; ++lane) {
+      uint32_t r = 0;
+      for (int c = 0; c < 4; ++c) {
+        r ^= mState[c][lane] = step(c, mState[c][lane]);
+      }
+      out[g * kLanes + lane] = r;
+    }
+  }
+#endif
+}
+
+void BatchRandom::uniform(float *dst, size_t count) {
+  uniform(dst, count, 1.f, 0.f);
+}
+
+void BatchRandom::uniform(float *dst, size_t count, float hi, float lo) {
+  uint32_t buffer[kBlock];
+  while (count) {
+    int n = int(std::min<size_t>(count, kBlock));
+    mRNG.fill(buffer, n);
+    toFloat(buffer, dst, n, hi - lo, lo);
+    dst += n;
+    count -= n;
+  }
+}
+
+void BatchRandom::uniformS(float *dst, size_t count) {
+  uniform(dst, count, 1.f, -1.f);
+}
+
+// Box-Muller transform, basic form so each pair takes exactly two uniforms
+void BatchRandom::normal(float *dst, size_t count, float mean, float stddev) {
+  float u[kBlock];
+  while (count) {
+    size_t pairs = std::min<size_t>((count + 1) / 2, kBlock / 2);
+    uniform(u, 2 * pairs);
+    for (size_t i = 0; i < pairs; ++i) {
+      // 1 - u is in (0, 1], so the log is finite
+      float r = stddev * std::sqrt(-2.f * std::log(1.f - u[2 * i]));
+      float angle = float(M_2PI) * u[2 * i + 1];
+      dst[2 * i] = mean + r * std::cos(angle);
+      if (2 * i + 1 < count) {
+        dst[2 * i + 1] = mean + r * std::sin(angle);
+      }
+    }
+    size_t n = std::min(count, 2 * pairs);
+    dst += n;
+    count -= n;
+  }
+}
+
+// Uniform height and angle on a cylinder, projected onto the sphere
+void BatchRandom::sphere(Vec3f *dst, size_t count) {
+  float u[kBlock];
+  while (count) {
+    size_t n = std::min<size_t>(count, kBlock / 2);
+    uniform(u, 2 * n);
+    for (size_t i = 0; i < n; ++i) {
+      float z = 2.f * u[2 * i] - 1.f;
+      float r = std::sqrt(std::max(0.f, 1.f - z * z));
+      float angle = float(M_2PI) * u[2 * i + 1];
+      dst[i].set(r * std::cos(angle), r * std::sin(angle), z);
+    }
+    dst += n;
+    count -= n;
+  }
+}
+
+// Points on the sphere scaled by the cube root of a uniform radius
+void BatchRandom::ball(Vec3f *dst, size_t count) {
+  float u[kBlock];
+  sphere(dst, count);
+  while (count) {
+    size_t n = std::min<size_t>(count, kBlock);
+    uniform(u, n);
+    for (size_t i = 0; i < n; ++i) {
+      dst[i] *= std::cbrt(u[i]);
+    }
+    dst += n;
+    count -= n;
+  }
+}
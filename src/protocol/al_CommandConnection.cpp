@@ -40,40 +40,342 @@ void from_bytes(const uint8_t *bytes, uint16_t &dest) {
 }
 
 void from_bytes(const uint8_t *bytes, uint32_t &dest) {
-  dest = (uint16_t(bytes[3]) << 8 * 3) | (uint16_t(bytes[4]) << 8 * 2) |
-         (uint16_t(bytes[1]) << 8 * 1) | (uint16_t(bytes[0]) << 8 * 0);
+  dest = (uint32_t(bytes[3]) << 8 * 3) | (uint32_t(bytes[2]) << 8 * 2) |
+         (uint32_t(bytes[1]) << 8 * 1) | (uint32_t(bytes[0]) << 8 * 0);
 }
 
 } // namespace Convert
 
 using namespace al;
 
+const uint8_t CommandConnection::kProtocolVersion;
+
+namespace {
+
+// Receives a handshake message of up to size bytes. A single recv() may
+// return part of it, so once the first bytes arrive this waits up to
+// timeoutSecs for the rest. Peers from before framing send shorter
+// messages, so fewer bytes are returned if the timeout passes or the peer
+// closes. Returns 0 if the peer closed and SIZE_MAX on error.
+size_t recvHandshake(Socket &socket, uint8_t *buffer, size_t size,
+                     double timeoutSecs = 0.2) {
+  size_t received = socket.recv((char *)buffer, size);
+  if (received == 0 || received == SIZE_MAX) {
+    return received;
+  }
+  double endTime = al_steady_time() + timeoutSecs;
+  while (received < size) {
+    double remaining = endTime - al_steady_time();
+    if (remaining <= 0) {
+      break;
+    }
+    std::vector<Socket::PollEvent> events(1);
+    events[0].socket = &socket;
+    if (Socket::poll(events, remaining) <= 0) {
+      break;
+    }
+    size_t bytes = socket.recv((char *)buffer + received, size - received);
+    if (bytes == 0 || bytes == SIZE_MAX) {
+      break;
+    }
+    received += bytes;
+  }
+  return received;
+}
+
+} // namespace
+
 void CommandConnection::stop() {
   mRunning = false;
   for (auto &connection : mConnectionThreads) {
-    connection->join();
+    if (connection->joinable()) {
+      connection->join();
+    }
+  }
+  mConnectionThreads.clear();
+  {
+    std::unique_lock<std::mutex> lk(mConnectionsLock);
+    mConnections.clear();
   }
   mSocket.close();
   mState = BarrierState::NONE;
 }
 
+size_t CommandConnection::queuedBytes() {
+  std::unique_lock<std::mutex> lk(mConnectionsLock);
+  size_t bytes = 0;
+  for (auto &connection : mConnections) {
+    bytes += connection->queuedBytes;
+  }
+  return bytes;
+}
+
+bool CommandConnection::flush(double timeoutSecs) {
+  double endTime = al_steady_time() + timeoutSecs;
+  while (queuedBytes() > 0) {
+    if (al_steady_time() > endTime) {
+      return false;
+    }
+    al_sleep(0.001);
+  }
+  return true;
+}
+
+void CommandConnection::addConnection(std::shared_ptr<Socket> socket) {
+  socket->timeout(0);
+  auto connection = std::make_shared<Connection>();
+  connection->socket = socket;
+  connection->receiveBuffer.resize(kChunkSize + 4);
+  std::unique_lock<std::mutex> lk(mConnectionsLock);
+  mConnections.push_back(connection);
+}
+
+std::shared_ptr<CommandConnection::Connection>
+CommandConnection::findConnection(Socket *socket) {
+  std::unique_lock<std::mutex> lk(mConnectionsLock);
+  for (auto &connection : mConnections) {
+    if (connection->socket.get() == socket) {
+      return connection;
+    }
+  }
+  return nullptr;
+}
+
+void CommandConnection::removeConnection(Socket *socket) {
+  std::shared_ptr<Connection> connection;
+  {
+    std::unique_lock<std::mutex> lk(mConnectionsLock);
+    for (auto it = mConnections.begin(); it != mConnections.end(); it++) {
+      if ((*it)->socket.get() == socket) {
+        connection = *it;
+        mConnections.erase(it);
+        break;
+      }
+    }
+  }
+  if (connection) {
+    std::unique_lock<std::mutex> lk(connection->sendLock);
+    connection->sendQueue.clear();
+    connection->queuedBytes = 0;
+    connection->socket->close();
+  }
+}
+
+bool CommandConnection::queueMessage(Connection &connection,
+                                     const uint8_t *message, size_t length) {
+  size_t frames = length == 0 ? 1 : (length + kChunkSize - 1) / kChunkSize;
+  size_t framedLength = length + 4 * frames;
+  std::unique_lock<std::mutex> lk(connection.sendLock);
+  // A message larger than the limit is still accepted on an empty queue
+  if (connection.queuedBytes > 0 &&
+      connection.queuedBytes + framedLength > mSendQueueLimit) {
+    if (mVerbose) {
+      std::cout << "Send queue full for " << connection.socket->address()
+                << ":" << connection.socket->port() << std::endl;
+    }
+    return false;
+  }
+  size_t offset = 0;
+  for (size_t i = 0; i < frames; i++) {
+    uint32_t chunk = uint32_t(std::min(length - offset, size_t(kChunkSize)));
+    uint32_t header = chunk | (i + 1 < frames ? 0x80000000u : 0);
+    std::vector<uint8_t> frame(4 + chunk);
+    auto headerBytes = Convert::to_bytes(header);
+    std::copy(headerBytes.begin(), headerBytes.end(), frame.begin());
+    if (chunk > 0) {
+      memcpy(frame.data() + 4, message + offset, chunk);
+    }
+    connection.sendQueue.push_back(std::move(frame));
+    offset += chunk;
+  }
+  connection.queuedBytes += framedLength;
+  // Send right away what fits in the socket buffer. The event loop sends the
+  // rest when the socket becomes writable
+  sendQueued(connection);
+  return true;
+}
+
+void CommandConnection::sendQueued(Connection &connection) {
+  while (!connection.sendQueue.empty()) {
+    auto &frame = connection.sendQueue.front();
+    size_t bytes = connection.socket->send(
+        (const char *)frame.data() + connection.sendOffset,
+        frame.size() - connection.sendOffset);
+    if (bytes == 0 || bytes == SIZE_MAX) {
+      break; // Would block
+    }
+    connection.sendOffset += bytes;
+    connection.queuedBytes -= bytes;
+    if (connection.sendOffset == frame.size()) {
+      connection.sendQueue.pop_front();
+      connection.sendOffset = 0;
+    }
+  }
+}
+
+bool CommandConnection::receive(Connection &connection, bool error) {
+  auto &buffer = connection.receiveBuffer;
+  // Bound the reads so a busy connection does not starve the others
+  for (int reads = 0; reads < 16; reads++) {
+    if (buffer.size() - connection.receivedBytes < kChunkSize) {
+      buffer.resize(connection.receivedBytes + kChunkSize + 4);
+    }
+    size_t bytes =
+        connection.socket->recv((char *)buffer.data() + connection.receivedBytes,
+                                buffer.size() - connection.receivedBytes);
+    if (bytes == 0 || (bytes == SIZE_MAX && error && reads == 0)) {
+      return false; // Connection closed
+    }
+    if (bytes == SIZE_MAX) {
+      break; // Nothing more to read
+    }
+    connection.receivedBytes += bytes;
+
+    size_t pos = 0;
+    while (connection.receivedBytes - pos >= 4) {
+      uint32_t header;
+      Convert::from_bytes(buffer.data() + pos, header);
+      uint32_t length = header & 0x7FFFFFFF;
+      bool more = (header & 0x80000000) != 0;
+      if (length > kChunkSize) {
+        std::cerr << __FILE__ << " : Invalid frame from "
+                  << connection.socket->address() << ":"
+                  << connection.socket->port() << ". Closing connection"
+                  << std::endl;
+        return false;
+      }
+      if (connection.receivedBytes - pos - 4 < length) {
+        break; // Incomplete frame
+      }
+      if (!connection.discardMessage) {
+        if (connection.message.size() + length > mMaxMessageSize) {
+          std::cerr << __FILE__ << " : Discarding message larger than "
+                    << mMaxMessageSize << " bytes from "
+                    << connection.socket->address() << ":"
+                    << connection.socket->port() << std::endl;
+          connection.discardMessage = true;
+          connection.message.clear();
+        } else {
+          connection.message.insert(connection.message.end(),
+                                    buffer.begin() + pos + 4,
+                                    buffer.begin() + pos + 4 + length);
+        }
+      }
+      pos += 4 + length;
+      if (!more) {
+        if (!connection.discardMessage) {
+          dispatchMessage(connection);
+        }
+        connection.message.clear();
+        connection.discardMessage = false;
+      }
+    }
+    if (pos > 0) {
+      memmove(buffer.data(), buffer.data() + pos,
+              connection.receivedBytes - pos);
+      connection.receivedBytes -= pos;
+    }
+  }
+  return true;
+}
+
+void CommandConnection::dispatchMessage(Connection &connection) {
+  Socket *src = connection.socket.get();
+  Message message(connection.message.data(), connection.message.size());
+  if (mVerbose) {
+    std::cout << "Received message from " << src->address() << ":"
+              << src->port() << std::endl;
+  }
+  // A message can hold several commands
+  while (!message.empty()) {
+    size_t remainingBytes = message.remainingBytes();
+    if (*message.data() == PING) {
+      message.getByte();
+      if (mVerbose) {
+        std::cout << "Got ping request" << std::endl;
+      }
+      uint8_t pong = PONG;
+      queueMessage(connection, &pong, 1);
+      continue;
+    }
+    if (!processIncomingMessage(message, src)) {
+      std::cerr << __FILE__ << " : Unable to process message("
+                << (int)connection.message[connection.message.size() -
+                                           remainingBytes]
+                << ") from " << src->address() << ":" << src->port()
+                << std::endl;
+      break;
+    }
+    if (message.remainingBytes() >= remainingBytes) {
+      break; // Nothing consumed or read past the end
+    }
+  }
+}
+
+void CommandConnection::runEventLoop() {
+  std::vector<std::shared_ptr<Connection>> connections;
+  std::vector<Socket::PollEvent> events;
+  while (mRunning) {
+    {
+      std::unique_lock<std::mutex> lk(mConnectionsLock);
+      connections = mConnections;
+    }
+    if (connections.empty()) {
+      if (mState == BarrierState::CLIENT) {
+        mRunning = false; // Server went away
+        break;
+      }
+      al_sleep(0.01);
+      continue;
+    }
+    events.resize(connections.size());
+    for (size_t i = 0; i < connections.size(); i++) {
+      events[i] = Socket::PollEvent();
+      events[i].socket = connections[i]->socket.get();
+      events[i].wantWrite = connections[i]->queuedBytes > 0;
+    }
+    // Short timeout to notice new connections, new queued messages and stop()
+    if (Socket::poll(events, 0.01) <= 0) {
+      continue;
+    }
+    for (size_t i = 0; i < connections.size(); i++) {
+      Connection &connection = *connections[i];
+      if (events[i].writable) {
+        std::unique_lock<std::mutex> lk(connection.sendLock);
+        sendQueued(connection);
+      }
+      if (events[i].readable || events[i].error) {
+        if (!receive(connection, events[i].error)) {
+          if (mVerbose) {
+            std::cout << "Connection closed " << connection.socket->address()
+                      << ":" << connection.socket->port() << std::endl;
+          }
+          removeConnection(connection.socket.get());
+        }
+      }
+    }
+  }
+}
+
 /// =====================================
 ///
 std::vector<float> CommandServer::ping(double timeoutSecs) {
   std::vector<float> pingTimes;
 
-  std::unique_lock<std::mutex> lk(mConnectionsLock);
-  for (auto listener : mServerConnections) {
+  std::vector<std::shared_ptr<Socket>> listeners;
+  {
+    std::unique_lock<std::mutex> lk(mConnectionsLock);
+    listeners = mServerConnections;
+  }
+  for (auto listener : listeners) {
     if (mVerbose) {
       std::cout << "pinging " + listener->address() + ":" +
                        std::to_string(listener->port())
                 << std::endl;
     }
     //    auto startTime = al_steady_time();
-    unsigned char message[2] = {0, 0};
-
-    message[0] = PING;
-    listener->send((const char *)message, 2);
+    uint8_t message = PING;
+    sendMessage(&message, 1, listener.get());
   }
 
   return pingTimes;
@@ -113,6 +415,7 @@ bool CommandServer::start(uint16_t serverPort, const char *serverAddr) {
     return false;
   }
 
+  mState = CommandConnection::SERVER;
   mRunning = true;
   mBootstrapServerThread = std::make_unique<std::thread>([&]() {
     // Receive data
@@ -129,18 +432,33 @@ bool CommandServer::start(uint16_t serverPort, const char *serverAddr) {
                     << incomingConnectionSocket->address() << ":"
                     << incomingConnectionSocket->port() << std::endl;
         }
-        uint8_t message[16384];
+        uint8_t message[16];
 
         size_t bytesRecv =
-            incomingConnectionSocket->recv((char *)message, 16384);
-        if (bytesRecv > 0 && bytesRecv <= 16384) {
+            recvHandshake(*incomingConnectionSocket, message, 6);
+        if (bytesRecv > 0 && bytesRecv <= 6) {
           if (message[0] == HANDSHAKE) {
             uint16_t version = 0;
             uint16_t revision = 0;
-            if (bytesRecv >= 4) {
+            if (bytesRecv >= 5) {
               Convert::from_bytes((const uint8_t *)&message[1], version);
               Convert::from_bytes((const uint8_t *)&message[3], revision);
             }
+            // Clients from before framing send no protocol version
+            uint8_t protocol = bytesRecv == 6 ? message[5] : 1;
+            if (protocol != kProtocolVersion) {
+              std::cerr << "[+Server] ERROR: Rejecting "
+                        << incomingConnectionSocket->address() << ":"
+                        << incomingConnectionSocket->port()
+                        << ". Client uses protocol version " << (int)protocol
+                        << ", server uses " << (int)kProtocolVersion
+                        << std::endl;
+              message[0] = HANDSHAKE_REJECT;
+              message[1] = kProtocolVersion;
+              incomingConnectionSocket->send((const char *)message, 2);
+              incomingConnectionSocket->close();
+              continue;
+            }
 
             if (mVerbose) {
               std::cout << "[+Server] Handshake for "
@@ -154,10 +472,11 @@ bool CommandServer::start(uint16_t serverPort, const char *serverAddr) {
             memcpy(message + 1, &mVersion, sizeof(uint16_t));
             memcpy(message + 1 + sizeof(uint16_t), &mRevision,
                    sizeof(uint16_t));
+            message[5] = kProtocolVersion;
 
             auto bytesSent =
-                incomingConnectionSocket->send((const char *)message, 5);
-            if (bytesSent != 5) {
+                incomingConnectionSocket->send((const char *)message, 6);
+            if (bytesSent != 6) {
               std::cerr << "[+Server] ERROR sending handshake ack" << std::endl;
             }
             {
@@ -166,61 +485,7 @@ bool CommandServer::start(uint16_t serverPort, const char *serverAddr) {
               mConnectionVersions.emplace_back(
                   std::pair<uint16_t, uint16_t>{version, revision});
             }
-
-            mConnectionThreads.emplace_back(std::make_unique<std::thread>(
-                [&](std::shared_ptr<Socket> client) {
-                  uint8_t commandMessage[8192];
-                  size_t bufferSize = 0;
-                  while (mRunning) {
-                    size_t bytes = client->recv(
-                        (char *)(commandMessage + bufferSize), 16384);
-
-                    while (bytes > 0 && bytes < 16385) {
-                      Message message(commandMessage, bytes);
-                      if (mVerbose) {
-                        std::cout << "[+Server] Received message from "
-                                  << client->address() << ":" << client->port()
-                                  << std::endl;
-                      }
-                      if (!processIncomingMessage(message, client.get())) {
-                        std::cerr << __FILE__
-                                  << " : Server unable to process message("
-                                  << (int)commandMessage[0] << ") from client "
-                                  << client->address() << ":" << client->port()
-                                  << std::endl;
-                      } else {
-                        if (message.remainingBytes() > 0) {
-                          memcpy(commandMessage, message.data(),
-                                 message.remainingBytes());
-                          bufferSize = message.remainingBytes();
-                        } else {
-                          bufferSize = 0;
-                        }
-                      }
-                      bytes =
-                          client->recv((char *)(commandMessage + bufferSize),
-                                       16384 - bufferSize);
-                      if (bufferSize >= 16384 && bytes == 0) {
-                        std::cerr << "[+Server] ERROR: Network buffer overrun. "
-                                     "Flushing "
-                                     "buffers "
-                                  << bytes << std::endl;
-                        bufferSize = 0;
-                      }
-                    }
-                    if (bytes != SIZE_MAX && bytes != 0) {
-                      std::cerr
-                          << __FILE__
-                          << " : Unexpected command size. Flushing buffer."
-                          << bytes << std::endl;
-                    }
-                  }
-
-                  if (mVerbose) {
-                    std::cout << "[+Server] Client stopped" << std::endl;
-                  }
-                },
-                incomingConnectionSocket));
+            addConnection(incomingConnectionSocket);
 
             onConnection(incomingConnectionSocket.get());
           } else {
@@ -236,8 +501,9 @@ bool CommandServer::start(uint16_t serverPort, const char *serverAddr) {
       std::cout << "Server stopped" << std::endl;
     }
   });
-
-  mState = CommandConnection::SERVER;
+  // All clients are served from a single thread
+  mConnectionThreads.emplace_back(
+      std::make_unique<std::thread>(&CommandServer::runEventLoop, this));
   return true;
 }
 
@@ -247,20 +513,35 @@ void CommandServer::stop() {
   mSocket.close();
   if (mBootstrapServerThread) {
     mBootstrapServerThread->join();
+    mBootstrapServerThread = nullptr;
   }
+  for (auto &connection : mConnectionThreads) {
+    connection->join();
+  }
+  mConnectionThreads.clear();
+  std::vector<std::shared_ptr<Socket>> connections;
   {
     std::unique_lock<std::mutex> lk(mConnectionsLock);
-    for (auto connectionSocket : mServerConnections) {
-      connectionSocket->close();
-    }
+    connections = mServerConnections;
   }
-
-  for (auto &connection : mConnectionThreads) {
-    connection->join();
+  for (auto connectionSocket : connections) {
+    removeConnection(connectionSocket.get());
   }
   mState = BarrierState::NONE;
 }
 
+void CommandServer::removeConnection(Socket *socket) {
+  CommandConnection::removeConnection(socket);
+  std::unique_lock<std::mutex> lk(mConnectionsLock);
+  for (size_t i = 0; i < mServerConnections.size(); i++) {
+    if (mServerConnections[i].get() == socket) {
+      mServerConnections.erase(mServerConnections.begin() + i);
+      mConnectionVersions.erase(mConnectionVersions.begin() + i);
+      break;
+    }
+  }
+}
+
 uint16_t CommandServer::waitForConnections(uint16_t connectionCount,
                                            double timeout) {
   if (mState == BarrierState::SERVER) {
@@ -301,26 +582,38 @@ bool CommandServer::sendMessage(uint8_t *message, size_t length,
     return false;
   }
 
+  std::vector<std::shared_ptr<Socket>> destinations;
   if (!dst) {
-
     std::unique_lock<std::mutex> lk(mConnectionsLock);
     for (auto connection : mServerConnections) {
       if (!src || connection->address() != src->ipAddr ||
           connection->port() != src->port) {
-        if (mVerbose) {
-          std::cout << "Sending message to " << connection->address() << ":"
-                    << connection->port() << std::endl;
-        }
-        ret &= connection->send((const char *)message, length) == length;
+        destinations.push_back(connection);
       }
     }
-
-  } else {
+  }
+  for (auto &destination : destinations) {
+    auto connection = findConnection(destination.get());
+    if (connection) {
+      if (mVerbose) {
+        std::cout << "Sending message to " << destination->address() << ":"
+                  << destination->port() << std::endl;
+      }
+      ret &= queueMessage(*connection, message, length);
+    }
+  }
+  if (dst) {
+    auto connection = findConnection(dst);
+    if (!connection) {
+      std::cerr << "[+Server] ERROR: Not connected to " << dst->address()
+                << ":" << dst->port() << std::endl;
+      return false;
+    }
     if (mVerbose) {
       std::cout << "Sending message to " << dst->address() << ":" << dst->port()
                 << std::endl;
     }
-    ret = dst->send((const char *)message, length) == length;
+    ret = queueMessage(*connection, message, length);
   }
   return ret;
 }
@@ -334,38 +627,56 @@ bool CommandClient::start(uint16_t serverPort, const char *serverAddr) {
   }
   std::condition_variable cv;
   std::mutex mutex;
-  std::unique_lock<std::mutex> lk(mutex);
-  mConnectionThreads.push_back(std::make_unique<std::thread>([&]() {
+  bool done = false;
+  bool connected = false;
+  auto notifyStart = [&](bool success) {
+    std::unique_lock<std::mutex> lk(mutex);
+    connected = success;
+    done = true;
+    cv.notify_one();
+  };
+  mConnectionThreads.push_back(std::make_unique<std::thread>([&, notifyStart]() {
     // For a client connection, mSocket is connected to a server socket on
     // the other end.
 
     if (!mSocket.connect()) {
       std::cerr << "[Client] Error connecting bootstrap socket" << std::endl;
+      notifyStart(false);
       return;
     }
 
     mState = CommandConnection::CLIENT;
-    mRunning = true;
     unsigned char message[8] = {0, 0, 0, 0, 0, 0, 0, 0};
     message[0] = HANDSHAKE;
     //    auto b = Convert::to_bytes(mSocket.port());
 
     memcpy(message + 1, &mVersion, sizeof(uint16_t));
     memcpy(message + 1 + sizeof(uint16_t), &mRevision, sizeof(uint16_t));
+    message[5] = kProtocolVersion;
 
-    // TODO provide functionality to validat connection versions
-    auto bytesSent = mSocket.send((const char *)message, 5);
-    if (bytesSent != 5) {
+    auto bytesSent = mSocket.send((const char *)message, 6);
+    if (bytesSent != 6) {
       std::cerr << "[Client] ERROR sending handshake" << std::endl;
     }
-    size_t bytesRecv = mSocket.recv((char *)message, 5);
-    if (bytesRecv == 5 && message[0] == HANDSHAKE_ACK) {
+    size_t bytesRecv = recvHandshake(mSocket, message, 6);
+    if (bytesRecv >= 1 && bytesRecv != SIZE_MAX &&
+        (message[0] == HANDSHAKE_REJECT ||
+         (message[0] == HANDSHAKE_ACK && bytesRecv != 6))) {
+      // Servers from before framing send no protocol version
+      int protocol =
+          message[0] == HANDSHAKE_REJECT && bytesRecv >= 2 ? message[1] : 1;
+      std::cerr << "[Client] ERROR: Server uses protocol version " << protocol
+                << ", client uses " << (int)kProtocolVersion << std::endl;
+      mSocket.close();
+      mState = CommandConnection::NONE;
+      notifyStart(false);
+      return;
+    }
+    if (bytesRecv == 6 && message[0] == HANDSHAKE_ACK) {
       uint16_t version = 0;
       uint16_t revision = 0;
-      if (bytesRecv >= 4) {
-        Convert::from_bytes((const uint8_t *)&message[1], version);
-        Convert::from_bytes((const uint8_t *)&message[3], revision);
-      }
+      Convert::from_bytes((const uint8_t *)&message[1], version);
+      Convert::from_bytes((const uint8_t *)&message[3], revision);
       if (mVerbose) {
         std::cout << "[Client] Got handshake ack from " << mSocket.address()
                   << ":" << mSocket.port() << std::endl;
@@ -374,111 +685,60 @@ bool CommandClient::start(uint16_t serverPort, const char *serverAddr) {
       }
       mRunning = true;
     } else {
+      std::cerr << "[Client] ERROR: No handshake ack from server" << std::endl;
+      mState = CommandConnection::NONE;
+      notifyStart(false);
       return;
     }
 
+    // mSocket is owned by this object
+    addConnection(std::shared_ptr<Socket>(&mSocket, [](Socket *) {}));
     onConnection(&mSocket);
-    {
-      std::unique_lock<std::mutex> lk(mutex);
-      cv.notify_one();
-    }
-    uint8_t commandMessage[16384];
-    size_t bufferSize = 0;
-    while (mRunning) {
-      if (!mSocket.opened()) {
-        std::cerr << "[Client] ERROR: Socket not open" << std::endl;
-        mRunning = false;
-        continue;
-      }
-
-      size_t bytes = mSocket.recv((char *)(commandMessage + bufferSize),
-                                  16384 - bufferSize);
-
-      if (bufferSize >= 16384 && bytes == 0) {
-        std::cerr << "[Client] ERROR: Network buffer overrun. Flushing buffers "
-                  << bytes << std::endl;
-        bufferSize = 0;
-      }
-      mBusy.store(true); // FIXME This helps, but we should add timeout to recv,
-                         // and mark as not busy when there is no incoming data
-      if (bytes > 0 && bytes < 16385) {
-        bufferSize += bytes;
-        if (commandMessage[0] == PING) {
-          clientHandlePing(mSocket);
-        } else {
-          Message message(commandMessage, bytes);
-          if (mVerbose) {
-            std::cout << "[Client] Received message from " << mSocket.address()
-                      << ":" << mSocket.port() << std::endl;
-          }
-          if (!processIncomingMessage(message, &mSocket)) {
-            std::cerr << __FILE__ << " : Client unable to process message("
-                      << (int)commandMessage[0] << ") from "
-                      << mSocket.address() << ":" << mSocket.port()
-                      << std::endl;
+    notifyStart(true);
 
-          } else {
-            if (message.remainingBytes() > 0) {
-              memcpy(commandMessage, message.data(), message.remainingBytes());
-              bufferSize = message.remainingBytes();
-            } else {
-              bufferSize = 0;
-            }
-          }
-        }
-      } else if (bytes != SIZE_MAX && bytes != 0) {
-        std::cerr << "[Client] ERROR: Network buffer overrun. " << bytes
-                  << std::endl;
-      }
-      mBusy.store(false);
-    }
-    //        connectionSocket.close();
+    runEventLoop();
     if (mVerbose) {
       std::cout << "[Client] stopped" << std::endl;
     }
   }));
 
-  cv.wait(lk);
-  return true;
+  std::unique_lock<std::mutex> lk(mutex);
+  cv.wait(lk, [&]() { return done; });
+  return connected;
 }
 
 void CommandClient::clientHandlePing(Socket &client) {
   if (mVerbose) {
     std::cout << "Client got ping request" << std::endl;
   }
-  char buffer[2] = {0, 0};
-  buffer[0] = PONG;
-  //  std::cout << "sending pong" << std::endl;
-  int bytesSent = client.send((const char *)buffer, 2);
-  if (bytesSent != 2) {
-    std::cerr << "ERROR: sent bytes mismatch for pong" << std::endl;
+  uint8_t buffer = PONG;
+  if (!sendMessage(&buffer, 1, &client)) {
+    std::cerr << "ERROR: sending pong" << std::endl;
   }
 }
 
 bool CommandClient::sendMessage(uint8_t *message, size_t length, Socket *dst,
                                 al::ValueSource *src) {
-  bool ret = true;
   if (length == 0) {
     return false;
   }
 
   if (!dst) {
-    if (!src || mSocket.address() != src->ipAddr ||
-        mSocket.port() != src->port) {
-      if (mVerbose) {
-        std::cout << "Sending message to " << mSocket.address() << ":"
-                  << mSocket.port() << std::endl;
-      }
-      ret = mSocket.send((const char *)message, length) == length;
-    }
-  } else {
-    if (mSocket.address() != dst->address() || mSocket.port() != dst->port()) {
-      if (mVerbose) {
-        std::cout << "Sending message to " << dst->address() << ":"
-                  << dst->port() << std::endl;
-      }
-      ret = dst->send((const char *)message, length) == length;
+    if (src && mSocket.address() == src->ipAddr &&
+        mSocket.port() == src->port) {
+      return true; // Don't send back to the source
     }
+    dst = &mSocket;
   }
-  return ret;
+  auto connection = findConnection(dst);
+  if (!connection) {
+    std::cerr << "[Client] ERROR: Not connected to " << dst->address() << ":"
+              << dst->port() << std::endl;
+    return false;
+  }
+  if (mVerbose) {
+    std::cout << "Sending message to " << dst->address() << ":" << dst->port()
+              << std::endl;
+  }
+  return queueMessage(*connection, message, length);
 }
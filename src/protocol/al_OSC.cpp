@@ -340,6 +340,12 @@ size_t Send::send(const Packet &p) {
   return r;
 }
 
+size_t Send::sendRaw(const char *data, size_t size) {
+  size_t r = 0;
+  OSCTRY("Send::sendRaw", r = socketSender->send(data, size);)
+  return r;
+}
+
 static void *recvThreadFunc(void *user) {
   Recv *r = static_cast<Recv *>(user);
   r->loop();
@@ -428,6 +434,9 @@ void Recv::stop() {
 
 void Recv::parse(const char *packet, int size, const char *senderAddr,
                  uint16_t senderPort) {
+  if (size > (int)mBuffer.size()) {
+    mBuffer.resize(size);
+  }
   std::memcpy(&mBuffer[0], packet, size);
   auto messages = parse(&mBuffer[0], size, 1, senderAddr, senderPort);
   for (auto *handler : mHandlers) {
@@ -1,10 +1,10 @@
-#include "al/core/protocol/al_Serialize.h"
+#include "al/protocol/al_Serialize.h"
 #include <cstdint>
 #include <cstring>
 #include <stdio.h>
 
 #ifdef __cplusplus
-#include "al/core/protocol/al_Serialize.hpp"
+#include "al/protocol/al_Serialize.hpp"
 
 namespace al {
 
@@ -16,31 +16,82 @@ Serializer& Serializer::operator<<(const std::string& v) {
   return add(v.c_str(), v.size() + 1);
 }
 
+void Serializer::reset() {
+  mBuf.clear();
+  mSize = 0;
+  mOverflow = false;
+}
+
+char* Serializer::reserve(uint32_t n) {
+  if (mExternal) {
+    if (mOverflow || n > mCapacity - mSize) {
+      mOverflow = true;
+      return nullptr;
+    }
+  } else {
+    mBuf.resize(mSize + n);
+  }
+  char* b = (mExternal ? mExternal : mBuf.data()) + mSize;
+  mSize += n;
+  return b;
+}
+
 const std::vector<char>& Serializer::buf() const { return mBuf; }
 
-Deserializer::Deserializer(const std::vector<char>& b) : mStart(0), mBuf(b) {}
+Deserializer::Deserializer(const std::vector<char>& b) {
+  reset(b.data(), uint32_t(b.size()));
+}
+
+Deserializer::Deserializer(const char* b, uint32_t n) { reset(b, n); }
+
+void Deserializer::reset(const char* b, uint32_t n) {
+  mData = b;
+  mSize = n;
+  mStart = 0;
+  mFailed = false;
+}
+
+const char* Deserializer::header(uint8_t type, SerHeader& h) {
+  if (mFailed || remaining() < uint32_t(serHeaderSize())) {
+    mFailed = true;
+    return nullptr;
+  }
+  h = serGetHeader(mData + mStart);
+  if (h.type != type) {
+    mFailed = true;
+    return nullptr;
+  }
+  return mData + mStart + serHeaderSize();
+}
 
-Deserializer::Deserializer(const char* b, uint32_t n) : mStart(0) {
-  mBuf.insert(mBuf.begin(), b, b + n);
+Deserializer& Deserializer::operator>>(const char*& v) {
+  SerHeader h;
+  const char* b = header(ser::getType<char>(), h);
+  if (!b) return *this;
+  if (h.num == 0 || h.num > remaining() - serHeaderSize() ||
+      b[h.num - 1] != '\0') {
+    mFailed = true;
+    return *this;
+  }
+  v = b;
+  mStart += serHeaderSize() + h.num;
+  return *this;
 }
 
 Deserializer& Deserializer::operator>>(char* v) {
-  uint32_t n = serDecode(bufDec(), v);
-  mStart += n;
+  const char* s = nullptr;
+  *this >> s;
+  if (s) strcpy(v, s);
   return *this;
 }
 
 Deserializer& Deserializer::operator>>(std::string& v) {
-  SerHeader h = serGetHeader(bufDec());
-  uint32_t need = serElementsSize(&h);
-  if (v.size() < need) v.resize(need);
-  return *this >> &v[0];
+  const char* s = nullptr;
+  *this >> s;
+  if (s) v.assign(s);
+  return *this;
 }
 
-const std::vector<char>& Deserializer::buf() const { return mBuf; }
-
-char* Deserializer::bufDec() { return &mBuf[mStart]; }
-
 }  // namespace al
 #endif
 
@@ -1,8 +1,50 @@
 #include "al/scene/al_DistributedScene.hpp"
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
 
 using namespace al;
 
+namespace {
+
+void putUint(std::vector<char> &buf, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    buf.push_back(char((value >> (8 * i)) & 0xFF));
+  }
+}
+
+// Bounds checked reading of received event batches
+struct EventReader {
+  const char *data;
+  size_t size;
+  size_t pos;
+
+  bool getUint(uint64_t &value, int bytes) {
+    if (pos + bytes > size) {
+      return false;
+    }
+    value = 0;
+    for (int i = 0; i < bytes; i++) {
+      value |= uint64_t((unsigned char)data[pos + i]) << (8 * i);
+    }
+    pos += bytes;
+    return true;
+  }
+
+  bool getString(std::string &s) {
+    uint64_t length;
+    if (!getUint(length, 2) || pos + length > size) {
+      return false;
+    }
+    s.assign(data + pos, length);
+    pos += length;
+    return true;
+  }
+};
+
+} // namespace
+
 DistributedScene::DistributedScene(std::string name, int threadPoolSize,
                                    TimeMasterMode masterMode)
     : DynamicScene(threadPoolSize, masterMode) {
@@ -11,7 +53,9 @@ DistributedScene::DistributedScene(std::string name, int threadPoolSize,
   PolySynth::registerTriggerOnCallback([this](SynthVoice *voice,
                                               int offsetFrames, int id,
                                               void *userData) {
-    if (this->mNotifier) {
+    if (this->mNotifier && mBinaryTriggers) {
+      appendTriggerOn(voice, id);
+    } else if (this->mNotifier) {
       osc::Packet p;
       std::string prefix = "/" + this->name();
       if (prefix.size() == 1) {
@@ -51,7 +95,9 @@ DistributedScene::DistributedScene(std::string name, int threadPoolSize,
   });
 
   PolySynth::registerTriggerOffCallback([this](int id, void *userData) {
-    if (this->mNotifier) {
+    if (this->mNotifier && mBinaryTriggers) {
+      appendTriggerEvent('f', id);
+    } else if (this->mNotifier) {
       osc::Packet p;
       std::string prefix = "/" + this->name();
       if (prefix.size() == 1) {
@@ -70,7 +116,9 @@ DistributedScene::DistributedScene(std::string name, int threadPoolSize,
   });
 
   PolySynth::registerFreeCallback([this](int id, void *userData) {
-    if (this->mNotifier) {
+    if (this->mNotifier && mBinaryTriggers) {
+      appendTriggerEvent('r', id);
+    } else if (this->mNotifier) {
       osc::Packet p;
       std::string prefix = "/" + this->name();
       if (prefix.size() == 1) {
@@ -96,6 +144,326 @@ DistributedScene::DistributedScene(std::string name, int threadPoolSize,
       });
 }
 
+DistributedScene::~DistributedScene() {
+  if (mBatchSenderThread) {
+    stopBatchSender();
+  }
+  flushTriggers();
+}
+
+void DistributedScene::binaryTriggers(bool enable) {
+  if (enable && !mBatchSenderThread) {
+    {
+      std::unique_lock<std::mutex> lk(mBatchLock);
+      // Batches move between these lists, which never need to grow
+      mBatches.reserve(triggerBatchPoolSize);
+      mSendingBatches.reserve(triggerBatchPoolSize);
+      mFreeBatches.reserve(triggerBatchPoolSize);
+      while (mFreeBatches.size() + mBatches.size() < triggerBatchPoolSize) {
+        mFreeBatches.emplace_back();
+        mFreeBatches.back().data.reserve(maxBatchBytes);
+        mFreeBatches.back().definedClasses.reserve(16);
+      }
+    }
+    mRunBatchSender = true;
+    mBatchSenderThread = std::make_unique<std::thread>(
+        &DistributedScene::batchSenderLoop, this);
+  } else if (!enable && mBatchSenderThread) {
+    mBinaryTriggers = false;
+    stopBatchSender();
+  }
+  mBinaryTriggers = enable;
+}
+
+DistributedScene::TriggerBatch *
+DistributedScene::batchForEvent(size_t eventSize) {
+  if (mBatches.empty() ||
+      mBatches.back().data.size() + eventSize > maxBatchBytes ||
+      mBatches.back().eventCount == UINT16_MAX) {
+    if (mFreeBatches.empty()) {
+      mDroppedEvents++;
+      return nullptr;
+    }
+    mBatches.push_back(std::move(mFreeBatches.back()));
+    mFreeBatches.pop_back();
+  }
+  return &mBatches.back();
+}
+
+namespace {
+
+// Encodes trigger fields as a list of tags and a list of raw values
+struct BinaryFieldWriter : public TriggerParamWriter {
+  char tags[UINT8_MAX];
+  char fields[DistributedScene::maxBatchBytes];
+  size_t numTags = 0;
+  size_t fieldBytes = 0;
+  bool overflow = false;
+
+  void putUint(uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+      fields[fieldBytes++] = char((value >> (8 * i)) & 0xFF);
+    }
+  }
+
+  bool reserve(size_t bytes) {
+    if (numTags == sizeof(tags) || fieldBytes + bytes > sizeof(fields)) {
+      overflow = true;
+    }
+    return !overflow;
+  }
+
+  void writeFloat(float value) override {
+    if (reserve(4)) {
+      uint32_t bits;
+      memcpy(&bits, &value, sizeof(float));
+      tags[numTags++] = 'f';
+      putUint(bits, 4);
+    }
+  }
+
+  void writeString(const char *value, size_t length) override {
+    if (reserve(2 + length)) {
+      tags[numTags++] = 's';
+      putUint(length, 2);
+      memcpy(fields + fieldBytes, value, length);
+      fieldBytes += length;
+    }
+  }
+};
+
+} // namespace
+
+void DistributedScene::appendTriggerOn(SynthVoice *voice, int id) {
+  int classId = voiceClassId(voice);
+  BinaryFieldWriter writer;
+  voice->writeTriggerParams(writer);
+  size_t eventSize = 1 + 4 + 2 + 1 + writer.numTags + writer.fieldBytes;
+
+  std::unique_lock<std::mutex> lk(mBatchLock);
+  if (classId >= int(mClassNames.size())) {
+    mClassNames.resize(classId + 1);
+  }
+  std::string &className = mClassNames[classId];
+  if (className.empty()) { // Only allocates the first time a class is sent
+    className = voiceClassName(classId);
+  }
+  size_t definitionSize = 1 + 2 + 2 + className.size();
+  if (writer.overflow || eventSize + definitionSize > maxBatchBytes) {
+    std::cerr << "ERROR: Trigger parameters too large for binary triggers"
+              << std::endl;
+    return;
+  }
+
+  // Class names are included once per batch so each batch can be decoded
+  // even if previous batches were lost
+  auto isDefined = [classId](const TriggerBatch &batch) {
+    return std::find(batch.definedClasses.begin(), batch.definedClasses.end(),
+                     uint16_t(classId)) != batch.definedClasses.end();
+  };
+  bool needsDefinition = mBatches.empty() || !isDefined(mBatches.back());
+  TriggerBatch *batch =
+      batchForEvent(eventSize + (needsDefinition ? definitionSize : 0));
+  if (batch && !isDefined(*batch)) {
+    // A new batch was started, which needs the definition too
+    batch = batchForEvent(eventSize + definitionSize);
+  }
+  if (!batch) {
+    return;
+  }
+  if (!isDefined(*batch)) {
+    batch->data.push_back('c');
+    putUint(batch->data, classId, 2);
+    putUint(batch->data, className.size(), 2);
+    batch->data.insert(batch->data.end(), className.begin(), className.end());
+    batch->definedClasses.push_back(uint16_t(classId));
+    batch->eventCount++;
+  }
+  batch->data.push_back('n');
+  putUint(batch->data, uint32_t(id), 4);
+  putUint(batch->data, classId, 2);
+  putUint(batch->data, writer.numTags, 1);
+  batch->data.insert(batch->data.end(), writer.tags,
+                     writer.tags + writer.numTags);
+  batch->data.insert(batch->data.end(), writer.fields,
+                     writer.fields + writer.fieldBytes);
+  batch->eventCount++;
+  if (verbose()) {
+    std::cout << "Queued binary trigger on for voice " << id << std::endl;
+  }
+}
+
+void DistributedScene::appendTriggerEvent(char type, int id) {
+  std::unique_lock<std::mutex> lk(mBatchLock);
+  TriggerBatch *batch = batchForEvent(5);
+  if (batch) {
+    batch->data.push_back(type);
+    putUint(batch->data, uint32_t(id), 4);
+    batch->eventCount++;
+  }
+}
+
+void DistributedScene::flushTriggers() {
+  std::unique_lock<std::mutex> flushLock(mFlushLock);
+  uint32_t sequence;
+  {
+    std::unique_lock<std::mutex> lk(mBatchLock);
+    mSendingBatches.swap(mBatches);
+    sequence = mSendSequence;
+    mSendSequence += uint32_t(mSendingBatches.size());
+  }
+  if (mNotifier && !mSendingBatches.empty()) {
+    std::string prefix = "/" + this->name();
+    if (prefix.size() == 1) {
+      prefix = "";
+    }
+    std::vector<char> blob;
+    blob.reserve(maxBatchBytes + 6);
+    for (auto &batch : mSendingBatches) {
+      blob.clear();
+      putUint(blob, sequence++, 4);
+      putUint(blob, batch.eventCount, 2);
+      blob.insert(blob.end(), batch.data.begin(), batch.data.end());
+      osc::Packet p(int(blob.size() + prefix.size() + 64));
+      p.beginMessage(prefix + "/events");
+      p << osc::Blob(blob.data(), blob.size());
+      p.endMessage();
+      mNotifier->send(p);
+    }
+  }
+  // Keep the buffers so the trigger callbacks don't need to allocate
+  std::unique_lock<std::mutex> lk(mBatchLock);
+  for (auto &batch : mSendingBatches) {
+    batch.data.clear();
+    batch.eventCount = 0;
+    batch.definedClasses.clear();
+    mFreeBatches.push_back(std::move(batch));
+  }
+  mSendingBatches.clear();
+}
+
+void DistributedScene::stopBatchSender() {
+  {
+    std::unique_lock<std::mutex> lk(mBatchSenderLock);
+    mRunBatchSender = false;
+  }
+  mBatchSenderCondition.notify_one();
+  mBatchSenderThread->join();
+  mBatchSenderThread = nullptr;
+}
+
+void DistributedScene::batchSenderLoop() {
+  std::unique_lock<std::mutex> lk(mBatchSenderLock);
+  while (mRunBatchSender) {
+    mBatchSenderCondition.wait_for(
+        lk, std::chrono::duration<double>(mBatchInterval),
+        [this]() { return !mRunBatchSender; });
+    lk.unlock();
+    flushTriggers();
+    lk.lock();
+  }
+}
+
+bool DistributedScene::consumeEvents(const char *data, size_t size) {
+  EventReader reader{data, size, 0};
+  uint64_t sequence, eventCount;
+  if (!reader.getUint(sequence, 4) || !reader.getUint(eventCount, 2)) {
+    return false;
+  }
+  uint32_t lost = uint32_t(sequence) - mExpectedSequence;
+  if (!mReceivedBatch || lost < UINT32_MAX / 2) {
+    if (mReceivedBatch && lost > 0) {
+      mLostBatches += lost;
+      std::cerr << "WARNING: Lost " << lost << " trigger batches" << std::endl;
+    }
+    mReceivedBatch = true;
+    mExpectedSequence = uint32_t(sequence) + 1;
+  } // else a reordered old batch, events are still applied
+
+  std::vector<float> floatFields;
+  std::vector<VariantValue> fields;
+  for (uint64_t i = 0; i < eventCount; i++) {
+    uint64_t type, id;
+    if (!reader.getUint(type, 1)) {
+      return false;
+    }
+    if (type == 'c') {
+      uint64_t remoteClassId;
+      std::string className;
+      if (!reader.getUint(remoteClassId, 2) || !reader.getString(className)) {
+        return false;
+      }
+      mRemoteClassIds[uint16_t(remoteClassId)] = voiceClassId(className);
+      continue;
+    }
+    if (!reader.getUint(id, 4)) {
+      return false;
+    }
+    if (type == 'n') {
+      uint64_t remoteClassId, fieldCount;
+      if (!reader.getUint(remoteClassId, 2) ||
+          !reader.getUint(fieldCount, 1) ||
+          reader.pos + fieldCount > reader.size) {
+        return false;
+      }
+      const char *tags = reader.data + reader.pos;
+      reader.pos += fieldCount;
+      bool allFloats = true;
+      floatFields.clear();
+      fields.clear();
+      for (uint64_t field = 0; field < fieldCount; field++) {
+        if (tags[field] == 's') {
+          std::string value;
+          if (!reader.getString(value)) {
+            return false;
+          }
+          fields.emplace_back(value);
+          allFloats = false;
+        } else {
+          uint64_t bits;
+          if (!reader.getUint(bits, 4)) {
+            return false;
+          }
+          uint32_t floatBits = uint32_t(bits);
+          float value;
+          memcpy(&value, &floatBits, sizeof(float));
+          floatFields.push_back(value);
+          fields.emplace_back(value);
+        }
+      }
+      auto classIt = mRemoteClassIds.find(uint16_t(remoteClassId));
+      SynthVoice *voice = nullptr;
+      if (classIt != mRemoteClassIds.end()) {
+        voice = getVoice(classIt->second);
+      }
+      if (!voice) {
+        std::cerr << "Can't get free voice of class id: " << remoteClassId
+                  << std::endl;
+        continue;
+      }
+      if (allFloats) {
+        voice->setTriggerParams(floatFields.data(), int(floatFields.size()));
+      } else {
+        voice->setTriggerParams(fields);
+      }
+      voice->markAsReplica();
+      if (verbose()) {
+        std::cout << "trigger on replica: " << id << std::endl;
+      }
+      triggerOn(voice, 0, int(id));
+    } else if (type == 'f') {
+      triggerOff(int(id));
+    } else if (type == 'r') {
+      int voiceId = int(id);
+      mVoiceIdsToFree.write((const char *)&voiceId, sizeof(int));
+    } else {
+      std::cerr << "ERROR: Unknown binary trigger event" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
 void DistributedScene::registerNotifier(OSCNotifier &notifier) {
     if (mNotifier) {
         std::cerr << "ERROR: Notifier has already been set and can't be changed"
@@ -103,10 +471,8 @@ void DistributedScene::registerNotifier(OSCNotifier &notifier) {
         return;
     }
     mNotifier = &notifier;
-    SynthVoice *voice = mFreeVoices;
-    while (voice) {
+    for (auto *voice : getFreeVoices()) {
         registerVoiceParameters(voice);
-        voice = voice->next;
     }
 }
 
@@ -143,7 +509,16 @@ bool al::DistributedScene::consumeMessage(osc::Message &m,
     }
   }
 
-  if (address == "/triggerOn") {
+  if (address == "/events") {
+    if (m.typeTags() == "b") {
+      osc::Blob blob;
+      m >> blob;
+      if (!consumeEvents(static_cast<const char *>(blob.data), blob.size)) {
+        std::cerr << "ERROR: Corrupt binary trigger batch" << std::endl;
+      }
+      return true;
+    }
+  } else if (address == "/triggerOn") {
     if (m.typeTags().size() > 2 && m.typeTags()[0] == 'i' &&
         m.typeTags()[1] == 'i' && m.typeTags()[2] == 's') {
       int offset, id;
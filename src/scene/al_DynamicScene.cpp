@@ -1,13 +1,50 @@
 #include "al/scene/al_DynamicScene.hpp"
 
 #include "al/graphics/al_Shapes.hpp"
+#include "al/math/al_Frustum.hpp"
 #include "al/scene/al_PositionedVoice.hpp"
 
 #include <algorithm>
+#include <cstring>
 
 using namespace std;
 using namespace al;
 
+namespace {
+
+// Stable LSD radix sort of items by their integer key. Passes where all keys
+// share the same byte are skipped.
+template <class Item>
+void radixSortByKey(std::vector<Item> &items, std::vector<Item> &scratch,
+                    int keyBytes) {
+  if (items.size() < 2) {
+    return;
+  }
+  scratch.resize(items.size());
+  for (int byte = 0; byte < keyBytes; byte++) {
+    const int shift = 8 * byte;
+    size_t counts[256] = {0};
+    for (const auto &item : items) {
+      counts[(item.key >> shift) & 0xFF]++;
+    }
+    if (counts[(items[0].key >> shift) & 0xFF] == items.size()) {
+      continue;
+    }
+    size_t offset = 0;
+    for (auto &count : counts) {
+      size_t n = count;
+      count = offset;
+      offset += n;
+    }
+    for (const auto &item : items) {
+      scratch[counts[(item.key >> shift) & 0xFF]++] = item;
+    }
+    items.swap(scratch);
+  }
+}
+
+} // namespace
+
 ThreadPool::ThreadPool(unsigned int n) : busy() {
   for (unsigned int i = 0; i < n; ++i) {
     workers.emplace_back(std::bind(&ThreadPool::thread_proc, this));
@@ -136,36 +173,59 @@ void DynamicScene::render(Graphics &g) {
     processVoiceTurnOff();
   }
   std::unique_lock<std::mutex> lk(mGraphicsLock);
-  std::vector<PositionedVoice *> voices;
-  voices.reserve(128);
+  // Frustum in the coordinates the voices are positioned in
+  Frustumd frustum;
+  bool cull = mCullDrawing &&
+              frustum.fromMatrix(g.projMatrix() * g.viewMatrix() *
+                                 g.modelMatrix());
+  auto viewPos = mListenerPose.pos();
+  bool grouped = false;
+  mDrawItems.clear();
+  mCulledVoices = 0;
   auto voice = mActiveVoices;
   while (voice) {
-    voices.push_back((PositionedVoice *)voice);
+    SynthVoice *current = voice;
     voice = voice->next;
+    // TODO implement offset?
+    if (!current->active()) {
+      continue;
+    }
+    auto *posVoice = dynamic_cast<PositionedVoice *>(current);
+    if (!posVoice) {
+      // Drawn first, without culling or transformations
+      mDrawItems.push_back({0, current, nullptr});
+      continue;
+    }
+    Vec3d pos = posVoice->pose().pos();
+    float radius = posVoice->boundingRadius() * posVoice->size();
+    if (cull && radius > 0 &&
+        frustum.testSphere(pos, radius) == Frustumd::OUTSIDE) {
+      mCulledVoices++;
+      continue;
+    }
+    uint64_t key = uint64_t(posVoice->drawGroup()) << 32;
+    grouped |= posVoice->drawGroup() != 0;
+    if (mSortDrawingByDistance) {
+      // Bits of non-negative floats order like the floats. Invert them to
+      // draw far to near.
+      float distSqr = float((pos - viewPos).magSqr());
+      uint32_t bits;
+      memcpy(&bits, &distSqr, sizeof(bits));
+      key |= uint32_t(~bits);
+    }
+    mDrawItems.push_back({key, current, posVoice});
   }
-  if (mSortDrawingByDistance) {
-    // FIXME this is crashing in some undetermined cases.
-    // For now a working but inefficient way of sorting
-    auto viewPos = mListenerPose.pos();
-    std::sort(voices.begin(), voices.end(),
-              [&](PositionedVoice *a, PositionedVoice *b) -> bool {
-                auto distA = (a->pose().pos() - viewPos).mag();
-                auto distB = (b->pose().pos() - viewPos).mag();
-                return distA >= distB;
-              });
+  if (mSortDrawingByDistance || grouped) {
+    radixSortByKey(mDrawItems, mDrawItemsScratch, 6);
   }
-  for (auto voice : voices) {
-    // TODO implement offset?
-    if (voice->active()) {
-      g.pushMatrix();
-      if (dynamic_cast<PositionedVoice *>(voice)) {
-        PositionedVoice *posVoice = static_cast<PositionedVoice *>(voice);
-        posVoice->preProcess(g);
-        posVoice->applyTransformations(g);
-      }
-      voice->onProcess(g);
-      g.popMatrix();
+  for (auto &item : mDrawItems) {
+    g.pushMatrix();
+    if (item.positioned) {
+      item.positioned->preProcess(g);
+      item.positioned->applyTransformations(g);
     }
+    item.voice->onProcess(g);
+    g.popMatrix();
   }
   if (mMasterMode == TimeMasterMode::TIME_MASTER_GRAPHICS) {
     processInactiveVoices();
@@ -294,6 +354,7 @@ void DynamicScene::render(AudioIOData &io) {
   if (mMasterMode == TimeMasterMode::TIME_MASTER_AUDIO) {
     processInactiveVoices();
   }
+  advanceSampleTime(io);
 }
 
 void DynamicScene::update(double dt) {
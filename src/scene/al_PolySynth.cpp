@@ -181,6 +181,7 @@ int al::asciiToMIDI(int asciiKey, int offset) {
 // ----------------------------
 
 PolySynth::PolySynth(TimeMasterMode masterMode) : mMasterMode(masterMode) {
+  mVoiceClasses.reserve(maxVoiceClasses);
   if (mMasterMode == TimeMasterMode::TIME_MASTER_CPU) {
     startCpuClockThread();
   }
@@ -218,6 +219,10 @@ int PolySynth::triggerOn(SynthVoice *voice, int offsetFrames, int id,
     }
   }
   voice->id(thisId);
+  if (!voice->mFreeList) { // Resolve here so freeing never needs a lookup
+    int classId = voiceClassId(voice);
+    voice->mFreeList = classId >= 0 ? &freeVoices(classId) : nullptr;
+  }
   if (userData) {
     voice->userData(userData);
   }
@@ -255,51 +260,110 @@ void PolySynth::triggerOff(int id) {
 void PolySynth::allNotesOff() { mAllNotesOff = true; }
 
 SynthVoice *PolySynth::getVoice(std::string name, bool forceAlloc) {
-  std::unique_lock<std::mutex> lk(
-      mFreeVoiceLock); // Only one getVoice() call at a time
-  SynthVoice *freeVoice = mFreeVoices;
-  SynthVoice *previousVoice = nullptr;
-  while (freeVoice) {
-    if (verbose()) {
-      std::cout << "Comparing  voice '" << demangle(typeid(*freeVoice).name())
-                << "' to '" << name << "'" << std::endl;
-    }
-    if (demangle(typeid(*freeVoice).name()) == name ||
-        strncmp(typeid(*freeVoice).name(), name.c_str(), name.size()) == 0) {
-      if (previousVoice) {
-        previousVoice->next = freeVoice->next;
-      } else {
-        mFreeVoices = freeVoice->next;
-      }
-      break;
+  int classId = voiceClassId(name);
+  if (classId < 0) {
+    if (mVerbose) {
+      std::cout << "Can't allocate voice of type " << name
+                << ". Voice not registered and no polyphony." << std::endl;
     }
-    previousVoice = freeVoice;
-    freeVoice = freeVoice->next;
+    return nullptr;
+  }
+  return getVoice(classId, forceAlloc);
+}
+
+SynthVoice *PolySynth::getVoice(int classId, bool forceAlloc) {
+  if (classId < 0 ||
+      classId >= mVoiceClassCount.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+  VoiceClass *voiceClass = mVoiceClasses[classId].get();
+  SynthVoice *freeVoice = nullptr;
+  if (!forceAlloc) {
+    freeVoice = voiceClass->freeVoices.pop();
   }
   if (!freeVoice) { // No free voice in list, so we need to allocate it
                     //  But only allocate if allocation has not been
                     //  disabled
-    if (std::find(mNoAllocationList.begin(), mNoAllocationList.end(), name) ==
-        mNoAllocationList.end()) {
+    if (voiceClass->allowAutoAllocation) {
       // TODO report current polyphony for more informed allocation of
       // polyphony
-      freeVoice = allocateVoice(name);
+      freeVoice = allocateVoice(voiceClass->name);
     } else {
-      std::cout << "Automatic allocation disabled for voice:" << name
-                << std::endl;
+      std::cout << "Automatic allocation disabled for voice:"
+                << voiceClass->name << std::endl;
     }
   }
   return freeVoice;
 }
 
+int PolySynth::voiceClassId(std::string name) {
+  std::unique_lock<std::mutex> lk(mVoiceClassLock);
+  auto classIt = mVoiceClassIds.find(name);
+  if (classIt != mVoiceClassIds.end()) {
+    return classIt->second;
+  }
+  // Also accept mangled names, as produced by typeid().name()
+  for (const auto &type : mVoiceTypeIds) {
+    if (strncmp(type.first.name(), name.c_str(), name.size()) == 0) {
+      mVoiceClassIds[name] = type.second;
+      return type.second;
+    }
+  }
+  return -1;
+}
+
+int PolySynth::voiceClassId(SynthVoice *voice) {
+  return typeClassId(typeid(*voice));
+}
+
+std::string PolySynth::voiceClassName(int classId) {
+  std::unique_lock<std::mutex> lk(mVoiceClassLock);
+  if (classId < 0 || classId >= int(mVoiceClasses.size())) {
+    return std::string();
+  }
+  return mVoiceClasses[classId]->name;
+}
+
+int PolySynth::typeClassId(const std::type_info &type) {
+  std::unique_lock<std::mutex> lk(mVoiceClassLock);
+  auto typeIt = mVoiceTypeIds.find(std::type_index(type));
+  if (typeIt != mVoiceTypeIds.end()) {
+    return typeIt->second;
+  }
+  if (mVoiceClasses.size() == size_t(maxVoiceClasses)) {
+    std::cerr << "ERROR: Too many voice classes in PolySynth. Can't add "
+              << demangle(type.name()) << std::endl;
+    return -1;
+  }
+  // Only demangled once, when the class is first seen
+  std::string name = demangle(type.name());
+  int classId = int(mVoiceClasses.size());
+  mVoiceClasses.emplace_back(new VoiceClass);
+  mVoiceClasses.back()->name = name;
+  mVoiceTypeIds[std::type_index(type)] = classId;
+  mVoiceClassIds.insert({name, classId});
+  mVoiceClassCount.store(classId + 1, std::memory_order_release);
+  return classId;
+}
+
 SynthVoice *PolySynth::getFreeVoice() {
-  std::unique_lock<std::mutex> lk(
-      mFreeVoiceLock); // Only one getVoice() call at a time
-  SynthVoice *freeVoice = mFreeVoices;
-  if (freeVoice) {
-    mFreeVoices = freeVoice->next;
+  std::unique_lock<std::mutex> lk(mVoiceClassLock);
+  for (auto &voiceClass : mVoiceClasses) {
+    SynthVoice *freeVoice = voiceClass->freeVoices.pop();
+    if (freeVoice) {
+      return freeVoice;
+    }
   }
-  return freeVoice;
+  return nullptr;
+}
+
+std::vector<SynthVoice *> PolySynth::getFreeVoices() {
+  std::vector<SynthVoice *> voices;
+  std::unique_lock<std::mutex> lk(mVoiceClassLock);
+  for (auto &voiceClass : mVoiceClasses) {
+    voiceClass->freeVoices.collect(voices);
+  }
+  return voices;
 }
 
 void PolySynth::render(AudioIOData &io) {
@@ -368,6 +432,7 @@ void PolySynth::render(AudioIOData &io) {
   if (mMasterMode == TimeMasterMode::TIME_MASTER_AUDIO) {
     processInactiveVoices();
   }
+  advanceSampleTime(io);
 }
 
 void PolySynth::render(Graphics &g) {
@@ -410,54 +475,32 @@ void PolySynth::update(double dt) {
 }
 
 void PolySynth::disableAllocation(std::string name) {
-  if (std::find(mNoAllocationList.begin(), mNoAllocationList.end(), name) ==
-      mNoAllocationList.end()) {
-    mNoAllocationList.push_back(name);
+  int classId = voiceClassId(name);
+  if (classId < 0) {
+    std::cerr << "ERROR: disableAllocation() for unknown voice: " << name
+              << std::endl;
+    return;
   }
+  mVoiceClasses[classId]->allowAutoAllocation = false;
 }
 
 void PolySynth::allocatePolyphony(std::string name, int number) {
-  std::unique_lock<std::mutex> lk(mFreeVoiceLock);
-  // Find last voice and add polyphony there
-  SynthVoice *lastVoice = mFreeVoices;
-  if (lastVoice) {
-    while (lastVoice->next) {
-      lastVoice = lastVoice->next;
-    }
-  } else {
-    lastVoice = mFreeVoices = allocateVoice(name);
-    number--;
-  }
   for (int i = 0; i < number; i++) {
-    lastVoice->next = allocateVoice(name);
-    lastVoice = lastVoice->next;
+    SynthVoice *voice = allocateVoice(name);
+    if (!voice) {
+      break;
+    }
+    releaseVoice(voice);
   }
 }
 
-void PolySynth::insertFreeVoice(SynthVoice *voice) {
-  std::unique_lock<std::mutex> lk(mFreeVoiceLock);
-  voice->next = mFreeVoices;
-  mFreeVoices = voice;
-}
+void PolySynth::insertFreeVoice(SynthVoice *voice) { releaseVoice(voice); }
 
 bool PolySynth::popFreeVoice(SynthVoice *voice) {
-  std::unique_lock<std::mutex> lk(mFreeVoiceLock);
-  SynthVoice *lastVoice = mFreeVoices;
-  SynthVoice *previousVoice = nullptr;
-  while (lastVoice) {
-    if (lastVoice == voice) {
-      if (previousVoice) {
-        previousVoice->next = lastVoice->next;
-        voice->next = nullptr;
-      } else {
-        mFreeVoices = lastVoice->next;
-        voice->next = nullptr;
-      }
-      return true;
-    }
-    lastVoice = lastVoice->next;
+  if (!voice->mFreeList) {
+    return false;
   }
-  return false;
+  return voice->mFreeList->remove(voice);
 }
 
 void PolySynth::setTimeMaster(TimeMasterMode masterMode) {
@@ -517,14 +560,11 @@ PolySynth &PolySynth::remove(AudioCallback &v) {
 
 void PolySynth::print(std::ostream &stream) {
   {
-    std::unique_lock<std::mutex> lk(mFreeVoiceLock);
-    auto voice = mFreeVoices;
     int counter = 0;
     stream << " ---- Free Voices ----" << std::endl;
-    while (voice) {
+    for (auto *voice : getFreeVoices()) {
       stream << "Voice " << counter++ << " " << voice->id() << " : "
              << typeid(voice).name() << " " << voice << std::endl;
-      voice = voice->next;
     }
   }
   //
@@ -571,12 +611,18 @@ void PolySynth::registerFreeCallback(std::function<bool(int, void *)> cb,
 }
 
 SynthVoice *PolySynth::allocateVoice(std::string name) {
-  if (mCreators.find(name) != mCreators.end()) {
+  VoiceCreatorFunc creator;
+  int classId = voiceClassId(name);
+  if (classId >= 0) {
+    std::unique_lock<std::mutex> lk(mVoiceClassLock);
+    creator = mVoiceClasses[classId]->creator;
+  }
+  if (creator) {
     if (mVerbose) {
       std::cout << "Allocating (from name) voice of type " << name << "."
                 << std::endl;
     }
-    SynthVoice *voice = mCreators[name]();
+    SynthVoice *voice = creator();
     return voice;
   } else {
     if (mVerbose) {
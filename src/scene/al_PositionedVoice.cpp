@@ -28,6 +28,18 @@ bool PositionedVoice::setTriggerParams(float *pFields, int numFields) {
   return ok;
 }
 
+void PositionedVoice::writeTriggerParams(TriggerParamWriter &writer) {
+  SynthVoice::writeTriggerParams(writer);
+  Pose currentPose = pose();
+  for (int i = 0; i < 3; i++) {
+    writer.writeFloat(float(currentPose.vec()[i]));
+  }
+  for (int i = 0; i < 4; i++) {
+    writer.writeFloat(float(currentPose.quat().components[i]));
+  }
+  writer.writeFloat(mSize.get());
+}
+
 bool PositionedVoice::setTriggerParams(const std::vector<float> &pFields,
                                        bool noCalls) {
   bool ok = SynthVoice::setTriggerParams(pFields, noCalls);
@@ -1,19 +1,279 @@
 
 #include "al/scene/al_SynthRecorder.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
 using namespace al;
 
+namespace {
+
+void putUint(std::ofstream &f, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    f.put(char((value >> (8 * i)) & 0xFF));
+  }
+}
+
+void putFloat(std::ofstream &f, float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(float));
+  putUint(f, bits, 4);
+}
+
+void putString(std::ofstream &f, const std::string &s, int lengthBytes) {
+  putUint(f, s.size(), lengthBytes);
+  f.write(s.data(), s.size());
+}
+
+// Copies trigger parameters into the fixed size arrays of a queued event.
+// Fields past kMaxFields are dropped and strings are truncated to fit.
+class EventFieldWriter : public TriggerParamWriter {
+public:
+  EventFieldWriter(float *fields, char *strings, int &numFields,
+                   uint32_t &stringMask)
+      : mFields(fields), mStrings(strings), mNumFields(numFields),
+        mStringMask(stringMask) {}
+
+  void writeFloat(float value) override {
+    if (mNumFields < SynthRecorder::kMaxFields) {
+      mFields[mNumFields++] = value;
+    }
+  }
+
+  void writeString(const char *value, size_t length) override {
+    if (mNumFields == SynthRecorder::kMaxFields) {
+      return;
+    }
+    if (mStringBytes < size_t(SynthRecorder::kMaxStringBytes)) {
+      length = std::min(length,
+                        SynthRecorder::kMaxStringBytes - mStringBytes - 1);
+      memcpy(mStrings + mStringBytes, value, length);
+      mStrings[mStringBytes + length] = '\0';
+      mStringBytes += length + 1;
+    }
+    mStringMask |= 1u << mNumFields;
+    mFields[mNumFields++] = 0;
+  }
+
+private:
+  float *mFields;
+  char *mStrings;
+  int &mNumFields;
+  uint32_t &mStringMask;
+  size_t mStringBytes{0};
+};
+
+} // namespace
+
+SynthRecorder::~SynthRecorder() {
+  if (mWriterThread) {
+    mRunWriter = false;
+    mWriterThread->join();
+  }
+}
+
 void SynthRecorder::startRecord(std::string name, bool overwrite,
                                 bool startOnEvent) {
+  if (mRecording) {
+    std::cerr << "ERROR: SynthRecorder already recording" << std::endl;
+    return;
+  }
+  if (!mQueue) {
+    mQueue.reset(new CapturedEvent[kQueueSize]);
+    for (size_t i = 0; i < kQueueSize; i++) {
+      mQueue[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+  // Discard events that were pushed while the previous recording stopped
+  collectEvents();
+  mSequence.clear();
+  mSequenceTimes.clear();
+  mDroppedEvents = 0;
+
   mOverwrite = overwrite;
   mStartOnEvent = startOnEvent;
-  mRecording = true;
-  mSequenceStart = std::chrono::high_resolution_clock::now();
   mSequenceName = name;
+  mUseSampleClock = mPolySynth && mPolySynth->sampleRate() > 0;
+  mTickRate = mUseSampleClock ? mPolySynth->sampleRate() : 1.0e6;
+  mClockStart = std::chrono::steady_clock::now();
+  mStartTime = now();
+
+  mRunWriter = true;
+  mWriterThread = std::make_unique<std::thread>(&SynthRecorder::writerLoop,
+                                                this);
+  mRecording = true;
+}
+
+bool SynthRecorder::onTriggerOn(SynthVoice *voice, int offsetFrames, int id,
+                                void *userData) {
+  SynthRecorder *rec = static_cast<SynthRecorder *>(userData);
+  if (rec->mRecording.load(std::memory_order_acquire)) {
+    rec->pushEvent(SynthEventType::TRIGGER_ON, voice->id(), voice,
+                   offsetFrames);
+  }
+  return true;
+}
+
+bool SynthRecorder::onTriggerOff(int id, void *userData) {
+  SynthRecorder *rec = static_cast<SynthRecorder *>(userData);
+  if (rec->mRecording.load(std::memory_order_acquire)) {
+    rec->pushEvent(SynthEventType::TRIGGER_OFF, id, nullptr, 0);
+  }
+  return true;
+}
+
+uint64_t SynthRecorder::now() const {
+  if (mUseSampleClock) {
+    return mPolySynth->sampleTime();
+  }
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - mClockStart)
+      .count();
+}
+
+bool SynthRecorder::pushEvent(SynthEventType type, int id, SynthVoice *voice,
+                              int offsetFrames) {
+  uint64_t time = now();
+  if (mUseSampleClock) {
+    time += offsetFrames;
+  }
+  CapturedEvent *event;
+  size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+  while (true) {
+    event = &mQueue[pos % kQueueSize];
+    size_t sequence = event->sequence.load(std::memory_order_acquire);
+    intptr_t diff = intptr_t(sequence) - intptr_t(pos);
+    if (diff == 0) {
+      if (mEnqueuePos.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) { // Queue full
+      mDroppedEvents++;
+      return false;
+    } else {
+      pos = mEnqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+  event->type = type;
+  event->id = id;
+  event->time = time;
+  event->numFields = 0;
+  event->stringMask = 0;
+  event->voiceType = nullptr;
+  if (voice) {
+    event->voiceType = &typeid(*voice);
+    EventFieldWriter writer(event->fields, event->strings, event->numFields,
+                            event->stringMask);
+    voice->writeTriggerParams(writer);
+  }
+  event->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+void SynthRecorder::collectEvents() {
+  if (!mQueue) {
+    return;
+  }
+  while (true) {
+    CapturedEvent &event = mQueue[mDequeuePos % kQueueSize];
+    if (event.sequence.load(std::memory_order_acquire) != mDequeuePos + 1) {
+      break;
+    }
+    if (mRecording) {
+      SynthEvent newEvent;
+      newEvent.type = event.type;
+      newEvent.id = event.id;
+      newEvent.duration = -1;
+      if (event.voiceType) {
+        auto nameIt = mVoiceNames.find(std::type_index(*event.voiceType));
+        if (nameIt == mVoiceNames.end()) {
+          nameIt = mVoiceNames
+                       .insert({std::type_index(*event.voiceType),
+                                demangle(event.voiceType->name())})
+                       .first;
+        }
+        newEvent.synthName = nameIt->second;
+      }
+      const char *strings = event.strings;
+      const char *stringsEnd = event.strings + kMaxStringBytes;
+      for (int i = 0; i < event.numFields; i++) {
+        if (event.stringMask & (1u << i)) {
+          size_t length =
+              strings < stringsEnd ? strnlen(strings, stringsEnd - strings) : 0;
+          newEvent.pFields.push_back(std::string(strings, length));
+          strings += length + 1;
+        } else {
+          newEvent.pFields.push_back(event.fields[i]);
+        }
+      }
+      if (mVerbose) {
+        std::cout << (event.type == SynthEventType::TRIGGER_ON ? "trigger"
+                                                               : "trigger OFF")
+                  << " at " << event.time << ":" << newEvent.synthName << ":"
+                  << event.id << std::endl;
+      }
+      mSequence.push_back(newEvent);
+      mSequenceTimes.push_back(event.time);
+    }
+    event.sequence.store(mDequeuePos + kQueueSize, std::memory_order_release);
+    mDequeuePos++;
+  }
+}
+
+void SynthRecorder::writerLoop() {
+  while (mRunWriter) {
+    collectEvents();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
 }
 
 void SynthRecorder::stopRecord() {
+  if (!mRecording) {
+    return;
+  }
+  // Collect remaining events while still recording so they are kept
+  mRunWriter = false;
+  mWriterThread->join();
+  mWriterThread = nullptr;
+  collectEvents();
   mRecording = false;
+  if (mDroppedEvents > 0) {
+    std::cerr << "WARNING: SynthRecorder dropped " << mDroppedEvents
+              << " events. Event queue full." << std::endl;
+  }
+
+  // Events from different threads can arrive out of order
+  std::vector<size_t> order(mSequence.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+    return mSequenceTimes[a] < mSequenceTimes[b];
+  });
+  uint64_t startTime = mStartTime;
+  if (mStartOnEvent) {
+    for (size_t index : order) {
+      if (mSequence[index].type == SynthEventType::TRIGGER_ON) {
+        startTime = mSequenceTimes[index];
+        break;
+      }
+    }
+  }
+  std::vector<SynthEvent> sequence;
+  std::vector<uint64_t> ticks;
+  sequence.reserve(order.size());
+  ticks.reserve(order.size());
+  for (size_t index : order) {
+    uint64_t eventTicks = mSequenceTimes[index] > startTime
+                              ? mSequenceTimes[index] - startTime
+                              : 0;
+    sequence.push_back(std::move(mSequence[index]));
+    sequence.back().time = eventTicks / mTickRate;
+    ticks.push_back(eventTicks);
+  }
+  mSequence.clear();
+  mSequenceTimes.clear();
+
   std::string path = File::conformDirectory(mDirectory);
   std::string fileName = path + mSequenceName + ".synthSequence";
 
@@ -28,13 +288,56 @@ void SynthRecorder::stopRecord() {
     fileName = newFileName;
   }
   std::vector<std::string> usedInstruments;
-  std::ofstream f(fileName);
+  std::ofstream f(fileName, mFormat == BINARY_FORMAT
+                                ? std::ios::out | std::ios::binary
+                                : std::ios::out);
   if (!f.is_open()) {
     std::cout << "Error while opening sequence file: " << fileName << std::endl;
     return;
   }
-  if (mFormat == CPP_FORMAT) {
-    for (SynthEvent &event : mSequence) {
+  if (mFormat == BINARY_FORMAT) {
+    for (SynthEvent &event : sequence) {
+      if (event.type == SynthEventType::TRIGGER_ON &&
+          std::find(usedInstruments.begin(), usedInstruments.end(),
+                    event.synthName) == usedInstruments.end()) {
+        usedInstruments.push_back(event.synthName);
+      }
+    }
+    f.write(SynthSequencer::binaryMagic, 4);
+    putUint(f, SynthSequencer::binaryVersion, 4);
+    uint64_t tickRateBits;
+    memcpy(&tickRateBits, &mTickRate, sizeof(double));
+    putUint(f, tickRateBits, 8);
+    putUint(f, usedInstruments.size(), 4);
+    for (auto &instr : usedInstruments) {
+      putString(f, instr, 2);
+    }
+    for (size_t i = 0; i < sequence.size(); i++) {
+      SynthEvent &event = sequence[i];
+      putUint(f, event.type == SynthEventType::TRIGGER_ON ? 0 : 1, 1);
+      putUint(f, ticks[i], 8);
+      putUint(f, uint32_t(event.id), 4);
+      if (event.type == SynthEventType::TRIGGER_ON) {
+        putUint(f,
+                std::find(usedInstruments.begin(), usedInstruments.end(),
+                          event.synthName) -
+                    usedInstruments.begin(),
+                4);
+        putUint(f, event.pFields.size(), 1);
+        for (auto &field : event.pFields) {
+          if (field.type() == VariantType::VARIANT_STRING) {
+            f.put('s');
+            putString(f, field.get<std::string>(), 2);
+          } else {
+            f.put('f');
+            putFloat(f, field.get<float>());
+          }
+        }
+      }
+    }
+    usedInstruments.clear(); // No parameter name comments in binary files
+  } else if (mFormat == CPP_FORMAT) {
+    for (SynthEvent &event : sequence) {
       f << "s.add<" << event.synthName << ">(" << event.time << ").set(";
       for (unsigned int i = 0; i < event.pFields.size(); i++) {
         if (event.pFields[i].type() == VariantType::VARIANT_STRING) {
@@ -54,7 +357,7 @@ void SynthRecorder::stopRecord() {
     }
   } else if (mFormat == SEQUENCER_EVENT) {
     std::map<int, SynthEvent *> eventStack;
-    for (SynthEvent &event : mSequence) {
+    for (SynthEvent &event : sequence) {
       if (event.type == SynthEventType::TRIGGER_ON) {
         eventStack[event.id] = &event;
       } else if (event.type == SynthEventType::TRIGGER_OFF) {
@@ -85,7 +388,7 @@ void SynthRecorder::stopRecord() {
     }
 
   } else if (mFormat == SEQUENCER_TRIGGERS) {
-    for (SynthEvent &event : mSequence) {
+    for (SynthEvent &event : sequence) {
       if (event.type == SynthEventType::TRIGGER_ON) {
         f << "+ " << event.time << " " << event.id << " " << event.synthName
           << " ";
@@ -118,12 +421,14 @@ void SynthRecorder::stopRecord() {
   if (f.bad()) {
     std::cout << "Error while writing sequence file: " << fileName << std::endl;
   }
-  mSequence.clear();
   for (auto &instr : usedInstruments) {
-    f << "# " << instr << " ";
     // Hack to get the parameter names. Get a voice from the polysynth and then
     // check the parameters. Should there be a better way?
     auto *voice = mPolySynth->getVoice(instr);
+    if (!voice) {
+      continue;
+    }
+    f << "# " << instr << " ";
     for (auto p : voice->triggerParameters()) {
       f << p->getName() << " ";
     }
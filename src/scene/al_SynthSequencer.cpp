@@ -5,8 +5,10 @@
 #include <algorithm>
 #include <cassert>
 #include <climits>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <typeinfo> // For class name instrospection
 
@@ -189,6 +191,14 @@ SynthSequencer::loadSequence(std::string sequenceName, double timeOffset,
     std::cout << "Could not open:" << fullName << std::endl;
     return events;
   }
+  char header[4] = {0};
+  f.read(header, 4);
+  if (f.gcount() == 4 && memcmp(header, binaryMagic, 4) == 0) {
+    f.close();
+    return loadBinarySequence(fullName, timeOffset, timeScale);
+  }
+  f.clear();
+  f.seekg(0);
 
   std::string line;
   double tempoFactor = 1.0;
@@ -459,6 +469,107 @@ SynthSequencer::loadSequence(std::string sequenceName, double timeOffset,
   return events;
 }
 
+std::list<SynthSequencerEvent>
+SynthSequencer::loadBinarySequence(std::string fullName, double timeOffset,
+                                   double timeScale) {
+  std::list<SynthSequencerEvent> events;
+  std::ifstream f(fullName, std::ios::binary);
+  auto getUint = [&f](uint64_t &value, int bytes) {
+    value = 0;
+    for (int i = 0; i < bytes; i++) {
+      int c = f.get();
+      if (c == EOF) {
+        return false;
+      }
+      value |= uint64_t(c & 0xFF) << (8 * i);
+    }
+    return true;
+  };
+  auto getString = [&](std::string &s, int lengthBytes) {
+    uint64_t length;
+    if (!getUint(length, lengthBytes)) {
+      return false;
+    }
+    s.resize(length);
+    f.read(&s[0], length);
+    return uint64_t(f.gcount()) == length;
+  };
+
+  uint64_t version, tickRateBits, nameCount;
+  f.ignore(4);
+  if (!getUint(version, 4) || !getUint(tickRateBits, 8) ||
+      !getUint(nameCount, 4) || version != binaryVersion) {
+    std::cerr << "ERROR: Unsupported binary sequence: " << fullName
+              << std::endl;
+    return events;
+  }
+  double tickRate;
+  memcpy(&tickRate, &tickRateBits, sizeof(double));
+  std::vector<std::string> names(nameCount);
+  for (auto &name : names) {
+    if (!getString(name, 2)) {
+      std::cerr << "ERROR: Corrupt binary sequence: " << fullName << std::endl;
+      return events;
+    }
+  }
+
+  // Events are stored sorted by time, so appending keeps the list sorted
+  std::map<int, std::list<SynthSequencerEvent>::iterator> openEvents;
+  uint64_t type, ticks, id;
+  while (getUint(type, 1)) {
+    if (!getUint(ticks, 8) || !getUint(id, 4)) {
+      std::cerr << "ERROR: Truncated binary sequence: " << fullName
+                << std::endl;
+      break;
+    }
+    double eventTime = ticks / tickRate * timeScale;
+    if (type == 0) {
+      uint64_t nameIndex, fieldCount;
+      if (!getUint(nameIndex, 4) || nameIndex >= names.size() ||
+          !getUint(fieldCount, 1)) {
+        std::cerr << "ERROR: Corrupt binary sequence: " << fullName
+                  << std::endl;
+        break;
+      }
+      std::vector<VariantValue> pFields;
+      pFields.reserve(fieldCount);
+      for (uint64_t i = 0; i < fieldCount; i++) {
+        int fieldType = f.get();
+        if (fieldType == 's') {
+          std::string value;
+          getString(value, 2);
+          pFields.push_back(value);
+        } else {
+          uint64_t bits;
+          getUint(bits, 4);
+          uint32_t floatBits = uint32_t(bits);
+          float value;
+          memcpy(&value, &floatBits, sizeof(float));
+          pFields.push_back(value);
+        }
+      }
+      auto insertedEvent = events.insert(events.end(), SynthSequencerEvent());
+      insertedEvent->type = SynthSequencerEvent::EVENT_PFIELDS;
+      insertedEvent->startTime = timeOffset + eventTime;
+      insertedEvent->fields.name = names[nameIndex];
+      insertedEvent->fields.pFields = pFields;
+      openEvents[int(id)] = insertedEvent;
+    } else {
+      auto openEvent = openEvents.find(int(id));
+      if (openEvent != openEvents.end()) {
+        openEvent->second->duration =
+            timeOffset + eventTime - openEvent->second->startTime;
+        openEvents.erase(openEvent);
+      }
+    }
+  }
+  // Trigger on events without trigger off are dropped as in '@' events
+  for (auto &openEvent : openEvents) {
+    events.erase(openEvent.second);
+  }
+  return events;
+}
+
 void SynthSequencer::playEvents(std::list<SynthSequencerEvent> events,
                                 double timeOffset) {
 
@@ -282,6 +282,26 @@ std::vector<VariantValue> SynthVoice::getTriggerParams() {
   return pFields;
 }
 
+void SynthVoice::writeTriggerParams(TriggerParamWriter &writer) {
+  char value[maxTriggerStringLength + 1];
+  for (auto param : mTriggerParams) {
+    if (param) {
+      if (strcmp(typeid(*param).name(), typeid(ParameterString).name()) == 0) {
+        size_t length =
+            static_cast<ParameterString *>(param)->copyTo(value, sizeof(value));
+        writer.writeString(value, length);
+      } else if (strcmp(typeid(*param).name(), typeid(ParameterMenu).name()) ==
+                 0) {
+        size_t length = static_cast<ParameterMenu *>(param)->copyCurrent(
+            value, sizeof(value));
+        writer.writeString(value, length);
+      } else {
+        writer.writeFloat(param->toFloat());
+      }
+    }
+  }
+}
+
 void SynthVoice::triggerOn(int offsetFrames) {
   mOnOffsetFrames = offsetFrames;
   mActive = true;
@@ -0,0 +1,136 @@
+#include "al/sound/al_BassManagement.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "al/math/al_Constants.hpp"
+
+using namespace al;
+
+namespace {
+
+// Butterworth section, two in cascade make a Linkwitz-Riley filter
+BiQuadBank::Coefficients butterworth(bool highPass, double freq,
+                                     double sampleRate) {
+  double omega = 2 * M_PI * freq / sampleRate;
+  double cs = cos(omega);
+  double alpha = sin(omega) / M_SQRT2;  // Q = 1/sqrt(2)
+  double a0 = 1 + alpha;
+  BiQuadBank::Coefficients c;
+  c.b0 = float((highPass ? (1 + cs) / 2 : (1 - cs) / 2) / a0);
+  c.b1 = float((highPass ? -(1 + cs) : 1 - cs) / a0);
+  c.b2 = c.b0;
+  c.a1 = float(-2 * cs / a0);
+  c.a2 = float((1 - alpha) / a0);
+  return c;
+}
+
+} // namespace
+
+void BassManagement::configure(const Speakers &mains,
+                               const std::vector<unsigned> &subwoofers,
+                               float crossoverFrequency, double sampleRate,
+                               unsigned maxDelay) {
+  mMains = mains;
+  mSubwoofers = subwoofers;
+  mSampleRate = sampleRate;
+
+  mHighPass.configure(unsigned(mains.size()), 2, sampleRate);
+  mLowPass.configure(unsigned(mains.size()), 2, sampleRate);
+  this->crossoverFrequency(crossoverFrequency);
+
+  mGains = std::vector<std::atomic<float>>(mains.size());
+  mDelays = std::vector<std::atomic<unsigned>>(mains.size());
+  for (size_t i = 0; i < mains.size(); i++) {
+    mGains[i] = 1.0f;
+    mDelays[i] = 0;
+  }
+  mMaxDelay = maxDelay;
+  unsigned delayLength = 1;
+  while (delayLength <= maxDelay) {
+    delayLength <<= 1;
+  }
+  mDelayMask = delayLength - 1;
+  mDelayWrite = 0;
+  mDelayLines.assign(size_t(delayLength) * mains.size(), 0.0f);
+
+  mMainBuffers.assign(mains.size(), nullptr);
+  mLowBuffers.resize(mains.size());
+  mLows.assign(size_t(kBlockFrames) * mains.size(), 0.0f);
+  for (size_t i = 0; i < mains.size(); i++) {
+    mLowBuffers[i] = mLows.data() + i * kBlockFrames;
+  }
+  mSum.assign(kBlockFrames, 0.0f);
+}
+
+void BassManagement::crossoverFrequency(float frequency) {
+  mCrossoverFrequency = frequency;
+  BiQuadBank::Coefficients high = butterworth(true, frequency, mSampleRate);
+  BiQuadBank::Coefficients low = butterworth(false, frequency, mSampleRate);
+  for (unsigned i = 0; i < mHighPass.channels(); i++) {
+    for (unsigned section = 0; section < 2; section++) {
+      mHighPass.setSection(i, section, high);
+      mLowPass.setSection(i, section, low);
+    }
+  }
+  mHighPass.commit();
+  mLowPass.commit();
+}
+
+void BassManagement::speakerGain(size_t speaker, float gain) {
+  mGains[speaker] = gain;
+}
+
+void BassManagement::speakerDelay(size_t speaker, unsigned samples) {
+  mDelays[speaker] = std::min(samples, mMaxDelay);
+}
+
+void BassManagement::processBass(AudioIOData &io) {
+  if (mMains.empty()) {
+    return;
+  }
+  unsigned channelsOut = io.channelsOut();
+  int count = int(io.framesPerBuffer());
+  float subGain = mSubwoofers.empty() ? 0.0f : 1.0f / mSubwoofers.size();
+  size_t delayLength = size_t(mDelayMask) + 1;
+
+  for (int start = 0; start < count; start += kBlockFrames) {
+    int frames = std::min(kBlockFrames, count - start);
+    for (size_t i = 0; i < mMains.size(); i++) {
+      unsigned channel = mMains[i].deviceChannel;
+      float *low = mLowBuffers[i];
+      if (channel < channelsOut) {
+        mMainBuffers[i] = io.outBuffer(channel) + start;
+        std::copy(mMainBuffers[i], mMainBuffers[i] + frames, low);
+      } else {
+        mMainBuffers[i] = nullptr;
+        std::fill(low, low + frames, 0.0f);
+      }
+    }
+    mHighPass.process(mMainBuffers.data(), frames);
+    mLowPass.process(mLowBuffers.data(), frames);
+
+    std::fill(mSum.begin(), mSum.begin() + frames, 0.0f);
+    for (size_t i = 0; i < mMains.size(); i++) {
+      const float *low = mLowBuffers[i];
+      float *line = mDelayLines.data() + i * delayLength;
+      float gain = mGains[i].load(std::memory_order_relaxed) * subGain;
+      unsigned delay = mDelays[i].load(std::memory_order_relaxed);
+      for (int n = 0; n < frames; n++) {
+        unsigned write = mDelayWrite + unsigned(n);
+        line[write & mDelayMask] = low[n];
+        mSum[n] += gain * line[(write - delay) & mDelayMask];
+      }
+    }
+    mDelayWrite += unsigned(frames);
+
+    for (unsigned sub : mSubwoofers) {
+      if (sub < channelsOut) {
+        float *out = io.outBuffer(sub) + start;
+        for (int n = 0; n < frames; n++) {
+          out[n] += mSum[n];
+        }
+      }
+    }
+  }
+}
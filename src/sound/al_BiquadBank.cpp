@@ -0,0 +1,198 @@
+#include "al/sound/al_BiquadBank.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "al/math/al_SIMD.hpp"
+
+using namespace al;
+
+void BiQuadBank::configure(unsigned numChannels, unsigned numSections,
+                           double sampleRate) {
+  mNumChannels = numChannels;
+  mNumSections = numSections;
+  mNumGroups = (numChannels + kLanes - 1) / kLanes;
+  mSampleRate = sampleRate;
+
+  LaneCoefficients passThrough;
+  for (int lane = 0; lane < kLanes; lane++) {
+    passThrough.b0[lane] = 1.0f;
+    passThrough.b1[lane] = passThrough.b2[lane] = 0.0f;
+    passThrough.a1[lane] = passThrough.a2[lane] = 0.0f;
+  }
+  size_t size = size_t(mNumGroups) * numSections;
+  mStaged.assign(size, passThrough);
+  for (auto &set : mSets) {
+    set.assign(size, passThrough);
+  }
+  mReadSet = 0;
+  mWriteSet = 1;
+  mPendingSet = 2;
+
+  LaneState zero;
+  std::fill(zero.z1, zero.z1 + kLanes, 0.0f);
+  std::fill(zero.z2, zero.z2 + kLanes, 0.0f);
+  mState.assign(size, zero);
+  mResetPending = false;
+  mBuffers.assign(numChannels, nullptr);
+}
+
+void BiQuadBank::setSection(unsigned channel, unsigned section,
+                            BIQUADTYPE type, double freq, double bandwidth,
+                            double dbGain) {
+  BiQuad biquad(type, mSampleRate);
+  biquad.set(freq, bandwidth, dbGain);
+  const BiquadData &data = biquad.coefficients();
+  Coefficients c;
+  c.b0 = float(data.a0);
+  c.b1 = float(data.a1);
+  c.b2 = float(data.a2);
+  c.a1 = float(data.a3);
+  c.a2 = float(data.a4);
+  setSection(channel, section, c);
+}
+
+void BiQuadBank::setSection(unsigned channel, unsigned section,
+                            const Coefficients &coefficients) {
+  assert(channel < mNumChannels && section < mNumSections);
+  LaneCoefficients &c =
+      mStaged[(channel / kLanes) * mNumSections + section];
+  int lane = channel % kLanes;
+  c.b0[lane] = coefficients.b0;
+  c.b1[lane] = coefficients.b1;
+  c.b2[lane] = coefficients.b2;
+  c.a1[lane] = coefficients.a1;
+  c.a2[lane] = coefficients.a2;
+}
+
+BiQuadBank::Coefficients BiQuadBank::section(unsigned channel,
+                                             unsigned section) const {
+  assert(channel < mNumChannels && section < mNumSections);
+  const LaneCoefficients &c =
+      mStaged[(channel / kLanes) * mNumSections + section];
+  int lane = channel % kLanes;
+  Coefficients coefficients;
+  coefficients.b0 = c.b0[lane];
+  coefficients.b1 = c.b1[lane];
+  coefficients.b2 = c.b2[lane];
+  coefficients.a1 = c.a1[lane];
+  coefficients.a2 = c.a2[lane];
+  return coefficients;
+}
+
+void BiQuadBank::commit() {
+  // Same size as mStaged, so copying does not allocate
+  mSets[mWriteSet] = mStaged;
+  mWriteSet = mPendingSet.exchange(mWriteSet | kNewSet) & (kNewSet - 1);
+}
+
+void BiQuadBank::process(float *const *buffers, int count) {
+  if (mNumGroups == 0 || mNumSections == 0) {
+    return;
+  }
+  if (mPendingSet.load() & kNewSet) {
+    mReadSet = mPendingSet.exchange(mReadSet) & (kNewSet - 1);
+  }
+  if (mResetPending.exchange(false)) {
+    for (auto &state : mState) {
+      std::fill(state.z1, state.z1 + kLanes, 0.0f);
+      std::fill(state.z2, state.z2 + kLanes, 0.0f);
+    }
+  }
+#ifdef AL_SIMD_SSE
+  // Flush denormals to zero, decaying filter tails are otherwise very slow
+  unsigned int csr = _mm_getcsr();
+  _mm_setcsr(csr | 0x8040);
+#endif
+  const std::vector<LaneCoefficients> &coefficients = mSets[mReadSet];
+  for (unsigned group = 0; group < mNumGroups; group++) {
+    unsigned firstChannel = group * kLanes;
+    int lanes = int(std::min<unsigned>(kLanes, mNumChannels - firstChannel));
+    bool active = false;
+    for (int lane = 0; lane < lanes; lane++) {
+      active |= buffers[firstChannel + lane] != nullptr;
+    }
+    if (!active) {
+      continue;
+    }
+    for (int start = 0; start < count; start += kBlockFrames) {
+      int frames = std::min(kBlockFrames, count - start);
+      // Interleave the group so each frame is one SIMD vector
+      for (int lane = 0; lane < kLanes; lane++) {
+        float *buffer =
+            lane < lanes ? buffers[firstChannel + lane] : nullptr;
+        if (buffer) {
+          for (int i = 0; i < frames; i++) {
+            mFrames[i * kLanes + lane] = buffer[start + i];
+          }
+        } else {
+          for (int i = 0; i < frames; i++) {
+            mFrames[i * kLanes + lane] = 0.0f;
+          }
+        }
+      }
+      for (unsigned section = 0; section < mNumSections; section++) {
+        size_t index = group * mNumSections + section;
+        processSection(mFrames, frames, coefficients[index], mState[index]);
+      }
+      for (int lane = 0; lane < lanes; lane++) {
+        float *buffer = buffers[firstChannel + lane];
+        if (buffer) {
+          for (int i = 0; i < frames; i++) {
+            buffer[start + i] = mFrames[i * kLanes + lane];
+          }
+        }
+      }
+    }
+  }
+#ifdef AL_SIMD_SSE
+  _mm_setcsr(csr);
+#endif
+}
+
+void BiQuadBank::processOutputs(AudioIOData &io) {
+  unsigned channelsOut = io.channelsOut();
+  for (unsigned c = 0; c < mNumChannels; c++) {
+    mBuffers[c] = c < channelsOut ? io.outBuffer(c) : nullptr;
+  }
+  process(mBuffers.data(), int(io.framesPerBuffer()));
+}
+
+void BiQuadBank::processSection(float *frames, int count,
+                                const LaneCoefficients &c, LaneState &state) {
+#ifdef AL_SIMD_SSE
+  static_assert(kLanes == 4, "SSE path processes 4 lanes");
+  const __m128 b0 = _mm_loadu_ps(c.b0);
+  const __m128 b1 = _mm_loadu_ps(c.b1);
+  const __m128 b2 = _mm_loadu_ps(c.b2);
+  const __m128 a1 = _mm_loadu_ps(c.a1);
+  const __m128 a2 = _mm_loadu_ps(c.a2);
+  __m128 z1 = _mm_loadu_ps(state.z1);
+  __m128 z2 = _mm_loadu_ps(state.z2);
+  for (int i = 0; i < count; i++) {
+    __m128 x = _mm_loadu_ps(frames + i * kLanes);
+    __m128 y = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+    z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), z2);
+    z2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+    _mm_storeu_ps(frames + i * kLanes, y);
+  }
+  _mm_storeu_ps(state.z1, z1);
+  _mm_storeu_ps(state.z2, z2);
+#else
+  // Fixed length inner loops the compiler can vectorize
+  float z1[kLanes], z2[kLanes];
+  std::copy(state.z1, state.z1 + kLanes, z1);
+  std::copy(state.z2, state.z2 + kLanes, z2);
+  for (int i = 0; i < count; i++) {
+    float *x = frames + i * kLanes;
+    for (int lane = 0; lane < kLanes; lane++) {
+      float y = c.b0[lane] * x[lane] + z1[lane];
+      z1[lane] = c.b1[lane] * x[lane] - c.a1[lane] * y + z2[lane];
+      z2[lane] = c.b2[lane] * x[lane] - c.a2[lane] * y;
+      x[lane] = y;
+    }
+  }
+  std::copy(z1, z1 + kLanes, state.z1);
+  std::copy(z2, z2 + kLanes, state.z2);
+#endif
+}
@@ -0,0 +1,234 @@
+#include "al/sound/al_FDNReverb.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "al/math/al_SIMD.hpp"
+
+using namespace al;
+
+namespace {
+
+const int kMaxBlockFrames = 128;
+const size_t kAlignFloats = 16;  // 64 byte cache lines
+
+size_t alignUp(size_t n) { return (n + kAlignFloats - 1) & ~(kAlignFloats - 1); }
+
+bool isPrime(unsigned n) {
+  if (n < 2) {
+    return false;
+  }
+  for (unsigned d = 2; d * d <= n; d++) {
+    if (n % d == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// a, b = a + b, a - b
+void butterfly(float *a, float *b, int frames) {
+  int i = 0;
+#ifdef AL_SIMD_SSE
+  for (; i + 4 <= frames; i += 4) {
+    __m128 x = _mm_load_ps(a + i);
+    __m128 y = _mm_load_ps(b + i);
+    _mm_store_ps(a + i, _mm_add_ps(x, y));
+    _mm_store_ps(b + i, _mm_sub_ps(x, y));
+  }
+#endif
+  for (; i < frames; i++) {
+    float x = a[i];
+    a[i] = x + b[i];
+    b[i] = x - b[i];
+  }
+}
+
+} // namespace
+
+void FDNReverb::configure(unsigned numOutputs, double sampleRate,
+                          unsigned numDelays, float minDelay, float maxDelay) {
+  mNumOutputs = numOutputs;
+  mSampleRate = sampleRate;
+  if (numDelays == 0) {
+    numDelays = std::max(numOutputs, 8u);
+  }
+  mNumDelays = 1;
+  while (mNumDelays < std::max(numDelays, numOutputs)) {
+    mNumDelays <<= 1;
+  }
+
+  // Mutually prime lengths spread exponentially between the limits
+  mLengths.resize(mNumDelays);
+  double minLength = std::max(double(minDelay) * sampleRate, 16.0);
+  double maxLength = std::max(double(maxDelay) * sampleRate, minLength);
+  unsigned previous = 0;
+  for (unsigned i = 0; i < mNumDelays; i++) {
+    double t = mNumDelays > 1 ? double(i) / (mNumDelays - 1) : 0.0;
+    unsigned length =
+        unsigned(minLength * std::pow(maxLength / minLength, t));
+    length = std::max(length, previous + 1);
+    while (!isPrime(length)) {
+      length++;
+    }
+    mLengths[i] = previous = length;
+  }
+  mBlockFrames = int(std::min<unsigned>(kMaxBlockFrames, mLengths[0]));
+
+  size_t total = kAlignFloats; // Room to align the first line
+  for (unsigned length : mLengths) {
+    total += alignUp(length);
+  }
+  size_t blockStride = alignUp(size_t(mBlockFrames));
+  total += blockStride * mNumDelays;
+  mMemory.assign(total, 0.0f);
+
+  uintptr_t address = reinterpret_cast<uintptr_t>(mMemory.data());
+  uintptr_t aligned = (address + 63) & ~uintptr_t(63);
+  float *p = mMemory.data() + (aligned - address) / sizeof(float);
+  mLines.resize(mNumDelays);
+  for (unsigned i = 0; i < mNumDelays; i++) {
+    mLines[i] = p;
+    p += alignUp(mLengths[i]);
+  }
+  mBlock = p;
+
+  mPositions.assign(mNumDelays, 0);
+  mFilterState.assign(mNumDelays, 0.0f);
+  mFeedback.resize(mNumDelays);
+  mInputGains.resize(mNumDelays);
+  float inputGain = 1.0f / std::sqrt(float(mNumDelays));
+  for (unsigned i = 0; i < mNumDelays; i++) {
+    // Bit parity gives a sign pattern that is not a Hadamard row
+    unsigned bits = i * 0x9E3779B1u;
+    bits ^= bits >> 16;
+    bits ^= bits >> 8;
+    bits ^= bits >> 4;
+    mInputGains[i] = (0x6996u >> (bits & 15)) & 1 ? -inputGain : inputGain;
+  }
+  updateGains();
+}
+
+FDNReverb &FDNReverb::decayTime(float seconds) {
+  mDecayTime = seconds;
+  updateGains();
+  return *this;
+}
+
+FDNReverb &FDNReverb::damping(float v) {
+  mDamping = v;
+  return *this;
+}
+
+FDNReverb &FDNReverb::mixing(Mixing m) {
+  mMixing = m;
+  updateGains();
+  return *this;
+}
+
+FDNReverb &FDNReverb::gain(float v) {
+  mGain = v;
+  return *this;
+}
+
+void FDNReverb::zero() {
+  std::fill(mMemory.begin(), mMemory.end(), 0.0f);
+  std::fill(mFilterState.begin(), mFilterState.end(), 0.0f);
+}
+
+void FDNReverb::updateGains() {
+  // The Hadamard butterflies are not normalized, so fold 1/sqrt(N) in here
+  float scale =
+      mMixing == HADAMARD ? 1.0f / std::sqrt(float(mNumDelays)) : 1.0f;
+  for (unsigned i = 0; i < mNumDelays; i++) {
+    double seconds = mLengths[i] / mSampleRate;
+    mFeedback[i] =
+        scale * float(std::pow(10.0, -3.0 * seconds / mDecayTime));
+  }
+}
+
+void FDNReverb::mixBlock(int frames) {
+  size_t stride = alignUp(size_t(mBlockFrames));
+  if (mMixing == HADAMARD) {
+    for (unsigned h = 1; h < mNumDelays; h <<= 1) {
+      for (unsigned i = 0; i < mNumDelays; i += 2 * h) {
+        for (unsigned j = i; j < i + h; j++) {
+          butterfly(mBlock + j * stride, mBlock + (j + h) * stride, frames);
+        }
+      }
+    }
+  } else {
+    // I - 2/N * ones, the sum of all lines is reflected out of each line
+    float sum[kMaxBlockFrames];
+    std::fill(sum, sum + frames, 0.0f);
+    for (unsigned i = 0; i < mNumDelays; i++) {
+      const float *row = mBlock + i * stride;
+      for (int n = 0; n < frames; n++) {
+        sum[n] += row[n];
+      }
+    }
+    float scale = 2.0f / mNumDelays;
+    for (int n = 0; n < frames; n++) {
+      sum[n] *= scale;
+    }
+    for (unsigned i = 0; i < mNumDelays; i++) {
+      float *row = mBlock + i * stride;
+      for (int n = 0; n < frames; n++) {
+        row[n] -= sum[n];
+      }
+    }
+  }
+}
+
+void FDNReverb::process(const float *in, float *const *outs, int frames) {
+  if (mNumDelays == 0) {
+    return;
+  }
+  size_t stride = alignUp(size_t(mBlockFrames));
+  for (int start = 0; start < frames; start += mBlockFrames) {
+    int count = std::min(mBlockFrames, frames - start);
+
+    // Read the oldest samples of every line, which are at the write position
+    for (unsigned i = 0; i < mNumDelays; i++) {
+      const float *line = mLines[i];
+      float *row = mBlock + i * stride;
+      unsigned pos = mPositions[i];
+      unsigned first = std::min(unsigned(count), mLengths[i] - pos);
+      std::copy(line + pos, line + pos + first, row);
+      std::copy(line, line + (count - first), row + first);
+      if (i < mNumOutputs && outs[i]) {
+        float *out = outs[i] + start;
+        for (int n = 0; n < count; n++) {
+          out[n] += row[n] * mGain;
+        }
+      }
+      // Damping and decay
+      float a = mDamping;
+      float b = (1.0f - mDamping) * mFeedback[i];
+      float state = mFilterState[i];
+      for (int n = 0; n < count; n++) {
+        state = b * row[n] + a * state;
+        row[n] = state;
+      }
+      mFilterState[i] = state;
+    }
+
+    mixBlock(count);
+
+    for (unsigned i = 0; i < mNumDelays; i++) {
+      float *line = mLines[i];
+      float *row = mBlock + i * stride;
+      float g = mInputGains[i];
+      for (int n = 0; n < count; n++) {
+        row[n] += g * in[start + n];
+      }
+      unsigned pos = mPositions[i];
+      unsigned first = std::min(unsigned(count), mLengths[i] - pos);
+      std::copy(row, row + first, line + pos);
+      std::copy(row + first, row + count, line);
+      pos += count;
+      mPositions[i] = pos >= mLengths[i] ? pos - mLengths[i] : pos;
+    }
+  }
+}
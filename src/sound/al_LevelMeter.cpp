@@ -0,0 +1,256 @@
+#include "al/sound/al_LevelMeter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "al/math/al_SIMD.hpp"
+
+using namespace al;
+
+namespace {
+
+// ITU-R BS.1770-4 Annex 2 interpolator, one row per phase
+const float kTruePeakCoefficients[4][12] = {
+    {0.0017089843750f, 0.0109863281250f, -0.0196533203125f, 0.0332031250000f,
+     -0.0594482421875f, 0.1373291015625f, 0.9721679687500f, -0.1022949218750f,
+     0.0476074218750f, -0.0266113281250f, 0.0148925781250f, -0.0083007812500f},
+    {-0.0291748046875f, 0.0292968750000f, -0.0517578125000f, 0.0891113281250f,
+     -0.1665039062500f, 0.4650878906250f, 0.7797851562500f, -0.2003173828125f,
+     0.1015625000000f, -0.0582275390625f, 0.0330810546875f, -0.0189208984375f},
+    {-0.0189208984375f, 0.0330810546875f, -0.0582275390625f, 0.1015625000000f,
+     -0.2003173828125f, 0.7797851562500f, 0.4650878906250f, -0.1665039062500f,
+     0.0891113281250f, -0.0517578125000f, 0.0292968750000f, -0.0291748046875f},
+    {-0.0083007812500f, 0.0148925781250f, -0.0266113281250f, 0.0476074218750f,
+     -0.1022949218750f, 0.9721679687500f, 0.1373291015625f, -0.0594482421875f,
+     0.0332031250000f, -0.0196533203125f, 0.0109863281250f, 0.0017089843750f}};
+
+// Largest absolute value and sum of squares of a buffer
+void bufferStats(const float *x, int frames, float &peak, float &sumSquares) {
+  int i = 0;
+  float maxAbs = 0.0f;
+  float sum = 0.0f;
+#ifdef AL_SIMD_SSE
+  const __m128 signMask = _mm_set1_ps(-0.0f);
+  __m128 maxV = _mm_setzero_ps();
+  __m128 sumV = _mm_setzero_ps();
+  for (; i + 4 <= frames; i += 4) {
+    __m128 v = _mm_loadu_ps(x + i);
+    maxV = _mm_max_ps(maxV, _mm_andnot_ps(signMask, v));
+    sumV = _mm_add_ps(sumV, _mm_mul_ps(v, v));
+  }
+  float lanes[4];
+  _mm_storeu_ps(lanes, maxV);
+  maxAbs = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+  _mm_storeu_ps(lanes, sumV);
+  sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+  for (; i < frames; i++) {
+    maxAbs = std::max(maxAbs, std::abs(x[i]));
+    sum += x[i] * x[i];
+  }
+  peak = maxAbs;
+  sumSquares = sum;
+}
+
+// K-weighting filter of ITU-R BS.1770 for any sample rate
+void kWeighting(double sampleRate, BiQuadBank::Coefficients &shelf,
+                BiQuadBank::Coefficients &highPass) {
+  double K = std::tan(M_PI * 1681.974450955533 / sampleRate);
+  double Q = 0.7071752369554196;
+  double Vh = std::pow(10.0, 3.999843853973347 / 20.0);
+  double Vb = std::pow(Vh, 0.4996667741545416);
+  double a0 = 1.0 + K / Q + K * K;
+  shelf.b0 = float((Vh + Vb * K / Q + K * K) / a0);
+  shelf.b1 = float(2.0 * (K * K - Vh) / a0);
+  shelf.b2 = float((Vh - Vb * K / Q + K * K) / a0);
+  shelf.a1 = float(2.0 * (K * K - 1.0) / a0);
+  shelf.a2 = float((1.0 - K / Q + K * K) / a0);
+
+  K = std::tan(M_PI * 38.13547087602444 / sampleRate);
+  Q = 0.5003270373238773;
+  a0 = 1.0 + K / Q + K * K;
+  highPass.b0 = 1.0f;
+  highPass.b1 = -2.0f;
+  highPass.b2 = 1.0f;
+  highPass.a1 = float(2.0 * (K * K - 1.0) / a0);
+  highPass.a2 = float((1.0 - K / Q + K * K) / a0);
+}
+
+} // namespace
+
+void LevelMeter::configure(unsigned numChannels, double sampleRate) {
+  mNumChannels = numChannels;
+  mSampleRate = sampleRate;
+  mPeak.assign(numChannels, 0.0f);
+  mMeanSquare.assign(numChannels, 0.0f);
+  mTruePeak.assign(numChannels, 0.0f);
+  mHistory.assign(size_t(numChannels) * (kTruePeakTaps - 1), 0.0f);
+  mInterpolated.assign(kBlockFrames, 0.0f);
+  mExtended.assign(kBlockFrames + kTruePeakTaps - 1, 0.0f);
+
+  mKWeighting.configure(numChannels, 2, sampleRate);
+  BiQuadBank::Coefficients shelf, highPass;
+  kWeighting(sampleRate, shelf, highPass);
+  for (unsigned c = 0; c < numChannels; c++) {
+    mKWeighting.setSection(c, 0, shelf);
+    mKWeighting.setSection(c, 1, highPass);
+  }
+  mKWeighting.commit();
+  mWeighted.assign(size_t(numChannels) * kBlockFrames, 0.0f);
+  mWeightedBuffers.resize(numChannels);
+  for (unsigned c = 0; c < numChannels; c++) {
+    mWeightedBuffers[c] = mWeighted.data() + size_t(c) * kBlockFrames;
+  }
+  mFrameEnergy.assign(kBlockFrames, 0.0f);
+  std::fill(mLoudnessBlocks, mLoudnessBlocks + 4, 0.0);
+  mLoudnessIndex = 0;
+  mLoudnessFrames = 0;
+  mLoudnessBlockLength = std::max(1, int(sampleRate * 0.1));
+  mLoudnessEnergy = 0;
+  mFrames = 0;
+
+  mBuffers.assign(numChannels, nullptr);
+  // Size all three slots, so publishing never allocates
+  mSnapshots.forEachSlot([numChannels](LevelMeterSnapshot &slot) {
+    slot.peak.assign(numChannels, 0.0f);
+    slot.rms.assign(numChannels, 0.0f);
+    slot.truePeak.assign(numChannels, 0.0f);
+    slot.loudness = -70.0f;
+    slot.frames = 0;
+  });
+}
+
+void LevelMeter::measureTruePeak(unsigned channel, const float *buffer,
+                                 int frames, float &peak) {
+  const int historyLength = kTruePeakTaps - 1;
+  float *history = mHistory.data() + size_t(channel) * historyLength;
+  float *x = mExtended.data();
+  std::copy(history, history + historyLength, x);
+  std::copy(buffer, buffer + frames, x + historyLength);
+  std::copy(x + frames, x + frames + historyLength, history);
+
+  float *y = mInterpolated.data();
+  peak = 0.0f;
+  for (int phase = 0; phase < 4; phase++) {
+    const float *c = kTruePeakCoefficients[phase];
+    std::fill(y, y + frames, 0.0f);
+    // Loops over frames are independent, so they vectorize
+    for (int tap = 0; tap < kTruePeakTaps; tap++) {
+      const float coefficient = c[kTruePeakTaps - 1 - tap];
+      const float *input = x + tap;
+      for (int n = 0; n < frames; n++) {
+        y[n] += coefficient * input[n];
+      }
+    }
+    float phasePeak, sumSquares;
+    bufferStats(y, frames, phasePeak, sumSquares);
+    peak = std::max(peak, phasePeak);
+  }
+}
+
+void LevelMeter::process(const float *const *buffers, int frames) {
+  if (mNumChannels == 0) {
+    return;
+  }
+  for (int start = 0; start < frames; start += kBlockFrames) {
+    int count = std::min(kBlockFrames, frames - start);
+    float release = std::pow(10.0f, -mPeakRelease * count /
+                                        float(20.0 * mSampleRate));
+    float smoothing =
+        std::exp(-float(count) / std::max(1.0f, float(mRmsTime * mSampleRate)));
+
+    for (unsigned c = 0; c < mNumChannels; c++) {
+      const float *buffer = buffers[c];
+      float *weighted = mWeightedBuffers[c];
+      if (!buffer) {
+        std::fill(weighted, weighted + count, 0.0f);
+        continue;
+      }
+      buffer += start;
+      float peak, sumSquares, truePeak;
+      bufferStats(buffer, count, peak, sumSquares);
+      measureTruePeak(c, buffer, count, truePeak);
+      mPeak[c] = std::max(peak, mPeak[c] * release);
+      mTruePeak[c] = std::max(std::max(truePeak, peak), mTruePeak[c] * release);
+      mMeanSquare[c] = smoothing * mMeanSquare[c] +
+                       (1.0f - smoothing) * sumSquares / float(count);
+      if (mLoudnessEnabled) {
+        std::copy(buffer, buffer + count, weighted);
+      }
+    }
+
+    if (mLoudnessEnabled) {
+      mKWeighting.process(mWeightedBuffers.data(), count);
+      std::fill(mFrameEnergy.begin(), mFrameEnergy.begin() + count, 0.0f);
+      for (unsigned c = 0; c < mNumChannels; c++) {
+        const float *weighted = mWeightedBuffers[c];
+        for (int n = 0; n < count; n++) {
+          mFrameEnergy[n] += weighted[n] * weighted[n];
+        }
+      }
+      for (int n = 0; n < count; n++) {
+        mLoudnessEnergy += mFrameEnergy[n];
+        if (++mLoudnessFrames == mLoudnessBlockLength) {
+          mLoudnessBlocks[mLoudnessIndex] = mLoudnessEnergy;
+          mLoudnessIndex = (mLoudnessIndex + 1) & 3;
+          mLoudnessEnergy = 0;
+          mLoudnessFrames = 0;
+        }
+      }
+    }
+    mFrames += uint64_t(count);
+  }
+
+  LevelMeterSnapshot &snapshot = mSnapshots.back();
+  for (unsigned c = 0; c < mNumChannels; c++) {
+    snapshot.peak[c] = mPeak[c];
+    snapshot.rms[c] = std::sqrt(mMeanSquare[c]);
+    snapshot.truePeak[c] = mTruePeak[c];
+  }
+  snapshot.loudness = -70.0f;
+  if (mLoudnessEnabled) {
+    double energy = (mLoudnessBlocks[0] + mLoudnessBlocks[1] +
+                     mLoudnessBlocks[2] + mLoudnessBlocks[3]) /
+                    (4.0 * mLoudnessBlockLength);
+    if (energy > 0) {
+      snapshot.loudness =
+          std::max(-70.0f, float(-0.691 + 10.0 * std::log10(energy)));
+    }
+  }
+  snapshot.frames = mFrames;
+  mSnapshots.publish();
+}
+
+void LevelMeter::processOutputs(AudioIOData &io) {
+  unsigned channelsOut = io.channelsOut();
+  for (unsigned c = 0; c < mNumChannels; c++) {
+    mBuffers[c] = c < channelsOut ? io.outBuffer(c) : nullptr;
+  }
+  process(mBuffers.data(), int(io.framesPerBuffer()));
+}
+
+size_t LevelMeter::send(osc::Send &sender, const std::string &prefix) {
+  update();
+  const LevelMeterSnapshot &s = snapshot();
+  sender.beginBundle();
+  sender.beginMessage(prefix + "/peak");
+  for (float v : s.peak) {
+    sender << v;
+  }
+  sender.endMessage();
+  sender.beginMessage(prefix + "/rms");
+  for (float v : s.rms) {
+    sender << v;
+  }
+  sender.endMessage();
+  sender.beginMessage(prefix + "/truePeak");
+  for (float v : s.truePeak) {
+    sender << v;
+  }
+  sender.endMessage();
+  sender.beginMessage(prefix + "/loudness");
+  sender << s.loudness;
+  sender.endMessage();
+  sender.endBundle();
+  return sender.send();
+}
@@ -0,0 +1,176 @@
+#include "al/spatial/al_BVH.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+using namespace al;
+
+void BVH::build(const std::vector<Vec3d> &mins,
+                const std::vector<Vec3d> &maxs) {
+  assert(mins.size() == maxs.size());
+  clear();
+  if (mins.empty()) {
+    return;
+  }
+  mItemMin = mins;
+  mItemMax = maxs;
+  mItems.resize(mins.size());
+  mItemLeaf.resize(mins.size());
+  mCentroids.resize(mins.size());
+  for (size_t i = 0; i < mins.size(); i++) {
+    mItems[i] = i;
+    mCentroids[i] = (mins[i] + maxs[i]) * 0.5;
+  }
+  mNodes.reserve(2 * mins.size() / kLeafSize + 1);
+  buildNode(0, uint32_t(mins.size()), -1);
+  mCentroids.clear();
+  mCentroids.shrink_to_fit();
+}
+
+void BVH::clear() {
+  mNodes.clear();
+  mItems.clear();
+  mItemLeaf.clear();
+  mItemMin.clear();
+  mItemMax.clear();
+}
+
+int32_t BVH::buildNode(uint32_t first, uint32_t count, int32_t parent) {
+  int32_t index = int32_t(mNodes.size());
+  mNodes.push_back(Node());
+  mNodes[index].parent = parent;
+  mNodes[index].first = first;
+  mNodes[index].count = 0;
+  if (count <= uint32_t(kLeafSize)) {
+    mNodes[index].count = count;
+    for (uint32_t i = first; i < first + count; i++) {
+      mItemLeaf[mItems[i]] = index;
+    }
+    updateLeafBounds(index);
+    return index;
+  }
+
+  // Split at the median centroid along the axis where centroids spread most
+  Vec3d cmin = mCentroids[mItems[first]];
+  Vec3d cmax = cmin;
+  for (uint32_t i = first + 1; i < first + count; i++) {
+    cmin = min(cmin, mCentroids[mItems[i]]);
+    cmax = max(cmax, mCentroids[mItems[i]]);
+  }
+  Vec3d extent = cmax - cmin;
+  int axis = 0;
+  if (extent[1] > extent[axis]) {
+    axis = 1;
+  }
+  if (extent[2] > extent[axis]) {
+    axis = 2;
+  }
+  uint32_t half = count / 2;
+  std::nth_element(mItems.begin() + first, mItems.begin() + first + half,
+                   mItems.begin() + first + count,
+                   [&](size_t a, size_t b) {
+                     return mCentroids[a][axis] < mCentroids[b][axis];
+                   });
+
+  // mNodes may reallocate while building the children
+  int32_t left = buildNode(first, half, index);
+  int32_t right = buildNode(first + half, count - half, index);
+  Node &node = mNodes[index];
+  node.left = left;
+  node.right = right;
+  node.min = min(mNodes[left].min, mNodes[right].min);
+  node.max = max(mNodes[left].max, mNodes[right].max);
+  return index;
+}
+
+void BVH::updateLeafBounds(int32_t index) {
+  Node &node = mNodes[index];
+  node.min = mItemMin[mItems[node.first]];
+  node.max = mItemMax[mItems[node.first]];
+  for (uint32_t i = node.first + 1; i < node.first + node.count; i++) {
+    node.min = min(node.min, mItemMin[mItems[i]]);
+    node.max = max(node.max, mItemMax[mItems[i]]);
+  }
+}
+
+void BVH::refit(size_t item, const Vec3d &min, const Vec3d &max) {
+  assert(item < mItemLeaf.size());
+  mItemMin[item] = min;
+  mItemMax[item] = max;
+  int32_t index = mItemLeaf[item];
+  updateLeafBounds(index);
+  index = mNodes[index].parent;
+  while (index >= 0) {
+    Node &node = mNodes[index];
+    Vec3d newMin = al::min(mNodes[node.left].min, mNodes[node.right].min);
+    Vec3d newMax = al::max(mNodes[node.left].max, mNodes[node.right].max);
+    if (newMin == node.min && newMax == node.max) {
+      break; // Ancestors are unchanged
+    }
+    node.min = newMin;
+    node.max = newMax;
+    index = node.parent;
+  }
+}
+
+bool BVH::bounds(Vec3d &min, Vec3d &max) const {
+  if (mNodes.empty()) {
+    return false;
+  }
+  min = mNodes[0].min;
+  max = mNodes[0].max;
+  return true;
+}
+
+void BVH::query(const Rayd &ray, std::vector<size_t> &items) const {
+  items.clear();
+  if (mNodes.empty()) {
+    return;
+  }
+  Vec3d invDir(1.0 / ray.d.x, 1.0 / ray.d.y, 1.0 / ray.d.z);
+  int32_t stack[64];
+  int stackSize = 0;
+  stack[stackSize++] = 0;
+  while (stackSize > 0) {
+    const Node &node = mNodes[stack[--stackSize]];
+    if (intersectBox(ray.o, invDir, node.min, node.max) < 0) {
+      continue;
+    }
+    if (node.leaf()) {
+      for (uint32_t i = node.first; i < node.first + node.count; i++) {
+        if (intersectBox(ray.o, invDir, mItemMin[mItems[i]],
+                         mItemMax[mItems[i]]) >= 0) {
+          items.push_back(mItems[i]);
+        }
+      }
+    } else {
+      stack[stackSize++] = node.right;
+      stack[stackSize++] = node.left;
+    }
+  }
+}
+
+double BVH::intersectBox(const Vec3d &origin, const Vec3d &invDir,
+                         const Vec3d &min, const Vec3d &max) {
+  double tmin = 0;
+  double tmax = std::numeric_limits<double>::infinity();
+  for (int i = 0; i < 3; i++) {
+    double t1 = (min[i] - origin[i]) * invDir[i];
+    double t2 = (max[i] - origin[i]) * invDir[i];
+    if (t1 > t2) {
+      std::swap(t1, t2);
+    }
+    // Comparisons written so NaN from an axis parallel ray is ignored
+    if (t1 > tmin) {
+      tmin = t1;
+    }
+    if (t2 < tmax) {
+      tmax = t2;
+    }
+    if (tmin > tmax) {
+      return -1.0;
+    }
+  }
+  return tmin;
+}
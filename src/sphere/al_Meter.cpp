@@ -7,43 +7,54 @@ void Meter::init(const Speakers &sl) {
   mSl = sl;
 }
 
+void Meter::init(const Speakers &sl, unsigned numChannels, double sampleRate) {
+  init(sl);
+  mLevels.configure(numChannels, sampleRate);
+}
+
 void Meter::processSound(AudioIOData &io) {
+  if (mConfigureRequested.load(std::memory_order_acquire)) {
+    return; // Waiting for the reader thread to configure the meter
+  }
+  if (mLevels.channels() != io.channelsOut() ||
+      mLevels.sampleRate() != io.framesPerSecond()) {
+    mRequestedChannels = io.channelsOut();
+    mRequestedSampleRate = io.framesPerSecond();
+    mConfigureRequested.store(true, std::memory_order_release);
+    return;
+  }
+  mLevels.processOutputs(io);
+}
 
-  if (tempValues.size() != io.channelsOut()) {
-    tempValues.resize(io.channelsOut());
-    values.resize(io.channelsOut());
+void Meter::applyConfiguration() {
+  if (mConfigureRequested.load(std::memory_order_acquire)) {
+    mLevels.configure(mRequestedChannels, mRequestedSampleRate);
     std::cout << "Resizing Meter buffers" << std::endl;
+    mConfigureRequested.store(false, std::memory_order_release);
   }
-  for (int i = 0; i < io.channelsOut(); i++) {
-    tempValues[i] = FLT_MIN;
-    auto *outBuf = io.outBuffer(i);
-    auto fpb = io.framesPerBuffer();
-    for (int samp = 0; samp < fpb; samp++) {
-      float val = fabs(*outBuf);
-      if (tempValues[i] < val) {
-        tempValues[i] = val;
-      }
-      outBuf++;
-    }
-    if (tempValues[i] == 0) {
-      tempValues[i] = 0.01;
-    } else {
-      float db = 20.0 * log10(tempValues[i]);
-      if (db < -60) {
-        tempValues[i] = 0.01;
-      } else {
-        tempValues[i] = 0.01 + 0.005 * (60 + db);
-      }
-    }
-    if (values[i] > tempValues[i]) {
-      values[i] = values[i] - 0.05 * (values[i] - tempValues[i]);
+}
+
+void Meter::updateValues() {
+  applyConfiguration();
+  if (!mLevels.update()) {
+    return;
+  }
+  const std::vector<float> &peaks = mLevels.snapshot().peak;
+  values.resize(peaks.size());
+  for (size_t i = 0; i < peaks.size(); i++) {
+    float db = peaks[i] > 0 ? 20.0 * log10(peaks[i]) : -120.0f;
+    float value = db < -60 ? 0.01f : 0.01f + 0.005f * (60 + db);
+    // Rise immediately, fall slowly
+    if (values[i] > value) {
+      values[i] -= 0.05f * (values[i] - value);
     } else {
-      values[i] = tempValues[i];
+      values[i] = value;
     }
   }
 }
 
 void Meter::draw(Graphics &g) {
+  updateValues();
   g.polygonLine();
   int index = 0;
   auto spkrIt = mSl.begin();
@@ -69,8 +80,7 @@ void Meter::draw(Graphics &g) {
 }
 
 void Meter::setMeterValues(float *newValues, size_t count) {
-  if (tempValues.size() != count) {
-    tempValues.resize(count);
+  if (values.size() != count) {
     values.resize(count);
     std::cout << "Resizing Meter buffers" << std::endl;
   }
@@ -1,5 +1,14 @@
 #include "al/sphere/al_PerProjection.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include "al/io/al_File.hpp"
+#include "al/types/al_Conversion.hpp"
+
 al::bhlw al::viewport_for_cubemap_face(int idx) {
   /*
     _________
@@ -33,10 +42,156 @@ al::bhlw al::viewport_for_cubemap_face(int idx) {
   return v;
 }
 
+namespace {
+
+const char warpblend_cache_magic[4] = {'A', 'L', 'W', 'B'};
+const uint32_t warpblend_cache_version = 1;
+const uint32_t warpblend_cache_half_float = 1;
+const size_t warpblend_cache_alignment = 64;
+
+// FNV-1a over 64 bit words, data size is always a multiple of 8
+uint64_t warpblend_checksum(const char *data, size_t size) {
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i + 8 <= size; i += 8) {
+    uint64_t word;
+    std::memcpy(&word, data + i, 8);
+    hash ^= word;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+void to_half_float(al::ProjectionViewport &vp) {
+  auto *values = reinterpret_cast<const float *>(vp.warp_and_blend_data.data());
+  size_t count = vp.warp_and_blend_data.size() * 4;
+  vp.warp_and_blend_data_half.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    vp.warp_and_blend_data_half[i] = al::floatToHalf(values[i]);
+  }
+  std::vector<al::Vec4f>().swap(vp.warp_and_blend_data);
+}
+
+template <typename T> void cache_append(std::vector<char> &buf, const T &v) {
+  const char *p = reinterpret_cast<const char *>(&v);
+  buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+void cache_append(std::vector<char> &buf, const std::string &s) {
+  cache_append(buf, uint32_t(s.size()));
+  buf.insert(buf.end(), s.begin(), s.end());
+}
+
+struct CacheReader {
+  const char *data;
+  size_t size;
+  size_t pos;
+
+  template <typename T> bool read(T &v) {
+    if (pos + sizeof(T) > size) {
+      return false;
+    }
+    std::memcpy(&v, data + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+  }
+
+  bool read(std::string &s) {
+    uint32_t length;
+    if (!read(length) || pos + length > size) {
+      return false;
+    }
+    s.assign(data + pos, length);
+    pos += length;
+    return true;
+  }
+};
+
+// Viewport data as stored in the cache. Only one of the arrays is filled
+const char *cache_block_data(const al::ProjectionViewport &vp) {
+  if (vp.warp_and_blend_data_half.size() > 0) {
+    return reinterpret_cast<const char *>(vp.warp_and_blend_data_half.data());
+  }
+  return reinterpret_cast<const char *>(vp.warp_and_blend_data.data());
+}
+
+uint64_t cache_block_size(const al::ProjectionViewport &vp) {
+  return vp.warp_and_blend_data_half.size() * sizeof(uint16_t) +
+         vp.warp_and_blend_data.size() * sizeof(al::Vec4f);
+}
+
+void cache_append_record(std::vector<char> &buf,
+                         const al::ProjectionViewport &vp, uint64_t offset,
+                         uint64_t checksum) {
+  cache_append(buf, vp.id);
+  cache_append(buf, vp.b);
+  cache_append(buf, vp.h);
+  cache_append(buf, vp.l);
+  cache_append(buf, vp.w);
+  cache_append(buf, vp.active);
+  cache_append(buf, vp.filepath);
+  cache_append(buf, vp.width);
+  cache_append(buf, vp.height);
+  cache_append(buf, double(al::File::modificationTime(vp.filepath.c_str())));
+  cache_append(buf, offset);
+  cache_append(buf, cache_block_size(vp));
+  cache_append(buf, checksum);
+}
+
+// Size of a cache record with an empty file path
+const size_t cache_min_record_size =
+    sizeof(al::ProjectionViewport::id) + 4 * sizeof(float) +
+    sizeof(al::ProjectionViewport::active) + sizeof(uint32_t) +
+    sizeof(al::ProjectionViewport::width) +
+    sizeof(al::ProjectionViewport::height) + sizeof(double) +
+    3 * sizeof(uint64_t);
+
+// Calls f(i) for i in [0, count) on at most one thread per core
+template <typename F> void for_each_parallel(size_t count, F f) {
+  size_t num_threads =
+      std::min<size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+  std::atomic<size_t> next{0};
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&]() {
+      for (size_t i = next++; i < count; i = next++) {
+        f(i);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+} // namespace
+
+al::Vec4f al::ProjectionViewport::warp_and_blend(size_t i) const {
+  if (i < warp_and_blend_data.size()) {
+    return warp_and_blend_data[i];
+  }
+  if (4 * i + 3 < warp_and_blend_data_half.size()) {
+    const uint16_t *h = warp_and_blend_data_half.data() + 4 * i;
+    return Vec4f(halfToFloat(h[0]), halfToFloat(h[1]), halfToFloat(h[2]),
+                 halfToFloat(h[3]));
+  }
+  return Vec4f(0, 0, 0, 0);
+}
+
 void al::WarpBlendData::load_allosphere_calibration(const char *path,
                                                     const char *hostname) {
-  std::ifstream config(
-      (std::string(path) + "/" + std::string(hostname) + ".txt").c_str());
+  std::string config_path =
+      std::string(path) + "/" + std::string(hostname) + ".txt";
+  std::string cache_path;
+  if (cache_directory.size() > 0) {
+    cache_path = File::conformDirectory(cache_directory) +
+                 std::string(hostname) + ".warpblend";
+    if (read_calibration_cache(cache_path, config_path)) {
+      return;
+    }
+  }
+  viewports.clear();
+
+  std::ifstream config(config_path.c_str());
 
   std::string id;
   if (config >> id) {
@@ -82,14 +237,16 @@ void al::WarpBlendData::load_allosphere_calibration(const char *path,
   // std::cout << "loaded " << viewports.size() << " viewports from " << path
   // << "/" << hostname << ".txt" << std::endl;
 
-  // Load warp data
-  for (size_t i = 0; i < viewports.size(); i++) {
+  // Load warp data, viewports in parallel
+  std::atomic<bool> all_loaded{true};
+  for_each_parallel(viewports.size(), [this, &all_loaded](size_t i) {
     ProjectionViewport &vp = viewports[i];
 
     std::ifstream file(vp.filepath, std::ios::in | std::ios::binary);
     if (!file) {
       std::cout << "could not open file: " << vp.filepath << std::endl;
-      continue;
+      all_loaded = false;
+      return;
     }
 
     vp.warp_and_blend_data.resize(vp.width * vp.height);
@@ -97,12 +254,176 @@ void al::WarpBlendData::load_allosphere_calibration(const char *path,
       auto *data = reinterpret_cast<char *>(vp.warp_and_blend_data.data());
       file.read(data, sizeof(Vec4f) * vp.width * vp.height);
     }
+    if (!file) {
+      all_loaded = false;
+    }
     file.close();
+    if (keep_half_float) {
+      to_half_float(vp);
+    }
     // std::cout << "loaded warp/blend data from " << vp.filepath <<
     // std::endl;
+  });
+
+  if (cache_path.size() > 0 && viewports.size() > 0 && all_loaded) {
+    write_calibration_cache(cache_path, config_path);
   }
 }
 
+bool al::WarpBlendData::read_calibration_cache(const std::string &cache_path,
+                                               const std::string &config_path) {
+  MappedFile cache;
+  if (!cache.open(cache_path)) {
+    return false;
+  }
+  CacheReader reader{cache.data(), cache.size(), 0};
+  char magic[4];
+  uint32_t version, count, flags;
+  double config_modified;
+  if (!reader.read(magic) ||
+      std::memcmp(magic, warpblend_cache_magic, 4) != 0 ||
+      !reader.read(version) || version != warpblend_cache_version ||
+      !reader.read(count) || !reader.read(flags) ||
+      !reader.read(config_modified)) {
+    return false;
+  }
+  bool half_float = (flags & warpblend_cache_half_float) != 0;
+  if (half_float != keep_half_float ||
+      config_modified != File::modificationTime(config_path.c_str())) {
+    return false;
+  }
+
+  struct DataBlock {
+    uint64_t offset, size, checksum;
+  };
+  // Every record needs at least cache_min_record_size bytes, so a corrupt
+  // count is rejected before allocating for it
+  if (uint64_t(count) * cache_min_record_size > cache.size()) {
+    return false;
+  }
+  std::vector<ProjectionViewport> cached(count);
+  std::vector<DataBlock> blocks(count);
+  for (uint32_t i = 0; i < count; i++) {
+    ProjectionViewport &vp = cached[i];
+    DataBlock &block = blocks[i];
+    double data_modified;
+    if (!reader.read(vp.id) || !reader.read(vp.b) || !reader.read(vp.h) ||
+        !reader.read(vp.l) || !reader.read(vp.w) || !reader.read(vp.active) ||
+        !reader.read(vp.filepath) || !reader.read(vp.width) ||
+        !reader.read(vp.height) || !reader.read(data_modified) ||
+        !reader.read(block.offset) || !reader.read(block.size) ||
+        !reader.read(block.checksum)) {
+      return false;
+    }
+    size_t expected_size = size_t(vp.width) * vp.height *
+                           (half_float ? 4 * sizeof(uint16_t) : sizeof(Vec4f));
+    if (block.size != expected_size ||
+        block.offset + block.size > cache.size() ||
+        data_modified != File::modificationTime(vp.filepath.c_str())) {
+      return false;
+    }
+  }
+
+  // Verify and copy data, viewports in parallel
+  std::atomic<bool> valid{true};
+  for_each_parallel(count, [&](size_t i) {
+    const char *data = cache.data() + blocks[i].offset;
+    if (warpblend_checksum(data, blocks[i].size) != blocks[i].checksum) {
+      valid = false;
+      return;
+    }
+    ProjectionViewport &vp = cached[i];
+    if (half_float) {
+      vp.warp_and_blend_data_half.resize(blocks[i].size / sizeof(uint16_t));
+      std::memcpy(vp.warp_and_blend_data_half.data(), data, blocks[i].size);
+    } else {
+      vp.warp_and_blend_data.resize(blocks[i].size / sizeof(Vec4f));
+      std::memcpy(vp.warp_and_blend_data.data(), data, blocks[i].size);
+    }
+  });
+  if (!valid) {
+    std::cout << "checksum mismatch in calibration cache: " << cache_path
+              << std::endl;
+    return false;
+  }
+  viewports = std::move(cached);
+  return true;
+}
+
+bool al::WarpBlendData::write_calibration_cache(
+    const std::string &cache_path, const std::string &config_path) {
+  std::vector<char> header;
+  header.insert(header.end(), warpblend_cache_magic,
+                warpblend_cache_magic + 4);
+  cache_append(header, warpblend_cache_version);
+  cache_append(header, uint32_t(viewports.size()));
+  cache_append(header,
+               uint32_t(keep_half_float ? warpblend_cache_half_float : 0));
+  cache_append(header, double(File::modificationTime(config_path.c_str())));
+
+  std::vector<uint64_t> checksums(viewports.size());
+  std::vector<std::thread> hashers;
+  for (size_t i = 0; i < viewports.size(); i++) {
+    hashers.emplace_back([this, i, &checksums]() {
+      checksums[i] = warpblend_checksum(cache_block_data(viewports[i]),
+                                        cache_block_size(viewports[i]));
+    });
+  }
+  for (auto &hasher : hashers) {
+    hasher.join();
+  }
+
+  // Records precede the data. Their size does not depend on the offsets, so
+  // write them once to find where the data starts
+  std::vector<char> records;
+  for (const auto &vp : viewports) {
+    cache_append_record(records, vp, 0, 0);
+  }
+  std::vector<uint64_t> block_offsets;
+  uint64_t offset = header.size() + records.size();
+  records.clear();
+  for (size_t i = 0; i < viewports.size(); i++) {
+    offset = (offset + warpblend_cache_alignment - 1) /
+             warpblend_cache_alignment * warpblend_cache_alignment;
+    block_offsets.push_back(offset);
+    cache_append_record(records, viewports[i], offset, checksums[i]);
+    offset += cache_block_size(viewports[i]);
+  }
+  header.insert(header.end(), records.begin(), records.end());
+
+  // Write to temporary file and rename, another renderer might have the
+  // current cache mapped
+  std::string temp_path = cache_path + ".tmp";
+  std::ofstream file(temp_path, std::ios::out | std::ios::binary);
+  if (!file) {
+    std::cout << "could not write calibration cache: " << temp_path
+              << std::endl;
+    return false;
+  }
+  file.write(header.data(), header.size());
+  uint64_t position = header.size();
+  for (size_t i = 0; i < viewports.size(); i++) {
+    std::vector<char> padding(size_t(block_offsets[i] - position), 0);
+    file.write(padding.data(), padding.size());
+    file.write(cache_block_data(viewports[i]),
+               cache_block_size(viewports[i]));
+    position = block_offsets[i] + cache_block_size(viewports[i]);
+  }
+  file.close();
+  if (!file) {
+    std::remove(temp_path.c_str());
+    return false;
+  }
+  if (std::rename(temp_path.c_str(), cache_path.c_str()) != 0) {
+    std::remove(cache_path.c_str());
+    if (std::rename(temp_path.c_str(), cache_path.c_str()) != 0) {
+      std::remove(temp_path.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
 void al::WarpBlendData::load_desktop_mode_calibration() {
   viewports.resize(6);
   for (int i = 0; i < 6; i += 1) {
@@ -121,6 +442,7 @@ void al::WarpBlendData::load_desktop_mode_calibration() {
   for (size_t i = 0; i < viewports.size(); i++) {
     auto &vp = viewports[i];
     vp.warp_and_blend_data.clear();
+    vp.warp_and_blend_data_half.clear();
   }
 }
 
@@ -183,9 +505,10 @@ void al::PerProjectionRender::init(const al::Lens &lens) {
     // First determine the central direction.
     Vec3f direction(0, 0, 0);
     for (int i = 0; i < vp.width * vp.height; i++) {
-      direction.x += vp.warp_and_blend_data[i].x;
-      direction.y += vp.warp_and_blend_data[i].y;
-      direction.z += vp.warp_and_blend_data[i].z;
+      Vec4f warp_and_blend = vp.warp_and_blend(i);
+      direction.x += warp_and_blend.x;
+      direction.y += warp_and_blend.y;
+      direction.z += warp_and_blend.z;
     }
     direction = direction.normalize();
 #if 0
@@ -232,9 +555,17 @@ void al::PerProjectionRender::init(const al::Lens &lens) {
     info.tanFovDiv2 = tan(fov / 2.0f);
 
     info.warp_texture.reset(new Texture());
-    info.warp_texture->create2D((unsigned int)vp.width, (unsigned int)vp.height,
-                                GL_RGBA32F, GL_RGBA, GL_FLOAT);
-    info.warp_texture->submit(vp.warp_and_blend_data.data());
+    if (vp.warp_and_blend_data_half.size() > 0) {
+      info.warp_texture->create2D((unsigned int)vp.width,
+                                  (unsigned int)vp.height, GL_RGBA16F, GL_RGBA,
+                                  GL_HALF_FLOAT);
+      info.warp_texture->submit(vp.warp_and_blend_data_half.data());
+    } else {
+      info.warp_texture->create2D((unsigned int)vp.width,
+                                  (unsigned int)vp.height, GL_RGBA32F, GL_RGBA,
+                                  GL_FLOAT);
+      info.warp_texture->submit(vp.warp_and_blend_data.data());
+    }
   }
 
   rbo_.create(res_, res_);
@@ -270,11 +601,10 @@ void al::PerProjectionRender::load_calibration_data(const char *path,
 
 void al::PerProjectionRender::load_and_init_as_desktop_config(
     const al::Lens &lens) {
-  static bool initialized = false;
-  if (initialized) {
+  if (desktop_config_initialized) {
     return;
   }
-  initialized = true;
+  desktop_config_initialized = true;
   // add six projection infos that will serve as each face of cubemap
   // https://www.khronos.org/opengl/wiki/Cubemap_Texture
   // 0: GL_TEXTURE_CUBE_MAP_POSITIVE_X
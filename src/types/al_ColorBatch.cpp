@@ -0,0 +1,512 @@
+#include "al/types/al_ColorBatch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "al/math/al_Constants.hpp"
+#include "al/math/al_SIMD.hpp"
+
+using namespace al;
+
+namespace {
+
+// 4 x float values with the operations the kernels need. The kernels are
+// written once against these and compile to SSE2, NEON or scalar code.
+#if defined(AL_SIMD_SSE2)
+
+typedef __m128 F4;
+typedef __m128i I4;
+typedef __m128 M4;
+
+inline F4 load(const float *p) { return _mm_loadu_ps(p); }
+inline void store(float *p, F4 a) { _mm_storeu_ps(p, a); }
+inline F4 set(float x) { return _mm_set1_ps(x); }
+inline F4 add(F4 a, F4 b) { return _mm_add_ps(a, b); }
+inline F4 sub(F4 a, F4 b) { return _mm_sub_ps(a, b); }
+inline F4 mul(F4 a, F4 b) { return _mm_mul_ps(a, b); }
+inline F4 div(F4 a, F4 b) { return _mm_div_ps(a, b); }
+inline F4 sqrt(F4 a) { return _mm_sqrt_ps(a); }
+inline M4 less(F4 a, F4 b) { return _mm_cmplt_ps(a, b); }
+inline M4 greater(F4 a, F4 b) { return _mm_cmpgt_ps(a, b); }
+inline F4 select(M4 m, F4 a, F4 b) {
+  return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+inline I4 roundToInt(F4 a) { return _mm_cvtps_epi32(a); }
+inline F4 toFloat(I4 a) { return _mm_cvtepi32_ps(a); }
+inline I4 bits(F4 a) { return _mm_castps_si128(a); }
+inline F4 fromBits(I4 a) { return _mm_castsi128_ps(a); }
+inline I4 iset(int x) { return _mm_set1_epi32(x); }
+inline I4 iadd(I4 a, I4 b) { return _mm_add_epi32(a, b); }
+inline I4 iand(I4 a, I4 b) { return _mm_and_si128(a, b); }
+inline I4 ior(I4 a, I4 b) { return _mm_or_si128(a, b); }
+template <int N> I4 shiftLeft(I4 a) { return _mm_slli_epi32(a, N); }
+template <int N> I4 shiftRight(I4 a) { return _mm_srli_epi32(a, N); }
+inline M4 bitSet(I4 a, int bit) {
+  return _mm_castsi128_ps(_mm_cmpeq_epi32(iand(a, iset(bit)), iset(bit)));
+}
+
+#elif defined(AL_SIMD_NEON) && defined(__aarch64__)
+
+typedef float32x4_t F4;
+typedef int32x4_t I4;
+typedef uint32x4_t M4;
+
+inline F4 load(const float *p) { return vld1q_f32(p); }
+inline void store(float *p, F4 a) { vst1q_f32(p, a); }
+inline F4 set(float x) { return vdupq_n_f32(x); }
+inline F4 add(F4 a, F4 b) { return vaddq_f32(a, b); }
+inline F4 sub(F4 a, F4 b) { return vsubq_f32(a, b); }
+inline F4 mul(F4 a, F4 b) { return vmulq_f32(a, b); }
+inline F4 div(F4 a, F4 b) { return vdivq_f32(a, b); }
+inline F4 sqrt(F4 a) { return vsqrtq_f32(a); }
+inline M4 less(F4 a, F4 b) { return vcltq_f32(a, b); }
+inline M4 greater(F4 a, F4 b) { return vcgtq_f32(a, b); }
+inline F4 select(M4 m, F4 a, F4 b) { return vbslq_f32(m, a, b); }
+inline I4 roundToInt(F4 a) { return vcvtnq_s32_f32(a); }
+inline F4 toFloat(I4 a) { return vcvtq_f32_s32(a); }
+inline I4 bits(F4 a) { return vreinterpretq_s32_f32(a); }
+inline F4 fromBits(I4 a) { return vreinterpretq_f32_s32(a); }
+inline I4 iset(int x) { return vdupq_n_s32(x); }
+inline I4 iadd(I4 a, I4 b) { return vaddq_s32(a, b); }
+inline I4 iand(I4 a, I4 b) { return vandq_s32(a, b); }
+inline I4 ior(I4 a, I4 b) { return vorrq_s32(a, b); }
+template <int N> I4 shiftLeft(I4 a) { return vshlq_n_s32(a, N); }
+template <int N> I4 shiftRight(I4 a) {
+  return vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(a), N));
+}
+inline M4 bitSet(I4 a, int bit) { return vtstq_s32(a, iset(bit)); }
+
+#else
+
+struct F4 {
+  float v[4];
+};
+struct I4 {
+  int32_t v[4];
+};
+struct M4 {
+  bool v[4];
+};
+
+#define AL_LANES(expr)                                                         \
+  for (int k = 0; k < 4; ++k) {                                                \
+    r.v[k] = expr;                                                             \
+  }                                                                            \
+  return r
+
+inline F4 load(const float *p) {
+  F4 r;
+  AL_LANES(p[k]);
+}
+inline void store(float *p, F4 a) { std::memcpy(p, a.v, sizeof(a.v)); }
+inline F4 set(float x) {
+  F4 r;
+  AL_LANES(x);
+}
+inline F4 add(F4 a, F4 b) {
+  F4 r;
+  AL_LANES(a.v[k] + b.v[k]);
+}
+inline F4 sub(F4 a, F4 b) {
+  F4 r;
+  AL_LANES(a.v[k] - b.v[k]);
+}
+inline F4 mul(F4 a, F4 b) {
+  F4 r;
+  AL_LANES(a.v[k] * b.v[k]);
+}
+inline F4 div(F4 a, F4 b) {
+  F4 r;
+  AL_LANES(a.v[k] / b.v[k]);
+}
+inline F4 sqrt(F4 a) {
+  F4 r;
+  AL_LANES(std::sqrt(a.v[k]));
+}
+inline M4 less(F4 a, F4 b) {
+  M4 r;
+  AL_LANES(a.v[k] < b.v[k]);
+}
+inline M4 greater(F4 a, F4 b) {
+  M4 r;
+  AL_LANES(a.v[k] > b.v[k]);
+}
+inline F4 select(M4 m, F4 a, F4 b) {
+  F4 r;
+  AL_LANES(m.v[k] ? a.v[k] : b.v[k]);
+}
+inline I4 roundToInt(F4 a) {
+  I4 r;
+  AL_LANES(int32_t(std::lrint(a.v[k])));
+}
+inline F4 toFloat(I4 a) {
+  F4 r;
+  AL_LANES(float(a.v[k]));
+}
+inline I4 bits(F4 a) {
+  I4 r;
+  std::memcpy(r.v, a.v, sizeof(r.v));
+  return r;
+}
+inline F4 fromBits(I4 a) {
+  F4 r;
+  std::memcpy(r.v, a.v, sizeof(r.v));
+  return r;
+}
+inline I4 iset(int x) {
+  I4 r;
+  AL_LANES(x);
+}
+inline I4 iadd(I4 a, I4 b) {
+  I4 r;
+  AL_LANES(a.v[k] + b.v[k]);
+}
+inline I4 iand(I4 a, I4 b) {
+  I4 r;
+  AL_LANES(a.v[k] & b.v[k]);
+}
+inline I4 ior(I4 a, I4 b) {
+  I4 r;
+  AL_LANES(a.v[k] | b.v[k]);
+}
+template <int N> I4 shiftLeft(I4 a) {
+  I4 r;
+  AL_LANES(int32_t(uint32_t(a.v[k]) << N));
+}
+template <int N> I4 shiftRight(I4 a) {
+  I4 r;
+  AL_LANES(int32_t(uint32_t(a.v[k]) >> N));
+}
+inline M4 bitSet(I4 a, int bit) {
+  M4 r;
+  AL_LANES((a.v[k] & bit) != 0);
+}
+
+#undef AL_LANES
+
+#endif
+
+inline F4 neg(F4 a) { return sub(set(0.f), a); }
+inline F4 abs(F4 a) { return select(less(a, set(0.f)), neg(a), a); }
+
+// Clamp to [lo, hi], NaN becomes lo
+inline F4 clamp(F4 a, float lo, float hi) {
+  a = select(greater(a, set(lo)), a, set(lo));
+  return select(less(a, set(hi)), a, set(hi));
+}
+
+// a + b * x + c * x^2 + ...
+inline F4 poly(F4 x, float c0, float c1) { return add(set(c0), mul(set(c1), x)); }
+template <class... Cs> F4 poly(F4 x, float c0, float c1, Cs... cs) {
+  return add(set(c0), mul(x, poly(x, c1, cs...)));
+}
+
+// Base 2 logarithm of positive normal numbers. Absolute error < 1e-7.
+F4 log2(F4 x) {
+  I4 b = bits(x);
+  F4 e = toFloat(iadd(iand(shiftRight<23>(b), iset(0xff)), iset(-127)));
+  F4 m = fromBits(ior(iand(b, iset(0x7fffff)), iset(0x3f800000)));
+  // Mantissa in [sqrt(1/2), sqrt(2)) keeps the series argument small
+  M4 big = greater(m, set(1.41421356f));
+  m = select(big, mul(m, set(0.5f)), m);
+  e = select(big, add(e, set(1.f)), e);
+  // log2(m) = 2 / ln(2) * atanh(s), |s| < 0.172
+  F4 s = div(sub(m, set(1.f)), add(m, set(1.f)));
+  F4 s2 = mul(s, s);
+  const float k = float(2.0 / M_LN2);
+  return add(e, mul(s, poly(s2, k, k / 3, k / 5, k / 7)));
+}
+
+// 2^x, relative error < 1e-8 before rounding
+F4 exp2(F4 x) {
+  x = clamp(x, -126.f, 126.f);
+  I4 n = roundToInt(x);
+  F4 f = sub(x, toFloat(n)); // [-0.5, 0.5]
+  F4 p = add(set(1.f), mul(f, poly(f, 0.693147188f, 0.240226509f,
+                                   0.055503571f, 0.00961805667f,
+                                   0.00133908674f, 0.000154614475f)));
+  return mul(p, fromBits(shiftLeft<23>(iadd(n, iset(127)))));
+}
+
+// x^p for x > 0
+F4 pow(F4 x, float p) { return exp2(mul(set(p), log2(x))); }
+
+// Angle in [-pi, pi]. Absolute error < 6e-7.
+F4 atan2(F4 y, F4 x) {
+  F4 ax = abs(x), ay = abs(y);
+  M4 steep = greater(ay, ax);
+  F4 num = select(steep, ax, ay);
+  F4 den = select(steep, ay, ax);
+  F4 t = div(num, select(greater(den, set(0.f)), den, set(1.f)));
+  // Least squares fit of atan(t) / t in t^2 over [0, 1]
+  F4 r = mul(t, poly(mul(t, t), 0.999999715f, -0.33327976f, 0.198950258f,
+                     -0.135376751f, 0.0847596977f, -0.0377517076f,
+                     0.00809729493f));
+  r = select(steep, sub(set(float(M_PI_2)), r), r);
+  r = select(less(x, set(0.f)), sub(set(float(M_PI)), r), r);
+  return select(less(y, set(0.f)), neg(r), r);
+}
+
+// Sine and cosine of an angle in turns. Absolute error < 3e-8.
+void sincosTurns(F4 turns, F4 &s, F4 &c) {
+  F4 quarters = mul(turns, set(4.f));
+  I4 q = roundToInt(quarters);
+  F4 r = mul(sub(quarters, toFloat(q)), set(float(M_PI_2))); // |r| <= pi/4
+  F4 r2 = mul(r, r);
+  F4 sr = mul(r, poly(r2, 1.f, -1.f / 6, 1.f / 120, -1.f / 5040,
+                      1.f / 362880));
+  F4 cr = poly(r2, 1.f, -1.f / 2, 1.f / 24, -1.f / 720, 1.f / 40320);
+  // Rotate by the quadrant
+  M4 odd = bitSet(q, 1);
+  s = select(odd, cr, sr);
+  c = select(odd, neg(sr), cr);
+  M4 half = bitSet(q, 2);
+  s = select(half, neg(s), s);
+  c = select(half, neg(c), c);
+}
+
+const float kEpsilon = 216.f / 24389.f, kKappa = 24389.f / 27.f;
+// Reference white D65
+const float kXn = 0.95047f, kYn = 1.f, kZn = 1.08883f;
+// Chroma normalization of HCLab
+const float kChroma = 133.419f;
+
+F4 decode(F4 v) {
+  F4 curve = pow(add(mul(v, set(1.f / 1.055f)), set(0.055f / 1.055f)), 2.4f);
+  return select(greater(v, set(0.04045f)), curve, mul(v, set(1.f / 12.92f)));
+}
+
+F4 encode(F4 v) {
+  F4 curve = sub(mul(pow(v, 1.f / 2.4f), set(1.055f)), set(0.055f));
+  v = select(greater(v, set(0.0031308f)), curve, mul(v, set(12.92f)));
+  return clamp(v, 0.f, 1.f);
+}
+
+// Lab companding function
+F4 labF(F4 t) {
+  return select(greater(t, set(kEpsilon)), pow(t, 1.f / 3.f),
+                mul(add(mul(t, set(kKappa)), set(16.f)), set(1.f / 116.f)));
+}
+
+F4 labFInverse(F4 f) {
+  F4 f3 = mul(mul(f, f), f);
+  return select(greater(f3, set(kEpsilon)), f3,
+                mul(sub(mul(f, set(116.f)), set(16.f)), set(1.f / kKappa)));
+}
+
+void rgbToLab4(F4 r, F4 g, F4 b, F4 &L, F4 &A, F4 &B) {
+  r = decode(r);
+  g = decode(g);
+  b = decode(b);
+  F4 x = add(add(mul(r, set(0.4124f)), mul(g, set(0.3576f))),
+             mul(b, set(0.1805f)));
+  F4 y = add(add(mul(r, set(0.2126f)), mul(g, set(0.7152f))),
+             mul(b, set(0.0722f)));
+  F4 z = add(add(mul(r, set(0.0193f)), mul(g, set(0.1192f))),
+             mul(b, set(0.9505f)));
+  F4 fx = labF(mul(x, set(1.f / kXn)));
+  F4 fy = labF(mul(y, set(1.f / kYn)));
+  F4 fz = labF(mul(z, set(1.f / kZn)));
+  L = sub(mul(fy, set(116.f)), set(16.f));
+  A = mul(sub(fx, fy), set(500.f));
+  B = mul(sub(fy, fz), set(200.f));
+}
+
+void labToRgb4(F4 L, F4 A, F4 B, F4 &r, F4 &g, F4 &b) {
+  F4 fy = mul(add(L, set(16.f)), set(1.f / 116.f));
+  F4 fx = add(mul(A, set(1.f / 500.f)), fy);
+  F4 fz = sub(fy, mul(B, set(1.f / 200.f)));
+  F4 x = mul(labFInverse(fx), set(kXn));
+  F4 y = select(greater(L, set(kEpsilon * kKappa)), mul(mul(fy, fy), fy),
+                mul(L, set(1.f / kKappa)));
+  y = mul(y, set(kYn));
+  F4 z = mul(labFInverse(fz), set(kZn));
+  r = encode(add(add(mul(x, set(3.2405f)), mul(y, set(-1.5371f))),
+                 mul(z, set(-0.4985f))));
+  g = encode(add(add(mul(x, set(-0.9693f)), mul(y, set(1.8760f))),
+                 mul(z, set(0.0416f))));
+  b = encode(add(add(mul(x, set(0.0556f)), mul(y, set(-0.2040f))),
+                 mul(z, set(1.0572f))));
+}
+
+void labToHCLab4(F4 L, F4 A, F4 B, F4 &h, F4 &c, F4 &l) {
+  h = mul(atan2(B, A), set(float(M_1_2PI)));
+  h = select(less(h, set(0.f)), add(h, set(1.f)), h);
+  c = mul(sqrt(add(mul(A, A), mul(B, B))), set(1.f / kChroma));
+  l = mul(L, set(1.f / 100.f));
+}
+
+void hcLabToLab4(F4 h, F4 c, F4 l, F4 &L, F4 &A, F4 &B) {
+  F4 s, co;
+  sincosTurns(h, s, co);
+  F4 chroma = mul(c, set(kChroma));
+  L = mul(l, set(100.f));
+  A = mul(chroma, co);
+  B = mul(chroma, s);
+}
+
+// Apply a 1 input, 1 output kernel to arrays
+template <class Kernel>
+void run(const float *src, float *dst, size_t count, Kernel kernel) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    store(dst + i, kernel(load(src + i)));
+  }
+  if (i < count) {
+    // Pad the last group with a valid value
+    float in[4], out[4];
+    for (size_t k = 0; k < 4; ++k) {
+      in[k] = src[i + k < count ? i + k : i];
+    }
+    store(out, kernel(load(in)));
+    std::copy(out, out + (count - i), dst + i);
+  }
+}
+
+// Apply a 3 input, 3 output kernel to planar arrays
+template <class Kernel>
+void run(const float *a, const float *b, const float *c, float *x, float *y,
+         float *z, size_t count, Kernel kernel) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    F4 o0, o1, o2;
+    kernel(load(a + i), load(b + i), load(c + i), o0, o1, o2);
+    store(x + i, o0);
+    store(y + i, o1);
+    store(z + i, o2);
+  }
+  if (i < count) {
+    float in[3][4], out[3][4];
+    for (size_t k = 0; k < 4; ++k) {
+      size_t j = i + k < count ? i + k : i;
+      in[0][k] = a[j];
+      in[1][k] = b[j];
+      in[2][k] = c[j];
+    }
+    F4 o0, o1, o2;
+    kernel(load(in[0]), load(in[1]), load(in[2]), o0, o1, o2);
+    store(out[0], o0);
+    store(out[1], o1);
+    store(out[2], o2);
+    size_t n = count - i;
+    std::copy(out[0], out[0] + n, x + i);
+    std::copy(out[1], out[1] + n, y + i);
+    std::copy(out[2], out[2] + n, z + i);
+  }
+}
+
+const size_t kBlock = 64;
+
+// Convert 3 component colors through planar buffers in blocks
+template <class Src, class Dst, class Read, class Write, class Convert>
+void convertBlocks(const Src *src, Dst *dst, size_t count, Read read,
+                   Write write, Convert convert) {
+  float in[3][kBlock], out[3][kBlock];
+  for (size_t start = 0; start < count; start += kBlock) {
+    size_t n = std::min(kBlock, count - start);
+    for (size_t i = 0; i < n; ++i) {
+      read(src[start + i], in[0][i], in[1][i], in[2][i]);
+    }
+    convert(in, out, n);
+    for (size_t i = 0; i < n; ++i) {
+      write(dst[start + i], out[0][i], out[1][i], out[2][i]);
+    }
+  }
+}
+
+} // namespace
+
+namespace al {
+
+void srgbToLinear(const float *src, float *dst, size_t count) {
+  run(src, dst, count, decode);
+}
+
+void linearToSrgb(const float *src, float *dst, size_t count) {
+  run(src, dst, count, encode);
+}
+
+void rgbToLab(const float *r, const float *g, const float *b, float *L,
+              float *A, float *B, size_t count) {
+  run(r, g, b, L, A, B, count, rgbToLab4);
+}
+
+void labToRgb(const float *L, const float *A, const float *B, float *r,
+              float *g, float *b, size_t count) {
+  run(L, A, B, r, g, b, count, labToRgb4);
+}
+
+void labToHCLab(const float *L, const float *A, const float *B, float *h,
+                float *c, float *l, size_t count) {
+  run(L, A, B, h, c, l, count, labToHCLab4);
+}
+
+void hcLabToLab(const float *h, const float *c, const float *l, float *L,
+                float *A, float *B, size_t count) {
+  run(h, c, l, L, A, B, count, hcLabToLab4);
+}
+
+void convertColors(const Color *src, Lab *dst, size_t count) {
+  convertBlocks(
+      src, dst, count,
+      [](const Color &v, float &r, float &g, float &b) {
+        r = v.r;
+        g = v.g;
+        b = v.b;
+      },
+      [](Lab &v, float L, float A, float B) { v = Lab(L, A, B); },
+      [](float (*in)[kBlock], float (*out)[kBlock], size_t n) {
+        rgbToLab(in[0], in[1], in[2], out[0], out[1], out[2], n);
+      });
+}
+
+void convertColors(const Lab *src, Color *dst, size_t count, float alpha) {
+  convertBlocks(
+      src, dst, count,
+      [](const Lab &v, float &L, float &A, float &B) {
+        L = v.l;
+        A = v.a;
+        B = v.b;
+      },
+      [alpha](Color &v, float r, float g, float b) {
+        v = Color(r, g, b, alpha);
+      },
+      [](float (*in)[kBlock], float (*out)[kBlock], size_t n) {
+        labToRgb(in[0], in[1], in[2], out[0], out[1], out[2], n);
+      });
+}
+
+void convertColors(const Color *src, HCLab *dst, size_t count) {
+  convertBlocks(
+      src, dst, count,
+      [](const Color &v, float &r, float &g, float &b) {
+        r = v.r;
+        g = v.g;
+        b = v.b;
+      },
+      [](HCLab &v, float h, float c, float l) { v = HCLab(h, c, l); },
+      [](float (*in)[kBlock], float (*out)[kBlock], size_t n) {
+        rgbToLab(in[0], in[1], in[2], out[0], out[1], out[2], n);
+        labToHCLab(out[0], out[1], out[2], out[0], out[1], out[2], n);
+      });
+}
+
+void convertColors(const HCLab *src, Color *dst, size_t count, float alpha) {
+  convertBlocks(
+      src, dst, count,
+      [](const HCLab &v, float &h, float &c, float &l) {
+        h = v.h;
+        c = v.c;
+        l = v.l;
+      },
+      [alpha](Color &v, float r, float g, float b) {
+        v = Color(r, g, b, alpha);
+      },
+      [](float (*in)[kBlock], float (*out)[kBlock], size_t n) {
+        hcLabToLab(in[0], in[1], in[2], in[0], in[1], in[2], n);
+        labToRgb(in[0], in[1], in[2], out[0], out[1], out[2], n);
+      });
+}
+
+} // namespace al
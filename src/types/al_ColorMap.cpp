@@ -0,0 +1,150 @@
+#include "al/types/al_ColorMap.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "al/math/al_SIMD.hpp"
+#include "al/types/al_ColorBatch.hpp"
+
+using namespace al;
+
+namespace {
+
+const int kPresetStops = 10;
+
+// 0xRRGGBB colors sampled evenly from the matplotlib color maps
+const uint32_t kViridis[kPresetStops] = {0x440154, 0x482878, 0x3e4989,
+                                         0x31688e, 0x26828e, 0x1f9e89,
+                                         0x35b779, 0x6ece58, 0xb5de2b,
+                                         0xfde725};
+const uint32_t kMagma[kPresetStops] = {0x000004, 0x180f3d, 0x440f76,
+                                       0x721f81, 0x9e2f7f, 0xcd4071,
+                                       0xf1605d, 0xfd9668, 0xfeca8d,
+                                       0xfcfdbf};
+const uint32_t kInferno[kPresetStops] = {0x000004, 0x1b0c41, 0x4a0c6b,
+                                         0x781c6d, 0xa52c60, 0xcf4446,
+                                         0xed6925, 0xfb9b06, 0xf7d13d,
+                                         0xfcffa4};
+const uint32_t kPlasma[kPresetStops] = {0x0d0887, 0x46039f, 0x7201a8,
+                                        0x9c179e, 0xbd3786, 0xd8576b,
+                                        0xed7953, 0xfb9f3a, 0xfdca26,
+                                        0xf0f921};
+
+std::vector<Color> presetStops(ColorMap::Preset preset) {
+  const uint32_t *hex = nullptr;
+  switch (preset) {
+  case ColorMap::VIRIDIS:
+    hex = kViridis;
+    break;
+  case ColorMap::MAGMA:
+    hex = kMagma;
+    break;
+  case ColorMap::INFERNO:
+    hex = kInferno;
+    break;
+  case ColorMap::PLASMA:
+    hex = kPlasma;
+    break;
+  default:
+    return {Color(0.f), Color(1.f)};
+  }
+  std::vector<Color> stops;
+  for (int i = 0; i < kPresetStops; ++i) {
+    stops.emplace_back(Colori(uint8_t(hex[i] >> 16), uint8_t(hex[i] >> 8),
+                              uint8_t(hex[i])));
+  }
+  return stops;
+}
+
+} // namespace
+
+ColorMap::ColorMap(Preset preset, unsigned size) { set(preset, size); }
+
+ColorMap::ColorMap(const std::vector<Color> &stops, unsigned size) {
+  set(stops, size);
+}
+
+void ColorMap::set(Preset preset, unsigned size) {
+  set(presetStops(preset), size);
+}
+
+void ColorMap::set(const std::vector<Color> &stops, unsigned size) {
+  size = std::max(size, 1u);
+  if (stops.empty()) {
+    mTable.assign(size, Color(1.f));
+    return;
+  }
+  size_t numStops = stops.size();
+  std::vector<Lab> labStops(numStops);
+  convertColors(stops.data(), labStops.data(), numStops);
+
+  std::vector<Lab> entries(size);
+  std::vector<float> alphas(size);
+  for (unsigned i = 0; i < size; ++i) {
+    float x = size > 1 ? float(i) * (numStops - 1) / (size - 1) : 0.f;
+    size_t k = std::min(size_t(x), numStops > 1 ? numStops - 2 : 0);
+    size_t next = std::min(k + 1, numStops - 1);
+    float f = x - float(k);
+    const Lab &a = labStops[k], &b = labStops[next];
+    entries[i] = Lab(a.l + (b.l - a.l) * f, a.a + (b.a - a.a) * f,
+                     a.b + (b.b - a.b) * f);
+    alphas[i] = stops[k].a + (stops[next].a - stops[k].a) * f;
+  }
+  mTable.resize(size);
+  convertColors(entries.data(), mTable.data(), size);
+  for (unsigned i = 0; i < size; ++i) {
+    mTable[i].a = alphas[i];
+  }
+}
+
+const Color &ColorMap::operator()(float t) const {
+  float last = float(mTable.size() - 1);
+  t *= last;
+  // Written so NaN maps to the first entry
+  if (!(t > 0.f)) {
+    t = 0.f;
+  }
+  if (t > last) {
+    t = last;
+  }
+  return mTable[size_t(std::lrint(t))];
+}
+
+void ColorMap::map(const float *values, Color *dst, size_t count, float lo,
+                   float hi) const {
+  const Color *table = mTable.data();
+  float last = float(mTable.size() - 1);
+  float scale = hi != lo ? last / (hi - lo) : 0.f;
+  size_t i = 0;
+#ifdef AL_SIMD_SSE2
+  const __m128 L = _mm_set1_ps(lo), S = _mm_set1_ps(scale);
+  const __m128 zero = _mm_setzero_ps(), M = _mm_set1_ps(last);
+  alignas(16) int32_t index[4];
+  for (; i + 4 <= count; i += 4) {
+    __m128 t = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(values + i), L), S);
+    // max returns its second operand if either is NaN
+    t = _mm_min_ps(_mm_max_ps(t, zero), M);
+    _mm_store_si128(reinterpret_cast<__m128i *>(index), _mm_cvtps_epi32(t));
+    dst[i] = table[index[0]];
+    dst[i + 1] = table[index[1]];
+    dst[i + 2] = table[index[2]];
+    dst[i + 3] = table[index[3]];
+  }
+#endif
+  for (; i < count; ++i) {
+    float t = (values[i] - lo) * scale;
+    if (!(t > 0.f)) {
+      t = 0.f;
+    }
+    if (t > last) {
+      t = last;
+    }
+    dst[i] = table[std::lrint(t)];
+  }
+}
+
+void ColorMap::map(const float *values, size_t count, std::vector<Color> &dst,
+                   float lo, float hi) const {
+  dst.resize(count);
+  map(values, dst.data(), count, lo, hi);
+}
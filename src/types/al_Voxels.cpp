@@ -1,728 +1,557 @@
-#include "al/util/al_Voxels.hpp"
-#include <cstdint>
-#include <cstring>
-#include "al/core/io/al_File.hpp"
-#include "al/core/system/al_Printing.hpp"
-#include "al/util/al_Image.hpp"
+#include "al/types/al_Voxels.hpp"
 
-#include <algorithm>  // min,max
+#include <algorithm> // min,max
 #include <cmath>
-//#include <cassert>
-
-namespace al {
-
-MRCHeader &Voxels::parseMRC(const char *mrcData) {
-  MRCHeader &mrcHeader = *(MRCHeader *)mrcData;
-
-  // check for byte swap:
-  bool swapped =
-      (mrcHeader.nx <= 0 || mrcHeader.ny <= 0 || mrcHeader.nz <= 0 ||
-       (mrcHeader.nx > 65535 && mrcHeader.ny > 65535 && mrcHeader.nz > 65535) ||
-       mrcHeader.mapx < 0 || mrcHeader.mapx > 4 || mrcHeader.mapy < 0 ||
-       mrcHeader.mapy > 4 || mrcHeader.mapz < 0 || mrcHeader.mapz > 4);
-
-  // ugh.
-  if (swapped) {
-    printf("swapping byte order...\n");
-    swapBytes(&mrcHeader.nx, 10);
-    swapBytes(&mrcHeader.xlen, 6);
-    swapBytes(&mrcHeader.mapx, 3);
-    swapBytes(&mrcHeader.amin, 3);
-    swapBytes(&mrcHeader.ispg, 2);
-    swapBytes(&mrcHeader.next, 1);
-    swapBytes(&mrcHeader.creatid, 1);
-    swapBytes(&mrcHeader.nint, 4);
-    swapBytes(&mrcHeader.min2, 4);
-    swapBytes(&mrcHeader.imodStamp, 2);
-    swapBytes(&mrcHeader.idtype, 6);
-    swapBytes(&mrcHeader.tiltangles[0], 6);
-    swapBytes(&mrcHeader.origin[0], 3);
-    swapBytes(&mrcHeader.rms, 1);
-    swapBytes(&mrcHeader.nlabl, 1);
-  }
-
-  printf("NX %d NY %d NZ %d\n", mrcHeader.nx, mrcHeader.ny, mrcHeader.nz);
-  printf("mode ");
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
 
-  AlloTy ty;
+#include "al/io/al_File.hpp"
+#include "al/types/al_Conversion.hpp"
 
-  // set type:
-  switch (mrcHeader.mode) {
-    case MRC_IMAGE_SINT8:
-      printf("signed int 8\n");
-      ty = Array::type<int8_t>();
-      break;
-    case MRC_IMAGE_SINT16:
-      printf("signed int 16\n");
-      ty = Array::type<int16_t>();
-      break;
-    case MRC_IMAGE_FLOAT32:
-      printf("float\n");
-      ty = Array::type<float>();
-      break;
-    case MRC_IMAGE_UINT16:
-      printf("unsigned int 16\n");
-      ty = Array::type<uint16_t>();
-      break;
-    default:
-      printf("MRC mode not supported\n");
-      break;
-  }
+namespace al {
 
-  printf("cell dimensions X %f Y %f Z %f\n", mrcHeader.xlen, mrcHeader.ylen,
-         mrcHeader.zlen);
-  printf("axis X %d axis Y %d axis Z %d\n", mrcHeader.mapx, mrcHeader.mapy,
-         mrcHeader.mapz);
-  printf("density min %f max %f mean %f\n", mrcHeader.amin, mrcHeader.amax,
-         mrcHeader.amean);
-  printf("origin %f %f %f\n", mrcHeader.origin[0], mrcHeader.origin[1],
-         mrcHeader.origin[2]);
-  printf("map %s\n", mrcHeader.cmap);
-  printf("machine stamp %s\n", mrcHeader.machinestamp);
-  printf("rms %f\n", mrcHeader.rms);
-  printf("labels %d\n", mrcHeader.nlabl);
-  for (int i = 0; i < mrcHeader.nlabl; i++) {
-    // printf("\t%02d: %s\n", i, mrcHeader.labels[i]);
+static_assert(sizeof(MRCHeader) == 1024, "MRC header must be 1024 bytes");
+
+// Volume data of an MRC file, either memory mapped or read on demand
+struct MRCSource {
+  MappedFile mapped;
+  std::ifstream stream;
+  uint64_t dataOffset = 1024;
+  int32_t mode = MRC_IMAGE_FLOAT32;
+  size_t voxelBytes = 4;
+  bool swapped = false;
+
+  bool read(uint64_t offset, char *dst, size_t bytes) {
+    if (mapped.opened()) {
+      if (offset + bytes > mapped.size()) {
+        return false;
+      }
+      std::memcpy(dst, mapped.data() + offset, bytes);
+      return true;
+    }
+    stream.seekg(std::streamoff(offset));
+    stream.read(dst, std::streamsize(bytes));
+    return bool(stream);
   }
 
-  const char *start = mrcData + 1024;
-
-  formatAligned(1, ty, mrcHeader.nx, mrcHeader.ny, mrcHeader.nz, 0);
-  memcpy(data.ptr, start, size());
-
-  if (swapped) {
-    // set type:
-    switch (mrcHeader.mode) {
+  // Convert count voxels in the file format to float
+  void convert(const char *src, float *dst, size_t count) const {
+    switch (mode) {
       case MRC_IMAGE_SINT8:
-        swapBytes((int8_t *)data.ptr, cells());
+        for (size_t i = 0; i < count; i++) {
+          dst[i] = float(int8_t(src[i]));
+        }
         break;
       case MRC_IMAGE_SINT16:
-        swapBytes((int16_t *)data.ptr, cells());
-        break;
-      case MRC_IMAGE_FLOAT32:
-        swapBytes((float *)data.ptr, cells());
+        convert<int16_t>(src, dst, count);
         break;
       case MRC_IMAGE_UINT16:
-        swapBytes((uint16_t *)data.ptr, cells());
+        convert<uint16_t>(src, dst, count);
         break;
       default:
+        convert<float>(src, dst, count);
         break;
     }
   }
 
-  return mrcHeader;
-}
-
-bool Voxels::loadFromMRC(std::string filename, bool update) {
-  zero();
-
-  File data_file(filename, "rb", true);
-
-  printf("Reading Data File: %s\n", data_file.path().c_str());
-
-  if (!data_file.opened()) {
-    AL_WARN("Cannot open MRC file");
-    exit(EXIT_FAILURE);
-  }
-
-  MRCHeader header = parseMRC(data_file.readAll());
-
-  data_file.close();
-
-  if (update) {
-    // convert into angstrom
-    header.xlen = m_voxWidth[0] * powf(10.0, m_units + 10);
-    header.ylen = m_voxWidth[1] * powf(10.0, m_units + 10);
-    header.zlen = m_voxWidth[2] * powf(10.0, m_units + 10);
-
-    writeToMRC(filename + "_new", header);
-  } else {
-    m_units = VOX_NANOMETERS;  // default to nanometers
-    m_voxWidth[0] = header.xlen * 0.1f;
-    m_voxWidth[1] = header.ylen * 0.1f;
-    m_voxWidth[2] = header.zlen * 0.1f;
+  template <class T>
+  void convert(const char *src, float *dst, size_t count) const {
+    for (size_t i = 0; i < count; i++) {
+      T v;
+      std::memcpy(&v, src + i * sizeof(T), sizeof(T));
+      if (swapped) {
+        swapBytes(v);
+      }
+      dst[i] = float(v);
+    }
   }
+};
 
-  m_min = header.amin;
-  m_max = header.amax;
-  m_mean = header.amean;
-  m_rms = header.rms;
+Voxels::Voxels() { init(1, 1, 1, VOX_METERS); }
 
-  return true;
+Voxels::Voxels(uint32_t dimx, uint32_t dimy, uint32_t dimz, float sizex,
+               float sizey, float sizez, UnitsTy units) {
+  format(dimx, dimy, dimz);
+  init(sizex, sizey, sizez, units);
 }
 
-bool Voxels::loadFromMRC(std::string filename, UnitsTy ty, float voxWidth) {
-  m_units = ty;
-  m_voxWidth[0] = voxWidth;
-  m_voxWidth[1] = voxWidth;
-  m_voxWidth[2] = voxWidth;
-
-  loadFromMRC(filename, true);
-
-  return true;
+Voxels::Voxels(uint32_t dimx, uint32_t dimy, uint32_t dimz, float voxelsize,
+               UnitsTy units) {
+  format(dimx, dimy, dimz);
+  init(voxelsize, voxelsize, voxelsize, units);
 }
 
-bool Voxels::loadFromMRC(std::string filename, UnitsTy ty, float voxWidthX,
-                         float voxWidthY, float voxWidthZ) {
-  m_units = ty;
-  m_voxWidth[0] = voxWidthX;
-  m_voxWidth[1] = voxWidthY;
-  m_voxWidth[2] = voxWidthZ;
-
-  loadFromMRC(filename, true);
-
-  return true;
+Voxels::Voxels(uint32_t dimx, uint32_t dimy, uint32_t dimz) {
+  format(dimx, dimy, dimz);
+  init(1, 1, 1, VOX_METERS);
 }
 
-bool Voxels::writeToMRC(std::string filename, MRCHeader &header) {
-  File mrc_file(filename, "wb", true);
-  printf("Writing MRC File: %s\n", mrc_file.path().c_str());
-
-  if (!mrc_file.opened()) {
-    AL_WARN("Cannot open MRC file");
-    exit(EXIT_FAILURE);
+Voxels::~Voxels() {}
+
+void Voxels::format(uint32_t dimx, uint32_t dimy, uint32_t dimz,
+                    uint32_t brickSize) {
+  mLevels.clear();
+  mLRU.clear();
+  mResidentBytes = 0;
+  mSource.reset();
+  mBrickSize = std::max(brickSize, 1u);
+
+  uint32_t dims[3] = {std::max(dimx, 1u), std::max(dimy, 1u),
+                      std::max(dimz, 1u)};
+  while (true) {
+    Level level;
+    size_t count = 1;
+    for (int i = 0; i < 3; i++) {
+      level.dims[i] = dims[i];
+      level.bricks[i] = (dims[i] + mBrickSize - 1) / mBrickSize;
+      count *= level.bricks[i];
+    }
+    level.grid.resize(count);
+    mLevels.push_back(std::move(level));
+    if (count == 1) {
+      break;
+    }
+    for (int i = 0; i < 3; i++) {
+      dims[i] = (dims[i] + 1) / 2;
+    }
   }
-
-  mrc_file.write(&header, sizeof(MRCHeader), 1);
-
-  mrc_file.write(data.ptr, size(), 1);
-
-  mrc_file.close();
-
-  return true;
 }
 
-bool Voxels::loadFromFile(std::string filename) {
-  zero();
-
-  File data_file(filename, "rb", true);
-
-  printf("Reading Data File: %s\n", data_file.path().c_str());
-
-  if (!data_file.opened()) {
-    AL_WARN("Cannot open data file");
-    exit(EXIT_FAILURE);
-  }
-  char validHeader[12];
-  data_file.read(&validHeader, sizeof(char), 12);
-
-  AlloArrayHeader h2;
-  data_file.read(&h2, sizeof(AlloArrayHeader), 1);
-
-  format(h2);
-
-  data_file.read(&m_units, sizeof(UnitsTy), 1);
-  data_file.read(&m_voxWidth[0], sizeof(float), 1);
-  data_file.read(&m_voxWidth[1], sizeof(float), 1);
-  data_file.read(&m_voxWidth[2], sizeof(float), 1);
+std::string Voxels::printVoxWidth(unsigned int axis) {
+  std::ostringstream ss;
+  ss << m_voxWidth[axis] << " " << printUnits(m_units);
 
-  data_file.read(data.ptr, size(), 1);
-
-  data_file.close();
-
-  return true;
+  return ss.str();
 }
 
-bool Voxels::writeToFile(std::string filename) {
-  File voxel_file(filename, "wb", true);
-  printf("Writing Voxel File: %s\n", voxel_file.path().c_str());
-
-  if (!voxel_file.opened()) {
-    AL_WARN("Cannot open voxel file");
-    exit(EXIT_FAILURE);
+const std::string Voxels::printUnits(UnitsTy t) {
+  if (t == VOX_ANGSTROMS) {
+    return "angstroms";
+  } else if (t == VOX_NANOMETERS) {
+    return "nm";
+  } else if (t == VOX_MICROMETERS) {
+    return "µm";
+  } else if (t == VOX_MILLIMETERS) {
+    return "mm";
+  } else if (t == VOX_CENTIMETERS) {
+    return "cm";
+  } else {
+    std::ostringstream ss;
+    ss << "(m*10^" << t << ")";
+    return ss.str();
   }
+}
 
-  char validHeader[12] = "Allo Voxels";
-
-  voxel_file.write(validHeader, sizeof(char), 12);
-
-  voxel_file.write(&header, sizeof(AlloArrayHeader), 1);
-
-  voxel_file.write(&m_units, sizeof(UnitsTy), 1);
-  voxel_file.write(&m_voxWidth[0], sizeof(float), 1);
-  voxel_file.write(&m_voxWidth[1], sizeof(float), 1);
-  voxel_file.write(&m_voxWidth[2], sizeof(float), 1);
-
-  voxel_file.write(data.ptr, size(), 1);
-
-  voxel_file.close();
-
-  return true;
+Voxels::Brick &Voxels::brickAt(int level, uint32_t bx, uint32_t by,
+                               uint32_t bz) const {
+  Level &l = mLevels[level];
+  return l.grid[(size_t(bz) * l.bricks[1] + by) * l.bricks[0] + bx];
 }
 
-void Voxels::print(FILE *fp) {
-  Array::print(fp);
-  fprintf(fp, "  cell:   %s, %s, %s\n", printVoxWidth(0).c_str(),
-          printVoxWidth(1).c_str(), printVoxWidth(2).c_str());
+Voxels::Brick &Voxels::load(int level, uint32_t bx, uint32_t by,
+                            uint32_t bz) const {
+  Brick &b = brickAt(level, bx, by, bz);
+  if (!b.loaded) {
+    if (level == 0 && !mSource) {
+      // Not written yet
+      b.min = b.max = mBackground;
+      return b;
+    }
+    size_t count = size_t(mBrickSize) * mBrickSize * mBrickSize;
+    std::unique_ptr<float[]> data(new float[count]);
+    decode(level, bx, by, bz, data.get());
+    store(b, std::move(data));
+  }
+  touch(b);
+  return b;
 }
 
-bool Voxels::getdir(std::string path, std::vector<std::string> &files) {
-  al::Dir dir;
-  if (dir.open(path)) {
-    while (dir.read()) {
-      auto &file = dir.entry();
-      if (file.type() == al::FileInfo::REG) {
-        auto &name = file.name();
-        if (name != "info.txt" && name != ".DS_Store") {
-          std::cout << name << "\n";
-          files.push_back(path + "/" + name);
+void Voxels::decode(int level, uint32_t bx, uint32_t by, uint32_t bz,
+                    float *dst) const {
+  const uint32_t B = mBrickSize;
+  const Level &l = mLevels[level];
+  int x0 = int(bx * B), y0 = int(by * B), z0 = int(bz * B);
+
+  if (level > 0) {
+    // Average 2x2x2 voxels of the level above
+    uint32_t S = 2 * B;
+    std::vector<float> fine(size_t(S) * S * S);
+    read(fine.data(), 2 * x0, 2 * y0, 2 * z0, S, S, S, level - 1);
+    for (uint32_t z = 0; z < B; z++) {
+      for (uint32_t y = 0; y < B; y++) {
+        for (uint32_t x = 0; x < B; x++) {
+          const float *f = &fine[((2 * z) * S + 2 * y) * S + 2 * x];
+          float sum = f[0] + f[1] + f[S] + f[S + 1] + f[S * S] +
+                      f[S * S + 1] + f[S * S + S] + f[S * S + S + 1];
+          dst[(z * B + y) * B + x] = sum * 0.125f;
         }
       }
     }
-    return true;
+    return;
   }
-  return false;
-}
-
-bool Voxels::parseInfo(std::string dir, std::vector<std::string> &data) {
-  std::string file = dir + "/info.txt";
-  std::cout << file << "\n";
-  std::ifstream infile(file.c_str());
-  if (!infile.good()) return false;  // exit if file not found
 
-  std::string strOneLine;
-
-  while (infile) {
-    getline(infile, strOneLine);
-    if (strOneLine.length() > 0) {
-      data.push_back(
-          strOneLine.substr(strOneLine.find(":") + 2, strOneLine.length()));
+  // Read rows from the file, repeating the last voxel past the edges
+  uint32_t nx = std::min(B, l.dims[0] - x0);
+  std::vector<char> row(nx * mSource->voxelBytes);
+  for (uint32_t z = 0; z < B; z++) {
+    uint64_t zc = std::min(z0 + z, l.dims[2] - 1);
+    for (uint32_t y = 0; y < B; y++) {
+      uint64_t yc = std::min(y0 + y, l.dims[1] - 1);
+      float *out = dst + (z * B + y) * B;
+      uint64_t index = (zc * l.dims[1] + yc) * l.dims[0] + x0;
+      if (mSource->read(mSource->dataOffset + index * mSource->voxelBytes,
+                        row.data(), row.size())) {
+        mSource->convert(row.data(), out, nx);
+      } else {
+        std::fill(out, out + nx, mBackground);
+      }
+      std::fill(out + nx, out + B, out[nx - 1]);
     }
   }
-
-  infile.close();
-
-  return true;
 }
 
-/*
-   sliceassembler
-
-   Voxel data import aka slice assembler aka volume reconstructor
-
-   by Matt Wright, April 2015
-   and Hannah Wolfe, July 2015
-
-   based on tiExporter.cpp from images2raw.cpp by Coby Kaufer
-   <cobykaufer@bluejayke.com>, Karl Yerkes <karl.yerkes@gmail.com>,
-   and Matt Wright <matt@create.ucsb.edu
-
-   Read in a directory full of 2D image files with some naming
-   convention, assemble them all into an al::Array or al::Voxels
-   and write the result as one huge fast-to-load raw binary data file.
-
-
-   Limitations:
-
-   - Images must contain 8-bit RGB pixels
-
-   - Ignores all but the red channel
-
-   - Chokes if directory contains anything besides "info.txt" and image files
-
-   - Creates a voxel from the data
-*/
+void Voxels::store(Brick &b, std::unique_ptr<float[]> data) const {
+  size_t count = size_t(mBrickSize) * mBrickSize * mBrickSize;
+  auto range = std::minmax_element(data.get(), data.get() + count);
+  b.min = *range.first;
+  b.max = *range.second;
+  b.loaded = true;
+  b.rangeKnown = true;
+  if (b.min == b.max) {
+    // Uniform bricks are stored as a single value
+    return;
+  }
+  b.data = std::move(data);
+  mResidentBytes += count * sizeof(float);
+  mLRU.push_front(&b);
+  b.lru = mLRU.begin();
+  evict();
+}
 
-bool Voxels::loadFromDirectory(std::string dir) {
-  std::vector<std::string> files;
-  std::vector<std::string> info;
+void Voxels::touch(Brick &b) const {
+  if (b.data && !b.pinned && b.lru != mLRU.begin()) {
+    mLRU.splice(mLRU.begin(), mLRU, b.lru);
+  }
+}
 
-  // Image and Texture handle reading and displaying image files.
-  Image RGBImage;  // for reading into
+void Voxels::evict() const {
+  // Keep the most recently used brick, it is about to be accessed
+  while (mCacheLimit && mResidentBytes > mCacheLimit && mLRU.size() > 1) {
+    release(*mLRU.back());
+  }
+}
 
-  if (!getdir(dir, files)) {
-    std::cout << "Problem reading directory " << dir << "\n";
-    return false;
+void Voxels::release(Brick &b) const {
+  if (b.data && !b.pinned) {
+    mLRU.erase(b.lru);
+    mResidentBytes -= size_t(mBrickSize) * mBrickSize * mBrickSize *
+                      sizeof(float);
+    b.data.reset();
   }
+  if (!b.pinned) {
+    b.loaded = false;
+  }
+}
 
-  if (files.size() == 0) {
-    std::cout << "Read zero files from directory " << dir << "\n";
-    return false;
+void Voxels::invalidateMips(uint32_t x, uint32_t y, uint32_t z) {
+  for (int level = 1; level < levels(); level++) {
+    Brick &b = brickAt(level, (x >> level) / mBrickSize,
+                       (y >> level) / mBrickSize, (z >> level) / mBrickSize);
+    release(b);
+    b.rangeKnown = false;
   }
+}
 
-  std::cout << "Judging by " << dir << " there are " << files.size()
-            << " images (or at least files)"
-            << "\n";
+void Voxels::cacheLimit(size_t bytes) {
+  mCacheLimit = bytes;
+  evict();
+}
 
-  // Try reading the first one just to get the size
-  if (!RGBImage.load(files[0])) {
-    std::cout << "Couldn't read file " << files[0] << "\n";
-    return false;
+float Voxels::value(uint32_t x, uint32_t y, uint32_t z, int level) const {
+  const uint32_t B = mBrickSize;
+  const Brick &b = load(level, x / B, y / B, z / B);
+  if (!b.data) {
+    return b.min;
   }
+  return b.data[((z % B) * B + y % B) * B + x % B];
+}
 
-  int nx = RGBImage.width();
-  int ny = RGBImage.height();
-  int nz = files.size();
-  float vx = 1.;
-  float vy = 1.;
-  float vz = 1.;
-  float type = VOX_NANOMETERS;
-
-  if (!parseInfo(dir, info)) {
-    if (info.size() == 4) {
-      type = atoi(info[0].c_str());
-      vx = atof(info[1].c_str());
-      vy = atof(info[2].c_str());
-      vz = atof(info[3].c_str());
-      std::cout << "imported values from info.txt: " << type << ", " << vx
-                << ", " << vy << ", " << vz << "\n";
-    } else {
-      std::cout << info.size()
-                << " info.txt doesn't have enough info, using default data"
-                << "\n";
+void Voxels::setValue(uint32_t x, uint32_t y, uint32_t z, float v) {
+  const uint32_t B = mBrickSize;
+  Brick &b = load(0, x / B, y / B, z / B);
+  if (!b.data) {
+    if (v == b.min) {
+      return;
     }
-  } else {
-    std::cout << "no info.txt, using default data"
-              << "\n";
+    size_t count = size_t(B) * B * B;
+    b.data.reset(new float[count]);
+    std::fill(b.data.get(), b.data.get() + count, b.min);
+    mResidentBytes += count * sizeof(float);
+  } else if (!b.pinned) {
+    mLRU.erase(b.lru);
   }
+  b.pinned = true;
+  b.loaded = true;
+  b.rangeKnown = true;
+  b.data[((z % B) * B + y % B) * B + x % B] = v;
+  // Range is kept as bounds, values being overwritten are not removed
+  b.min = std::min(b.min, v);
+  b.max = std::max(b.max, v);
+  invalidateMips(x, y, z);
+}
 
-  std::cout << "Judging by " << files[0] << " each image should be " << nx
-            << " by " << ny << "\n";
-
-  // For now assume 8-bit with 1 nm cube voxels
-  format(1, AlloUInt8Ty, nx, ny, nz);
-  init(vx, vy, vz, type);
-
-  // Iterate through entire directory
-  int slice = 0;
-  for (std::vector<std::string>::iterator it = files.begin(); it != files.end();
-       ++it, ++slice) {
-    std::string &filename = *it;
-
-    if (RGBImage.load(filename)) {
-      std::cout << "loaded " << filename << " (" << slice + 1 << " of "
-                << files.size() << ")"
-                << "\n";
-    } else {
-      std::cout << "Failed to read image from " << filename << "\n";
-      return false;
-    }
-
-    // Verify XY resolution
-    if (int(RGBImage.width()) != nx || int(RGBImage.height()) != ny) {
-      std::cout << "Error:  resolution mismatch!"
-                << "\n";
-      std::cout << "   " << files[0] << ": " << nx << " by " << ny << "\n";
-      std::cout << "   " << filename << ": " << RGBImage.width() << " by "
-                << RGBImage.height() << "\n";
-      return false;
-    }
-
-    // Access the read-in image data
-    Array &array(RGBImage.array());
-
-    // For now assume 8-bit RGBA
-    Image::RGBAPix<uint8_t> pixel;
-
-    // Copy it out pixel-by-pixel:
-    for (size_t row = 0; row < array.height(); ++row) {
-      for (size_t col = 0; col < array.width(); ++col) {
-        array.read(&pixel, col, row);
-
-        // For now we'll take only the red and put it in the single component;
-        // that's lame.
-        elem<char>(0, col, row, slice) = (char)pixel.r;
+void Voxels::read(float *dst, int x0, int y0, int z0, uint32_t nx,
+                  uint32_t ny, uint32_t nz, int level) const {
+  const int B = int(mBrickSize);
+  const Level &l = mLevels[level];
+  auto clamp = [](int v, uint32_t n) {
+    return uint32_t(std::min(std::max(v, 0), int(n) - 1));
+  };
+  for (uint32_t k = 0; k < nz; k++) {
+    uint32_t z = clamp(z0 + int(k), l.dims[2]);
+    for (uint32_t j = 0; j < ny; j++) {
+      uint32_t y = clamp(y0 + int(j), l.dims[1]);
+      float *row = dst + (size_t(k) * ny + j) * nx;
+      uint32_t i = 0;
+      while (i < nx) {
+        int xi = x0 + int(i);
+        uint32_t x = clamp(xi, l.dims[0]);
+        uint32_t run = 1;
+        if (xi >= 0 && xi < int(l.dims[0])) {
+          // Copy up to the end of the brick or the volume
+          uint32_t end = std::min(uint32_t(x / B + 1) * B, l.dims[0]);
+          run = std::min(nx - i, end - x);
+        }
+        const Brick &b = load(level, x / B, y / B, z / B);
+        if (b.data) {
+          const float *src = &b.data[((z % B) * B + y % B) * B + x % B];
+          std::copy(src, src + run, row + i);
+        } else {
+          std::fill(row + i, row + i + run, b.min);
+        }
+        i += run;
       }
     }
   }
-  return true;
 }
 
-/*  //BACK-UP
-bool Voxels::linePlaneIntersection(const Vec3f &P0, const Vec3f &P1, const Vec3f
-&planeCenter, const Vec3f &planeNormal, Vec3f* intersection)
-{
-   Vec3f P10 = P1 - P0;
-   Vec3f P20 = planeCenter - P0;
-   float nDot10 = planeNormal.dot(P10);
-   float nDot20 = planeNormal.dot(P20);
+const float *Voxels::brick(uint32_t bx, uint32_t by, uint32_t bz, int level,
+                           float &min, float &max) const {
+  const Brick &b = load(level, bx, by, bz);
+  min = b.min;
+  max = b.max;
+  return b.data.get();
+}
 
-   if (nDot10 == 0){
-     return false;
-   }
+void Voxels::brickRange(uint32_t bx, uint32_t by, uint32_t bz, int level,
+                        float &min, float &max) const {
+  const Brick &b = brickAt(level, bx, by, bz);
+  if (!b.rangeKnown) {
+    load(level, bx, by, bz);
+  }
+  min = b.min;
+  max = b.max;
+}
 
-   float u = nDot20/nDot10;
+bool Voxels::parseMRC(const char *data, MRCHeader &mrcHeader, bool &swapped) {
+  std::memcpy(&mrcHeader, data, sizeof(MRCHeader));
 
-   if (u > 1.0 or u < 0.0) {
-     return false;
-   }
+  // check for byte swap:
+  swapped =
+      (mrcHeader.nx <= 0 || mrcHeader.ny <= 0 || mrcHeader.nz <= 0 ||
+       (mrcHeader.nx > 65535 && mrcHeader.ny > 65535 && mrcHeader.nz > 65535) ||
+       mrcHeader.mapx < 0 || mrcHeader.mapx > 4 || mrcHeader.mapy < 0 ||
+       mrcHeader.mapy > 4 || mrcHeader.mapz < 0 || mrcHeader.mapz > 4);
 
-   *intersection = u*P0 + (1-u)*P1;
+  // ugh.
+  if (swapped) {
+    swapBytes(&mrcHeader.nx, 10);
+    swapBytes(&mrcHeader.xlen, 6);
+    swapBytes(&mrcHeader.mapx, 3);
+    swapBytes(&mrcHeader.amin, 3);
+    swapBytes(&mrcHeader.ispg, 2);
+    swapBytes(&mrcHeader.next, 1);
+    swapBytes(&mrcHeader.creatid, 1);
+    swapBytes(&mrcHeader.nint, 4);
+    swapBytes(&mrcHeader.min2, 4);
+    swapBytes(&mrcHeader.imodStamp, 2);
+    swapBytes(&mrcHeader.idtype, 6);
+    swapBytes(&mrcHeader.tiltangles[0], 6);
+    swapBytes(&mrcHeader.origin[0], 3);
+    swapBytes(&mrcHeader.rms, 1);
+    swapBytes(&mrcHeader.nlabl, 1);
+  }
 
-   return true;
+  return mrcHeader.nx > 0 && mrcHeader.ny > 0 && mrcHeader.nz > 0 &&
+         mrcHeader.next >= 0;
 }
 
-//back 2
-bool Voxels::linePlaneIntersection(const Vec3f &P0, const Vec3f &P1, const Vec3f
-&planeCenter, const Vec3f &planeNormal, Vec3f* intersection)
-{
-   Vec3f P10 = P1 - P0;
-   Vec3f P20 = planeCenter - P0;
-   float nDot10 = planeNormal.dot(P10);
-   float nDot20 = planeNormal.dot(P20);
-   Vec3f w = P0 -planeCenter;
-   float fac = -planeNormal.dot(w)/nDot10;
-   Vec3f t = P10*fac;
-
-   if (nDot10 == 0){
-     return false;
-   }
-
-   float u = nDot20/nDot10;
-
-   if (u > 1.0 or u < 0.0) {
-     return false;
-   }
+bool Voxels::loadFromMRC(std::string filename, MRCAccess access) {
+  std::unique_ptr<MRCSource> source(new MRCSource);
+  char headerData[sizeof(MRCHeader)];
+  uint64_t fileSize = 0;
 
-  *intersection = P0 +t;  //testing a new intersect calculation
+  if (access == MRC_MAP) {
+    if (!source->mapped.open(filename)) {
+      std::cerr << "Voxels: Cannot map MRC file " << filename << std::endl;
+      return false;
+    }
+    fileSize = source->mapped.size();
+    if (fileSize < sizeof(MRCHeader)) {
+      std::cerr << "Voxels: MRC file too short " << filename << std::endl;
+      return false;
+    }
+    std::memcpy(headerData, source->mapped.data(), sizeof(MRCHeader));
+  } else {
+    source->stream.open(filename, std::ios::binary);
+    if (!source->stream.read(headerData, sizeof(MRCHeader))) {
+      std::cerr << "Voxels: Cannot read MRC file " << filename << std::endl;
+      return false;
+    }
+    source->stream.seekg(0, std::ios::end);
+    fileSize = uint64_t(source->stream.tellg());
+  }
 
-   return true;
-}
-*/
-
-bool Voxels::linePlaneIntersection(const Vec3f &P0, const Vec3f &P1,
-                                   const Vec3f &planeCenter,
-                                   const Vec3f &planeNormal,
-                                   Vec3f *intersection) {
-  Vec3f P10 = P1 - P0;
-  Vec3f P20 = planeCenter - P0;
-  Vec3f P02 = P0 - planeCenter;
-  float nDot10 = planeNormal.dot(P10);
-  float nDot20 = planeNormal.dot(P20);
-
-  if (nDot10 == 0) {
+  MRCHeader header;
+  if (!parseMRC(headerData, header, source->swapped)) {
+    std::cerr << "Voxels: Invalid MRC header in " << filename << std::endl;
     return false;
   }
 
-  float u = nDot20 / nDot10;
+  source->mode = header.mode;
+  switch (header.mode) {
+    case MRC_IMAGE_SINT8:
+      source->voxelBytes = 1;
+      break;
+    case MRC_IMAGE_SINT16:
+    case MRC_IMAGE_UINT16:
+      source->voxelBytes = 2;
+      break;
+    case MRC_IMAGE_FLOAT32:
+      source->voxelBytes = 4;
+      break;
+    default:
+      std::cerr << "Voxels: MRC mode " << header.mode << " not supported"
+                << std::endl;
+      return false;
+  }
+  if (header.mapx != 1 || header.mapy != 2 || header.mapz != 3) {
+    std::cerr << "Voxels: MRC axis order " << header.mapx << header.mapy
+              << header.mapz << " read as 123" << std::endl;
+  }
 
-  if (u > 1.0 || u < 0.0) {
+  // Extended header sits between the header and the data
+  source->dataOffset = sizeof(MRCHeader) + uint64_t(header.next);
+  uint64_t dataSize = uint64_t(header.nx) * header.ny * header.nz *
+                      source->voxelBytes;
+  if (fileSize < source->dataOffset + dataSize) {
+    std::cerr << "Voxels: MRC file truncated " << filename << std::endl;
     return false;
   }
 
-  *intersection = P0 + P10 * u;  // testing a new intersect calculation
+  format(header.nx, header.ny, header.nz, mBrickSize);
+  mSource = std::move(source);
+
+  // Cell dimensions are in angstroms for the whole sampled grid
+  m_units = VOX_NANOMETERS;
+  const float lengths[3] = {header.xlen, header.ylen, header.zlen};
+  const int32_t intervals[3] = {header.mx > 0 ? header.mx : header.nx,
+                                header.my > 0 ? header.my : header.ny,
+                                header.mz > 0 ? header.mz : header.nz};
+  for (int i = 0; i < 3; i++) {
+    m_voxWidth[i] = lengths[i] > 0.f ? lengths[i] / intervals[i] * 0.1f : 1.f;
+  }
+
+  m_min = header.amin;
+  m_max = header.amax;
+  m_mean = header.amean;
+  m_rms = header.rms;
 
   return true;
 }
 
-std::vector<Vec3f> Voxels::linspace(Vec3f a, Vec3f b, int n) {
-  std::vector<Vec3f> arr;
-  Vec3f ba = b - a;
-  Vec3f step = Vec3f(ba.x / (n - 1.0), ba.y / (n - 1.0), ba.z / (n - 1.0));
-  //  std::cout << ba.x << " " << ba.y << " " << ba.z << "\n";
-  //  std::cout << step.x << " " << step.y << " " << step.z << "\n";
+bool Voxels::loadFromMRC(std::string filename, UnitsTy ty, float voxWidth,
+                         MRCAccess access) {
+  return loadFromMRC(filename, ty, voxWidth, voxWidth, voxWidth, access);
+}
 
-  for (int i = 0; i < n; i++) {
-    arr.push_back(a);
-    a += step;
+bool Voxels::loadFromMRC(std::string filename, UnitsTy ty, float voxWidthX,
+                         float voxWidthY, float voxWidthZ, MRCAccess access) {
+  if (!loadFromMRC(filename, access)) {
+    return false;
   }
-  return arr;
+  init(voxWidthX, voxWidthY, voxWidthZ, ty);
+  return true;
 }
 
-Vec3f Voxels::point2Dto3D(Vec3f Q, Vec3f H, Vec3f K, float u, float v) {
-  return Vec3f(Q.x + u * H.x + v * K.x, Q.y + u * H.y + v * K.y,
-               Q.z + u * H.z + v * K.z);
-}
+bool Voxels::writeToMRC(std::string filename) {
+  std::ofstream file(filename, std::ios::binary);
+  if (!file) {
+    std::cerr << "Voxels: Cannot open MRC file " << filename << std::endl;
+    return false;
+  }
 
-bool Voxels::parallelLinespace(Vec3f p0, Vec3f p1, Vec3f p2, Vec3f p3,
-                               std::vector<Vec3f> &list,
-                               std::vector<Vec3f> &list2, float aDirection,
-                               float oDirection, std::vector<Vec3f> &points) {
-  Vec3f a = p0 - p1;
-  Vec3f b = p2 - p3;
-  float t = a.dot(b) / (a.mag() * b.mag());
-  t = round(t * 10000) / 10000;
-  int n = aDirection;
-  if ((p0 - p1).mag() / (p0 - p2).mag() == aDirection / oDirection) {
-    n = oDirection;
+  MRCHeader header;
+  std::memset(&header, 0, sizeof(header));
+  header.nx = header.mx = int32_t(width());
+  header.ny = header.my = int32_t(height());
+  header.nz = header.mz = int32_t(depth());
+  header.mode = MRC_IMAGE_FLOAT32;
+  // convert into angstrom
+  float toAngstrom = std::pow(10.f, float(m_units + 10));
+  header.xlen = m_voxWidth[0] * header.nx * toAngstrom;
+  header.ylen = m_voxWidth[1] * header.ny * toAngstrom;
+  header.zlen = m_voxWidth[2] * header.nz * toAngstrom;
+  header.alpha = header.beta = header.gamma = 90.f;
+  header.mapx = 1;
+  header.mapy = 2;
+  header.mapz = 3;
+  std::memcpy(header.cmap, "MAP ", 4);
+  uint16_t one = 1;
+  bool littleEndian = *reinterpret_cast<char *>(&one) == 1;
+  header.machinestamp[0] = littleEndian ? 0x44 : 0x11;
+  header.machinestamp[1] = littleEndian ? 0x44 : 0x11;
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+  // One section at a time, so the volume need not fit in memory
+  std::vector<float> section(size_t(width()) * height());
+  double sum = 0, sum2 = 0;
+  float amin = section.empty() ? 0.f : value(0, 0, 0);
+  float amax = amin;
+  for (uint32_t z = 0; z < depth(); z++) {
+    read(section.data(), 0, 0, int(z), width(), height(), 1);
+    for (float v : section) {
+      amin = std::min(amin, v);
+      amax = std::max(amax, v);
+      sum += v;
+      sum2 += double(v) * v;
+    }
+    file.write(reinterpret_cast<const char *>(section.data()),
+               std::streamsize(section.size() * sizeof(float)));
   }
-  std::cout.flush();
-  std::cout << "t = " << t << "\n";
-  if (t == -1.0) {
-    list = linspace(p0, p1, n);
-    list2 = linspace(p3, p2, n);
-    points.push_back(p0);
-    points.push_back(p1);
-    points.push_back(p3);
-    points.push_back(p2);
-    return true;
-  } else if (t == 1.0) {
-    list = linspace(p0, p1, n);
-    list2 = linspace(p2, p3, n);
-    points.push_back(p0);
-    points.push_back(p1);
-    points.push_back(p2);
-    points.push_back(p3);
-    return true;
+
+  double count = double(section.size()) * depth();
+  double mean = sum / count;
+  header.amin = m_min = amin;
+  header.amax = m_max = amax;
+  header.amean = m_mean = float(mean);
+  header.rms = m_rms = float(std::sqrt(std::max(0.0, sum2 / count - mean * mean)));
+  file.seekp(0);
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  if (!file) {
+    std::cerr << "Voxels: Cannot write MRC file " << filename << std::endl;
+    return false;
   }
-  return false;
+  return true;
 }
 
-// does this needs to be in voxels?  currently it isn't
-Array Voxels::slice(Vec3f planeCenter, Vec3f planeNormal,
-                    std::vector<Vec3f> &finalPointList) {
-  // assume point and vector are given in cell*width, cell*height, cell*depth
-  // coordinate system point and vector define a plane
-  // nice page on cube plane intersection
-  // http://cococubed.asu.edu/code_pages/raybox.shtml
-  // calculate Maxs
-  float xMax = width() * m_voxWidth[0];
-  float yMax = height() * m_voxWidth[1];
-  float zMax = depth() * m_voxWidth[2];
-
-  std::cout << "values " << xMax << " " << yMax << " " << zMax << "\n";
-  //
-  // calculate intersections
-  std::vector<Vec3f> P;
-  Vec3f intersection;
-  if (linePlaneIntersection(Vec3f(0, 0, 0), Vec3f(0, 0, zMax), planeCenter,
-                            planeNormal, &intersection))
-    P.push_back(intersection);
-  if (linePlaneIntersection(Vec3f(0, yMax, 0), Vec3f(0, yMax, zMax),
-                            planeCenter, planeNormal, &intersection))
-    P.push_back(intersection);
-  if (linePlaneIntersection(Vec3f(xMax, yMax, 0), Vec3f(xMax, yMax, zMax),
-                            planeCenter, planeNormal, &intersection))
-    P.push_back(intersection);
-  if (linePlaneIntersection(Vec3f(xMax, 0, 0), Vec3f(xMax, 0, zMax),
-                            planeCenter, planeNormal, &intersection))
-    P.push_back(intersection);
-  if (linePlaneIntersection(Vec3f(0, 0, 0), Vec3f(xMax, 0, 0), planeCenter,
-                            planeNormal, &intersection))
-    P.push_back(intersection);
-  if (linePlaneIntersection(Vec3f(0, yMax, 0), Vec3f(xMax, yMax, 0),
-                            planeCenter, planeNormal, &intersection))
-    P.push_back(intersection);
-  if (linePlaneIntersection(Vec3f(0, yMax, zMax), Vec3f(xMax, yMax, zMax),
-                            planeCenter, planeNormal, &intersection))
-    P.push_back(intersection);
-  if (linePlaneIntersection(Vec3f(xMax, 0, zMax), Vec3f(0, 0, zMax),
-                            planeCenter, planeNormal, &intersection))
-    P.push_back(intersection);
-  if (linePlaneIntersection(Vec3f(0, 0, 0), Vec3f(0, yMax, 0), planeCenter,
-                            planeNormal, &intersection))
-    P.push_back(intersection);
-  if (linePlaneIntersection(Vec3f(0, yMax, zMax), Vec3f(0, 0, zMax),
-                            planeCenter, planeNormal, &intersection))
-    P.push_back(intersection);
-  if (linePlaneIntersection(Vec3f(xMax, 0, zMax), Vec3f(xMax, yMax, zMax),
-                            planeCenter, planeNormal, &intersection))
-    P.push_back(intersection);
-  if (linePlaneIntersection(Vec3f(xMax, 0, 0), Vec3f(xMax, yMax, 0),
-                            planeCenter, planeNormal, &intersection))
-    P.push_back(intersection);
-
-  Array result = Array();  // XXX
-
-  if (P.size() > 1) {
-    Vec2f *p2D = new Vec2f[P.size()];
-    p2D[0] = Vec2f(0, 0);
-    float x = sqrt(pow(P[1].x - P[0].x, 2.0) + pow(P[1].y - P[0].y, 2.0) +
-                   pow(P[1].z - P[0].z, 2.0));
-    std::cout << x << "\n";
-    p2D[1] = Vec2f(x, 0);
-    if (P.size() == 2) {
-      // super easy, it's just a line :)
-      x = ceil(x);
-      result.format(1, type(), x);
-      std::vector<Vec3f> space = linspace(P[0], P[1], x);
-      for (unsigned j = 0; j < space.size(); j++) {
-        Vec3f point = space[j];
-        float temp[1] = {0};
-        if (point.x >= 0 && point.y >= 0 && point.z >= 0 &&
-            point.x <= width() * m_voxWidth[2] &&
-            point.y <= height() * m_voxWidth[1] &&
-            point.z <= depth() * m_voxWidth[2]) {
-          Vec3f p = Vec3f(point.x / m_voxWidth[0], point.y / m_voxWidth[1],
-                          point.z / m_voxWidth[2]);
-          read_interp(temp, p);
-        }
-        result.write(temp, j);
-      }
-    } else {
-      // Oh noes!  It's more than a line, this is a little more complex
-      float minA2D = 0, minO2D = 0, maxA2D = 0, maxO2D = 0;
-      // what are all these points in 2d on a plane
-      // http://stackoverflow.com/questions/10702099/computing-two-vectors-that-are-perpendicular-to-third-vector-in-3d
-      Vec3f y_axis = planeNormal.cross((P[0] - planeCenter).normalize());
-      Vec3f z_axis = planeNormal.cross(y_axis);
-      // http://stackoverflow.com/questions/23472048/projecting-3d-points-to-2d-plane
-      for (unsigned i = 0; i < P.size(); i++) {
-        Vec3f pi = P[i] - planeCenter;
-        float t_1 = y_axis.dot(pi);
-        float t_2 = z_axis.dot(pi);
-        minA2D = std::min(minA2D, t_1);
-        maxA2D = std::max(maxA2D, t_1);
-        minO2D = std::min(minO2D, t_2);
-        maxO2D = std::max(maxO2D, t_2);
-        p2D[i] = Vec2f(t_1, t_2);
-      }
-      int aDirection = ceil(maxA2D - minA2D);
-      int oDirection = ceil(maxO2D - minO2D);
-      // http://math.stackexchange.com/questions/525829/how-to-find-the-3d-coordinate-of-a-2d-point-on-a-known-plane
-      result.format(1, type(), aDirection, oDirection);
-      Vec3f p0 = point2Dto3D(planeCenter, y_axis, z_axis, minA2D, minO2D);
-      Vec3f p1 = point2Dto3D(planeCenter, y_axis, z_axis, minA2D, maxO2D);
-      Vec3f p2 = point2Dto3D(planeCenter, y_axis, z_axis, maxA2D, maxO2D);
-      Vec3f p3 = point2Dto3D(planeCenter, y_axis, z_axis, maxA2D, minO2D);
-      std::cout << "p0 :" << p0.x << " " << p0.y << " " << p0.z << "\n";
-      std::cout << "p1 :" << p1.x << " " << p1.y << " " << p1.z << "\n";
-      std::cout << "p2 :" << p2.x << " " << p2.y << " " << p2.z << "\n";
-      std::cout << "p3 :" << p3.x << " " << p3.y << " " << p3.z << "\n";
-      // Check to see if two lines intersect
-      std::vector<Vec3f> list;
-      std::vector<Vec3f> list2;
-      if (!parallelLinespace(p0, p1, p2, p3, list, list2, maxA2D - minA2D,
-                             maxO2D - minO2D, finalPointList)) {
-        if (!parallelLinespace(p0, p2, p1, p3, list, list2, maxA2D - minA2D,
-                               maxO2D - minO2D, finalPointList)) {
-          parallelLinespace(p0, p3, p1, p2, list, list2, maxA2D - minA2D,
-                            maxO2D - minO2D, finalPointList);
-        }
-      }
-      std::cout << "finalPointList Length:" << finalPointList.size() << "\n";
-      // now lets fill the results
-      for (unsigned i = 0; i < list.size(); i++) {
-        std::vector<Vec3f> space = linspace(
-            list[i], list2[i], oDirection);  // XXX should this be oDirection or
-                                             // aDirection, please check!
-        for (unsigned j = 0; j < space.size(); j++) {
-          Vec3f point = space[j];
-          float temp[1] = {0};
-          if (point.x >= 0 && point.y >= 0 && point.z >= 0 &&
-              point.x <= width() * m_voxWidth[2] &&
-              point.y <= height() * m_voxWidth[1] &&
-              point.z <= depth() * m_voxWidth[2]) {
-            Vec3f p = Vec3f(point.x / m_voxWidth[0], point.y / m_voxWidth[1],
-                            point.z / m_voxWidth[2]);
-            read_interp(temp, p);
-          }
-          result.write(temp, i, j);
-        }
-      }
-    }
-    delete[] p2D;
-  } else if (P.size() == 1) {
-    // Intersects at one point, this is super easy!
-    // calculate point and return array with single point
-    result.format(1, type(), 1);
-    Vec3f point = P[0];
-    float temp[1] = {0};
-    if (point.x >= 0 && point.y >= 0 && point.z >= 0 &&
-        point.x <= width() * m_voxWidth[2] &&
-        point.y <= height() * m_voxWidth[1] &&
-        point.z <= depth() * m_voxWidth[2]) {
-      Vec3f p = Vec3f(point.x / m_voxWidth[0], point.y / m_voxWidth[1],
-                      point.z / m_voxWidth[2]);
-      read_interp(temp, p);
-    }
-    result.write(temp, 0);
-  }
-  //  for (int i = 0; i < finalPointList.size(); i++){
-  //    finalPointList[i] = finalPointList[i]/Vec3f(xMax,yMax,zMax);
-  //  }
-  //  std::cout << "wtf" << "\n";
-  return result;
+void Voxels::print(FILE *fp) {
+  fprintf(fp, "Voxels %u x %u x %u, %d levels, %u^3 bricks\n", width(),
+          height(), depth(), levels(), brickSize());
+  fprintf(fp, "  cell:   %s, %s, %s\n", printVoxWidth(0).c_str(),
+          printVoxWidth(1).c_str(), printVoxWidth(2).c_str());
 }
 
 }  // namespace al
@@ -0,0 +1,866 @@
+#include "al/ui/al_ParameterJournal.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+using namespace al;
+
+namespace {
+
+const size_t journalHeaderSize = 16;
+
+void putUint(std::vector<char> &buf, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    buf.push_back(char((value >> (8 * i)) & 0xFF));
+  }
+}
+
+void putString(std::vector<char> &buf, const char *s, size_t length) {
+  putUint(buf, length, 2);
+  buf.insert(buf.end(), s, s + length);
+}
+
+uint64_t doubleBits(double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(double));
+  return bits;
+}
+
+double bitsDouble(uint64_t bits) {
+  double value;
+  memcpy(&value, &bits, sizeof(double));
+  return value;
+}
+
+// Bounds checked reading from the mapped journal
+struct JournalReader {
+  const char *data;
+  size_t size;
+  size_t pos;
+
+  bool getUint(uint64_t &value, int bytes) {
+    if (pos + bytes > size) {
+      return false;
+    }
+    value = 0;
+    for (int i = 0; i < bytes; i++) {
+      value |= uint64_t((unsigned char)data[pos + i]) << (8 * i);
+    }
+    pos += bytes;
+    return true;
+  }
+
+  bool getString(std::string &s) {
+    uint64_t length;
+    if (!getUint(length, 2) || pos + length > size) {
+      return false;
+    }
+    s.assign(data + pos, length);
+    pos += length;
+    return true;
+  }
+
+  bool skip(size_t bytes) {
+    if (pos + bytes > size) {
+      return false;
+    }
+    pos += bytes;
+    return true;
+  }
+
+  bool skipFields() {
+    uint64_t count, type, length;
+    if (!getUint(count, 1)) {
+      return false;
+    }
+    for (uint64_t i = 0; i < count; i++) {
+      if (!getUint(type, 1)) {
+        return false;
+      }
+      if (VariantType(type) == VariantType::VARIANT_STRING) {
+        if (!getUint(length, 2) || !skip(length)) {
+          return false;
+        }
+      } else if (!skip(8)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool getFields(std::vector<VariantValue> &fields) {
+    uint64_t count, type, bits;
+    if (!getUint(count, 1)) {
+      return false;
+    }
+    fields.clear();
+    fields.reserve(count);
+    for (uint64_t i = 0; i < count; i++) {
+      if (!getUint(type, 1)) {
+        return false;
+      }
+      if (VariantType(type) == VariantType::VARIANT_STRING) {
+        std::string s;
+        if (!getString(s)) {
+          return false;
+        }
+        fields.emplace_back(s);
+        continue;
+      }
+      if (!getUint(bits, 8)) {
+        return false;
+      }
+      switch (VariantType(type)) {
+      case VariantType::VARIANT_FLOAT:
+        fields.emplace_back(float(bitsDouble(bits)));
+        break;
+      case VariantType::VARIANT_DOUBLE:
+        fields.emplace_back(bitsDouble(bits));
+        break;
+      case VariantType::VARIANT_INT64:
+        fields.emplace_back(int64_t(bits));
+        break;
+      case VariantType::VARIANT_INT32:
+        fields.emplace_back(int32_t(bits));
+        break;
+      case VariantType::VARIANT_INT16:
+        fields.emplace_back(int16_t(bits));
+        break;
+      case VariantType::VARIANT_INT8:
+        fields.emplace_back(int8_t(bits));
+        break;
+      case VariantType::VARIANT_UINT64:
+        fields.emplace_back(uint64_t(bits));
+        break;
+      case VariantType::VARIANT_UINT32:
+        fields.emplace_back(uint32_t(bits));
+        break;
+      case VariantType::VARIANT_UINT16:
+        fields.emplace_back(uint16_t(bits));
+        break;
+      case VariantType::VARIANT_UINT8:
+        fields.emplace_back(uint8_t(bits));
+        break;
+      case VariantType::VARIANT_BOOL:
+        fields.emplace_back(bits != 0);
+        break;
+      default:
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+// Encode fields for snapshots from the values returned by getFields()
+void putFields(std::vector<char> &buf, std::vector<VariantValue> &fields) {
+  size_t count = std::min(fields.size(), size_t(255));
+  putUint(buf, count, 1);
+  for (size_t i = 0; i < count; i++) {
+    VariantValue &field = fields[i];
+    putUint(buf, uint8_t(field.type()), 1);
+    switch (field.type()) {
+    case VariantType::VARIANT_STRING: {
+      std::string s = field.get<std::string>();
+      putString(buf, s.data(), std::min(s.size(), size_t(0xFFFF)));
+      break;
+    }
+    case VariantType::VARIANT_FLOAT:
+    case VariantType::VARIANT_DOUBLE:
+      putUint(buf, doubleBits(field.toDouble()), 8);
+      break;
+    case VariantType::VARIANT_INT64:
+      putUint(buf, uint64_t(field.get<int64_t>()), 8);
+      break;
+    case VariantType::VARIANT_INT32:
+      putUint(buf, uint64_t(int64_t(field.get<int32_t>())), 8);
+      break;
+    case VariantType::VARIANT_INT16:
+      putUint(buf, uint64_t(int64_t(field.get<int16_t>())), 8);
+      break;
+    case VariantType::VARIANT_INT8:
+      putUint(buf, uint64_t(int64_t(field.get<int8_t>())), 8);
+      break;
+    case VariantType::VARIANT_UINT64:
+      putUint(buf, field.get<uint64_t>(), 8);
+      break;
+    case VariantType::VARIANT_UINT32:
+      putUint(buf, field.get<uint32_t>(), 8);
+      break;
+    case VariantType::VARIANT_UINT16:
+      putUint(buf, field.get<uint16_t>(), 8);
+      break;
+    case VariantType::VARIANT_UINT8:
+      putUint(buf, field.get<uint8_t>(), 8);
+      break;
+    case VariantType::VARIANT_BOOL:
+      putUint(buf, field.get<bool>() ? 1 : 0, 8);
+      break;
+    default: // Unsupported types are stored as double
+      buf.back() = char(VariantType::VARIANT_DOUBLE);
+      putUint(buf, doubleBits(field.toDouble()), 8);
+    }
+  }
+}
+
+// Copy of parameter values into the fixed size captured change. The change
+// type is deduced so these can fill ParameterJournal's private struct.
+VariantType variantType(float) { return VariantType::VARIANT_FLOAT; }
+VariantType variantType(double) { return VariantType::VARIANT_DOUBLE; }
+VariantType variantType(int64_t) { return VariantType::VARIANT_INT64; }
+VariantType variantType(int32_t) { return VariantType::VARIANT_INT32; }
+VariantType variantType(int16_t) { return VariantType::VARIANT_INT16; }
+VariantType variantType(int8_t) { return VariantType::VARIANT_INT8; }
+VariantType variantType(uint64_t) { return VariantType::VARIANT_UINT64; }
+VariantType variantType(uint32_t) { return VariantType::VARIANT_UINT32; }
+VariantType variantType(uint16_t) { return VariantType::VARIANT_UINT16; }
+VariantType variantType(uint8_t) { return VariantType::VARIANT_UINT8; }
+VariantType variantType(bool) { return VariantType::VARIANT_BOOL; }
+
+template <class Change, class T>
+void captureNumber(Change &change, T value, std::true_type /*isFloat*/) {
+  change.types[change.numFields] = uint8_t(variantType(value));
+  change.values[change.numFields++] = doubleBits(double(value));
+}
+
+template <class Change, class T>
+void captureNumber(Change &change, T value, std::false_type /*isFloat*/) {
+  change.types[change.numFields] = uint8_t(variantType(value));
+  change.values[change.numFields++] = uint64_t(int64_t(value));
+}
+
+template <class Change, class T>
+void captureValue(Change &change, const T &value) {
+  if (change.numFields < ParameterJournal::kMaxFields) {
+    captureNumber(change, value, std::is_floating_point<T>());
+  }
+}
+
+template <class Change>
+void captureValue(Change &change, const std::string &value) {
+  if (change.numFields >= ParameterJournal::kMaxFields) {
+    return;
+  }
+  size_t offset = 0;
+  for (int i = 0; i < change.numFields; i++) {
+    if (VariantType(change.types[i]) == VariantType::VARIANT_STRING) {
+      offset += strlen(change.strings + change.values[i]) + 1;
+    }
+  }
+  if (offset >= ParameterJournal::kMaxStringBytes) {
+    return;
+  }
+  size_t length = std::min(value.size(),
+                           size_t(ParameterJournal::kMaxStringBytes - offset - 1));
+  memcpy(change.strings + offset, value.data(), length);
+  change.strings[offset + length] = '\0';
+  change.types[change.numFields] = uint8_t(VariantType::VARIANT_STRING);
+  change.values[change.numFields++] = offset;
+}
+
+template <class Change, int N>
+void captureValue(Change &change, const Vec<N, float> &value) {
+  for (int i = 0; i < N; i++) {
+    captureValue(change, value[i]);
+  }
+}
+
+// Same fields as ParameterPose::getFields()
+template <class Change> void captureValue(Change &change, const Pose &value) {
+  for (int i = 0; i < 3; i++) {
+    captureValue(change, float(value.pos()[i]));
+  }
+  Quatd quat = value.quat();
+  captureValue(change, float(quat.w));
+  captureValue(change, float(quat.x));
+  captureValue(change, float(quat.y));
+  captureValue(change, float(quat.z));
+}
+
+template <class Change> void captureValue(Change &change, const Color &value) {
+  captureValue(change, value.r);
+  captureValue(change, value.g);
+  captureValue(change, value.b);
+  captureValue(change, value.a);
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// ParameterJournal
+
+ParameterJournal::~ParameterJournal() { stopRecord(); }
+
+template <class ParameterType>
+bool ParameterJournal::registerWrapper(ParameterMeta &p, uint16_t id) {
+  auto *param = dynamic_cast<ParameterWrapper<ParameterType> *>(&p);
+  if (!param) {
+    return false;
+  }
+  param->registerChangeCallback([this, id](ParameterType value,
+                                           ValueSource *src) {
+    if (mRecording.load(std::memory_order_acquire)) {
+      CapturedChange *change = reserveChange(id, src);
+      if (change) {
+        captureValue(*change, value);
+        commitChange(change);
+      }
+    }
+  });
+  return true;
+}
+
+void ParameterJournal::registerParameter(ParameterMeta &p) {
+  if (mRecording || mWriterThread) {
+    std::cerr << "ERROR: Can't register parameters while journal is recording: "
+              << p.getFullAddress() << std::endl;
+    return;
+  }
+  if (std::find(mParameters.begin(), mParameters.end(), &p) !=
+      mParameters.end()) {
+    return;
+  }
+  if (mParameters.size() >= 0xFFFF) {
+    std::cerr << "ERROR: Too many parameters in journal" << std::endl;
+    return;
+  }
+  uint16_t id = uint16_t(mParameters.size());
+  ParameterMenu *menu = dynamic_cast<ParameterMenu *>(&p);
+  if (menu) {
+    // The index is turned into the element text by the writer thread
+    menu->registerChangeCallback([this, id](int32_t value, ValueSource *src) {
+      if (mRecording.load(std::memory_order_acquire)) {
+        CapturedChange *change = reserveChange(id, src);
+        if (change) {
+          captureValue(*change, value);
+          commitChange(change);
+        }
+      }
+    });
+  } else if (!registerWrapper<float>(p, id) &&
+             !registerWrapper<double>(p, id) &&
+             !registerWrapper<int32_t>(p, id) &&
+             !registerWrapper<int64_t>(p, id) &&
+             !registerWrapper<int16_t>(p, id) &&
+             !registerWrapper<int8_t>(p, id) &&
+             !registerWrapper<uint64_t>(p, id) &&
+             !registerWrapper<uint32_t>(p, id) &&
+             !registerWrapper<uint16_t>(p, id) &&
+             !registerWrapper<uint8_t>(p, id) &&
+             !registerWrapper<bool>(p, id) &&
+             !registerWrapper<std::string>(p, id) &&
+             !registerWrapper<Vec3f>(p, id) && !registerWrapper<Vec4f>(p, id) &&
+             !registerWrapper<Vec5f>(p, id) && !registerWrapper<Pose>(p, id) &&
+             !registerWrapper<Color>(p, id)) {
+    std::cerr << "ERROR: Unsupported parameter type for journal: "
+              << p.getFullAddress() << std::endl;
+    return;
+  }
+  mParameters.push_back(&p);
+  mMenus.push_back(menu);
+}
+
+void ParameterJournal::sampleClock(std::function<uint64_t()> clock,
+                                   double sampleRate) {
+  mPendingSampleClock = clock;
+  mPendingSampleRate = sampleRate;
+}
+
+uint64_t ParameterJournal::now() const {
+  if (mSampleClock) {
+    return mSampleClock();
+  }
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - mClockStart)
+      .count();
+}
+
+bool ParameterJournal::startRecord(std::string path) {
+  if (mRecording) {
+    std::cerr << "ERROR: ParameterJournal already recording" << std::endl;
+    return false;
+  }
+  if (mWriterThread) { // Stopped by maxRecordTime()
+    stopRecord();
+  }
+  mFile.open(path, std::ios::binary | std::ios::trunc);
+  if (!mFile.is_open()) {
+    std::cerr << "ERROR: Could not open journal for writing: " << path
+              << std::endl;
+    return false;
+  }
+  if (!mQueue) {
+    mQueue.reset(new CapturedChange[kQueueSize]);
+    for (size_t i = 0; i < kQueueSize; i++) {
+      mQueue[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+  // Discard changes that were pushed while the previous recording stopped
+  collectChanges(false);
+  mDroppedChanges = 0;
+  mSources.clear();
+  mBuffer.clear();
+
+  // Callbacks only call now() while recording, so the clock can change here
+  if (mPendingSampleClock && mPendingSampleRate > 0) {
+    mSampleClock = mPendingSampleClock;
+  } else {
+    mSampleClock = nullptr;
+  }
+  mTickRate = mSampleClock ? mPendingSampleRate : 1.0e6;
+  mClockStart = std::chrono::steady_clock::now();
+  mStartTime = now();
+  mMaxTicks = uint64_t(std::max(mMaxRecordTime, 0.0) * mTickRate);
+  mLastTime = 0;
+  mLastSnapshot = 0;
+
+  mBuffer.insert(mBuffer.end(), magic, magic + 4);
+  putUint(mBuffer, formatVersion, 4);
+  putUint(mBuffer, doubleBits(mTickRate), 8);
+  mCurrentValues.clear();
+  for (size_t i = 0; i < mParameters.size(); i++) {
+    std::string address = mParameters[i]->getFullAddress();
+    mBuffer.push_back('p');
+    putUint(mBuffer, i, 2);
+    putString(mBuffer, address.data(), std::min(address.size(), size_t(0xFFFF)));
+    std::vector<VariantValue> fields;
+    mParameters[i]->getFields(fields);
+    mCurrentValues.emplace_back();
+    putFields(mCurrentValues.back(), fields);
+  }
+  // Initial values
+  mBuffer.push_back('k');
+  putUint(mBuffer, 0, 8);
+  putUint(mBuffer, mCurrentValues.size(), 2);
+  for (size_t i = 0; i < mCurrentValues.size(); i++) {
+    putUint(mBuffer, i, 2);
+    mBuffer.insert(mBuffer.end(), mCurrentValues[i].begin(),
+                   mCurrentValues[i].end());
+  }
+
+  mRecording = true;
+  mRunWriter = true;
+  mWriterThread =
+      std::make_unique<std::thread>(&ParameterJournal::writerLoop, this);
+  return true;
+}
+
+void ParameterJournal::stopRecord() {
+  if (!mWriterThread) {
+    return;
+  }
+  mRunWriter = false;
+  mWriterThread->join();
+  mWriterThread = nullptr;
+  collectChanges(true);
+  mRecording = false;
+  mFile.write(mBuffer.data(), mBuffer.size());
+  mBuffer.clear();
+  mFile.close();
+  if (mFile.fail()) {
+    std::cerr << "ERROR: Writing parameter journal" << std::endl;
+  }
+  if (mDroppedChanges > 0) {
+    std::cerr << "WARNING: ParameterJournal dropped " << mDroppedChanges
+              << " changes. Change queue full." << std::endl;
+  }
+}
+
+ParameterJournal::CapturedChange *
+ParameterJournal::reserveChange(uint16_t id, ValueSource *src) {
+  uint64_t time = now();
+  CapturedChange *change;
+  size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+  while (true) {
+    change = &mQueue[pos % kQueueSize];
+    size_t sequence = change->sequence.load(std::memory_order_acquire);
+    intptr_t diff = intptr_t(sequence) - intptr_t(pos);
+    if (diff == 0) {
+      if (mEnqueuePos.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) { // Queue full
+      mDroppedChanges++;
+      return nullptr;
+    } else {
+      pos = mEnqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+  change->time = time;
+  change->parameterId = id;
+  change->numFields = 0;
+  change->hasSource = src != nullptr;
+  if (src) {
+    size_t length =
+        std::min(src->ipAddr.size(), size_t(kMaxSourceBytes - 1));
+    memcpy(change->source, src->ipAddr.data(), length);
+    change->source[length] = '\0';
+    change->sourcePort = src->port;
+  }
+  return change;
+}
+
+void ParameterJournal::commitChange(CapturedChange *change) {
+  size_t pos = change->sequence.load(std::memory_order_relaxed);
+  change->sequence.store(pos + 1, std::memory_order_release);
+}
+
+void ParameterJournal::collectChanges(bool write) {
+  if (!mQueue) {
+    return;
+  }
+  uint64_t snapshotTicks = uint64_t(mSnapshotInterval * mTickRate);
+  while (true) {
+    CapturedChange &change = mQueue[mDequeuePos % kQueueSize];
+    if (change.sequence.load(std::memory_order_acquire) != mDequeuePos + 1) {
+      break;
+    }
+    uint64_t time = change.time > mStartTime ? change.time - mStartTime : 0;
+    if (write && (mMaxTicks == 0 || time <= mMaxTicks)) {
+      // Changes from different threads can arrive slightly out of order.
+      // Keep times increasing so the player can stop at the first later one
+      time = std::max(time, mLastTime);
+      mLastTime = time;
+
+      uint16_t sourceId = 0;
+      if (change.hasSource) {
+        std::string source =
+            std::string(change.source, strnlen(change.source, kMaxSourceBytes)) +
+            ":" + std::to_string(change.sourcePort);
+        auto sourceIt = mSources.find(source);
+        if (sourceIt == mSources.end()) {
+          sourceIt =
+              mSources.insert({source, uint16_t(mSources.size() + 1)}).first;
+          mBuffer.push_back('s');
+          putUint(mBuffer, sourceIt->second, 2);
+          putString(mBuffer, source.data(), source.size());
+        }
+        sourceId = sourceIt->second;
+      }
+
+      std::vector<char> &fields = mCurrentValues[change.parameterId];
+      fields.clear();
+      ParameterMenu *menu = mMenus[change.parameterId];
+      if (menu) {
+        // Element text like ParameterMenu::getFields()
+        int32_t index = int32_t(change.values[0]);
+        auto elements = menu->getElements();
+        change.numFields = 0;
+        if (index >= 0 && index < int32_t(elements.size())) {
+          captureValue(change, elements[index]);
+        }
+      }
+      putUint(fields, change.numFields, 1);
+      for (int i = 0; i < change.numFields; i++) {
+        putUint(fields, change.types[i], 1);
+        if (VariantType(change.types[i]) == VariantType::VARIANT_STRING) {
+          const char *s = change.strings + change.values[i];
+          putString(fields, s, strnlen(s, kMaxStringBytes - change.values[i]));
+        } else {
+          putUint(fields, change.values[i], 8);
+        }
+      }
+      mBuffer.push_back('c');
+      putUint(mBuffer, time, 8);
+      putUint(mBuffer, change.parameterId, 2);
+      putUint(mBuffer, sourceId, 2);
+      mBuffer.insert(mBuffer.end(), fields.begin(), fields.end());
+
+      if (time - mLastSnapshot >= snapshotTicks) {
+        mBuffer.push_back('k');
+        putUint(mBuffer, time, 8);
+        putUint(mBuffer, mCurrentValues.size(), 2);
+        for (size_t i = 0; i < mCurrentValues.size(); i++) {
+          putUint(mBuffer, i, 2);
+          mBuffer.insert(mBuffer.end(), mCurrentValues[i].begin(),
+                         mCurrentValues[i].end());
+        }
+        mLastSnapshot = time;
+      }
+    }
+    change.sequence.store(mDequeuePos + kQueueSize, std::memory_order_release);
+    mDequeuePos++;
+  }
+}
+
+void ParameterJournal::writerLoop() {
+  while (mRunWriter) {
+    if (mRecording && mMaxTicks > 0 && now() > mStartTime + mMaxTicks) {
+      mRecording = false; // Later changes are no longer queued
+    }
+    collectChanges(true);
+    if (mBuffer.size() > 0) {
+      mFile.write(mBuffer.data(), mBuffer.size());
+      mFile.flush();
+      mBuffer.clear();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+
+// ---------------------------------------------------------------------------
+// ParameterJournalPlayer
+
+bool ParameterJournalPlayer::open(std::string path) {
+  close();
+  if (!mFile.open(path)) {
+    return false;
+  }
+  JournalReader reader{mFile.data(), mFile.size(), 0};
+  uint64_t version, tickRateBits;
+  if (mFile.size() < journalHeaderSize ||
+      memcmp(mFile.data(), ParameterJournal::magic, 4) != 0) {
+    std::cerr << "ERROR: Not a parameter journal: " << path << std::endl;
+    close();
+    return false;
+  }
+  reader.pos = 4;
+  reader.getUint(version, 4);
+  reader.getUint(tickRateBits, 8);
+  mTickRate = bitsDouble(tickRateBits);
+  if (version != ParameterJournal::formatVersion || !(mTickRate > 0)) {
+    std::cerr << "ERROR: Unsupported parameter journal version " << version
+              << ": " << path << std::endl;
+    close();
+    return false;
+  }
+  // Index snapshots and definitions. A journal still being written or cut
+  // short is used up to its last complete record.
+  mSourceNames.push_back("");
+  uint64_t lastTime = 0;
+  while (reader.pos < reader.size) {
+    size_t recordStart = reader.pos;
+    char type = reader.data[reader.pos++];
+    uint64_t id, time, count;
+    std::string name;
+    bool ok = true;
+    if (type == 'p') {
+      ok = reader.getUint(id, 2) && reader.getString(name);
+      if (ok) {
+        if (id >= mAddresses.size()) {
+          mAddresses.resize(id + 1);
+        }
+        mAddresses[id] = name;
+      }
+    } else if (type == 's') {
+      ok = reader.getUint(id, 2) && reader.getString(name);
+      if (ok) {
+        if (id >= mSourceNames.size()) {
+          mSourceNames.resize(id + 1);
+        }
+        mSourceNames[id] = name;
+      }
+    } else if (type == 'k') {
+      ok = reader.getUint(time, 8) && reader.getUint(count, 2);
+      for (uint64_t i = 0; ok && i < count; i++) {
+        ok = reader.skip(2) && reader.skipFields();
+      }
+      if (ok) {
+        mSnapshots.push_back({time, recordStart});
+        lastTime = time;
+      }
+    } else if (type == 'c') {
+      ok = reader.getUint(time, 8) && reader.skip(4) && reader.skipFields();
+      if (ok) {
+        lastTime = time;
+      }
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      std::cerr << "WARNING: Parameter journal truncated at " << recordStart
+                << ": " << path << std::endl;
+      reader.size = recordStart;
+      break;
+    }
+  }
+  mValidSize = reader.size;
+  if (mSnapshots.empty()) {
+    std::cerr << "ERROR: Parameter journal has no snapshots: " << path
+              << std::endl;
+    close();
+    return false;
+  }
+  mDuration = lastTime / mTickRate;
+  mPosition = 0;
+  mReadOffset = mSnapshots[0].offset;
+  return true;
+}
+
+void ParameterJournalPlayer::close() {
+  mFile.close();
+  mAddresses.clear();
+  mSourceNames.clear();
+  mSnapshots.clear();
+  mValidSize = 0;
+  mDuration = 0;
+  mPosition = 0;
+  mReadOffset = 0;
+}
+
+void ParameterJournalPlayer::registerParameter(ParameterMeta &p) {
+  mParameters[p.getFullAddress()] = &p;
+}
+
+bool ParameterJournalPlayer::findState(
+    uint64_t ticks, std::vector<std::vector<VariantValue>> &state,
+    std::vector<bool> &valid, size_t &nextRecord) {
+  if (mSnapshots.empty()) {
+    return false;
+  }
+  auto snapshotIt = std::upper_bound(
+      mSnapshots.begin(), mSnapshots.end(), ticks,
+      [](uint64_t t, const Snapshot &snapshot) { return t < snapshot.time; });
+  if (snapshotIt != mSnapshots.begin()) {
+    snapshotIt--;
+  }
+  state.clear();
+  state.resize(mAddresses.size());
+  valid.assign(mAddresses.size(), false);
+
+  JournalReader reader{mFile.data(), mValidSize, snapshotIt->offset + 1};
+  uint64_t time, count, id, sourceId;
+  reader.getUint(time, 8);
+  reader.getUint(count, 2);
+  for (uint64_t i = 0; i < count; i++) {
+    std::vector<VariantValue> fields;
+    if (!reader.getUint(id, 2) || !reader.getFields(fields)) {
+      return false;
+    }
+    if (id < state.size()) {
+      state[id] = std::move(fields);
+      valid[id] = true;
+    }
+  }
+  // Replay the changes between the snapshot and the requested time
+  while (reader.pos < reader.size) {
+    size_t recordStart = reader.pos;
+    char type = reader.data[reader.pos++];
+    if (type == 'c' || type == 'k') {
+      reader.getUint(time, 8);
+      if (time > ticks) {
+        reader.pos = recordStart;
+        break;
+      }
+      if (type == 'k') {
+        reader.getUint(count, 2);
+        for (uint64_t i = 0; i < count; i++) {
+          reader.skip(2);
+          reader.skipFields();
+        }
+        continue;
+      }
+      std::vector<VariantValue> fields;
+      reader.getUint(id, 2);
+      reader.getUint(sourceId, 2);
+      reader.getFields(fields);
+      if (id < state.size()) {
+        state[id] = std::move(fields);
+        valid[id] = true;
+      }
+    } else { // Definitions, already indexed by open()
+      reader.skip(2);
+      std::string name;
+      reader.getString(name);
+    }
+  }
+  nextRecord = reader.pos;
+  return true;
+}
+
+bool ParameterJournalPlayer::stateAt(double time, ParameterStates &values) {
+  std::vector<std::vector<VariantValue>> state;
+  std::vector<bool> valid;
+  size_t nextRecord;
+  uint64_t ticks = time > 0 ? uint64_t(time * mTickRate) : 0;
+  if (!findState(ticks, state, valid, nextRecord)) {
+    return false;
+  }
+  values.clear();
+  for (size_t i = 0; i < state.size(); i++) {
+    if (valid[i]) {
+      values[mAddresses[i]] = state[i];
+    }
+  }
+  return true;
+}
+
+void ParameterJournalPlayer::applyFields(uint16_t id,
+                                         std::vector<VariantValue> &fields) {
+  if (id >= mAddresses.size() || fields.empty()) {
+    return;
+  }
+  auto paramIt = mParameters.find(mAddresses[id]);
+  if (paramIt != mParameters.end()) {
+    paramIt->second->setFields(fields);
+  }
+}
+
+bool ParameterJournalPlayer::seek(double time) {
+  std::vector<std::vector<VariantValue>> state;
+  std::vector<bool> valid;
+  size_t nextRecord;
+  uint64_t ticks = time > 0 ? uint64_t(time * mTickRate) : 0;
+  if (!findState(ticks, state, valid, nextRecord)) {
+    return false;
+  }
+  for (size_t i = 0; i < state.size(); i++) {
+    if (valid[i]) {
+      applyFields(uint16_t(i), state[i]);
+    }
+  }
+  mPosition = std::max(time, 0.0);
+  mReadOffset = nextRecord;
+  return true;
+}
+
+bool ParameterJournalPlayer::advance(double time) {
+  if (!mFile.opened()) {
+    return false;
+  }
+  if (time < mPosition) {
+    return seek(time);
+  }
+  uint64_t ticks = uint64_t(time * mTickRate);
+  JournalReader reader{mFile.data(), mValidSize, mReadOffset};
+  uint64_t recordTime, count, id, sourceId;
+  while (reader.pos < reader.size) {
+    size_t recordStart = reader.pos;
+    char type = reader.data[reader.pos++];
+    if (type == 'c' || type == 'k') {
+      reader.getUint(recordTime, 8);
+      if (recordTime > ticks) {
+        reader.pos = recordStart;
+        break;
+      }
+      if (type == 'k') {
+        reader.getUint(count, 2);
+        for (uint64_t i = 0; i < count; i++) {
+          reader.skip(2);
+          reader.skipFields();
+        }
+        continue;
+      }
+      std::vector<VariantValue> fields;
+      reader.getUint(id, 2);
+      reader.getUint(sourceId, 2);
+      reader.getFields(fields);
+      applyFields(uint16_t(id), fields);
+      if (mChangeCallback && id < mAddresses.size()) {
+        const std::string &source =
+            sourceId < mSourceNames.size() ? mSourceNames[sourceId] : "";
+        mChangeCallback(mAddresses[id], fields, source,
+                        recordTime / mTickRate);
+      }
+    } else {
+      reader.skip(2);
+      std::string name;
+      reader.getString(name);
+    }
+  }
+  mReadOffset = reader.pos;
+  mPosition = time;
+  return true;
+}
@@ -5,6 +5,7 @@
 
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <cstring>
 
 constexpr int handshakeServerPort = 16987;
@@ -17,142 +18,195 @@ using namespace al;
 OSCNotifier::OSCNotifier() { mHandshakeHandler.notifier = this; }
 
 OSCNotifier::~OSCNotifier() {
+  {
+    std::unique_lock<std::mutex> lk(mQueueLock);
+    mSenderRunning = false;
+  }
+  mQueueCondition.notify_all();
+  if (mSenderThread) {
+    mSenderThread->join();
+  }
+  flush();
   for (osc::Send *sender : mOSCSenders) {
     delete sender;
   }
 }
 
-void OSCNotifier::notifyListeners(std::string OSCaddress, float value,
-                                  ValueSource *src) {
-  mListenerLock.lock();
-  for (osc::Send *sender : mOSCSenders) {
-    auto ip = Socket::nameToIp(sender->address());
+std::string OSCNotifier::resolveListenerAddress(const std::string &address) {
+  return Socket::nameToIp(address);
+}
 
-    if (!src || (src->port == 0 && src->ipAddr != ip) ||
-        (src->port != sender->port() && src->ipAddr != ip)) {
-      sender->send(OSCaddress, value);
-    }
-    //		std::cout << "Notifying " << sender->address() << ":" <<
-    // sender->port() << " -- " << OSCaddress << std::endl;
+namespace {
+
+void appendBigEndian32(std::vector<char> &buf, uint32_t value) {
+  buf.push_back(char((value >> 24) & 0xFF));
+  buf.push_back(char((value >> 16) & 0xFF));
+  buf.push_back(char((value >> 8) & 0xFF));
+  buf.push_back(char(value & 0xFF));
+}
+
+void sendBundle(osc::Send *sender, std::vector<char> &bundle,
+                const std::vector<char> *single, int numMessages) {
+  if (numMessages == 1) {
+    // No need for bundle overhead
+    sender->sendRaw(single->data(), single->size());
+  } else if (numMessages > 1) {
+    sender->sendRaw(bundle.data(), bundle.size());
   }
-  mListenerLock.unlock();
 }
 
-void OSCNotifier::notifyListeners(std::string OSCaddress, int value,
-                                  ValueSource *src) {
-  mListenerLock.lock();
-  for (osc::Send *sender : mOSCSenders) {
-    auto ip = Socket::nameToIp(sender->address());
+// Don't echo values back to where they came from
+bool isEcho(const ValueSource *src, osc::Send *sender, const std::string &ip) {
+  return src && !((src->port == 0 && src->ipAddr != ip) ||
+                  (src->port != sender->port() && src->ipAddr != ip));
+}
 
-    if (!src || (src->port == 0 && src->ipAddr != ip) ||
-        (src->port != sender->port() && src->ipAddr != ip)) {
-      sender->send(OSCaddress, value);
+} // namespace
+
+template <class... Args>
+void OSCNotifier::queueMessage(const std::string &OSCaddress, ValueSource *src,
+                               bool coalesce, const Args &...args) {
+  osc::Packet p;
+  p.addMessage(OSCaddress, args...);
+  if (mCoalesceInterval <= 0) {
+    std::unique_lock<std::mutex> lk(mListenerLock);
+    // Messages queued while coalescing was enabled go first
+    sendQueued();
+    for (size_t i = 0; i < mOSCSenders.size(); i++) {
+      if (!isEcho(src, mOSCSenders[i], mListenerIps[i])) {
+        mOSCSenders[i]->sendRaw(p.data(), p.size());
+      }
     }
-    //        std::cout << "Notifying " << sender->address() << ":" <<
-    //        sender->port() << " -- " << OSCaddress << std::endl;
+    return;
   }
-  mListenerLock.unlock();
+  std::unique_lock<std::mutex> lk(mQueueLock);
+  auto existing = coalesce ? mQueueIndex.find(OSCaddress) : mQueueIndex.end();
+  QueuedMessage *message;
+  if (existing != mQueueIndex.end()) {
+    // Last value wins, keeping the position of the first notification
+    message = &mQueue[existing->second];
+  } else {
+    if (coalesce) {
+      mQueueIndex[OSCaddress] = mQueue.size();
+    }
+    mQueue.emplace_back();
+    message = &mQueue.back();
+  }
+  message->data.assign(p.data(), p.data() + p.size());
+  message->hasSource = src != nullptr;
+  if (src) {
+    message->source = *src;
+  }
+  if (!mSenderThread) {
+    mSenderRunning = true;
+    mSenderThread = std::make_unique<std::thread>([this]() { senderLoop(); });
+  }
+  lk.unlock();
+  mQueueCondition.notify_one();
 }
 
-void OSCNotifier::notifyListeners(std::string OSCaddress, std::string value,
-                                  ValueSource *src) {
-  mListenerLock.lock();
-  for (osc::Send *sender : mOSCSenders) {
-    auto ip = Socket::nameToIp(sender->address());
-
-    if (!src || (src->port == 0 && src->ipAddr != ip) ||
-        (src->port != sender->port() && src->ipAddr != ip)) {
-      sender->send(OSCaddress, value);
+void OSCNotifier::senderLoop() {
+  std::unique_lock<std::mutex> lk(mQueueLock);
+  while (mSenderRunning) {
+    mQueueCondition.wait(
+        lk, [this]() { return !mSenderRunning || !mQueue.empty(); });
+    if (!mSenderRunning) {
+      break;
+    }
+    lk.unlock();
+    // Gather further changes for the rest of the interval
+    if (mCoalesceInterval > 0) {
+      std::this_thread::sleep_for(
+          std::chrono::duration<double>(mCoalesceInterval));
     }
-    //    std::cout << "Notifying " << sender->address() << ":" <<
-    //    sender->port()
-    //              << " -- " << OSCaddress << std::endl;
+    flush();
+    lk.lock();
   }
-  mListenerLock.unlock();
 }
 
-void OSCNotifier::notifyListeners(std::string OSCaddress, Vec3f value,
-                                  ValueSource *src) {
-  mListenerLock.lock();
-  for (osc::Send *sender : mOSCSenders) {
-    auto ip = Socket::nameToIp(sender->address());
+void OSCNotifier::sendQueued() {
+  std::vector<QueuedMessage> queue;
+  {
+    std::unique_lock<std::mutex> lk(mQueueLock);
+    queue.swap(mQueue);
+    mQueueIndex.clear();
+  }
+  if (queue.empty()) {
+    return;
+  }
 
-    if (!src || (src->port == 0 && src->ipAddr != ip) ||
-        (src->port != sender->port() && src->ipAddr != ip)) {
-      sender->send(OSCaddress, value[0], value[1], value[2]);
+  // "#bundle" and an immediate time tag
+  const char bundleHeader[16] = {'#', 'b', 'u', 'n', 'd', 'l', 'e', 0,
+                                 0,   0,   0,   0,   0,   0,   0,   1};
+  std::vector<char> bundle;
+  for (size_t i = 0; i < mOSCSenders.size(); i++) {
+    osc::Send *sender = mOSCSenders[i];
+    const std::string &ip = mListenerIps[i];
+    bundle.assign(bundleHeader, bundleHeader + sizeof(bundleHeader));
+    const std::vector<char> *single = nullptr;
+    int numMessages = 0;
+    for (const auto &message : queue) {
+      if (isEcho(message.hasSource ? &message.source : nullptr, sender, ip)) {
+        continue;
+      }
+      if (numMessages > 0 &&
+          bundle.size() + 4 + message.data.size() > mMaxBundleSize) {
+        sendBundle(sender, bundle, single, numMessages);
+        bundle.resize(sizeof(bundleHeader));
+        numMessages = 0;
+      }
+      appendBigEndian32(bundle, uint32_t(message.data.size()));
+      bundle.insert(bundle.end(), message.data.begin(), message.data.end());
+      single = &message.data;
+      numMessages++;
     }
-    //		std::cout << "Notifying " << sender->address() << ":" <<
-    // sender->port() << " -- " << OSCaddress << std::endl;
+    sendBundle(sender, bundle, single, numMessages);
   }
-  mListenerLock.unlock();
 }
 
-void OSCNotifier::notifyListeners(std::string OSCaddress, Vec4f value,
+void OSCNotifier::notifyListeners(std::string OSCaddress, float value,
                                   ValueSource *src) {
-  mListenerLock.lock();
-  for (osc::Send *sender : mOSCSenders) {
-    auto ip = Socket::nameToIp(sender->address());
+  queueMessage(OSCaddress, src, true, value);
+}
 
-    if (!src || (src->port == 0 && src->ipAddr != ip) ||
-        (src->port != sender->port() && src->ipAddr != ip)) {
-      sender->send(OSCaddress, value[0], value[1], value[2], value[3]);
-    }
-    //		std::cout << "Notifying " << sender->address() << ":" <<
-    // sender->port() << " -- " << OSCaddress << std::endl;
-  }
-  mListenerLock.unlock();
+void OSCNotifier::notifyListeners(std::string OSCaddress, int value,
+                                  ValueSource *src) {
+  queueMessage(OSCaddress, src, true, value);
 }
 
-void OSCNotifier::notifyListeners(std::string OSCaddress, Vec5f value,
+void OSCNotifier::notifyListeners(std::string OSCaddress, std::string value,
                                   ValueSource *src) {
-  mListenerLock.lock();
-  for (osc::Send *sender : mOSCSenders) {
-    auto ip = Socket::nameToIp(sender->address());
+  queueMessage(OSCaddress, src, true, value);
+}
 
-    if (!src || (src->port == 0 && src->ipAddr != ip) ||
-        (src->port != sender->port() && src->ipAddr != ip)) {
-      sender->send(OSCaddress, value[0], value[1], value[2], value[3],
-                   value[4]);
-    }
-    //		std::cout << "Notifying " << sender->address() << ":" <<
-    // sender->port() << " -- " << OSCaddress << std::endl;
-  }
-  mListenerLock.unlock();
+void OSCNotifier::notifyListeners(std::string OSCaddress, Vec3f value,
+                                  ValueSource *src) {
+  queueMessage(OSCaddress, src, true, value.x, value.y, value.z);
 }
 
-void OSCNotifier::notifyListeners(std::string OSCaddress, Pose value,
+void OSCNotifier::notifyListeners(std::string OSCaddress, Vec4f value,
                                   ValueSource *src) {
-  mListenerLock.lock();
-  for (osc::Send *sender : mOSCSenders) {
-    auto ip = Socket::nameToIp(sender->address());
+  queueMessage(OSCaddress, src, true, value.x, value.y, value.z, value.w);
+}
 
-    if (!src || (src->port == 0 && src->ipAddr != ip) ||
-        (src->port != sender->port() && src->ipAddr != ip)) {
-      sender->send(OSCaddress, (float)value.pos()[0], (float)value.pos()[1],
-                   (float)value.pos()[2], (float)value.quat().w,
-                   (float)value.quat().x, (float)value.quat().y,
-                   (float)value.quat().z);
-    }
-    //		std::cout << "Notifying " << sender->address() << ":" <<
-    // sender->port() << " -- " << OSCaddress << std::endl;
-  }
-  mListenerLock.unlock();
+void OSCNotifier::notifyListeners(std::string OSCaddress, Vec5f value,
+                                  ValueSource *src) {
+  queueMessage(OSCaddress, src, true, value[0], value[1], value[2], value[3],
+               value[4]);
 }
 
-void OSCNotifier::notifyListeners(std::string OSCaddress, Color value,
+void OSCNotifier::notifyListeners(std::string OSCaddress, Pose value,
                                   ValueSource *src) {
-  mListenerLock.lock();
-  for (osc::Send *sender : mOSCSenders) {
-    auto ip = Socket::nameToIp(sender->address());
+  queueMessage(OSCaddress, src, true, (float)value.pos()[0],
+               (float)value.pos()[1], (float)value.pos()[2],
+               (float)value.quat().w, (float)value.quat().x,
+               (float)value.quat().y, (float)value.quat().z);
+}
 
-    if (!src || (src->port == 0 && src->ipAddr != ip) ||
-        (src->port != sender->port() && src->ipAddr != ip)) {
-      sender->send(OSCaddress, float(value.r), float(value.g), float(value.b));
-    }
-    //		std::cout << "Notifying " << sender->address() << ":" <<
-    // sender->port() << " -- " << OSCaddress << std::endl;
-  }
-  mListenerLock.unlock();
+void OSCNotifier::notifyListeners(std::string OSCaddress, Color value,
+                                  ValueSource *src) {
+  queueMessage(OSCaddress, src, true, float(value.r), float(value.g),
+               float(value.b));
 }
 
 void OSCNotifier::notifyListeners(std::string OSCaddress, ParameterMeta *param,
@@ -190,7 +244,8 @@ void OSCNotifier::notifyListeners(std::string OSCaddress, ParameterMeta *param,
                  dynamic_cast<ParameterColor *>(param)) { // ParameterColor
     notifyListeners(OSCaddress, p->get(), src);
   } else if (Trigger *p = dynamic_cast<Trigger *>(param)) { // Trigger
-    notifyListeners(OSCaddress, p->get(), src);
+    // Every trigger is an event, so they are never coalesced
+    queueMessage(OSCaddress, src, false, int(p->get()));
   } else {
     std::cout << "OSCNotifier::notifyListeners Unsupported Parameter type for "
                  "notification"
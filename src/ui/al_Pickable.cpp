@@ -10,6 +10,8 @@ Pickable::Pickable() {
   bundle << hover << selected << pose << scale << scaleVec;
   scale.registerChangeCallback(
       [this](float value) { scaleVec.set(Vec3f(value, value, value)); });
+  pose.registerChangeCallback([this](Pose) { boundsChanged = true; });
+  scaleVec.registerChangeCallback([this](Vec3f) { boundsChanged = true; });
   hover.setHint("hide", 1.0);
   selected.setHint("hide", 1.0);
   scaleVec.setHint("hide",
@@ -106,21 +108,41 @@ Vec3f Pickable::transformVecLocal(const Vec3f &v, float w) {
   return Vec3f(o.sub<3>(0));
 }
 
+double Pickable::worldDistance(const Rayd &ray, const Rayd &localRay,
+                               double localT) {
+  if (localT <= 0) {
+    return localT;
+  }
+  // Rays normalize their direction, so localT is in local units
+  Matrix4d t, r, s;
+  Matrix4d model = t.translation(pose.get().pos()) *
+                   r.fromQuat(pose.get().quat()) * s.scaling(scaleVec.get());
+  Vec4d p = model.transform(Vec4d(localRay.o + localRay.d * localT, 1));
+  return (p.sub<3>(0) - ray.o).dot(ray.d);
+}
+
 void PickableBB::set(Mesh &m) {
   mesh = &m;
   bb.set(*mesh);
+  boundsChanged = true;
 }
 
 Hit PickableBB::intersect(Rayd r) {
   auto ray = transformRayLocal(r);
-  double t = intersectBB(ray) * scaleVec.get().x;
-  // auto r2 = Rayd(r.o*scaleVec.get(), r.d);
+  double t = worldDistance(r, ray, intersectBB(ray));
   if (t > 0)
     return Hit(true, r, t, this);
   else
     return Hit(false, r, t, this);
 }
 
+bool PickableBB::bounds(Vec3d &min, Vec3d &max) {
+  updateAABB();
+  min = aabb.min;
+  max = aabb.max;
+  return true;
+}
+
 bool PickableBB::onEvent(PickEvent e, Hit h) {
   switch (e.type) {
   case Point:
@@ -332,3 +354,101 @@ void PickableBB::updateAABB() {
   Vec4d dim = absModel.transform(Vec4d(bb.dim, 0));
   aabb.setCenterDim(cen.sub<3>(0), dim.sub<3>(0));
 }
+
+void PickableMesh::set(Mesh &m) {
+  mesh = &m;
+  updateTriangles();
+}
+
+void PickableMesh::updateTriangles() {
+  mTriangles.clear();
+  mTriangleBVH.clear();
+  if (!mesh) {
+    return;
+  }
+  // Vertices may have moved outside the previous bounds
+  bb.set(*mesh);
+  boundsChanged = true;
+  auto &indices = mesh->indices();
+  size_t count = indices.size() > 0 ? indices.size() : mesh->vertices().size();
+  auto vertexIndex = [&](size_t i) {
+    return indices.size() > 0 ? indices[i] : Mesh::Index(i);
+  };
+  if (mesh->primitive() == Mesh::TRIANGLES) {
+    for (size_t i = 0; i + 2 < count; i += 3) {
+      mTriangles.push_back(vertexIndex(i));
+      mTriangles.push_back(vertexIndex(i + 1));
+      mTriangles.push_back(vertexIndex(i + 2));
+    }
+  } else if (mesh->primitive() == Mesh::TRIANGLE_STRIP) {
+    for (size_t i = 0; i + 2 < count; i++) {
+      mTriangles.push_back(vertexIndex(i));
+      mTriangles.push_back(vertexIndex(i + 1));
+      mTriangles.push_back(vertexIndex(i + 2));
+    }
+  }
+
+  auto &vertices = mesh->vertices();
+  std::vector<Vec3d> mins, maxs;
+  mins.reserve(triangleCount());
+  maxs.reserve(triangleCount());
+  for (size_t i = 0; i < mTriangles.size(); i += 3) {
+    Vec3d a = vertices[mTriangles[i]];
+    Vec3d b = vertices[mTriangles[i + 1]];
+    Vec3d c = vertices[mTriangles[i + 2]];
+    mins.push_back(min(min(a, b), c));
+    maxs.push_back(max(max(a, b), c));
+  }
+  mTriangleBVH.build(mins, maxs);
+}
+
+Hit PickableMesh::intersect(Rayd r) {
+  auto ray = transformRayLocal(r);
+  double t =
+      mTriangles.size() > 0 ? intersectTriangles(ray) : intersectBB(ray);
+  t = worldDistance(r, ray, t);
+  return Hit(t > 0, r, t, this);
+}
+
+double PickableMesh::intersectTriangles(Rayd localRay) {
+  if (useBVH) {
+    size_t triangle;
+    return mTriangleBVH.nearest(
+        localRay,
+        [&](size_t i) { return intersectTriangle(localRay, i); }, triangle);
+  }
+  double best = -1.0;
+  for (size_t i = 0; i < triangleCount(); i++) {
+    double t = intersectTriangle(localRay, i);
+    if (t > 0 && (best < 0 || t < best)) {
+      best = t;
+    }
+  }
+  return best;
+}
+
+double PickableMesh::intersectTriangle(const Rayd &ray, size_t triangle) {
+  // Moller-Trumbore ray-triangle intersection
+  auto &vertices = mesh->vertices();
+  Vec3d v0 = vertices[mTriangles[3 * triangle]];
+  Vec3d e1 = Vec3d(vertices[mTriangles[3 * triangle + 1]]) - v0;
+  Vec3d e2 = Vec3d(vertices[mTriangles[3 * triangle + 2]]) - v0;
+  Vec3d p = cross(ray.d, e2);
+  double det = e1.dot(p);
+  if (std::abs(det) < 1e-12) {
+    return -1.0; // Parallel to the triangle
+  }
+  double invDet = 1.0 / det;
+  Vec3d s = ray.o - v0;
+  double u = s.dot(p) * invDet;
+  if (u < 0.0 || u > 1.0) {
+    return -1.0;
+  }
+  Vec3d q = cross(s, e1);
+  double v = ray.d.dot(q) * invDet;
+  if (v < 0.0 || u + v > 1.0) {
+    return -1.0;
+  }
+  double t = e2.dot(q) * invDet;
+  return t > 0 ? t : -1.0;
+}
@@ -4,23 +4,99 @@ using namespace al;
 
 PickableManager &PickableManager::registerPickable(Pickable &p) {
   mPickables.push_back(&p);
+  mTreeDirty = true;
   return *this;
 }
+
+void PickableManager::updateTree() {
+  // pickables() can be modified directly
+  if (mTreeItems.size() + mUnbounded.size() != mPickables.size()) {
+    mTreeDirty = true;
+  }
+  Vec3d min, max;
+  if (!mTreeDirty) {
+    for (size_t i = 0; i < mTreeItems.size(); i++) {
+      Pickable *p = mPickables[mTreeItems[i]];
+      if (p->boundsChanged.exchange(false)) {
+        if (!p->bounds(min, max)) {
+          mTreeDirty = true;
+          break;
+        }
+        mTree.refit(i, min, max);
+        mRefitCount++;
+      }
+    }
+    // Refitting loosens the tree as pickables move away from where it was
+    // built. Rebuild once as many refits as pickables have accumulated.
+    if (mRefitCount > mTreeItems.size()) {
+      mTreeDirty = true;
+    }
+  }
+  if (mTreeDirty) {
+    std::vector<Vec3d> mins, maxs;
+    mTreeItems.clear();
+    mUnbounded.clear();
+    for (size_t i = 0; i < mPickables.size(); i++) {
+      mPickables[i]->boundsChanged = false;
+      if (mPickables[i]->bounds(min, max)) {
+        mTreeItems.push_back(i);
+        mins.push_back(min);
+        maxs.push_back(max);
+      } else {
+        mUnbounded.push_back(i);
+      }
+    }
+    mTree.build(mins, maxs);
+    mTreeDirty = false;
+    mRefitCount = 0;
+  }
+}
+
 Hit PickableManager::intersect(Rayd r) {
+  updateTree();
   Hit hmin = Hit(false, r, 1e10, NULL);
-  for (Pickable *p : mPickables) {
+  auto testPickable = [&](Pickable *p) {
     Hit h = p->intersect(r);
     if (h.hit && h.t < hmin.t) {
       hmin = h;
     }
+    return h.hit ? h.t : -1.0;
+  };
+  size_t item;
+  mTree.nearest(
+      r, [&](size_t i) { return testPickable(mPickables[mTreeItems[i]]); },
+      item);
+  for (size_t i : mUnbounded) {
+    testPickable(mPickables[i]);
   }
   return hmin;
 }
 
 void PickableManager::event(PickEvent e) {
   Hit h = intersect(e.ray);
-  for (Pickable *p : mPickables) {
-    if (p == h.p || p->selected.get() || e.type == Unpick || e.type == Point) {
+  if (e.type == Point) {
+    // Only pickables the ray can hit, or that need to clear their hover
+    // state, get point events. Children are not in the pickable bounds, so
+    // pickables with children always get them.
+    mDispatch.assign(mPickables.size(), 0);
+    mTree.query(e.ray, mQueryItems);
+    for (size_t i : mQueryItems) {
+      mDispatch[mTreeItems[i]] = 1;
+    }
+    for (size_t i : mUnbounded) {
+      mDispatch[i] = 1;
+    }
+    for (size_t i = 0; i < mPickables.size(); i++) {
+      Pickable *p = mPickables[i];
+      if (p->hover.get() || (p->testChildren && !p->children.empty())) {
+        mDispatch[i] = 1;
+      }
+    }
+  }
+  for (size_t i = 0; i < mPickables.size(); i++) {
+    Pickable *p = mPickables[i];
+    if (p == h.p || p->selected.get() || e.type == Unpick ||
+        (e.type == Point && mDispatch[i])) {
       p->event(e);
 
       if (e.type == Point)
@@ -0,0 +1,257 @@
+#include "al/ui/al_PresetBank.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace al;
+
+namespace {
+
+const char bankMagic[4] = {'A', 'L', 'P', 'B'};
+const size_t bankHeaderSize = 16;
+
+void putUint(std::vector<char> &buf, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    buf.push_back(char((value >> (8 * i)) & 0xFF));
+  }
+}
+
+void putString(std::vector<char> &buf, const std::string &s, int lengthBytes) {
+  putUint(buf, s.size(), lengthBytes);
+  buf.insert(buf.end(), s.begin(), s.end());
+}
+
+// Bounds checked reading from the mapped file
+struct BankReader {
+  const char *data;
+  size_t size;
+  size_t pos;
+
+  bool getUint(uint64_t &value, int bytes) {
+    if (pos + bytes > size) {
+      return false;
+    }
+    value = 0;
+    for (int i = 0; i < bytes; i++) {
+      value |= uint64_t((unsigned char)data[pos + i]) << (8 * i);
+    }
+    pos += bytes;
+    return true;
+  }
+
+  bool getString(std::string &s, int lengthBytes) {
+    uint64_t length;
+    if (!getUint(length, lengthBytes) || pos + length > size) {
+      return false;
+    }
+    s.assign(data + pos, length);
+    pos += length;
+    return true;
+  }
+};
+
+} // namespace
+
+bool PresetBank::open(std::string path) {
+  close();
+  if (!mFile.open(path)) {
+    return false;
+  }
+  mModified = File::modificationTime(path.c_str());
+  BankReader reader{mFile.data(), mFile.size(), 0};
+  uint64_t version, count, indexSize;
+  if (mFile.size() < bankHeaderSize ||
+      memcmp(mFile.data(), bankMagic, 4) != 0) {
+    std::cerr << "ERROR: Not a preset bank: " << path << std::endl;
+    close();
+    return false;
+  }
+  reader.pos = 4;
+  reader.getUint(version, 4);
+  reader.getUint(count, 4);
+  reader.getUint(indexSize, 4);
+  if (version != formatVersion) {
+    std::cerr << "ERROR: Unsupported preset bank version " << version << ": "
+              << path << std::endl;
+    close();
+    return false;
+  }
+  reader.size = std::min(mFile.size(), size_t(bankHeaderSize + indexSize));
+  for (uint64_t i = 0; i < count; i++) {
+    std::string name;
+    IndexEntry entry;
+    if (!reader.getString(name, 2) || !reader.getUint(entry.offset, 8) ||
+        !reader.getUint(entry.size, 8) ||
+        entry.offset + entry.size > mFile.size()) {
+      std::cerr << "ERROR: Corrupt preset bank index: " << path << std::endl;
+      close();
+      return false;
+    }
+    mIndex[name] = entry;
+  }
+  return true;
+}
+
+void PresetBank::close() {
+  mFile.close();
+  mIndex.clear();
+  mModified = 0;
+}
+
+std::vector<std::string> PresetBank::presetNames() {
+  std::vector<std::string> names;
+  for (const auto &entry : mIndex) {
+    names.push_back(entry.first);
+  }
+  return names;
+}
+
+bool PresetBank::getPresetValues(std::string name, ParameterStates &values) {
+  auto entryIt = mIndex.find(name);
+  if (entryIt == mIndex.end()) {
+    return false;
+  }
+  BankReader reader{mFile.data(),
+                    size_t(entryIt->second.offset + entryIt->second.size),
+                    size_t(entryIt->second.offset)};
+  uint64_t parameterCount;
+  if (!reader.getUint(parameterCount, 4)) {
+    return false;
+  }
+  values.clear();
+  for (uint64_t i = 0; i < parameterCount; i++) {
+    std::string address;
+    uint64_t fieldCount;
+    if (!reader.getString(address, 2) || !reader.getUint(fieldCount, 2)) {
+      return false;
+    }
+    std::vector<VariantValue> &fields = values[address];
+    fields.reserve(fieldCount);
+    for (uint64_t j = 0; j < fieldCount; j++) {
+      uint64_t type, value;
+      if (!reader.getUint(type, 1)) {
+        return false;
+      }
+      if (type == 's') {
+        std::string s;
+        if (!reader.getString(s, 4)) {
+          return false;
+        }
+        fields.push_back(s);
+        continue;
+      }
+      if (!reader.getUint(value, 4)) {
+        return false;
+      }
+      uint32_t bits = uint32_t(value);
+      if (type == 'f') {
+        float f;
+        memcpy(&f, &bits, sizeof(float));
+        fields.push_back(f);
+      } else if (type == 'i') {
+        int32_t intValue;
+        memcpy(&intValue, &bits, sizeof(int32_t));
+        fields.push_back(intValue);
+      } else {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool PresetBank::write(std::string path,
+                       const std::map<std::string, ParameterStates> &presets) {
+  std::vector<char> index;
+  std::vector<char> data;
+  for (const auto &preset : presets) {
+    putString(index, preset.first, 2);
+    putUint(index, data.size(), 8); // Relative offset. Fixed below
+    size_t start = data.size();
+    putUint(data, preset.second.size(), 4);
+    for (const auto &parameter : preset.second) {
+      std::vector<char> fields;
+      uint64_t fieldCount = 0;
+      for (const auto &field : parameter.second) {
+        if (field.type() == VariantType::VARIANT_FLOAT) {
+          float f = field.get<float>();
+          uint32_t bits;
+          memcpy(&bits, &f, sizeof(float));
+          fields.push_back('f');
+          putUint(fields, bits, 4);
+        } else if (field.type() == VariantType::VARIANT_INT32) {
+          fields.push_back('i');
+          putUint(fields, uint32_t(field.get<int32_t>()), 4);
+        } else if (field.type() == VariantType::VARIANT_STRING) {
+          fields.push_back('s');
+          putString(fields, field.get<std::string>(), 4);
+        } else {
+          continue;
+        }
+        fieldCount++;
+      }
+      if (fieldCount > UINT16_MAX) {
+        std::cerr << "ERROR: Too many fields in " << parameter.first
+                  << " for preset bank: " << path << std::endl;
+        return false;
+      }
+      putString(data, parameter.first, 2);
+      putUint(data, fieldCount, 2);
+      data.insert(data.end(), fields.begin(), fields.end());
+    }
+    putUint(index, data.size() - start, 8);
+  }
+
+  // Now that the index size is known, make data offsets absolute
+  uint64_t dataStart = bankHeaderSize + index.size();
+  BankReader reader{index.data(), index.size(), 0};
+  while (reader.pos < index.size()) {
+    std::string name;
+    uint64_t offset, size;
+    reader.getString(name, 2);
+    size_t offsetPos = reader.pos;
+    reader.getUint(offset, 8);
+    reader.getUint(size, 8);
+    std::vector<char> absoluteOffset;
+    putUint(absoluteOffset, dataStart + offset, 8);
+    std::copy(absoluteOffset.begin(), absoluteOffset.end(),
+              index.begin() + offsetPos);
+  }
+
+  std::vector<char> header(bankMagic, bankMagic + 4);
+  putUint(header, formatVersion, 4);
+  putUint(header, presets.size(), 4);
+  putUint(header, index.size(), 4);
+
+  // Write to a temporary file and then replace, as the previous bank might
+  // be mapped by a PresetHandler.
+  std::string tempPath = path + ".tmp";
+  std::ofstream f(tempPath, std::ios::binary);
+  if (!f.is_open()) {
+    std::cerr << "ERROR: Could not open preset bank for writing: " << tempPath
+              << std::endl;
+    return false;
+  }
+  f.write(header.data(), header.size());
+  f.write(index.data(), index.size());
+  f.write(data.data(), data.size());
+  f.close();
+  if (f.fail()) {
+    std::cerr << "ERROR: Writing preset bank: " << tempPath << std::endl;
+    std::remove(tempPath.c_str());
+    return false;
+  }
+  if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+    // rename() does not replace existing files on Windows
+    std::remove(path.c_str());
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+      std::cerr << "ERROR: Could not replace preset bank: " << path
+                << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
@@ -51,6 +51,7 @@ void PresetHandler::setSubDirectory(std::string directory) {
   }
   setCurrentPresetMap();
   mSubDir = directory;
+  openPresetBank();
 }
 
 void PresetHandler::registerPresetCallback(
@@ -743,6 +744,7 @@ void PresetHandler::setCurrentPresetMap(std::string mapName, bool autoCreate) {
     mPresetsMap = readPresetMap(mapName);
     mCurrentMapName = mapName;
   }
+  openPresetBank();
   if (verbose()) {
     std::cout << "Setting preset map:" << mapName << std::endl;
   }
@@ -1200,8 +1202,43 @@ PresetHandler::getBundleStates(ParameterBundle *bundle, std::string id) {
 PresetHandler::ParameterStates
 PresetHandler::loadPresetValues(std::string name) {
   ParameterStates preset;
-  std::lock_guard<std::mutex> lock(mFileLock); // Protect loading and saving
-  std::lock_guard<std::mutex> lock2(mSkipParametersLock); // Protect skip list
+  {
+    std::lock_guard<std::mutex> lock(mFileLock); // Protect loading and saving
+    std::lock_guard<std::mutex> lock2(mPresetCacheLock);
+    std::string path = getCurrentPath();
+    if (path.back() != '/') {
+      path += "/";
+    }
+    std::string filePath = path + name + ".preset";
+    // Modification times have a resolution of a second, so the size also
+    // identifies a file edited within the second it was cached
+    al_sec modified = File::modificationTime(filePath.c_str());
+    size_t size = File(filePath, "rb", true).size();
+    auto cached = mPresetCache.find(filePath);
+    if (cached != mPresetCache.end() && cached->second.modified == modified &&
+        cached->second.size == size) {
+      preset = cached->second.values;
+    } else {
+      // Text files edited after the bank was written take precedence. Files
+      // modified in the same second as the bank are also read as text, as
+      // they might be newer.
+      if (!mPresetBank.opened() || modified >= mPresetBank.modified() ||
+          !mPresetBank.getPresetValues(name, preset)) {
+        preset = readPresetFile(name);
+      }
+      mPresetCache[filePath] = {preset, modified, size};
+    }
+  }
+  std::lock_guard<std::mutex> lock(mSkipParametersLock); // Protect skip list
+  for (const auto &skipAddress : mSkipParameters) {
+    preset.erase(skipAddress);
+  }
+  return preset;
+}
+
+PresetHandler::ParameterStates
+PresetHandler::readPresetFile(std::string name) {
+  ParameterStates preset;
   std::string path = getCurrentPath();
   if (path.back() != '/') {
     path += "/";
@@ -1253,10 +1290,7 @@ PresetHandler::loadPresetValues(std::string name) {
           ++currentType;
         }
 
-        if (address.size() > 0 && address[0] != '#' && type.size() > 0 &&
-            std::find(mSkipParameters.begin(), mSkipParameters.end(),
-                      address) == mSkipParameters.end()) {
-          // Address is not in ignore list, so add to values loaded
+        if (address.size() > 0 && address[0] != '#' && type.size() > 0) {
           // Should we make sure the address corresponds to an existing
           // preset?
           preset[address] = values;
@@ -1288,6 +1322,14 @@ bool PresetHandler::savePresetValues(const ParameterStates &values,
     number++;
   }
   infile.close();
+  {
+    std::lock_guard<std::mutex> lk(mPresetCacheLock);
+    std::string cachePath = path.size() > 0 && path.back() != '/'
+                                ? path + "/" + presetName + ".preset"
+                                : path + presetName + ".preset";
+    mPresetCache.erase(cachePath);
+    mPresetBank.invalidate(presetName);
+  }
   std::ofstream f(fileName);
   if (!f.is_open()) {
     if (mVerbose) {
@@ -1326,6 +1368,91 @@ bool PresetHandler::savePresetValues(const ParameterStates &values,
   return ok;
 }
 
+bool PresetHandler::exportPresetBank(std::string mapName) {
+  if (mapName.size() == 0) {
+    mapName = mCurrentMapName;
+  }
+  std::map<std::string, ParameterStates> presets;
+  for (const auto &preset : readPresetMap(mapName)) {
+    presets[preset.second] = readPresetFile(preset.second);
+  }
+  std::string bankPath = buildBankPath(mapName);
+  std::lock_guard<std::mutex> lock(mFileLock);
+  std::lock_guard<std::mutex> lock2(mPresetCacheLock);
+  bool ok = PresetBank::write(bankPath, presets);
+  if (ok && mPresetBank.opened() && mPresetBank.path() == bankPath) {
+    mPresetBank.open(bankPath);
+    mPresetCache.clear();
+  }
+  if (mVerbose) {
+    std::cout << "Exported " << presets.size()
+              << " presets to bank: " << bankPath << std::endl;
+  }
+  return ok;
+}
+
+bool PresetHandler::importPresetBank(std::string mapName, bool overwrite) {
+  if (mapName.size() == 0) {
+    mapName = mCurrentMapName;
+  }
+  std::string bankPath = buildBankPath(mapName);
+  PresetBank bank;
+  if (!bank.open(bankPath)) {
+    std::cerr << "ERROR: Could not open preset bank: " << bankPath
+              << std::endl;
+    return false;
+  }
+  bool ok = true;
+  for (const auto &name : bank.presetNames()) {
+    ParameterStates values;
+    if (!bank.getPresetValues(name, values) ||
+        !savePresetValues(values, name, overwrite)) {
+      std::cerr << "ERROR: Could not import preset from bank: " << name
+                << std::endl;
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+void PresetHandler::usePresetBank(bool use) {
+  mUsePresetBank = use;
+  openPresetBank();
+}
+
+void PresetHandler::clearPresetCache() {
+  std::lock_guard<std::mutex> lk(mPresetCacheLock);
+  mPresetCache.clear();
+}
+
+std::string PresetHandler::buildBankPath(std::string mapName) {
+  std::string mapPath = buildMapPath(mapName, true);
+  return mapPath.substr(0, mapPath.rfind('.')) + ".presetBank";
+}
+
+void PresetHandler::openPresetBank() {
+  std::string bankPath = buildBankPath(mCurrentMapName);
+  std::lock_guard<std::mutex> lk(mPresetCacheLock);
+  mPresetCache.clear();
+  if (!mUsePresetBank) {
+    mPresetBank.close();
+    return;
+  }
+  if (mPresetBank.opened() && mPresetBank.path() == bankPath) {
+    return;
+  }
+  if (File::exists(bankPath)) {
+    if (!mPresetBank.open(bankPath)) {
+      std::cerr << "ERROR: Could not open preset bank: " << bankPath
+                << std::endl;
+    } else if (mVerbose) {
+      std::cout << "Using preset bank: " << bankPath << std::endl;
+    }
+  } else {
+    mPresetBank.close();
+  }
+}
+
 void PresetHandler::setTimeMaster(TimeMasterMode masterMode) {
   stopCpuThread();
   mTimeMasterMode = masterMode;
@@ -13,7 +13,8 @@
 using namespace al;
 
 SequenceRecorder::SequenceRecorder()
-    : mRecorderThread(nullptr), mMaxRecordTime(60.0) {}
+    : mPresetHandler(nullptr), mRecording(false), mRecorderThread(nullptr),
+      mMaxRecordTime(60.0) {}
 
 //{
 //	stopSequence();
@@ -94,9 +95,25 @@ void SequenceRecorder::startRecord(std::string name, bool overwrite) {
   mRecording = true;
   mRecorderThread =
       new std::thread(SequenceRecorder::recorderFunction, this, name);
+  if (mRecordJournal) {
+    std::string path = mDirectory;
+    if (mPresetHandler) {
+      path = File::conformDirectory(mPresetHandler->getCurrentPath());
+    }
+    std::string journalName = name.size() > 0 ? name : "new_seq";
+    std::string fileName = path + journalName + ".journal";
+    int counter = 0;
+    while (!overwrite && File::exists(fileName)) {
+      fileName = path + journalName + "_" + std::to_string(counter++) +
+                 ".journal";
+    }
+    mJournal.maxRecordTime(mMaxRecordTime);
+    mJournal.startRecord(fileName);
+  }
 }
 
 void SequenceRecorder::stopRecord() {
+  mJournal.stopRecord();
   if (mRecorderThread) {
     mRecording = false;
     mSequenceConditionVar.notify_one();
@@ -266,6 +283,7 @@ void SequenceRecorder::registerParameter(ParameterMeta &p) {
     });
   }
   mParameters.push_back(&p);
+  mJournal.registerParameter(p);
   if (mPresetHandler) {
     for (auto *presetParam : mPresetHandler->parameters()) {
       if (presetParam->getFullAddress() == p.getFullAddress()) {
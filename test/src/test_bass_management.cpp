@@ -0,0 +1,95 @@
+#include "gtest/gtest.h"
+
+#include "al/sound/al_BassManagement.hpp"
+
+#include <cmath>
+
+using namespace al;
+
+namespace {
+
+const double kSampleRate = 48000;
+const int kFrames = 512;
+
+// Play a sine on the first speaker, run bass management and return the peak
+// of main + sub once the filters have settled
+float processSine(BassManagement &bass, AudioIOData &io, double freq,
+                  std::vector<float> *sub = nullptr) {
+  float peak = 0;
+  for (int buffer = 0; buffer < 20; buffer++) {
+    io.zeroOut();
+    for (int i = 0; i < kFrames; i++) {
+      float s = float(sin(2 * M_PI * freq * (buffer * kFrames + i) /
+                          kSampleRate));
+      io.outBuffer(0)[i] = s;
+    }
+    bass.processBass(io);
+    if (sub) {
+      sub->insert(sub->end(), io.outBuffer(4), io.outBuffer(4) + kFrames);
+    }
+    for (int i = 0; buffer >= 15 && i < kFrames; i++) {
+      peak = std::max(peak, std::abs(io.outBuffer(0)[i] + io.outBuffer(4)[i]));
+    }
+  }
+  return peak;
+}
+
+} // namespace
+
+TEST(BassManagement, CrossoverSumsFlat) {
+  Speakers mains;
+  for (unsigned i = 0; i < 4; i++) {
+    mains.push_back(Speaker(i, i * 90.0f));
+  }
+  AudioIOData io;
+  io.framesPerSecond(kSampleRate);
+  io.framesPerBuffer(kFrames);
+  io.channelsOut(5);
+
+  BassManagement bass;
+  bass.configure(mains, {4}, 100.0f, kSampleRate);
+  for (double freq : {30.0, 100.0, 400.0, 5000.0}) {
+    EXPECT_NEAR(processSine(bass, io, freq), 1.0, 0.02) << freq << " Hz";
+  }
+  // High frequencies stay out of the sub and lows out of the mains
+  processSine(bass, io, 5000.0);
+  float subPeak = 0;
+  for (int i = 0; i < kFrames; i++) {
+    subPeak = std::max(subPeak, std::abs(io.outBuffer(4)[i]));
+  }
+  EXPECT_LT(subPeak, 0.001f);
+  processSine(bass, io, 20.0);
+  float mainPeak = 0;
+  for (int i = 0; i < kFrames; i++) {
+    mainPeak = std::max(mainPeak, std::abs(io.outBuffer(0)[i]));
+  }
+  EXPECT_LT(mainPeak, 0.01f);
+}
+
+TEST(BassManagement, DelayAndGain) {
+  Speakers mains{Speaker(0), Speaker(1), Speaker(2), Speaker(3)};
+  AudioIOData io;
+  io.framesPerSecond(kSampleRate);
+  io.framesPerBuffer(kFrames);
+  io.channelsOut(5);
+
+  BassManagement reference;
+  reference.configure(mains, {4}, 80.0f, kSampleRate);
+  std::vector<float> referenceSub;
+  processSine(reference, io, 50.0, &referenceSub);
+
+  BassManagement bass;
+  bass.configure(mains, {4}, 80.0f, kSampleRate);
+  bass.speakerDelay(0, 300);
+  bass.speakerGain(0, 0.5f);
+  std::vector<float> sub;
+  processSine(bass, io, 50.0, &sub);
+
+  ASSERT_EQ(sub.size(), referenceSub.size());
+  for (size_t i = 0; i < 300; i++) {
+    EXPECT_EQ(sub[i], 0.0f);
+  }
+  for (size_t i = 300; i < sub.size(); i++) {
+    EXPECT_NEAR(sub[i], 0.5f * referenceSub[i - 300], 1e-5);
+  }
+}
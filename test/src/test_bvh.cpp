@@ -0,0 +1,100 @@
+#include "gtest/gtest.h"
+
+#include "al/spatial/al_BVH.hpp"
+
+#include <algorithm>
+#include <random>
+
+using namespace al;
+
+namespace {
+
+// Ray parameter where a ray hits a sphere, or -1
+double hitSphere(const Rayd &ray, const Vec3d &center, double radius) {
+  Rayd r = ray;
+  return r.intersectSphere(center, radius);
+}
+
+} // namespace
+
+TEST(BVH, NearestAndQuery) {
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<double> position(-50.0, 50.0);
+  std::uniform_real_distribution<double> size(0.1, 2.0);
+
+  std::vector<Vec3d> centers, mins, maxs;
+  std::vector<double> radii;
+  for (int i = 0; i < 2000; i++) {
+    Vec3d c(position(rng), position(rng), position(rng));
+    double r = size(rng);
+    centers.push_back(c);
+    radii.push_back(r);
+    mins.push_back(c - r);
+    maxs.push_back(c + r);
+  }
+  BVH bvh;
+  bvh.build(mins, maxs);
+  EXPECT_EQ(bvh.size(), 2000u);
+
+  int totalTested = 0;
+  auto checkRays = [&]() {
+    for (int i = 0; i < 200; i++) {
+      Vec3d origin(position(rng), position(rng), 100);
+      Vec3d target(position(rng), position(rng), -100);
+      Rayd ray(origin, (target - origin).normalize());
+
+      int tested = 0;
+      size_t item = 0;
+      double t = bvh.nearest(
+          ray,
+          [&](size_t j) {
+            tested++;
+            return hitSphere(ray, centers[j], radii[j]);
+          },
+          item);
+
+      double bruteT = -1;
+      size_t bruteItem = 0;
+      for (size_t j = 0; j < centers.size(); j++) {
+        double tj = hitSphere(ray, centers[j], radii[j]);
+        if (tj > 0 && (bruteT < 0 || tj < bruteT)) {
+          bruteT = tj;
+          bruteItem = j;
+        }
+      }
+      EXPECT_DOUBLE_EQ(t, bruteT);
+      if (bruteT > 0) {
+        EXPECT_EQ(item, bruteItem);
+      }
+      totalTested += tested;
+
+      std::vector<size_t> items;
+      bvh.query(ray, items);
+      if (bruteT > 0) {
+        EXPECT_NE(std::find(items.begin(), items.end(), bruteItem),
+                  items.end());
+      }
+    }
+  };
+  checkRays();
+  // Only a small fraction of the items is tested per ray
+  EXPECT_LT(totalTested / 200, 50);
+
+  // Move some items and refit instead of rebuilding
+  for (size_t j = 0; j < centers.size(); j += 10) {
+    centers[j] = Vec3d(position(rng), position(rng), position(rng));
+    bvh.refit(j, centers[j] - radii[j], centers[j] + radii[j]);
+  }
+  checkRays();
+
+  Vec3d min, max;
+  ASSERT_TRUE(bvh.bounds(min, max));
+  EXPECT_LE(min.x, -49.0);
+  EXPECT_GE(max.x, 49.0);
+
+  bvh.clear();
+  size_t item;
+  EXPECT_LT(bvh.nearest(Rayd(Vec3d(0, 0, 10), Vec3d(0, 0, -1)),
+                        [](size_t) { return 1.0; }, item),
+            0);
+}
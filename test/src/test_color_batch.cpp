@@ -0,0 +1,111 @@
+#include <cmath>
+#include <vector>
+
+#include "al/types/al_ColorBatch.hpp"
+#include "al/types/al_ColorMap.hpp"
+#include "gtest/gtest.h"
+
+using namespace al;
+
+namespace {
+
+std::vector<Color> colorGrid() {
+  std::vector<Color> colors;
+  const int steps = 17; // Not a multiple of the SIMD width
+  for (int r = 0; r < steps; r++) {
+    for (int g = 0; g < steps; g++) {
+      for (int b = 0; b < steps; b++) {
+        colors.emplace_back(r / float(steps - 1), g / float(steps - 1),
+                            b / float(steps - 1));
+      }
+    }
+  }
+  return colors;
+}
+
+} // namespace
+
+TEST(ColorBatch, MatchesSingleConversions) {
+  std::vector<Color> colors = colorGrid();
+  size_t n = colors.size();
+
+  std::vector<Lab> labs(n);
+  convertColors(colors.data(), labs.data(), n);
+  std::vector<HCLab> hclabs(n);
+  convertColors(colors.data(), hclabs.data(), n);
+  for (size_t i = 0; i < n; i++) {
+    Lab lab(colors[i]);
+    for (int k = 0; k < 3; k++) {
+      EXPECT_NEAR(labs[i][k], lab[k], 1e-3f);
+    }
+    HCLab hclab(colors[i]);
+    EXPECT_NEAR(hclabs[i].c, hclab.c, 1e-5f);
+    EXPECT_NEAR(hclabs[i].l, hclab.l, 1e-5f);
+    if (hclab.c > 1e-3f) {
+      // Hue wraps around at 0
+      float dh = std::fabs(hclabs[i].h - hclab.h);
+      EXPECT_LT(std::min(dh, 1.f - dh), 1e-5f);
+    }
+  }
+
+  // Round trip back to RGB, and against the single conversion from Lab
+  std::vector<Color> back(n);
+  convertColors(labs.data(), back.data(), n, 0.5f);
+  for (size_t i = 0; i < n; i++) {
+    Color expected(labs[i]);
+    for (int k = 0; k < 3; k++) {
+      EXPECT_NEAR(back[i].components[k], expected.components[k], 1e-5f);
+      // The 4 digit sRGB matrices are not exact inverses
+      EXPECT_NEAR(back[i].components[k], colors[i].components[k], 5e-3f);
+    }
+    EXPECT_EQ(back[i].a, 0.5f);
+  }
+  convertColors(hclabs.data(), back.data(), n);
+  for (size_t i = 0; i < n; i++) {
+    Color expected(hclabs[i]);
+    for (int k = 0; k < 3; k++) {
+      EXPECT_NEAR(back[i].components[k], expected.components[k], 1e-5f);
+    }
+  }
+
+  // Planar kernels, in place
+  std::vector<float> v(n);
+  for (size_t i = 0; i < n; i++) {
+    v[i] = colors[i].r;
+  }
+  srgbToLinear(v.data(), v.data(), n);
+  linearToSrgb(v.data(), v.data(), n);
+  for (size_t i = 0; i < n; i++) {
+    EXPECT_NEAR(v[i], colors[i].r, 1e-5f);
+  }
+}
+
+TEST(ColorBatch, ColorMap) {
+  ColorMap gray(ColorMap::GRAY, 101);
+  ASSERT_EQ(gray.table().size(), 101u);
+  EXPECT_NEAR(gray(0.f).r, 0.f, 1e-5f);
+  EXPECT_NEAR(gray(1.f).g, 1.f, 1e-5f);
+  EXPECT_NEAR(gray(2.f).b, 1.f, 1e-5f);
+  // Lightness is even along the table
+  Lab first(gray.table()[25]), second(gray.table()[50]), third(gray.table()[75]);
+  EXPECT_NEAR(second.l - first.l, third.l - second.l, 0.05f);
+
+  ColorMap viridis;
+  Color start = Colori(0x44, 0x01, 0x54);
+  EXPECT_NEAR(viridis(0.f).r, start.r, 1e-3f);
+  EXPECT_NEAR(viridis(0.f).b, start.b, 1e-3f);
+
+  std::vector<float> values = {-1.f, 0.f, 2.5f, 5.f, 7.5f, 10.f, 20.f, NAN, 5.f};
+  std::vector<Color> colors;
+  viridis.map(values.data(), values.size(), colors, 0.f, 10.f);
+  ASSERT_EQ(colors.size(), values.size());
+  const std::vector<Color> &table = viridis.table();
+  EXPECT_EQ(colors[0], table.front());
+  EXPECT_EQ(colors[1], table.front());
+  EXPECT_EQ(colors[2], viridis(0.25f));
+  EXPECT_EQ(colors[3], viridis(0.5f));
+  EXPECT_EQ(colors[5], table.back());
+  EXPECT_EQ(colors[6], table.back());
+  EXPECT_EQ(colors[7], table.front());
+  EXPECT_EQ(colors[8], colors[3]);
+}
@@ -0,0 +1,181 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "al/protocol/al_CommandConnection.hpp"
+#include "al/system/al_Time.hpp"
+#include "gtest/gtest.h"
+
+using namespace al;
+
+enum { BULK_DATA = CommandConnection::COMMAND_LAST_INTERNAL, SMALL_COMMAND };
+
+// Consumes whole messages and checks their contents
+struct BulkReceiver {
+  std::atomic<int> bulkMessages{0};
+  std::atomic<int> smallCommands{0};
+  std::atomic<bool> contentsOk{true};
+  // Stalls processing to simulate a slow receiver
+  std::atomic<bool> hold{false};
+
+  bool process(Message &m) {
+    while (hold) {
+      al_sleep(0.001);
+    }
+    uint8_t command = m.getByte();
+    if (command == BULK_DATA) {
+      size_t length = m.remainingBytes();
+      uint8_t *data = m.data();
+      for (size_t i = 0; i < length; i++) {
+        if (data[i] != uint8_t(i * 7)) {
+          contentsOk = false;
+          break;
+        }
+      }
+      m.pushReadIndex(length);
+      bulkMessages++;
+      return true;
+    } else if (command == SMALL_COMMAND) {
+      smallCommands++;
+      return true;
+    }
+    return false;
+  }
+};
+
+struct TestServer : public CommandServer {
+  BulkReceiver receiver;
+  bool processIncomingMessage(Message &m, Socket *src) override {
+    return receiver.process(m);
+  }
+};
+
+struct TestClient : public CommandClient {
+  BulkReceiver receiver;
+  bool processIncomingMessage(Message &m, Socket *src) override {
+    return receiver.process(m);
+  }
+};
+
+bool waitFor(std::function<bool()> condition, double timeout = 10.0) {
+  double endTime = al_steady_time() + timeout;
+  while (!condition()) {
+    if (al_steady_time() > endTime) {
+      return false;
+    }
+    al_sleep(0.005);
+  }
+  return true;
+}
+
+TEST(CommandConnection, LargeMessages) {
+  TestServer server;
+  TestClient client;
+  ASSERT_TRUE(server.start(16510, "localhost"));
+  ASSERT_TRUE(client.start(16510, "localhost"));
+  ASSERT_EQ(server.waitForConnections(1, 5.0), 1);
+
+  // Several chunks, larger than the socket buffers
+  std::vector<uint8_t> bulk(3 * 1024 * 1024 + 17);
+  bulk[0] = BULK_DATA;
+  for (size_t i = 1; i < bulk.size(); i++) {
+    bulk[i] = uint8_t((i - 1) * 7);
+  }
+  uint8_t small = SMALL_COMMAND;
+  for (int i = 0; i < 3; i++) {
+    EXPECT_TRUE(client.sendMessage(bulk.data(), bulk.size()));
+    // Small messages are not held back by large ones in the other direction
+    EXPECT_TRUE(server.sendMessage(&small, 1));
+  }
+  EXPECT_TRUE(
+      waitFor([&]() { return client.receiver.smallCommands == 3; }));
+  EXPECT_TRUE(waitFor([&]() { return server.receiver.bulkMessages == 3; }));
+  EXPECT_TRUE(server.receiver.contentsOk);
+  EXPECT_TRUE(client.flush());
+  EXPECT_EQ(client.queuedBytes(), 0u);
+
+  // Messages over the limit are discarded and the connection stays usable
+  server.maxMessageSize(1024);
+  EXPECT_TRUE(client.sendMessage(bulk.data(), 2048));
+  EXPECT_TRUE(client.sendMessage(&small, 1));
+  EXPECT_TRUE(waitFor([&]() { return server.receiver.smallCommands == 1; }));
+  EXPECT_EQ(server.receiver.bulkMessages, 3);
+
+  // A full send queue rejects messages instead of blocking. The server stops
+  // reading, so the socket buffers fill up and the rest stays queued
+  server.receiver.hold = true;
+  EXPECT_TRUE(client.sendMessage(&small, 1));
+  bulk.resize(32 * 1024 * 1024);
+  client.sendQueueLimit(bulk.size());
+  EXPECT_TRUE(client.sendMessage(bulk.data(), bulk.size()));
+  EXPECT_GT(client.queuedBytes(), 0u);
+  EXPECT_FALSE(client.sendMessage(bulk.data(), bulk.size()));
+  EXPECT_LE(client.queuedBytes(), bulk.size() + 4096);
+  server.receiver.hold = false;
+  EXPECT_TRUE(client.flush());
+
+  client.stop();
+  EXPECT_TRUE(waitFor([&]() { return server.connectionCount() == 0; }));
+  server.stop();
+}
+
+TEST(CommandConnection, ProtocolVersion) {
+  TestServer server;
+  ASSERT_TRUE(server.start(16511, "localhost"));
+
+  // A client from before framing sends no protocol version
+  Socket oldClient;
+  ASSERT_TRUE(oldClient.open(16511, "localhost", 2.0, Socket::TCP));
+  ASSERT_TRUE(oldClient.connect());
+  uint8_t handshake[5] = {CommandConnection::HANDSHAKE, 0, 0, 0, 0};
+  ASSERT_EQ(oldClient.send((const char *)handshake, 5), 5u);
+  uint8_t reply[8] = {0};
+  EXPECT_EQ(oldClient.recv((char *)reply, 8), 2u);
+  EXPECT_EQ(reply[0], CommandConnection::HANDSHAKE_REJECT);
+  EXPECT_EQ(reply[1], CommandConnection::kProtocolVersion);
+  oldClient.close();
+  EXPECT_EQ(server.connectionCount(), 0u);
+
+  // A handshake split across segments is not mistaken for an old client
+  Socket splitClient;
+  ASSERT_TRUE(splitClient.open(16511, "localhost", 2.0, Socket::TCP));
+  ASSERT_TRUE(splitClient.connect());
+  uint8_t split[6] = {CommandConnection::HANDSHAKE,      0, 0, 0, 0,
+                      CommandConnection::kProtocolVersion};
+  ASSERT_EQ(splitClient.send((const char *)split, 3), 3u);
+  al_sleep(0.05);
+  ASSERT_EQ(splitClient.send((const char *)split + 3, 3), 3u);
+  EXPECT_EQ(splitClient.recv((char *)reply, 6), 6u);
+  EXPECT_EQ(reply[0], CommandConnection::HANDSHAKE_ACK);
+  EXPECT_EQ(reply[5], CommandConnection::kProtocolVersion);
+  EXPECT_EQ(server.waitForConnections(1, 5.0), 1);
+  splitClient.close();
+  EXPECT_TRUE(waitFor([&]() { return server.connectionCount() == 0; }));
+
+  TestClient client;
+  ASSERT_TRUE(client.start(16511, "localhost"));
+  EXPECT_EQ(server.waitForConnections(1, 5.0), 1);
+  client.stop();
+  server.stop();
+
+  // A server from before framing acknowledges without a protocol version
+  Socket oldServer;
+  ASSERT_TRUE(oldServer.open(16512, "localhost", 2.0, Socket::TCP));
+  ASSERT_TRUE(oldServer.bind());
+  ASSERT_TRUE(oldServer.listen());
+  std::thread serverThread([&]() {
+    Socket connection;
+    if (oldServer.accept(connection)) {
+      uint8_t message[8];
+      connection.recv((char *)message, 5);
+      message[0] = CommandConnection::HANDSHAKE_ACK;
+      connection.send((const char *)message, 5);
+      al_sleep(0.2);
+    }
+  });
+  TestClient newClient;
+  EXPECT_FALSE(newClient.start(16512, "localhost"));
+  serverThread.join();
+  newClient.stop();
+  oldServer.close();
+}
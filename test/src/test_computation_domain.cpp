@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "al/app/al_ComputationDomain.hpp"
+#include "al/app/al_SimulationDomain.hpp"
+#include "gtest/gtest.h"
+
+using namespace al;
+
+// Records the order in which domains tick
+struct OrderDomain : public SynchronousDomain {
+  std::atomic<int> *counter{nullptr};
+  std::atomic<int> *concurrentNow{nullptr};
+  std::atomic<int> *maxConcurrent{nullptr};
+  int tickOrder{-1};
+  int sleepMs{0};
+  // Wait inside tick() until this many domains sharing arrived have started
+  // ticking. Bounded so that ticking them one at a time fails the test
+  // instead of hanging
+  std::atomic<int> *arrived{nullptr};
+  int waitForConcurrent{0};
+  bool sawConcurrent{false};
+
+  bool tick() override {
+    int now = ++(*concurrentNow);
+    int previous = maxConcurrent->load();
+    while (now > previous &&
+           !maxConcurrent->compare_exchange_weak(previous, now)) {
+    }
+    if (arrived) {
+      ++(*arrived);
+      auto deadline =
+          std::chrono::steady_clock::now() + std::chrono::seconds(10);
+      while (*arrived < waitForConcurrent &&
+             std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+      }
+      sawConcurrent = *arrived >= waitForConcurrent;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(sleepMs));
+    tickOrder = (*counter)++;
+    (*concurrentNow)--;
+    return true;
+  }
+};
+
+struct ParentDomain : public SynchronousDomain {
+  bool tick() override {
+    bool ret = tickSubdomains(true);
+    ret &= tickSubdomains(false);
+    return ret;
+  }
+};
+
+TEST(ComputationDomain, SerialOrder) {
+  std::atomic<int> counter{0}, concurrentNow{0}, maxConcurrent{0};
+  ParentDomain parent;
+  std::vector<std::shared_ptr<OrderDomain>> domains;
+  for (int i = 0; i < 4; i++) {
+    auto domain = parent.newSubDomain<OrderDomain>(i < 2);
+    domain->counter = &counter;
+    domain->concurrentNow = &concurrentNow;
+    domain->maxConcurrent = &maxConcurrent;
+    domains.push_back(domain);
+  }
+  EXPECT_TRUE(parent.tick());
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ(domains[i]->tickOrder, i);
+    EXPECT_EQ(domains[i]->tickStats().ticks, 1u);
+  }
+  EXPECT_EQ(maxConcurrent, 1);
+}
+
+TEST(ComputationDomain, ConcurrentWithDependencies) {
+  std::atomic<int> counter{0}, concurrentNow{0}, maxConcurrent{0};
+  ParentDomain parent;
+  auto makeDomain = [&](bool concurrent) {
+    auto domain = parent.newSubDomain<OrderDomain>();
+    domain->counter = &counter;
+    domain->concurrentNow = &concurrentNow;
+    domain->maxConcurrent = &maxConcurrent;
+    domain->runConcurrently(concurrent);
+    return domain;
+  };
+  // a and b only finish once both have started ticking
+  std::atomic<int> arrived{0};
+  auto a = makeDomain(true);
+  auto b = makeDomain(true);
+  for (auto &domain : {a, b}) {
+    domain->arrived = &arrived;
+    domain->waitForConcurrent = 2;
+  }
+  a->sleepMs = 20;
+  // d is listed first but waits for c, which waits for a and b
+  auto d = makeDomain(true);
+  auto c = makeDomain(true);
+  c->dependsOn(a);
+  c->dependsOn(b);
+  d->dependsOn(c);
+  auto last = makeDomain(false);
+
+  EXPECT_TRUE(parent.tick());
+  EXPECT_TRUE(a->sawConcurrent);
+  EXPECT_TRUE(b->sawConcurrent);
+  EXPECT_EQ(maxConcurrent, 2);
+  EXPECT_GT(c->tickOrder, a->tickOrder);
+  EXPECT_GT(c->tickOrder, b->tickOrder);
+  EXPECT_EQ(d->tickOrder, 3);
+  EXPECT_EQ(last->tickOrder, 4); // Serial domains wait for all before them
+  EXPECT_GE(a->tickStats().lastSeconds, 0.02);
+  EXPECT_GE(a->tickStats().maxSeconds, a->tickStats().lastSeconds);
+}
+
+TEST(ComputationDomain, SerialDependenciesIgnored) {
+  std::atomic<int> counter{0}, concurrentNow{0}, maxConcurrent{0};
+  ParentDomain parent;
+  auto a = parent.newSubDomain<OrderDomain>();
+  auto b = parent.newSubDomain<OrderDomain>();
+  for (auto &domain : {a, b}) {
+    domain->counter = &counter;
+    domain->concurrentNow = &concurrentNow;
+    domain->maxConcurrent = &maxConcurrent;
+  }
+  // Serial domains keep their list order
+  a->dependsOn(b);
+  EXPECT_TRUE(parent.tick());
+  EXPECT_EQ(a->tickOrder, 0);
+  EXPECT_EQ(b->tickOrder, 1);
+}
+
+TEST(ComputationDomain, CircularDependencies) {
+  std::atomic<int> counter{0}, concurrentNow{0}, maxConcurrent{0};
+  ParentDomain parent;
+  auto a = parent.newSubDomain<OrderDomain>();
+  auto b = parent.newSubDomain<OrderDomain>();
+  for (auto &domain : {a, b}) {
+    domain->counter = &counter;
+    domain->concurrentNow = &concurrentNow;
+    domain->maxConcurrent = &maxConcurrent;
+    domain->runConcurrently(true);
+  }
+  a->dependsOn(b);
+  b->dependsOn(a);
+  EXPECT_TRUE(parent.tick());
+  EXPECT_EQ(counter, 2);
+}
+
+TEST(ComputationDomain, TripleBuffer) {
+  TripleBuffer<int> buffer;
+  EXPECT_FALSE(buffer.update());
+  buffer.back() = 1;
+  buffer.publish();
+  buffer.back() = 2;
+  buffer.publish();
+  EXPECT_TRUE(buffer.update());
+  EXPECT_EQ(buffer.front(), 2); // Latest value wins
+  EXPECT_FALSE(buffer.update());
+  EXPECT_EQ(buffer.front(), 2);
+  buffer.back() = 3;
+  buffer.publish();
+  EXPECT_TRUE(buffer.update());
+  EXPECT_EQ(buffer.front(), 3);
+}
+
+struct Particle {
+  double position{0};
+};
+
+TEST(ComputationDomain, FixedStepSimulation) {
+  FixedStepSimulationDomain<Particle> simulation;
+  simulation.stepRate(1000);
+  simulation.simulationFunction = [](double dt, Particle &p) {
+    p.position += dt; // Unit speed
+  };
+  simulation.interpolationFunction = [](const Particle &a, const Particle &b,
+                                        double alpha, Particle &out) {
+    out.position = a.position + alpha * (b.position - a.position);
+  };
+  simulation.init();
+  double lastStep = 0;
+  for (int i = 0; i < 20; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_TRUE(simulation.tick());
+    auto &current = simulation.current();
+    EXPECT_GE(double(current.step), lastStep);
+    lastStep = double(current.step);
+    EXPECT_NEAR(current.state.position, current.time, 1e-9);
+    EXPECT_GE(simulation.alpha(), 0.0);
+    EXPECT_LE(simulation.alpha(), 1.0);
+    EXPECT_GE(simulation.interpolated().position,
+              simulation.previous().state.position);
+    EXPECT_LE(simulation.interpolated().position, current.state.position);
+  }
+  simulation.cleanup();
+  // Simulation runs independently of the tick rate
+  EXPECT_GT(lastStep + simulation.droppedSteps(), 40u);
+}
+
+TEST(ComputationDomain, FixedStepInterpolation) {
+  FixedStepSimulationDomain<Particle> simulation;
+  simulation.stepRate(50);
+  simulation.simulationFunction = [](double dt, Particle &p) {
+    p.position += dt;
+  };
+  simulation.interpolationFunction = [](const Particle &a, const Particle &b,
+                                        double alpha, Particle &out) {
+    out.position = a.position + alpha * (b.position - a.position);
+  };
+  simulation.init();
+  // Only checks invariants that hold however the ticks are scheduled
+  double lastTime = 0.0;
+  uint64_t lastStep = 0;
+  int snapshots = 0;
+  auto endTime = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (snapshots < 5 && std::chrono::steady_clock::now() < endTime) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(3));
+    simulation.tick();
+    const auto &previous = simulation.previous();
+    const auto &current = simulation.current();
+    EXPECT_GE(simulation.alpha(), 0.0);
+    EXPECT_LE(simulation.alpha(), 1.0);
+    EXPECT_GE(current.time, previous.time);
+    EXPECT_GE(current.time, lastTime);
+    EXPECT_GE(current.step, lastStep);
+    EXPECT_NEAR(current.time, current.step / 50.0, 1e-9);
+    EXPECT_NEAR(simulation.interpolated().position,
+                previous.state.position +
+                    simulation.alpha() *
+                        (current.state.position - previous.state.position),
+                1e-9);
+    if (current.step != lastStep) {
+      snapshots++;
+    }
+    lastTime = current.time;
+    lastStep = current.step;
+  }
+  simulation.cleanup();
+  EXPECT_EQ(snapshots, 5);
+}
@@ -0,0 +1,182 @@
+#include "gtest/gtest.h"
+
+#include "al/scene/al_DistributedScene.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+namespace {
+
+class PositionedTestVoice : public al::PositionedVoice {
+public:
+  al::Parameter amp{"amp", "", 0.5};
+  al::ParameterString label{"label"};
+
+  void init() override { registerTriggerParameters(amp, label); }
+};
+
+// Forwards received messages to a replica scene
+struct SceneForwarder : al::osc::PacketHandler {
+  al::DistributedScene *scene;
+  std::mutex lock;
+
+  void onMessage(al::osc::Message &m) override {
+    std::unique_lock<std::mutex> lk(lock);
+    scene->consumeMessage(m, "scene");
+  }
+};
+
+void sendBatch(al::DistributedScene &scene, uint32_t sequence) {
+  // Empty batch: sequence number and event count
+  char blob[6] = {0};
+  for (int i = 0; i < 4; i++) {
+    blob[i] = char((sequence >> (8 * i)) & 0xFF);
+  }
+  al::osc::Packet p;
+  p.beginMessage("/events");
+  p << al::osc::Blob(blob, sizeof(blob));
+  p.endMessage();
+  al::osc::Message m(p.data(), p.size());
+  scene.consumeMessage(m);
+}
+
+} // namespace
+
+TEST(DistributedScene, BinaryTriggerPose) {
+  al::DistributedScene replica("scene");
+  replica.registerSynthClass<PositionedTestVoice>();
+  SceneForwarder forwarder;
+  forwarder.scene = &replica;
+  al::osc::Recv listener(9060, "127.0.0.1");
+  listener.handler(forwarder);
+  listener.start();
+
+  al::OSCNotifier notifier;
+  notifier.addListener("127.0.0.1", 9060);
+  al::DistributedScene sender("scene");
+  sender.registerSynthClass<PositionedTestVoice>();
+  sender.registerNotifier(notifier);
+  sender.binaryTriggers(true);
+  sender.triggerBatchInterval(0.01);
+
+  auto *voice = sender.getVoice<PositionedTestVoice>();
+  voice->amp.set(0.25f);
+  voice->label.set("voice label");
+  voice->setPose(al::Pose({1, 2, -3}, al::Quatd(0.5, 0.5, 0.5, 0.5)));
+  voice->setSize(2.5f);
+  sender.triggerOn(voice, 0, 1234);
+  sender.flushTriggers();
+  al::al_sleep(0.2);
+
+  std::unique_lock<std::mutex> lk(forwarder.lock);
+  replica.processVoices();
+  auto *replicaVoice =
+      dynamic_cast<PositionedTestVoice *>(replica.getActiveVoices());
+  ASSERT_NE(replicaVoice, nullptr);
+  EXPECT_EQ(replicaVoice->id(), 1234);
+  EXPECT_FALSE(replicaVoice->isPrimary());
+  EXPECT_FLOAT_EQ(replicaVoice->amp.get(), 0.25f);
+  EXPECT_EQ(replicaVoice->label.get(), "voice label");
+  al::Pose pose = replicaVoice->pose();
+  EXPECT_FLOAT_EQ(pose.x(), 1.f);
+  EXPECT_FLOAT_EQ(pose.y(), 2.f);
+  EXPECT_FLOAT_EQ(pose.z(), -3.f);
+  EXPECT_FLOAT_EQ(pose.quat().w, 0.5f);
+  EXPECT_FLOAT_EQ(pose.quat().z, 0.5f);
+  EXPECT_FLOAT_EQ(replicaVoice->size(), 2.5f);
+  EXPECT_EQ(replica.lostTriggerBatches(), 0u);
+
+  lk.unlock();
+  listener.stop();
+}
+
+TEST(DistributedScene, BinaryTriggerSequenceGap) {
+  al::DistributedScene replica("");
+  sendBatch(replica, 7);
+  EXPECT_EQ(replica.lostTriggerBatches(), 0u);
+  sendBatch(replica, 8);
+  EXPECT_EQ(replica.lostTriggerBatches(), 0u);
+  // Batches 9 and 10 missing
+  sendBatch(replica, 11);
+  EXPECT_EQ(replica.lostTriggerBatches(), 2u);
+  // Late batch arriving out of order is not counted
+  sendBatch(replica, 10);
+  EXPECT_EQ(replica.lostTriggerBatches(), 2u);
+  sendBatch(replica, 12);
+  EXPECT_EQ(replica.lostTriggerBatches(), 2u);
+
+  // Sequence numbers wrap around
+  al::DistributedScene wrapping("");
+  sendBatch(wrapping, UINT32_MAX - 1);
+  sendBatch(wrapping, UINT32_MAX);
+  sendBatch(wrapping, 0);
+  EXPECT_EQ(wrapping.lostTriggerBatches(), 0u);
+  sendBatch(wrapping, 2);
+  EXPECT_EQ(wrapping.lostTriggerBatches(), 1u);
+}
+
+TEST(DistributedScene, BinaryTriggerBatchPool) {
+  // Records the size of the received batches before forwarding them
+  struct BatchSizes : SceneForwarder {
+    size_t maxBlob = 0;
+    void onMessage(al::osc::Message &m) override {
+      if (m.typeTags() == "b") {
+        std::unique_lock<std::mutex> lk(lock);
+        al::osc::Blob blob;
+        m >> blob;
+        maxBlob = std::max(maxBlob, size_t(blob.size));
+        m.resetStream();
+      }
+      SceneForwarder::onMessage(m);
+    }
+  } forwarder;
+  al::DistributedScene replica("scene");
+  replica.registerSynthClass<PositionedTestVoice>();
+  forwarder.scene = &replica;
+  al::osc::Recv listener(9062, "127.0.0.1");
+  listener.handler(forwarder);
+  listener.start();
+
+  al::OSCNotifier notifier;
+  notifier.addListener("127.0.0.1", 9062);
+  al::DistributedScene sender("scene");
+  sender.registerSynthClass<PositionedTestVoice>();
+  sender.registerNotifier(notifier);
+  // Only sent when flushed
+  sender.triggerBatchInterval(60.0);
+  sender.binaryTriggers(true);
+
+  // Many batches, each defining the voice class
+  for (int i = 0; i < 100; i++) {
+    sender.triggerOn(sender.getVoice<PositionedTestVoice>(), 0, i);
+  }
+  sender.flushTriggers();
+  al::al_sleep(0.2);
+  {
+    std::unique_lock<std::mutex> lk(forwarder.lock);
+    EXPECT_LE(forwarder.maxBlob, size_t(al::DistributedScene::maxBatchBytes + 6));
+    replica.processVoices();
+    int count = 0;
+    for (auto *v = replica.getActiveVoices(); v; v = v->next) {
+      count++;
+    }
+    EXPECT_EQ(count, 100);
+  }
+
+  // Events that don't fit in the pool are dropped
+  const int events = 20000;
+  for (int i = 0; i < events; i++) {
+    sender.triggerOff(i);
+  }
+  uint64_t dropped = sender.droppedTriggerEvents();
+  EXPECT_GT(dropped, 0u);
+  EXPECT_LT(dropped, uint64_t(events));
+  // Flushing returns the batches to the pool
+  sender.flushTriggers();
+  sender.triggerOff(0);
+  EXPECT_EQ(sender.droppedTriggerEvents(), dropped);
+
+  sender.binaryTriggers(false);
+  listener.stop();
+}
@@ -6,6 +6,7 @@
 #include "al/sphere/al_AlloSphereSpeakerLayout.hpp"
 
 #include <fstream>
+#include <vector>
 
 class Voice : public al::PositionedVoice {
 public:
@@ -16,6 +17,32 @@ public:
   }
 };
 
+// Records the order voices are drawn in and the model matrix they see
+struct DrawLog {
+  std::vector<int> order;
+  std::vector<al::Vec3f> translations;
+
+  void record(int tag, al::Graphics &g) {
+    order.push_back(tag);
+    al::Matrix4f m = g.modelMatrix();
+    translations.push_back({m[12], m[13], m[14]});
+  }
+};
+
+class DrawnVoice : public al::PositionedVoice {
+public:
+  DrawLog *log{nullptr};
+  int tag{0};
+  void onProcess(al::Graphics &g) override { log->record(tag, g); }
+};
+
+class PlainDrawnVoice : public al::SynthVoice {
+public:
+  DrawLog *log{nullptr};
+  int tag{0};
+  void onProcess(al::Graphics &g) override { log->record(tag, g); }
+};
+
 TEST(DynamicScene, SpatializerLbapAllosphere2Voices) {
   al::AudioIOData io;
   io.channelsOut(64);
@@ -361,3 +388,55 @@ TEST(DynamicScene, SpatializerLbap2D) {
     EXPECT_NEAR(io.out(7, samp), 0.3, 1e-6);
   }
 }
+
+TEST(DynamicScene, DrawCullingAndGroups) {
+  al::DynamicScene scene(0, al::TimeMasterMode::TIME_MASTER_FREE);
+  DrawLog log;
+
+  auto *far = scene.getVoice<DrawnVoice>();
+  far->setPose(al::Pose({0, 0, -20}));
+  auto *grouped = scene.getVoice<DrawnVoice>();
+  grouped->setPose(al::Pose({1, 0, -5}));
+  grouped->drawGroup(1);
+  auto *near = scene.getVoice<DrawnVoice>();
+  near->setPose(al::Pose({0, 0, -5}));
+  auto *behind = scene.getVoice<DrawnVoice>();
+  behind->setPose(al::Pose({0, 0, 10}));
+  behind->boundingRadius(1);
+  auto *plain = scene.getVoice<PlainDrawnVoice>();
+
+  int tag = 0;
+  for (DrawnVoice *v : {far, grouped, near, behind}) {
+    v->log = &log;
+    v->tag = tag++;
+    scene.triggerOn(v);
+  }
+  plain->log = &log;
+  plain->tag = tag;
+  scene.triggerOn(plain);
+  scene.processVoices();
+
+  // Camera at the origin looking down -z
+  al::Graphics g;
+  g.projMatrix(al::Matrix4f::perspective(60.f, 1.f, 0.1f, 100.f));
+  g.viewMatrix(al::Matrix4f::identity());
+  scene.cullDrawing(true);
+  scene.sortDrawingByDistance(true);
+  scene.render(g);
+
+  // Plain voice first, then group 0 far to near, then group 1
+  EXPECT_EQ(scene.culledVoices(), 1u);
+  ASSERT_EQ(log.order, (std::vector<int>{4, 0, 2, 1}));
+  // Plain voice is drawn without transformations
+  EXPECT_EQ(log.translations[0], al::Vec3f(0, 0, 0));
+  EXPECT_EQ(log.translations[1], al::Vec3f(0, 0, -20));
+  EXPECT_EQ(log.translations[3], al::Vec3f(1, 0, -5));
+
+  // Voices without a bounding radius are never culled
+  log.order.clear();
+  log.translations.clear();
+  behind->boundingRadius(0);
+  scene.render(g);
+  EXPECT_EQ(scene.culledVoices(), 0u);
+  EXPECT_EQ(log.order.size(), 5u);
+}
@@ -0,0 +1,90 @@
+#include "gtest/gtest.h"
+
+#include "al/sound/al_FDNReverb.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace al;
+
+namespace {
+
+const double kSampleRate = 44100;
+
+// Impulse response of every output, computed in blocks of blockFrames
+std::vector<std::vector<float>> impulseResponse(FDNReverb &reverb, int frames,
+                                                int blockFrames) {
+  std::vector<float> in(frames, 0.0f);
+  in[0] = 1.0f;
+  std::vector<std::vector<float>> outs(reverb.outputs(),
+                                       std::vector<float>(frames, 0.0f));
+  std::vector<float *> pointers(reverb.outputs());
+  for (int start = 0; start < frames; start += blockFrames) {
+    for (unsigned i = 0; i < reverb.outputs(); i++) {
+      pointers[i] = outs[i].data() + start;
+    }
+    reverb.process(in.data() + start, pointers.data(),
+                   std::min(blockFrames, frames - start));
+  }
+  return outs;
+}
+
+double energy(const std::vector<float> &x, size_t begin, size_t end) {
+  double sum = 0;
+  for (size_t i = begin; i < end; i++) {
+    sum += double(x[i]) * x[i];
+  }
+  return sum;
+}
+
+} // namespace
+
+TEST(FDNReverb, DecayAndDecorrelation) {
+  for (auto mixing : {FDNReverb::HADAMARD, FDNReverb::HOUSEHOLDER}) {
+    FDNReverb reverb;
+    reverb.configure(24, kSampleRate);
+    EXPECT_EQ(reverb.delays(), 32u);
+    reverb.decayTime(1.0f).damping(0.0f).mixing(mixing);
+
+    const int frames = int(kSampleRate * 1.5);
+    auto outs = impulseResponse(reverb, frames, 512);
+
+    // Energy drops by about 30 dB every half second
+    const size_t halfSecond = size_t(kSampleRate / 2);
+    double first = 0, second = 0;
+    for (auto &out : outs) {
+      first += energy(out, halfSecond / 2, halfSecond);
+      second += energy(out, halfSecond + halfSecond / 2, 2 * halfSecond);
+    }
+    double dropDb = 10 * std::log10(first / second);
+    EXPECT_NEAR(dropDb, 30.0, 3.0) << "mixing " << mixing;
+
+    // Outputs are decorrelated
+    for (unsigned a = 0; a < 4; a++) {
+      for (unsigned b = a + 1; b < 4; b++) {
+        double cross = 0;
+        for (size_t i = 0; i < outs[a].size(); i++) {
+          cross += double(outs[a][i]) * outs[b][i];
+        }
+        double norm = std::sqrt(energy(outs[a], 0, outs[a].size()) *
+                                energy(outs[b], 0, outs[b].size()));
+        EXPECT_LT(std::abs(cross / norm), 0.2) << a << " " << b;
+      }
+    }
+  }
+}
+
+TEST(FDNReverb, BlockSizeIndependent) {
+  FDNReverb reverb;
+  reverb.configure(8, kSampleRate);
+  reverb.decayTime(2.0f).damping(0.3f);
+  auto whole = impulseResponse(reverb, 20000, 20000);
+  reverb.zero();
+  auto pieces = impulseResponse(reverb, 20000, 37);
+  for (unsigned i = 0; i < reverb.outputs(); i++) {
+    for (size_t n = 0; n < whole[i].size(); n++) {
+      ASSERT_FLOAT_EQ(whole[i][n], pieces[i][n]) << i << " " << n;
+    }
+  }
+}
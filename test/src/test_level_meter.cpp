@@ -0,0 +1,112 @@
+#include "gtest/gtest.h"
+
+#include "al/sound/al_LevelMeter.hpp"
+#include "al/sphere/al_Meter.hpp"
+
+#include <cmath>
+#include <vector>
+
+using namespace al;
+
+namespace {
+
+const double kSampleRate = 48000;
+
+// Meter one second of sines, one per channel
+void meterSines(LevelMeter &meter, const std::vector<double> &freqs,
+                const std::vector<double> &amplitudes, double phase = 0) {
+  const int frames = 480;
+  std::vector<std::vector<float>> buffers(freqs.size(),
+                                          std::vector<float>(frames));
+  std::vector<const float *> pointers;
+  for (auto &b : buffers) {
+    pointers.push_back(b.data());
+  }
+  for (int block = 0; block < 100; block++) {
+    for (size_t c = 0; c < freqs.size(); c++) {
+      for (int i = 0; i < frames; i++) {
+        double t = (block * frames + i) / kSampleRate;
+        buffers[c][i] =
+            float(amplitudes[c] * sin(2 * M_PI * freqs[c] * t + phase));
+      }
+    }
+    meter.process(pointers.data(), frames);
+  }
+}
+
+} // namespace
+
+TEST(LevelMeter, Levels) {
+  LevelMeter meter;
+  meter.configure(2, kSampleRate);
+  meter.rmsTime(0.1f);
+  EXPECT_EQ(meter.snapshot().peak.size(), 2u);
+  EXPECT_FALSE(meter.update());
+
+  meterSines(meter, {1000.0, 997.0}, {0.5, 0.1});
+  ASSERT_TRUE(meter.update());
+  const LevelMeterSnapshot &s = meter.snapshot();
+  EXPECT_EQ(s.frames, uint64_t(kSampleRate));
+  EXPECT_NEAR(s.peak[0], 0.5, 0.001);
+  EXPECT_NEAR(s.rms[0], 0.5 / std::sqrt(2.0), 0.005);
+  EXPECT_NEAR(s.truePeak[0], 0.5, 0.01);
+  EXPECT_NEAR(s.peak[1], 0.1, 0.001);
+  // Sum of a -6 dBFS and a -20 dBFS sine near 1 kHz. The K-weighting gain at
+  // 1 kHz cancels the -0.691 dB offset
+  double expected = 10 * std::log10(0.5 * (0.25 + 0.01));
+  EXPECT_NEAR(s.loudness, expected, 0.1);
+
+  // Peaks fall at the release rate once the signal stops
+  meter.peakRelease(20.0f);
+  meterSines(meter, {1000.0, 997.0}, {0.0, 0.0});
+  ASSERT_TRUE(meter.update());
+  EXPECT_NEAR(meter.snapshot().peak[0], 0.05, 0.001);
+  EXPECT_LT(meter.snapshot().rms[0], 0.005);
+  EXPECT_EQ(meter.snapshot().loudness, -70.0f);
+}
+
+TEST(LevelMeter, TruePeak) {
+  LevelMeter meter;
+  meter.configure(1, kSampleRate);
+  meter.loudness(false);
+  // Samples of a quarter sample rate sine at 45 degrees miss its peaks
+  meterSines(meter, {kSampleRate / 4}, {1.0}, M_PI / 4);
+  ASSERT_TRUE(meter.update());
+  EXPECT_NEAR(meter.snapshot().peak[0], std::sqrt(0.5), 0.001);
+  EXPECT_NEAR(meter.snapshot().truePeak[0], 1.0, 0.05);
+}
+
+TEST(LevelMeter, MeterConfiguredOffAudioThread) {
+  AudioIOData io;
+  io.framesPerSecond(kSampleRate);
+  io.framesPerBuffer(480);
+  io.channelsOut(2);
+  auto fill = [&](float value) {
+    for (int c = 0; c < 2; c++) {
+      for (int i = 0; i < 480; i++) {
+        io.outBuffer(c)[i] = value;
+      }
+    }
+  };
+
+  Meter meter;
+  meter.init(Speakers{Speaker(0), Speaker(1)});
+  fill(0.5f);
+  // Not configured yet, so nothing is measured on the audio thread
+  meter.processSound(io);
+  EXPECT_TRUE(meter.getMeterValues().empty());
+  EXPECT_EQ(meter.levels().channels(), 2u);
+
+  meter.processSound(io);
+  auto values = meter.getMeterValues();
+  ASSERT_EQ(values.size(), 2u);
+  EXPECT_GT(values[0], 0.2f);
+
+  // Displayed values fall slowly after the signal stops
+  meter.levels().peakRelease(1000.0f);
+  fill(0.0f);
+  meter.processSound(io);
+  auto released = meter.getMeterValues();
+  EXPECT_LT(released[0], values[0]);
+  EXPECT_GT(released[0], 0.9f * values[0]);
+}
@@ -3,8 +3,10 @@
 
 #include "gtest/gtest.h"
 
+#include "al/math/al_BatchTransform.hpp"
 #include "al/math/al_Functions.hpp"
 #include "al/math/al_Mat.hpp"
+#include "al/math/al_Matrix4.hpp"
 #include "al/math/al_Quat.hpp"
 #include "al/math/al_Vec.hpp"
 // #include "al/math/al_Random.hpp"
@@ -1177,4 +1179,83 @@ EXPECT_TRUE(eq(m(2,2),i));\
     EXPECT_TRUE(f.testSphere(Vec3d(0, 0, 0), 1.1) == Frustumd::INTERSECT);
     EXPECT_TRUE(f.testSphere(Vec3d(2, 2, 2), 0.5) == Frustumd::OUTSIDE);
   }
+
+  {
+    // Camera at the origin looking down -z
+    Frustumd f;
+    Mat4d m = Matrix4d::perspective(90, 1, 1, 100) *
+              Mat4d::translation(Vec3d(0, 0, -2));
+    EXPECT_TRUE(f.fromMatrix(m));
+    EXPECT_NEAR(f.ntl[2], -1 + 2, 1e-9);
+    EXPECT_NEAR(f.fbr[0], 100, 1e-6);
+    EXPECT_NEAR(f.fbr[1], -100, 1e-6);
+
+    EXPECT_TRUE(f.testPoint(Vec3d(0, 0, -10)) == Frustumd::INSIDE);
+    EXPECT_TRUE(f.testPoint(Vec3d(0, 0, 10)) == Frustumd::OUTSIDE);
+    EXPECT_TRUE(f.testPoint(Vec3d(0, 0, 1.5)) == Frustumd::OUTSIDE);
+    EXPECT_TRUE(f.testPoint(Vec3d(20, 0, -10)) == Frustumd::OUTSIDE);
+    EXPECT_TRUE(f.testSphere(Vec3d(13, 0, -10), 2) == Frustumd::INTERSECT);
+    EXPECT_TRUE(f.testSphere(Vec3d(0, 0, -200), 50) == Frustumd::OUTSIDE);
+  }
+}
+
+TEST(Math, SIMDTransforms) {
+  Mat4f a, b;
+  Mat4d ad, bd;
+  for (int i = 0; i < 16; ++i) {
+    a[i] = ad[i] = 0.25f * i - 1.5f;
+    b[i] = bd[i] = 1.0f / (i + 1);
+  }
+  Mat4f r = a * b;
+  Mat4d rd = ad * bd;
+  for (int i = 0; i < 16; ++i) {
+    EXPECT_NEAR(r[i], rd[i], 1e-5);
+  }
+  // Result may alias an operand
+  Mat4f::multiply(a, a, b);
+  for (int i = 0; i < 16; ++i) {
+    EXPECT_EQ(a[i], r[i]);
+  }
+  Vec4f v(1, -2, 3, 0.5f);
+  Vec4f mv = r * v;
+  Vec4d mvd = rd * Vec4d(1, -2, 3, 0.5);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_NEAR(mv[i], mvd[i], 1e-5);
+  }
+
+  Mat4f xfm = Mat4f::translation(Vec3f(1, 2, 3)) *
+              Mat4f::rotation(0.7f, 0, 1) * Mat4f::scaling(2.f, 1.f, 0.5f);
+  std::vector<Vec3f> points, out(100);
+  std::vector<Vec4f> points4, out4(100);
+  for (int i = 0; i < 100; ++i) {
+    points.emplace_back(0.1f * i, -0.2f * i, 1.0f);
+    points4.emplace_back(points.back(), 1.0f);
+  }
+  transformPoints(xfm, points.data(), out.data(), points.size());
+  transform(xfm, points4.data(), out4.data(), points4.size());
+  for (int i = 0; i < 100; ++i) {
+    Vec4f expected = xfm * Vec4f(points[i], 1);
+    for (int k = 0; k < 3; ++k) {
+      EXPECT_FLOAT_EQ(out[i][k], expected[k]);
+      EXPECT_FLOAT_EQ(out4[i][k], expected[k]);
+    }
+  }
+  transformVectors(xfm, points.data(), out.data(), points.size());
+  for (int i = 0; i < 100; ++i) {
+    Vec4f expected = xfm * Vec4f(points[i], 0);
+    for (int k = 0; k < 3; ++k) {
+      EXPECT_NEAR(out[i][k], expected[k], 1e-5);
+    }
+  }
+
+  // In place quaternion rotation
+  Quatf q = Quatf().fromAxisAngle(1.1f, Vec3f(1, 2, 3).normalize());
+  out = points;
+  rotate(q, out.data(), out.data(), out.size());
+  for (int i = 0; i < 100; ++i) {
+    Vec3f expected = q.rotate(points[i]);
+    for (int k = 0; k < 3; ++k) {
+      EXPECT_NEAR(out[i][k], expected[k], 1e-4);
+    }
+  }
 }
@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <array>
+#include <random>
+#include <set>
+
+#include "al/graphics/al_Mesh.hpp"
+#include "al/graphics/al_MeshPacker.hpp"
+#include "gtest/gtest.h"
+
+using namespace al;
+
+namespace {
+
+Mesh randomMesh(Mesh::Primitive prim, bool indexed, int numVertices) {
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<float> dist(-1, 1);
+  Mesh m(prim);
+  for (int i = 0; i < numVertices; i++) {
+    m.vertex(dist(gen), dist(gen), dist(gen));
+  }
+  if (indexed) {
+    for (int i = 0; i < 3 * numVertices; i++) {
+      m.index(gen() % numVertices);
+    }
+  }
+  return m;
+}
+
+bool sameNormals(const Mesh &a, const Mesh &b, float eps = 1e-5f) {
+  if (a.normals().size() != b.normals().size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.normals().size(); i++) {
+    if ((a.normals()[i] - b.normals()[i]).mag() > eps) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+TEST(Mesh, GenerateNormalsParallel) {
+  for (auto prim : {Mesh::TRIANGLES, Mesh::TRIANGLE_STRIP}) {
+    for (bool indexed : {false, true}) {
+      Mesh serial = randomMesh(prim, indexed, 50000);
+      Mesh parallel = serial;
+      serial.generateNormals();
+      parallel.generateNormalsParallel(true, false, 4);
+      EXPECT_TRUE(sameNormals(serial, parallel));
+    }
+  }
+
+  // Indexed meshes without triangles get zero normals
+  Mesh lines = randomMesh(Mesh::TRIANGLES, true, 100);
+  lines.generateNormals();
+  lines.primitive(Mesh::LINES);
+  lines.generateNormalsParallel(true, false, 4);
+  for (auto &n : lines.normals()) {
+    EXPECT_EQ(n, Mesh::Normal(0, 0, 0));
+  }
+}
+
+TEST(Mesh, UpdateNormals) {
+  for (auto prim : {Mesh::TRIANGLES, Mesh::TRIANGLE_STRIP}) {
+    for (bool indexed : {false, true}) {
+      Mesh m = randomMesh(prim, indexed, 3000);
+      m.generateNormals();
+      for (int i = 100; i < 200; i++) {
+        m.vertices()[i] += Vec3f(0.1f, -0.2f, 0.05f);
+      }
+      m.updateNormals(100, 200);
+      Mesh full = m;
+      full.generateNormals();
+      EXPECT_TRUE(sameNormals(m, full));
+    }
+  }
+
+  // Changed indices regenerate all normals
+  Mesh m = randomMesh(Mesh::TRIANGLES, true, 3000);
+  m.generateNormals();
+  std::reverse(m.indices().begin() + 600, m.indices().end());
+  m.updateNormals(0, 1);
+  Mesh full = m;
+  full.generateNormals();
+  EXPECT_TRUE(sameNormals(m, full));
+}
+
+namespace {
+
+// Non-indexed grid of quads, each made of two triangles
+Mesh gridTriangles(int n) {
+  Mesh m(Mesh::TRIANGLES);
+  for (int j = 0; j < n; j++) {
+    for (int i = 0; i < n; i++) {
+      Vec3f a(i, j, 0), b(i + 1, j, 0), c(i + 1, j + 1, 0), d(i, j + 1, 0);
+      m.vertex(a).vertex(b).vertex(c);
+      m.vertex(a).vertex(c).vertex(d);
+    }
+  }
+  return m;
+}
+
+std::multiset<std::array<float, 9>> triangleSet(const Mesh &m) {
+  std::multiset<std::array<float, 9>> tris;
+  for (size_t i = 0; i + 2 < m.indices().size(); i += 3) {
+    std::array<float, 9> t;
+    for (int k = 0; k < 3; k++) {
+      const auto &v = m.vertices()[m.indices()[i + k]];
+      t[3 * k] = v.x;
+      t[3 * k + 1] = v.y;
+      t[3 * k + 2] = v.z;
+    }
+    tris.insert(t);
+  }
+  return tris;
+}
+
+} // namespace
+
+TEST(Mesh, Weld) {
+  Mesh m = gridTriangles(20);
+  m.weld();
+  EXPECT_EQ(m.vertices().size(), 21u * 21u);
+  EXPECT_EQ(m.indices().size(), 20u * 20u * 6u);
+
+  // Vertices within tolerance are merged
+  Mesh jittered = gridTriangles(10);
+  for (size_t i = 0; i < jittered.vertices().size(); i++) {
+    jittered.vertices()[i].x += (i % 2) * 0.001f;
+  }
+  jittered.weld(0.01f);
+  EXPECT_EQ(jittered.vertices().size(), 11u * 11u);
+
+  // Differing attributes keep vertices apart
+  Mesh colored = gridTriangles(2);
+  for (size_t i = 0; i < colored.vertices().size(); i++) {
+    colored.color(i % 2 ? Color(1, 0, 0) : Color(0, 1, 0));
+  }
+  Mesh weldAll = colored;
+  colored.weld();
+  weldAll.weld(0, false);
+  EXPECT_EQ(weldAll.vertices().size(), 9u);
+  EXPECT_GT(colored.vertices().size(), 9u);
+  EXPECT_EQ(colored.colors().size(), colored.vertices().size());
+}
+
+TEST(Mesh, Optimize) {
+  Mesh m = gridTriangles(64);
+  m.weld();
+
+  // Shuffle triangles to destroy locality
+  std::mt19937 gen(2);
+  size_t Nt = m.indices().size() / 3;
+  for (size_t t = Nt - 1; t > 0; t--) {
+    size_t u = gen() % (t + 1);
+    for (int k = 0; k < 3; k++) {
+      std::swap(m.indices()[3 * t + k], m.indices()[3 * u + k]);
+    }
+  }
+  auto before = triangleSet(m);
+  float acmrBefore = m.vertexCacheMissRatio();
+
+  m.optimize();
+  EXPECT_LT(m.vertexCacheMissRatio(), 0.8f);
+  EXPECT_LT(m.vertexCacheMissRatio(), acmrBefore);
+  EXPECT_TRUE(triangleSet(m) == before);
+
+  // Vertices are in order of first use
+  unsigned next = 0;
+  for (auto idx : m.indices()) {
+    EXPECT_LE(idx, next);
+    if (idx == next) {
+      next++;
+    }
+  }
+  EXPECT_EQ(next, m.vertices().size());
+}
+
+TEST(Mesh, PackerLayout) {
+  Mesh m = gridTriangles(4);
+  for (size_t i = 0; i < m.vertices().size(); i++) {
+    m.color(0.25f, 0.5f, 0.75f, 1.f);
+  }
+  m.generateNormals();
+
+  MeshPacker packer;
+  packer.pack(m);
+  EXPECT_TRUE(packer.layoutChanged());
+  EXPECT_EQ(packer.stride(), sizeof(Vec3f) + sizeof(Color) + sizeof(Vec3f));
+  EXPECT_EQ(packer.size(), packer.stride() * m.vertices().size());
+  EXPECT_FALSE(packer.attrib(MeshPacker::TEXCOORD).enabled);
+
+  MeshPacker quantized(true);
+  quantized.pack(m);
+  EXPECT_EQ(quantized.stride(), sizeof(Vec3f) + 4 + 8);
+  for (size_t i = 0; i < m.vertices().size(); i++) {
+    float v[4];
+    ASSERT_TRUE(quantized.unpack(MeshPacker::POSITION, i, v));
+    EXPECT_EQ(Vec3f(v[0], v[1], v[2]), m.vertices()[i]);
+    ASSERT_TRUE(quantized.unpack(MeshPacker::COLOR, i, v));
+    EXPECT_NEAR(v[1], 0.5f, 1.f / 255.f);
+    ASSERT_TRUE(quantized.unpack(MeshPacker::NORMAL, i, v));
+    EXPECT_NEAR(v[2], m.normals()[i].z, 1e-3f);
+  }
+}
+
+TEST(Mesh, PackerDirtyRanges) {
+  Mesh m = gridTriangles(16);
+  MeshPacker packer;
+  packer.pack(m);
+  packer.clearDirty();
+
+  // Unchanged mesh uploads nothing
+  packer.pack(m);
+  EXPECT_FALSE(packer.layoutChanged());
+  EXPECT_FALSE(packer.indicesChanged());
+  EXPECT_EQ(packer.dirtyBytes(), 0u);
+
+  // Two distant edits produce two ranges
+  packer.mergeGap(4);
+  m.vertices()[10].z = 1;
+  m.vertices()[12].z = 1;
+  m.vertices()[1000].z = 1;
+  packer.pack(m);
+  ASSERT_EQ(packer.dirtyRanges().size(), 2u);
+  EXPECT_EQ(packer.dirtyRanges()[0],
+            MeshPacker::Range(10 * packer.stride(), 13 * packer.stride()));
+  EXPECT_EQ(packer.dirtyRanges()[1],
+            MeshPacker::Range(1000 * packer.stride(), 1001 * packer.stride()));
+  packer.clearDirty();
+
+  // Adding an attribute changes the layout
+  m.generateNormals();
+  packer.pack(m);
+  EXPECT_TRUE(packer.layoutChanged());
+  EXPECT_EQ(packer.dirtyBytes(), packer.size());
+}
+
+TEST(Mesh, TransformFloat) {
+  Mesh m = randomMesh(Mesh::TRIANGLES, false, 300);
+  m.generateNormals();
+  Mesh reference = m;
+  Mat4d xfm = Mat4d::translation(Vec3d(1, 2, 3)) *
+              Mat4d::rotation(0.3, 1, 2) * Mat4d::scaling(2.0, 2.0, 2.0);
+  // Batch version for float matrices matches the generic template
+  m.transform(Mat4f(xfm), 10, -10);
+  reference.transform(xfm, 10, -10);
+  for (size_t i = 0; i < m.vertices().size(); i++) {
+    EXPECT_LT((m.vertices()[i] - reference.vertices()[i]).mag(), 1e-5f);
+  }
+  EXPECT_TRUE(sameNormals(m, reference));
+  EXPECT_EQ(m.vertices()[5], reference.vertices()[5]);
+}
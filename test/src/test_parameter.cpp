@@ -0,0 +1,80 @@
+#include <thread>
+
+#include "al/ui/al_Parameter.hpp"
+#include "al/ui/al_ParameterSmoother.hpp"
+#include "gtest/gtest.h"
+
+using namespace al;
+
+TEST(Parameter, ConcurrentVec3) {
+  ParameterVec3 p{"vec"};
+  std::atomic<bool> running{true};
+
+  // Writer only ever stores vectors with equal components
+  std::thread writer([&]() {
+    float v = 0;
+    while (running) {
+      p.set(Vec3f(v, v, v));
+      v += 1;
+    }
+  });
+  for (int i = 0; i < 100000; i++) {
+    Vec3f v = p.get();
+    ASSERT_EQ(v.x, v.y);
+    ASSERT_EQ(v.x, v.z);
+  }
+  running = false;
+  writer.join();
+}
+
+TEST(Parameter, ConcurrentPose) {
+  ParameterPose p{"pose"};
+  std::atomic<bool> running{true};
+  std::thread writer([&]() {
+    double v = 0;
+    while (running) {
+      p.set(Pose(Vec3d(v, v, v)));
+      v += 1;
+    }
+  });
+  for (int i = 0; i < 100000; i++) {
+    Vec3d pos = p.get().pos();
+    ASSERT_EQ(pos.x, pos.y);
+    ASSERT_EQ(pos.x, pos.z);
+  }
+  running = false;
+  writer.join();
+}
+
+TEST(Parameter, SmootherLinear) {
+  Parameter p{"gain", "", 0.f, 0.f, 1.f};
+  ParameterSmoother<float> smoother(p, 0.01f); // 10 samples at 1 kHz
+  smoother.update(1000);
+  EXPECT_FLOAT_EQ(smoother.next(), 0.f);
+
+  p.set(1.f);
+  smoother.update(1000);
+  float block[10];
+  smoother.nextBlock(block, 10);
+  for (int i = 0; i < 10; i++) {
+    EXPECT_NEAR(block[i], (i + 1) / 10.f, 1e-6);
+  }
+  EXPECT_FALSE(smoother.isSmoothing());
+  EXPECT_EQ(smoother.next(), 1.f);
+}
+
+TEST(Parameter, SmootherOnePole) {
+  ParameterVec3 p{"position"};
+  ParameterSmoother<Vec3f> smoother(p, 0.01f,
+                                    ParameterSmoother<Vec3f>::ONE_POLE);
+  p.set(Vec3f(1, 2, 3));
+  smoother.update(1000);
+  Vec3f previous = smoother.current();
+  for (int i = 0; i < 100; i++) {
+    Vec3f v = smoother.next();
+    EXPECT_GT(v.x, previous.x);
+    previous = v;
+  }
+  // Ten time constants: within 0.01% of target
+  EXPECT_NEAR(previous.z, 3.f, 3e-4f);
+}
@@ -0,0 +1,159 @@
+#include "gtest/gtest.h"
+
+#include "al/ui/al_ParameterJournal.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+using namespace al;
+
+TEST(ParameterJournal, RecordSeek) {
+  Parameter p{"param", "group", 0.0f, 0.0, 100.0};
+  ParameterInt pint{"paramint", "group", 0, 0, 1000};
+  ParameterString pstring{"paramstring", "group"};
+  ParameterVec3 pvec{"paramvec", "group"};
+  ParameterMenu pmenu{"parammenu", "group"};
+  pmenu.setElements({"a", "b", "c"});
+
+  std::atomic<uint64_t> clock{0};
+  ParameterJournal journal;
+  journal << p << pint << pstring << pvec << pmenu;
+  journal.sampleClock([&]() { return clock.load(); }, 1000.0);
+  journal.snapshotInterval(0.1);
+
+  const std::string fileName = "test.journal";
+  ASSERT_TRUE(journal.startRecord(fileName));
+  ValueSource remote{"10.0.0.2", 9011};
+  for (int i = 1; i <= 1000; i++) {
+    clock = i;
+    p.set(i * 0.1f);
+    if (i % 10 == 0) {
+      pint.set(i, &remote);
+    }
+  }
+  clock = 1500;
+  pstring.set("text");
+  pvec.set(Vec3f(1, 2, 3));
+  pmenu.set(2);
+  journal.stopRecord();
+  EXPECT_EQ(journal.droppedChanges(), 0u);
+
+  // Recording can also be done from several threads at once
+  Parameter other{"other", "group"};
+  ParameterJournal threadedJournal;
+  threadedJournal << other << p;
+  ASSERT_TRUE(threadedJournal.startRecord("threaded.journal"));
+  std::thread t([&]() {
+    for (int i = 0; i < 1000; i++) {
+      other.set(float(i));
+    }
+  });
+  for (int i = 0; i < 1000; i++) {
+    p.set(i * 0.1f);
+  }
+  t.join();
+  threadedJournal.stopRecord();
+
+  Parameter p2{"param", "group", 0.0f, 0.0, 100.0};
+  ParameterInt pint2{"paramint", "group", 0, 0, 1000};
+  ParameterString pstring2{"paramstring", "group"};
+  ParameterVec3 pvec2{"paramvec", "group"};
+  ParameterMenu pmenu2{"parammenu", "group"};
+  pmenu2.setElements({"a", "b", "c"});
+  ParameterJournalPlayer player;
+  player << p2 << pint2 << pstring2 << pvec2 << pmenu2;
+  ASSERT_TRUE(player.open(fileName));
+  EXPECT_DOUBLE_EQ(player.duration(), 1.5);
+  EXPECT_EQ(player.parameterAddresses().size(), 5u);
+
+  ASSERT_TRUE(player.seek(0.5005));
+  EXPECT_FLOAT_EQ(p2.get(), 50.0f);
+  EXPECT_EQ(pint2.get(), 500);
+  EXPECT_EQ(pstring2.get(), "");
+
+  // Backwards
+  ASSERT_TRUE(player.seek(0.25));
+  EXPECT_FLOAT_EQ(p2.get(), 25.0f);
+  EXPECT_EQ(pint2.get(), 250);
+
+  int remoteChanges = 0;
+  player.registerChangeCallback(
+      [&](const std::string &address, std::vector<VariantValue> &fields,
+          const std::string &source, double time) {
+        if (address == "/group/paramint") {
+          EXPECT_EQ(source, "10.0.0.2:9011");
+          remoteChanges++;
+        } else if (address == "/group/param") {
+          EXPECT_EQ(source, "");
+        }
+        EXPECT_LE(time, 1.5);
+      });
+  ASSERT_TRUE(player.advance(0.5));
+  EXPECT_FLOAT_EQ(p2.get(), 50.0f);
+  EXPECT_EQ(remoteChanges, 25);
+  ASSERT_TRUE(player.advance(2.0));
+  EXPECT_FLOAT_EQ(p2.get(), 100.0f);
+  EXPECT_EQ(pint2.get(), 1000);
+  EXPECT_EQ(pstring2.get(), "text");
+  EXPECT_EQ(pvec2.get(), Vec3f(1, 2, 3));
+  EXPECT_EQ(pmenu2.get(), 2);
+
+  ParameterJournalPlayer::ParameterStates states;
+  ASSERT_TRUE(player.stateAt(0.0, states));
+  EXPECT_FLOAT_EQ(states["/group/param"][0].get<float>(), 0.0f);
+  EXPECT_EQ(states["/group/parammenu"][0].get<std::string>(), "a");
+  player.close();
+
+  ASSERT_TRUE(player.open("threaded.journal"));
+  ASSERT_TRUE(player.stateAt(player.duration() + 1.0, states));
+  EXPECT_FLOAT_EQ(states["/group/other"][0].get<float>(), 999.0f);
+  EXPECT_FLOAT_EQ(states["/group/param"][0].get<float>(), 99.9f);
+  player.close();
+
+  std::remove(fileName.c_str());
+  std::remove("threaded.journal");
+}
+
+TEST(ParameterJournal, MaxRecordTime) {
+  Parameter p{"param", "group", 0.0f, 0.0, 100.0};
+  ParameterMenu pmenu{"parammenu", "group"};
+  pmenu.setElements({"a", "b", "c"});
+  std::atomic<uint64_t> clock{0};
+  ParameterJournal journal;
+  journal << p << pmenu;
+  journal.sampleClock([&]() { return clock.load(); }, 1000.0);
+  journal.maxRecordTime(1.0);
+
+  const std::string fileName = "max_time.journal";
+  ASSERT_TRUE(journal.startRecord(fileName));
+  // Only used from the next recording
+  journal.sampleClock([]() { return uint64_t(0); }, 10.0);
+  for (int i = 1; i <= 2000; i++) {
+    clock = i;
+    p.set(i * 0.01f);
+    if (i == 500) {
+      pmenu.set(1);
+    } else if (i == 1500) {
+      pmenu.set(2);
+    }
+  }
+  // The writer thread notices the limit has passed
+  for (int i = 0; i < 500 && journal.recording(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  EXPECT_FALSE(journal.recording());
+  journal.stopRecord();
+
+  ParameterJournalPlayer player;
+  ASSERT_TRUE(player.open(fileName));
+  EXPECT_DOUBLE_EQ(player.duration(), 1.0);
+  ParameterJournalPlayer::ParameterStates states;
+  ASSERT_TRUE(player.stateAt(2.0, states));
+  EXPECT_FLOAT_EQ(states["/group/param"][0].get<float>(), 10.0f);
+  // Menu changes are recorded as the element text
+  EXPECT_EQ(states["/group/parammenu"][0].get<std::string>(), "b");
+  player.close();
+  std::remove(fileName.c_str());
+}
@@ -4,6 +4,8 @@
 #include "al/ui/al_ParameterServer.hpp"
 
 #include <fstream>
+#include <map>
+#include <mutex>
 
 TEST(ParameterSever, Handshake) {
   al::ParameterServer s;
@@ -30,3 +32,70 @@ TEST(ParameterSever, Handshake) {
   c.stopServer();
   s.stopServer();
 }
+
+TEST(ParameterSever, NotifierCoalescing) {
+  struct Counter : al::osc::PacketHandler {
+    std::mutex lock;
+    std::map<std::string, float> values;
+    int messages = 0;
+    void onMessage(al::osc::Message &m) override {
+      std::unique_lock<std::mutex> lk(lock);
+      float v;
+      if (m.typeTags() == "i") {
+        int i;
+        m >> i;
+        v = float(i);
+      } else {
+        m >> v;
+      }
+      values[m.addressPattern()] = v;
+      messages++;
+    }
+  } counter;
+
+  al::osc::Recv listener(9050, "127.0.0.1");
+  listener.handler(counter);
+  listener.start();
+
+  {
+    al::OSCNotifier notifier;
+    notifier.addListener("127.0.0.1", 9050);
+    notifier.coalesceInterval(0.05);
+    // Repeated values for the same address collapse to the last one
+    for (int i = 0; i < 100; i++) {
+      notifier.notifyListeners("/repeated", float(i));
+    }
+    // Many addresses are packed into bundles
+    for (int i = 0; i < 200; i++) {
+      notifier.notifyListeners("/param/" + std::to_string(i), float(i));
+    }
+    // Triggers are events and are all sent
+    al::Trigger trigger("trigger");
+    for (int i = 0; i < 3; i++) {
+      notifier.notifyListeners("/trigger", &trigger, nullptr);
+    }
+    al::al_sleep(0.2);
+  }
+
+  std::unique_lock<std::mutex> lk(counter.lock);
+  EXPECT_EQ(counter.messages, 204);
+  EXPECT_EQ(counter.values["/repeated"], 99.f);
+  EXPECT_EQ(counter.values["/param/199"], 199.f);
+  counter.messages = 0;
+  lk.unlock();
+
+  {
+    // Without a coalescing interval every value is sent immediately
+    al::OSCNotifier notifier;
+    EXPECT_EQ(notifier.coalesceInterval(), 0.0);
+    notifier.addListener("127.0.0.1", 9050);
+    for (int i = 0; i < 10; i++) {
+      notifier.notifyListeners("/repeated", float(i));
+    }
+    al::al_sleep(0.2);
+  }
+  lk.lock();
+  EXPECT_EQ(counter.messages, 10);
+  EXPECT_EQ(counter.values["/repeated"], 9.f);
+  listener.stop();
+}
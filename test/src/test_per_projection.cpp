@@ -0,0 +1,164 @@
+#include "gtest/gtest.h"
+
+#include "al/io/al_File.hpp"
+#include "al/sphere/al_PerProjection.hpp"
+#include "al/types/al_Conversion.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <thread>
+
+using namespace al;
+
+namespace {
+
+const char *calibrationDir = "per_projection_test/";
+
+void writeViewportData(const std::string &path, int count, float offset) {
+  std::vector<Vec4f> data(count);
+  for (int i = 0; i < count; i++) {
+    data[i] = Vec4f(i * 0.25f + offset, -i * 0.5f, 1.f, i / float(count));
+  }
+  std::ofstream file(path, std::ios::binary);
+  file.write(reinterpret_cast<const char *>(data.data()),
+             data.size() * sizeof(Vec4f));
+}
+
+void writeCalibration() {
+  Dir::make(calibrationDir);
+  std::ofstream config(std::string(calibrationDir) + "host.txt");
+  config << "id vp0 width 4 height 2 b 0 h 0.5 l 0 w 0.5 active 1 filepath "
+         << calibrationDir << "vp0.bin\n"
+         << "id vp1 width 3 height 3 b 0.5 h 0.5 l 0.5 w 0.5 active 1 "
+         << "filepath " << calibrationDir << "vp1.bin\n";
+  config.close();
+  writeViewportData(std::string(calibrationDir) + "vp0.bin", 8, 0.f);
+  writeViewportData(std::string(calibrationDir) + "vp1.bin", 9, 10.f);
+}
+
+} // namespace
+
+TEST(Conversion, HalfFloat) {
+  EXPECT_EQ(floatToHalf(1.f), 0x3c00);
+  EXPECT_EQ(floatToHalf(-2.f), 0xc000);
+  EXPECT_EQ(floatToHalf(-0.f), 0x8000);
+  EXPECT_EQ(floatToHalf(65504.f), 0x7bff); // Largest half
+  EXPECT_EQ(floatToHalf(65520.f), 0x7c00); // Rounds up to infinity
+  EXPECT_EQ(floatToHalf(1e6f), 0x7c00);
+
+  // Denormals
+  EXPECT_EQ(floatToHalf(std::ldexp(1.f, -14)), 0x0400); // Smallest normal
+  EXPECT_EQ(floatToHalf(std::ldexp(1023.f, -24)), 0x03ff);
+  EXPECT_EQ(floatToHalf(std::ldexp(1.f, -24)), 0x0001);
+  EXPECT_EQ(floatToHalf(std::ldexp(1.f, -25)), 0x0000); // Ties to even
+  EXPECT_EQ(floatToHalf(std::ldexp(1.5f, -25)), 0x0001);
+  EXPECT_EQ(floatToHalf(-std::ldexp(1.f, -30)), 0x8000);
+  EXPECT_EQ(halfToFloat(0x0001), std::ldexp(1.f, -24));
+  EXPECT_EQ(halfToFloat(0x83ff), -std::ldexp(1023.f, -24));
+
+  // Rounding to nearest even
+  EXPECT_EQ(floatToHalf(1.f + std::ldexp(1.f, -11)), 0x3c00);
+  EXPECT_EQ(floatToHalf(1.f + std::ldexp(3.f, -11)), 0x3c02);
+
+  // Infinity and NaN
+  const float inf = std::numeric_limits<float>::infinity();
+  EXPECT_EQ(floatToHalf(inf), 0x7c00);
+  EXPECT_EQ(floatToHalf(-inf), 0xfc00);
+  EXPECT_EQ(halfToFloat(0xfc00), -inf);
+  uint16_t nan = floatToHalf(std::numeric_limits<float>::quiet_NaN());
+  EXPECT_EQ(nan & 0x7c00, 0x7c00);
+  EXPECT_NE(nan & 0x3ff, 0);
+  EXPECT_TRUE(std::isnan(halfToFloat(nan)));
+
+  // Every half other than NaN survives a round trip
+  for (uint32_t h = 0; h < 0x10000; h++) {
+    if ((h & 0x7c00) == 0x7c00 && (h & 0x3ff) != 0) {
+      continue;
+    }
+    ASSERT_EQ(floatToHalf(halfToFloat(uint16_t(h))), h);
+  }
+}
+
+TEST(PerProjection, CalibrationCache) {
+  writeCalibration();
+  std::string configPath = std::string(calibrationDir) + "host.txt";
+  std::string cachePath = std::string(calibrationDir) + "host.warpblend";
+  std::remove(cachePath.c_str());
+
+  WarpBlendData loaded;
+  loaded.cache_directory = calibrationDir;
+  loaded.load_allosphere_calibration(calibrationDir, "host");
+  ASSERT_EQ(loaded.viewports.size(), 2u);
+  EXPECT_EQ(loaded.viewports[1].id, "vp1");
+  EXPECT_EQ(loaded.viewports[1].warp_and_blend(2),
+            Vec4f(10.5f, -1, 1, 2 / 9.f));
+  EXPECT_TRUE(File::exists(cachePath));
+
+  // Cache hit
+  WarpBlendData cached;
+  ASSERT_TRUE(cached.read_calibration_cache(cachePath, configPath));
+  ASSERT_EQ(cached.viewports.size(), 2u);
+  EXPECT_EQ(cached.viewports[0].width, 4);
+  EXPECT_FLOAT_EQ(cached.viewports[1].b, 0.5f);
+  EXPECT_EQ(cached.viewports[1].warp_and_blend_data,
+            loaded.viewports[1].warp_and_blend_data);
+
+  // A cache with full floats is not used for half floats, and the other way
+  WarpBlendData half;
+  half.keep_half_float = true;
+  EXPECT_FALSE(half.read_calibration_cache(cachePath, configPath));
+  half.cache_directory = calibrationDir;
+  half.load_allosphere_calibration(calibrationDir, "host");
+  ASSERT_EQ(half.viewports.size(), 2u);
+  EXPECT_TRUE(half.viewports[0].warp_and_blend_data.empty());
+  EXPECT_EQ(half.viewports[0].warp_and_blend(3),
+            Vec4f(0.75f, -1.5f, 1, 3 / 8.f));
+  EXPECT_TRUE(half.read_calibration_cache(cachePath, configPath));
+  EXPECT_FALSE(cached.read_calibration_cache(cachePath, configPath));
+
+  // Desktop mode drops both representations
+  half.load_desktop_mode_calibration();
+  ASSERT_EQ(half.viewports.size(), 6u);
+  for (auto &vp : half.viewports) {
+    EXPECT_TRUE(vp.warp_and_blend_data.empty());
+    EXPECT_TRUE(vp.warp_and_blend_data_half.empty());
+  }
+
+  // Corrupt data fails the checksum
+  {
+    std::fstream file(cachePath,
+                      std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(-1, std::ios::end);
+    file.put('x');
+  }
+  EXPECT_FALSE(half.read_calibration_cache(cachePath, configPath));
+
+  // Changed calibration files invalidate the cache. Modification times have
+  // a resolution of a second
+  loaded.load_allosphere_calibration(calibrationDir, "host");
+  EXPECT_TRUE(cached.read_calibration_cache(cachePath, configPath));
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+  writeViewportData(std::string(calibrationDir) + "vp0.bin", 8, 5.f);
+  EXPECT_FALSE(cached.read_calibration_cache(cachePath, configPath));
+  loaded.load_allosphere_calibration(calibrationDir, "host");
+  EXPECT_EQ(loaded.viewports[0].warp_and_blend(0), Vec4f(5, 0, 1, 0));
+  EXPECT_TRUE(cached.read_calibration_cache(cachePath, configPath));
+  EXPECT_EQ(cached.viewports[0].warp_and_blend(0), Vec4f(5, 0, 1, 0));
+
+  // A viewport count larger than the file can hold is rejected
+  {
+    std::fstream file(cachePath,
+                      std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(8);
+    uint32_t count = 0xFFFFFFFF;
+    file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+  }
+  EXPECT_FALSE(cached.read_calibration_cache(cachePath, configPath));
+  EXPECT_EQ(cached.viewports.size(), 2u);
+
+  for (auto name : {"host.txt", "host.warpblend", "vp0.bin", "vp1.bin"}) {
+    std::remove((std::string(calibrationDir) + name).c_str());
+  }
+}
@@ -0,0 +1,117 @@
+#include "gtest/gtest.h"
+
+#include "al/graphics/al_Shapes.hpp"
+#include "al/ui/al_PickableManager.hpp"
+
+#include <memory>
+
+using namespace al;
+
+TEST(Pickable, ManagerBVH) {
+  Mesh cube;
+  addCube(cube, false, 0.5); // Unit cube centered at the origin
+  std::vector<std::unique_ptr<PickableBB>> pickables;
+  PickableManager manager;
+  for (int x = 0; x < 20; x++) {
+    for (int y = 0; y < 20; y++) {
+      pickables.emplace_back(new PickableBB(cube));
+      pickables.back()->pose = Pose(Vec3d(x * 3.0, y * 3.0, 0));
+      manager << pickables.back().get();
+    }
+  }
+
+  // Ray looking down -z onto pickable (4, 5)
+  Rayd ray(Vec3d(12, 15, 10), Vec3d(0, 0, -1));
+  Hit h = manager.intersect(ray);
+  ASSERT_TRUE(h.hit);
+  EXPECT_EQ(h.p, pickables[4 * 20 + 5].get());
+  EXPECT_NEAR(h.t, 9.5, 1e-6);
+
+  // Moving a pickable in front of it refits the hierarchy
+  pickables[0]->pose = Pose(Vec3d(12, 15, 5));
+  h = manager.intersect(ray);
+  ASSERT_TRUE(h.hit);
+  EXPECT_EQ(h.p, pickables[0].get());
+  EXPECT_NEAR(h.t, 4.5, 1e-6);
+
+  // Point events only update hover on the pickables under the ray
+  manager.event(PickEvent(Point, ray));
+  EXPECT_TRUE(pickables[0]->hover.get());
+  EXPECT_TRUE(pickables[4 * 20 + 5]->hover.get());
+  EXPECT_FALSE(pickables[1]->hover.get());
+  manager.event(PickEvent(Point, Rayd(Vec3d(-10, -10, 10), Vec3d(0, 0, -1))));
+  EXPECT_FALSE(pickables[0]->hover.get());
+  EXPECT_FALSE(pickables[4 * 20 + 5]->hover.get());
+}
+
+TEST(Pickable, MeshTriangles) {
+  Mesh sphere;
+  addSphere(sphere, 1.0, 64, 64);
+  PickableMesh pickable(sphere);
+  EXPECT_GT(pickable.triangleCount(), 1000u);
+  pickable.pose = Pose(Vec3d(0, 0, -5));
+
+  Rayd ray(Vec3d(0.3, 0.2, 0), Vec3d(0, 0, -1));
+  Hit h = pickable.intersect(ray);
+  ASSERT_TRUE(h.hit);
+  // Polygonal sphere is slightly inside the true sphere
+  double expected = 5.0 - std::sqrt(1.0 - 0.3 * 0.3 - 0.2 * 0.2);
+  EXPECT_NEAR(h.t, expected, 0.01);
+
+  pickable.useBVH = false;
+  Hit bruteForce = pickable.intersect(ray);
+  EXPECT_DOUBLE_EQ(bruteForce.t, h.t);
+
+  // Inside the bounding box but outside the sphere
+  EXPECT_FALSE(pickable.intersect(Rayd(Vec3d(0.95, 0.95, 0), Vec3d(0, 0, -1)))
+                   .hit);
+
+  // Growing the mesh also grows the bounds used by the manager
+  for (auto &v : sphere.vertices()) {
+    v *= 2.f;
+  }
+  pickable.updateTriangles();
+  EXPECT_NEAR(pickable.bb.dim.x, 4.0, 1e-3);
+  PickableManager manager;
+  manager << pickable;
+  Hit grown = manager.intersect(Rayd(Vec3d(1.5, 0, 0), Vec3d(0, 0, -1)));
+  ASSERT_TRUE(grown.hit);
+  EXPECT_EQ(grown.p, &pickable);
+}
+
+TEST(Pickable, ScaledHitDistance) {
+  Mesh cube;
+  addCube(cube, false, 0.5);
+  PickableBB large(cube);
+  large.pose = Pose(Vec3d(0, 0, -10));
+  large.scale = 4;
+  PickableBB small(cube);
+  small.pose = Pose(Vec3d(0, 0, -7));
+
+  Rayd ray(Vec3d(0, 0, 0), Vec3d(0, 0, -1));
+  EXPECT_NEAR(large.intersect(ray).t, 8.0, 1e-6);
+  EXPECT_NEAR(small.intersect(ray).t, 6.5, 1e-6);
+
+  // Non uniform scale and an oblique ray
+  PickableBB stretched(cube);
+  stretched.pose = Pose(Vec3d(0, 0, -10));
+  stretched.scaleVec = Vec3f(1, 1, 3);
+  Rayd oblique(Vec3d(0, 0, 0), Vec3d(0, 0.01, -1));
+  double expected = 8.5 * oblique.d.mag() / -oblique.d.z;
+  EXPECT_NEAR(stretched.intersect(oblique).t, expected, 1e-6);
+
+  // The large pickable is nearer in its own units but farther in the world
+  PickableManager manager;
+  manager << large << small;
+  Hit h = manager.intersect(ray);
+  ASSERT_TRUE(h.hit);
+  EXPECT_EQ(h.p, &small);
+  EXPECT_NEAR(h.t, 6.5, 1e-6);
+
+  Mesh sphere;
+  addSphere(sphere, 1.0, 64, 64);
+  PickableMesh scaledMesh(sphere);
+  scaledMesh.pose = Pose(Vec3d(0, 0, -5));
+  scaledMesh.scale = 2;
+  EXPECT_NEAR(scaledMesh.intersect(ray).t, 3.0, 0.01);
+}
@@ -0,0 +1,88 @@
+#include "gtest/gtest.h"
+
+#include "al/scene/al_PolySynth.hpp"
+
+#include <algorithm>
+
+class VoiceA : public al::SynthVoice {};
+class VoiceB : public al::SynthVoice {};
+
+namespace {
+
+// Trigger voices and free them, returning them to their free lists
+void triggerAndFree(al::PolySynth &synth,
+                    std::initializer_list<al::SynthVoice *> voices) {
+  for (auto *voice : voices) {
+    synth.triggerOn(voice);
+  }
+  synth.processVoices();
+  for (auto *voice : voices) {
+    voice->free();
+  }
+  synth.processInactiveVoices();
+}
+
+} // namespace
+
+TEST(PolySynth, VoiceClassIds) {
+  al::PolySynth synth(al::TimeMasterMode::TIME_MASTER_FREE);
+  int a = synth.voiceClassId<VoiceA>();
+  int b = synth.voiceClassId<VoiceB>();
+  EXPECT_NE(a, b);
+  EXPECT_EQ(synth.voiceClassId<VoiceA>(), a);
+  EXPECT_EQ(synth.voiceClassId("VoiceB"), b);
+  EXPECT_EQ(synth.voiceClassName(a), "VoiceA");
+  EXPECT_EQ(synth.voiceClassId("Unknown"), -1);
+
+  VoiceB voice;
+  EXPECT_EQ(synth.voiceClassId(&voice), b);
+
+  // Registering a class with another name keeps its id
+  synth.registerSynthClass<VoiceA>("Renamed");
+  EXPECT_EQ(synth.voiceClassId("Renamed"), a);
+  EXPECT_EQ(synth.voiceClassName(a), "Renamed");
+}
+
+TEST(PolySynth, PerClassFreeLists) {
+  al::PolySynth synth(al::TimeMasterMode::TIME_MASTER_FREE);
+  synth.registerSynthClass<VoiceA>();
+  synth.registerSynthClass<VoiceB>();
+  auto *a1 = synth.getVoice<VoiceA>();
+  auto *a2 = synth.getVoice<VoiceA>();
+  auto *b1 = synth.getVoice<VoiceB>();
+  EXPECT_NE(a1, a2);
+  EXPECT_TRUE(synth.getFreeVoices().empty());
+
+  triggerAndFree(synth, {a1, a2, b1});
+  auto freeVoices = synth.getFreeVoices();
+  EXPECT_EQ(freeVoices.size(), 3u);
+
+  // Free voices are only reused for their own class
+  auto *b2 = synth.getVoice<VoiceB>();
+  EXPECT_EQ(b2, b1);
+  auto *b3 = synth.getVoice<VoiceB>();
+  EXPECT_NE(static_cast<al::SynthVoice *>(b3), a1);
+  EXPECT_NE(static_cast<al::SynthVoice *>(b3), a2);
+  EXPECT_EQ(dynamic_cast<VoiceB *>(b3), b3);
+
+  // Voices requested by name or class id come from the same list
+  al::SynthVoice *byName = synth.getVoice("VoiceA");
+  al::SynthVoice *byId = synth.getVoice(synth.voiceClassId<VoiceA>());
+  EXPECT_TRUE((byName == a1 && byId == a2) || (byName == a2 && byId == a1));
+  EXPECT_TRUE(synth.getFreeVoices().empty());
+
+  // Disabled allocation returns nothing when the list is empty
+  synth.disableAllocation<VoiceA>();
+  EXPECT_EQ(synth.getVoice<VoiceA>(), nullptr);
+  triggerAndFree(synth, {byName});
+  EXPECT_EQ(synth.getVoice<VoiceA>(), byName);
+
+  // Voices allocated outside the synth join the list of their class
+  auto *external = new VoiceB;
+  triggerAndFree(synth, {external, b2, b3});
+  freeVoices = synth.getFreeVoices();
+  EXPECT_EQ(freeVoices.size(), 3u);
+  EXPECT_NE(std::find(freeVoices.begin(), freeVoices.end(), external),
+            freeVoices.end());
+  triggerAndFree(synth, {byId});
+}
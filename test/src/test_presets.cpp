@@ -361,3 +361,76 @@ TEST(Presets, PresetDifferingParams) {
   EXPECT_FLOAT_EQ(pcolor.get().g, 0.73f);
   EXPECT_FLOAT_EQ(pcolor.get().b, 0.8f);
 }
+
+TEST(Presets, PresetBank) {
+
+  al::Parameter p{"param", "group", 0.5f, 0.0, 1.0};
+  al::ParameterInt pint{"paramint", "group", 3, 1, 10};
+  al::ParameterColor pcolor{"paramcolor", "group", al::Color(0.1f, 0.1f, 0.1f)};
+
+  al::PresetHandler ph{al::TimeMasterMode::TIME_MASTER_FREE, "presets_bank"};
+  ph << p << pint << pcolor;
+
+  p.set(0.8f);
+  pint.set(9);
+  pcolor.set({0.4f, 0.3f, 0.2f});
+  ph.storePreset("2");
+  p.set(0.1f);
+  pint.set(4);
+  pcolor.set({0.31f, 0.33f, 0.36f});
+  ph.storePreset("3");
+
+  EXPECT_TRUE(ph.exportPresetBank());
+  al::File::remove(ph.getCurrentPath() + "2.preset");
+  al::File::remove(ph.getCurrentPath() + "3.preset");
+  ph.usePresetBank();
+
+  ph.recallPresetSynchronous("2");
+  EXPECT_FLOAT_EQ(p.get(), 0.8f);
+  EXPECT_EQ(pint.get(), 9);
+  EXPECT_FLOAT_EQ(pcolor.get().r, 0.4f);
+  EXPECT_FLOAT_EQ(pcolor.get().g, 0.3f);
+  EXPECT_FLOAT_EQ(pcolor.get().b, 0.2f);
+
+  ph.setInterpolatedPreset("2", "3", 0.5f);
+  EXPECT_FLOAT_EQ(p.get(), 0.45f);
+  EXPECT_EQ(pint.get(), 6);
+  EXPECT_FLOAT_EQ(pcolor.get().r, 0.355f);
+
+  // Storing writes a text preset that replaces the bank entry
+  p.set(0.2f);
+  ph.storePreset("3");
+  p.set(0.9f);
+  ph.recallPresetSynchronous("3");
+  EXPECT_FLOAT_EQ(p.get(), 0.2f);
+
+  // Convert back to text files
+  ph.usePresetBank(false);
+  EXPECT_TRUE(ph.importPresetBank());
+  EXPECT_TRUE(al::File::exists(ph.getCurrentPath() + "2.preset"));
+  ph.recallPresetSynchronous("3");
+  EXPECT_FLOAT_EQ(p.get(), 0.1f);
+}
+
+TEST(Presets, PresetBankFieldCount) {
+  std::map<std::string, al::PresetHandler::ParameterStates> presets;
+  std::vector<al::VariantValue> fields;
+  for (int i = 0; i < 300; i++) {
+    fields.push_back(float(i));
+  }
+  presets["many"]["/values"] = fields;
+  ASSERT_TRUE(al::PresetBank::write("field_count.alpb", presets));
+
+  al::PresetBank bank;
+  ASSERT_TRUE(bank.open("field_count.alpb"));
+  al::PresetHandler::ParameterStates values;
+  ASSERT_TRUE(bank.getPresetValues("many", values));
+  ASSERT_EQ(values["/values"].size(), 300u);
+  EXPECT_FLOAT_EQ(values["/values"][299].get<float>(), 299.f);
+  bank.close();
+
+  // Counts that don't fit the format are rejected
+  presets["many"]["/values"].resize(70000, al::VariantValue(0.f));
+  EXPECT_FALSE(al::PresetBank::write("field_count.alpb", presets));
+  al::File::remove("field_count.alpb");
+}
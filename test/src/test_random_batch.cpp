@@ -0,0 +1,96 @@
+#include <cmath>
+#include <vector>
+
+#include "al/math/al_RandomBatch.hpp"
+#include "gtest/gtest.h"
+
+using namespace al;
+
+TEST(RandomBatch, Stream) {
+  rnd::TauswortheLanes a(1234), b(1234), c(1234, 1);
+  std::vector<uint32_t> whole(23), parts(23), other(23);
+  a.fill(whole.data(), whole.size());
+  // The stream does not depend on how it is split into calls
+  b.fill(parts.data(), 3);
+  parts[3] = b();
+  b.fill(parts.data() + 4, 9);
+  b.fill(parts.data() + 13, 10);
+  EXPECT_EQ(whole, parts);
+
+  c.fill(other.data(), other.size());
+  int same = 0;
+  for (size_t i = 0; i < whole.size(); i++) {
+    same += whole[i] == other[i];
+  }
+  EXPECT_EQ(same, 0);
+
+  // Skipping ahead matches generating and dropping the values
+  rnd::TauswortheLanes skip(99), step(99);
+  const int steps = 1000;
+  const int lanes = rnd::TauswortheLanes::kLanes;
+  std::vector<uint32_t> dropped(lanes - 1 + steps * lanes);
+  step();  // discard() also drops the rest of the cached group
+  step.fill(dropped.data(), dropped.size());
+  skip();
+  skip.discard(steps);
+  for (int i = 0; i < 16; i++) {
+    EXPECT_EQ(skip(), step());
+  }
+
+  // Usable as the generator of Random<>
+  rnd::Random<rnd::TauswortheLanes> r(5);
+  float v = r.uniform();
+  EXPECT_GE(v, 0.f);
+  EXPECT_LT(v, 1.f);
+}
+
+TEST(RandomBatch, Distributions) {
+  rnd::BatchRandom r(42);
+  const size_t n = 100001;
+  std::vector<float> values(n);
+
+  r.uniform(values.data(), n, 5.f, 3.f);
+  double sum = 0;
+  for (float v : values) {
+    EXPECT_GE(v, 3.f);
+    EXPECT_LT(v, 5.f);
+    sum += v;
+  }
+  EXPECT_NEAR(sum / n, 4.0, 0.01);
+
+  r.uniformS(values.data(), n);
+  for (float v : values) {
+    EXPECT_GE(v, -1.f);
+    EXPECT_LT(v, 1.f);
+  }
+
+  r.normal(values.data(), n, 2.f, 3.f);
+  double sum2 = 0;
+  sum = 0;
+  for (float v : values) {
+    ASSERT_TRUE(std::isfinite(v));
+    sum += v;
+    sum2 += v * v;
+  }
+  double mean = sum / n;
+  EXPECT_NEAR(mean, 2.0, 0.05);
+  EXPECT_NEAR(std::sqrt(sum2 / n - mean * mean), 3.0, 0.05);
+
+  std::vector<Vec3f> points(n);
+  r.sphere(points.data(), n);
+  Vec3d centroid(0, 0, 0);
+  for (auto &p : points) {
+    EXPECT_NEAR(p.mag(), 1.f, 1e-5f);
+    centroid += Vec3d(p);
+  }
+  EXPECT_LT((centroid / double(n)).mag(), 0.01);
+
+  r.ball(points.data(), n);
+  double radius = 0;
+  for (auto &p : points) {
+    EXPECT_LE(p.mag(), 1.f + 1e-5f);
+    radius += p.mag();
+  }
+  // Mean distance from the center of a unit ball is 3/4
+  EXPECT_NEAR(radius / n, 0.75, 0.01);
+}
@@ -0,0 +1,108 @@
+#include "al/protocol/al_Serialize.hpp"
+#include "gtest/gtest.h"
+
+#include <type_traits>
+
+using namespace al;
+
+// Deserializer reads in place, so it can't be built from a temporary
+static_assert(std::is_constructible<Deserializer, std::vector<char> &>::value,
+              "");
+static_assert(!std::is_constructible<Deserializer, std::vector<char>>::value,
+              "");
+
+TEST(Serialize, RoundTrip) {
+  Serializer ser;
+  float f[3] = {1.5f, -2.f, 3.25f};
+  ser << int32_t(-7) << 2.5 << "text" << std::string("string");
+  ser.add(f, 3);
+
+  // Reads in place from the serializer's buffer
+  Deserializer des(ser.buf());
+  int32_t i = 0;
+  double d = 0;
+  const char *text = nullptr;
+  std::string s;
+  float g[3] = {0, 0, 0};
+  des >> i >> d >> text >> s;
+  EXPECT_EQ(des.read(g, 3), 3u);
+  EXPECT_TRUE(des.ok());
+  EXPECT_EQ(i, -7);
+  EXPECT_EQ(d, 2.5);
+  EXPECT_STREQ(text, "text");
+  EXPECT_GE(text, ser.buf().data());
+  EXPECT_LT(text, ser.buf().data() + ser.buf().size());
+  EXPECT_EQ(s, "string");
+  EXPECT_EQ(g[2], 3.25f);
+  EXPECT_EQ(des.remaining(), 0u);
+
+  // Reading past the end or the wrong type fails without touching values
+  des >> i;
+  EXPECT_FALSE(des.ok());
+  EXPECT_EQ(i, -7);
+  Deserializer wrongType(ser.buf());
+  wrongType >> d;
+  EXPECT_FALSE(wrongType.ok());
+  EXPECT_EQ(d, 2.5);
+
+  // Truncated array
+  Deserializer truncated(ser.buf().data(), uint32_t(ser.buf().size() - 1));
+  truncated >> i >> d >> text >> s;
+  EXPECT_TRUE(truncated.ok());
+  EXPECT_EQ(truncated.read(g, 3), 0u);
+  EXPECT_FALSE(truncated.ok());
+
+  // Reuse keeps the buffer
+  const char *data = ser.data();
+  ser.reset();
+  ser << int32_t(1);
+  EXPECT_EQ(ser.size(), 9u);
+  EXPECT_EQ(ser.data(), data);
+}
+
+TEST(Serialize, ExternalBuffer) {
+  char buffer[16];
+  Serializer ser(buffer, sizeof(buffer));
+  ser << int32_t(3) << uint16_t(4);
+  EXPECT_FALSE(ser.overflowed());
+  EXPECT_EQ(ser.size(), 16u);
+  EXPECT_EQ(ser.data(), buffer);
+  ser << int8_t(5);
+  EXPECT_TRUE(ser.overflowed());
+  EXPECT_EQ(ser.size(), 16u);
+
+  Deserializer des(buffer, ser.size());
+  int32_t i;
+  uint16_t u;
+  des >> i >> u;
+  EXPECT_TRUE(des.ok());
+  EXPECT_EQ(i, 3);
+  EXPECT_EQ(u, 4);
+}
+
+TEST(Serialize, Varint) {
+  uint32_t counts[4] = {0, 127, 128, 4000000000u};
+  int64_t positions[4] = {-1, 1, -300, 1000000};
+  int32_t previous[4] = {100, 200, 300, 400};
+  int32_t current[4] = {101, 199, 300, 464};
+  Serializer ser;
+  ser.addVarint(counts, 4);
+  ser.addVarint(positions, 4);
+  ser.addDelta(current, previous, 4);
+  // 3 headers, 9 bytes of counts, 7 of positions and 5 of differences
+  EXPECT_EQ(ser.size(), 3 * 5 + 9 + 7 + 5u);
+
+  Deserializer des(ser.buf());
+  uint32_t counts2[4];
+  int64_t positions2[4];
+  int32_t current2[4];
+  EXPECT_EQ(des.readVarint(counts2, 4), 4u);
+  EXPECT_EQ(des.readVarint(positions2, 4), 4u);
+  EXPECT_EQ(des.readDelta(current2, previous, 4), 4u);
+  EXPECT_TRUE(des.ok());
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ(counts2[i], counts[i]);
+    EXPECT_EQ(positions2[i], positions[i]);
+    EXPECT_EQ(current2[i], current[i]);
+  }
+}
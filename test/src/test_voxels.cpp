@@ -0,0 +1,297 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "al/graphics/al_Isosurface.hpp"
+#include "al/types/al_Conversion.hpp"
+#include "al/types/al_Voxels.hpp"
+#include "gtest/gtest.h"
+
+using namespace al;
+
+namespace {
+
+float field(uint32_t x, uint32_t y, uint32_t z) {
+  return std::sin(x * 0.3f) + std::cos(y * 0.2f) * z * 0.1f;
+}
+
+// Sphere of radius r around the volume center, positive inside
+void fillSphere(Voxels &voxels, std::vector<float> &dense, float r) {
+  uint32_t n = voxels.width();
+  float c = (n - 1) * 0.5f;
+  dense.resize(size_t(n) * n * n);
+  for (uint32_t z = 0; z < n; z++) {
+    for (uint32_t y = 0; y < n; y++) {
+      for (uint32_t x = 0; x < n; x++) {
+        float d = std::sqrt((x - c) * (x - c) + (y - c) * (y - c) +
+                            (z - c) * (z - c));
+        float v = d < r + 2 ? r - d : -2.f;
+        dense[(size_t(z) * n + y) * n + x] = v;
+        if (v != voxels.background()) {
+          voxels.setValue(x, y, z, v);
+        }
+      }
+    }
+  }
+}
+
+} // namespace
+
+TEST(Voxels, SparseStorage) {
+  Voxels voxels(100, 80, 60);
+  voxels.format(100, 80, 60, 16);
+  EXPECT_EQ(voxels.bricks(0), 7u);
+  EXPECT_EQ(voxels.bricks(1), 5u);
+  EXPECT_EQ(voxels.bricks(2), 4u);
+  EXPECT_EQ(voxels.levels(), 4);
+  EXPECT_EQ(voxels.width(3), 13u);
+
+  voxels.background(-1.f);
+  EXPECT_EQ(voxels.value(50, 40, 30), -1.f);
+  EXPECT_EQ(voxels.residentBytes(), 0u);
+
+  voxels.setValue(99, 79, 59, 3.f);
+  voxels.setValue(0, 0, 0, 2.f);
+  EXPECT_EQ(voxels.value(99, 79, 59), 3.f);
+  EXPECT_EQ(voxels.value(0, 0, 0), 2.f);
+  EXPECT_EQ(voxels.value(1, 0, 0), -1.f);
+  EXPECT_EQ(voxels.residentBytes(), 2 * 16 * 16 * 16 * sizeof(float));
+
+  float lo, hi;
+  EXPECT_EQ(voxels.brick(3, 3, 3, 0, lo, hi), nullptr);
+  EXPECT_EQ(lo, -1.f);
+  EXPECT_NE(voxels.brick(0, 0, 0, 0, lo, hi), nullptr);
+  EXPECT_EQ(lo, -1.f);
+  EXPECT_EQ(hi, 2.f);
+
+  // Reads outside the volume clamp to its edges
+  float region[8];
+  voxels.read(region, -1, -1, -1, 2, 2, 2);
+  for (float v : region) {
+    EXPECT_EQ(v, 2.f);
+  }
+}
+
+TEST(Voxels, MipLevels) {
+  Voxels voxels(20, 20, 20);
+  voxels.format(20, 20, 20, 8);
+  for (uint32_t z = 0; z < 20; z++) {
+    for (uint32_t y = 0; y < 20; y++) {
+      for (uint32_t x = 0; x < 20; x++) {
+        voxels.setValue(x, y, z, field(x, y, z));
+      }
+    }
+  }
+  ASSERT_EQ(voxels.levels(), 3);
+  for (uint32_t z = 0; z < 10; z++) {
+    for (uint32_t y = 0; y < 10; y++) {
+      for (uint32_t x = 0; x < 10; x++) {
+        float sum = 0;
+        for (int i = 0; i < 8; i++) {
+          sum += field(2 * x + (i & 1), 2 * y + (i >> 1 & 1),
+                       2 * z + (i >> 2));
+        }
+        EXPECT_NEAR(voxels.value(x, y, z, 1), sum / 8, 1e-5);
+      }
+    }
+  }
+
+  // Writing a voxel updates the levels below it
+  float before = voxels.value(2, 2, 2, 2);
+  voxels.setValue(9, 9, 9, 100.f);
+  EXPECT_GT(voxels.value(4, 4, 4, 1), 10.f);
+  EXPECT_GT(voxels.value(2, 2, 2, 2), before);
+}
+
+TEST(Voxels, MRCRoundTrip) {
+  const char *path = "voxels_test.mrc";
+  Voxels voxels(37, 21, 18, 0.5f, VOX_NANOMETERS);
+  voxels.format(37, 21, 18, 8);
+  for (uint32_t z = 0; z < 18; z++) {
+    for (uint32_t y = 0; y < 21; y++) {
+      for (uint32_t x = 0; x < 37; x++) {
+        voxels.setValue(x, y, z, field(x, y, z));
+      }
+    }
+  }
+  ASSERT_TRUE(voxels.writeToMRC(path));
+
+  for (MRCAccess access : {MRC_MAP, MRC_STREAM}) {
+    Voxels loaded;
+    loaded.format(1, 1, 1, 8);
+    ASSERT_TRUE(loaded.loadFromMRC(path, access));
+    EXPECT_EQ(loaded.width(), 37u);
+    EXPECT_EQ(loaded.height(), 21u);
+    EXPECT_EQ(loaded.depth(), 18u);
+    EXPECT_NEAR(loaded.getVoxWidth(0), 0.5f, 1e-5);
+    EXPECT_EQ(loaded.getUnits(), VOX_NANOMETERS);
+    EXPECT_FLOAT_EQ(loaded.min(), voxels.min());
+    EXPECT_FLOAT_EQ(loaded.max(), voxels.max());
+
+    // Cache holds a few bricks, so bricks are dropped and decoded again
+    loaded.cacheLimit(3 * 8 * 8 * 8 * sizeof(float));
+    for (int pass = 0; pass < 2; pass++) {
+      for (uint32_t z = 0; z < 18; z++) {
+        for (uint32_t y = 0; y < 21; y++) {
+          for (uint32_t x = 0; x < 37; x++) {
+            ASSERT_EQ(loaded.value(x, y, z), field(x, y, z));
+          }
+        }
+      }
+      EXPECT_LE(loaded.residentBytes(), loaded.cacheLimit());
+    }
+    EXPECT_NEAR(loaded.value(0, 0, 0, 1),
+                (field(0, 0, 0) + field(1, 0, 0) + field(0, 1, 0) +
+                 field(1, 1, 0) + field(0, 0, 1) + field(1, 0, 1) +
+                 field(0, 1, 1) + field(1, 1, 1)) /
+                    8,
+                1e-5);
+  }
+  std::remove(path);
+
+  Voxels missing;
+  EXPECT_FALSE(missing.loadFromMRC("voxels_missing.mrc", MRC_STREAM));
+}
+
+TEST(Voxels, BrickRangesAfterEviction) {
+  const char *path = "voxels_test_ranges.mrc";
+  Voxels voxels(37, 21, 18);
+  voxels.format(37, 21, 18, 8);
+  for (uint32_t z = 0; z < 18; z++) {
+    for (uint32_t y = 0; y < 21; y++) {
+      for (uint32_t x = 0; x < 37; x++) {
+        voxels.setValue(x, y, z, field(x, y, z) + 10.f);
+      }
+    }
+  }
+  ASSERT_TRUE(voxels.writeToMRC(path));
+
+  Voxels loaded;
+  loaded.format(1, 1, 1, 8);
+  ASSERT_TRUE(loaded.loadFromMRC(path, MRC_STREAM));
+  loaded.cacheLimit(2 * 8 * 8 * 8 * sizeof(float));
+  std::vector<float> mins, maxs;
+  for (uint32_t k = 0; k < 3; k++) {
+    for (uint32_t j = 0; j < 3; j++) {
+      for (uint32_t i = 0; i < 5; i++) {
+        float lo, hi;
+        loaded.brick(i, j, k, 0, lo, hi);
+        EXPECT_GT(lo, 5.f);
+        mins.push_back(lo);
+        maxs.push_back(hi);
+      }
+    }
+  }
+
+  // Bricks decoded from now on only contain the background
+  std::ofstream(path, std::ios::binary | std::ios::trunc).close();
+  size_t n = 0;
+  for (uint32_t k = 0; k < 3; k++) {
+    for (uint32_t j = 0; j < 3; j++) {
+      for (uint32_t i = 0; i < 5; i++, n++) {
+        float lo, hi;
+        loaded.brickRange(i, j, k, 0, lo, hi);
+        EXPECT_EQ(lo, mins[n]);
+        EXPECT_EQ(hi, maxs[n]);
+      }
+    }
+  }
+  std::remove(path);
+
+  // Writes change the ranges of the levels below
+  float lo, hi;
+  voxels.brickRange(0, 0, 0, 1, lo, hi);
+  EXPECT_LT(hi, 100.f);
+  voxels.setValue(0, 0, 0, 1000.f);
+  voxels.brickRange(0, 0, 0, 0, lo, hi);
+  EXPECT_EQ(hi, 1000.f);
+  voxels.brickRange(0, 0, 0, 1, lo, hi);
+  EXPECT_GT(hi, 100.f);
+}
+
+TEST(Voxels, MRCSwappedInt16) {
+  // Big endian 16-bit file with an extended header
+  const char *path = "voxels_test_int16.mrc";
+  const int32_t n[3] = {5, 4, 3};
+  const int32_t extended = 64;
+  MRCHeader header;
+  std::memset(&header, 0, sizeof(header));
+  header.nx = n[0];
+  header.ny = n[1];
+  header.nz = n[2];
+  header.mode = MRC_IMAGE_SINT16;
+  header.mapx = 1;
+  header.mapy = 2;
+  header.mapz = 3;
+  header.xlen = header.ylen = header.zlen = 20.f;
+  header.next = extended;
+  swapBytes(&header.nx, 10);
+  swapBytes(&header.xlen, 6);
+  swapBytes(&header.mapx, 3);
+  swapBytes(&header.next, 1);
+
+  std::vector<int16_t> data;
+  for (int i = 0; i < n[0] * n[1] * n[2]; i++) {
+    int16_t v = int16_t(i * 37 - 1000);
+    swapBytes(v);
+    data.push_back(v);
+  }
+  {
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    std::vector<char> ext(extended, 'x');
+    file.write(ext.data(), extended);
+    file.write(reinterpret_cast<const char *>(data.data()),
+               data.size() * sizeof(int16_t));
+  }
+
+  MRCHeader parsed;
+  bool swapped = false;
+  EXPECT_TRUE(Voxels::parseMRC(reinterpret_cast<const char *>(&header), parsed,
+                               swapped));
+  EXPECT_TRUE(swapped);
+  EXPECT_EQ(parsed.nx, 5);
+  EXPECT_EQ(parsed.next, extended);
+
+  for (MRCAccess access : {MRC_MAP, MRC_STREAM}) {
+    Voxels voxels;
+    ASSERT_TRUE(voxels.loadFromMRC(path, access));
+    EXPECT_NEAR(voxels.getVoxWidth(0), 0.4f, 1e-5);
+    for (int z = 0; z < n[2]; z++) {
+      for (int y = 0; y < n[1]; y++) {
+        for (int x = 0; x < n[0]; x++) {
+          int i = (z * n[1] + y) * n[0] + x;
+          EXPECT_EQ(voxels.value(x, y, z), float(i * 37 - 1000));
+        }
+      }
+    }
+  }
+  std::remove(path);
+}
+
+TEST(Voxels, Isosurface) {
+  const uint32_t n = 40;
+  Voxels voxels(n, n, n, 0.25f, VOX_METERS);
+  voxels.format(n, n, n, 8);
+  voxels.background(-2.f);
+  std::vector<float> dense;
+  fillSphere(voxels, dense, 9.f);
+
+  Isosurface fromDense;
+  fromDense.generate(dense.data(), n, 0.25f);
+  Isosurface fromVoxels;
+  ASSERT_TRUE(fromVoxels.generate(voxels));
+  ASSERT_GT(fromDense.vertices().size(), 0u);
+  EXPECT_EQ(fromVoxels.vertices().size(), fromDense.vertices().size());
+  EXPECT_EQ(fromVoxels.indices().size(), fromDense.indices().size());
+
+  // Most bricks are empty and skipped
+  EXPECT_LT(voxels.residentBytes(), dense.size() * sizeof(float));
+
+  Isosurface coarse;
+  ASSERT_TRUE(coarse.generate(voxels, 1));
+  EXPECT_GT(coarse.vertices().size(), 0u);
+  EXPECT_LT(coarse.vertices().size(), fromDense.vertices().size());
+}